@@ -21,9 +21,42 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import <Foundation/Foundation.h>
+#include <sys/types.h>
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ The on-disk attributes of a single item, captured
+ in one system call rather than one lookup per property.
+ */
+typedef struct {
+    BOOL isDirectory;                   // Whether the item is a directory
+    long long size;                     // The file size of the item (0 for directories)
+    struct timespec creationTime;       // The creation time of the item
+    struct timespec modificationTime;   // The content modification time of the item
+    struct timespec changeTime;         // The last time the item's metadata (including its extended attributes) changed
+    uint64_t inode;                     // The file system ID number of the item
+    dev_t device;                       // The ID of the device the item is stored on
+    uint32_t numberOfChildItems;        // For directories, the number of items inside, including hidden ones (0 if unknown)
+} TOFileSystemItemAttributes;
+
+/**
+ Whether two sets of attributes were read from the same item on disk, even if it has since been moved or renamed.
+ Since file system IDs can be reused once an item is deleted, the creation time is compared too, standing in
+ as the generation of the ID.
+ */
+NS_INLINE BOOL TOFileSystemItemAttributesAreSameItem(const TOFileSystemItemAttributes *first,
+                                                     const TOFileSystemItemAttributes *second) {
+    return first->inode != 0 && first->inode == second->inode && first->device == second->device &&
+           first->creationTime.tv_sec == second->creationTime.tv_sec &&
+           first->creationTime.tv_nsec == second->creationTime.tv_nsec;
+}
+
+/** Converts a timestamp from a set of item attributes into a date object. */
+NS_INLINE NSDate *TOFileSystemDateFromTimespec(struct timespec time) {
+    return [NSDate dateWithTimeIntervalSince1970:(NSTimeInterval)time.tv_sec + ((NSTimeInterval)time.tv_nsec / NSEC_PER_SEC)];
+}
+
 /**
  A convenience wrapper for fetching specific attributes
  about the item on disk that this URL represents
@@ -48,6 +81,19 @@ NS_ASSUME_NONNULL_BEGIN
 /** The number of sub-items in this directory. */
 @property (nonatomic, readonly) NSInteger to_numberOfSubItems;
 
+/**
+ Counts the number of sub-items in this directory, and also provides the modification time
+ of the directory the count is valid for. If the directory was modified while it was being read,
+ the modification time is set to zero, as the count may already be out of date.
+ */
+- (NSInteger)to_numberOfSubItemsWithModificationTime:(struct timespec *)modificationTime;
+
+/**
+ Fetches the type, size, timestamps, inode and (for directories) child count of the item in a single call.
+ Returns NO if the item couldn't be read (eg, it no longer exists).
+ */
+- (BOOL)to_getAttributes:(TOFileSystemItemAttributes *)attributes;
+
 @end
 
 NS_ASSUME_NONNULL_END
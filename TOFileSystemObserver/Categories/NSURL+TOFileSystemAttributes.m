@@ -22,7 +22,9 @@
 
 #import "NSURL+TOFileSystemAttributes.h"
 #import "TOFileSystemObserverConstants.h"
+#import "TOFileSystemAttributeList.h"
 #include <dirent.h>
+#include <sys/stat.h>
 
 @implementation NSURL (TOFileSystemAttributes)
 
@@ -64,24 +66,69 @@
 }
 
 - (NSInteger)to_numberOfSubItems
+{
+    struct timespec modificationTime;
+    return [self to_numberOfSubItemsWithModificationTime:&modificationTime];
+}
+
+- (NSInteger)to_numberOfSubItemsWithModificationTime:(struct timespec *)modificationTime
 {
     NSInteger numberOfItems = 0;
     DIR *directory;
     struct dirent *entry;
+    struct stat startStat, endStat;
+    *modificationTime = (struct timespec){0};
 
     // Do it using POSIX APIs to avoid needing to load in all of the file names
     const char *path = [self.path cStringUsingEncoding:NSUTF8StringEncoding];
     directory = opendir(path);
     if (directory == NULL) { return 0; }
+    BOOL hasStartStat = (fstat(dirfd(directory), &startStat) == 0);
     while ((entry = readdir(directory)) != NULL) {
         if (entry->d_name[0] == '.') { continue; }
         if (entry->d_type == DT_REG || entry->d_type == DT_DIR) {
              numberOfItems++;
         }
     }
+
+    // Only vouch for the count if nothing changed in the directory while it was being read
+    if (hasStartStat && fstat(dirfd(directory), &endStat) == 0 &&
+        startStat.st_mtimespec.tv_sec == endStat.st_mtimespec.tv_sec &&
+        startStat.st_mtimespec.tv_nsec == endStat.st_mtimespec.tv_nsec) {
+        *modificationTime = endStat.st_mtimespec;
+    }
     closedir(directory);
     
     return numberOfItems;
 }
 
+- (BOOL)to_getAttributes:(TOFileSystemItemAttributes *)attributes
+{
+    // Request everything (including the directory entry count) in one go
+    struct attrlist attributeList;
+    TOFileSystemAttributeListPrepare(&attributeList, NO);
+
+    char buffer[sizeof(uint32_t) + sizeof(attribute_set_t) + sizeof(attrreference_t) +
+                sizeof(TOFileSystemItemAttributes) + sizeof(struct timespec) + MAXPATHLEN];
+    const char *name = NULL;
+    if (getattrlist(self.fileSystemRepresentation, &attributeList, buffer, sizeof(buffer), FSOPT_NOFOLLOW) == 0 &&
+        TOFileSystemAttributeListParseRecord(buffer, attributes, &name, NULL)) {
+        return YES;
+    }
+
+    // If the volume doesn't support it, fall back to a regular stat (without the entry count)
+    struct stat fileStat;
+    if (lstat(self.fileSystemRepresentation, &fileStat) != 0) { return NO; }
+
+    attributes->isDirectory = S_ISDIR(fileStat.st_mode);
+    attributes->size = attributes->isDirectory ? 0 : (long long)fileStat.st_size;
+    attributes->creationTime = fileStat.st_birthtimespec;
+    attributes->modificationTime = fileStat.st_mtimespec;
+    attributes->changeTime = fileStat.st_ctimespec;
+    attributes->inode = (uint64_t)fileStat.st_ino;
+    attributes->device = fileStat.st_dev;
+    attributes->numberOfChildItems = 0;
+    return YES;
+}
+
 @end
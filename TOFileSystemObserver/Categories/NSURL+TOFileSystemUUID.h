@@ -22,8 +22,43 @@
 
 #import <Foundation/Foundation.h>
 
+@class TOFileSystemUUID;
+
 NS_ASSUME_NONNULL_BEGIN
 
+/** The outcome of reading the UUID saved to an item. */
+typedef NS_ENUM(NSInteger, TOFileSystemUUIDReadResult) {
+    TOFileSystemUUIDReadResultFound,    // A valid UUID was read
+    TOFileSystemUUIDReadResultMissing,  // The item has no UUID yet (or the saved value isn't a valid UUID)
+    TOFileSystemUUIDReadResultError     // The item couldn't be read at all (`errno` holds the reason)
+};
+
+/**
+ Reads the UUID of the item with the provided name, relative to an already open directory,
+ so the full path doesn't need to be resolved again for each item.
+ */
+FOUNDATION_EXTERN TOFileSystemUUIDReadResult TOFileSystemUUIDReadFromItemInDirectory(int directoryDescriptor,
+                                                                                      const char *name,
+                                                                                      TOFileSystemUUID * _Nullable __autoreleasing * _Nonnull uuid);
+
+/**
+ Saves a UUID to the item with the provided name, relative to an already open directory.
+ Returns NO (with `errno` set) if it couldn't be written.
+ */
+FOUNDATION_EXTERN BOOL TOFileSystemUUIDWriteToItemInDirectory(int directoryDescriptor, const char *name, TOFileSystemUUID *uuid);
+
+/**
+ Saves a UUID to the item with the provided name, relative to an already open directory, but only if
+ it is still the item with the provided file system ID (ie, it wasn't renamed or replaced since the ID was read).
+ Returns NO (with `errno` set) if it couldn't be written. `errno` is `ESTALE` if the name now belongs to a
+ different item, or `EFTYPE` if the item isn't a regular file or directory, and so wasn't opened.
+ */
+FOUNDATION_EXTERN BOOL TOFileSystemUUIDWriteToItemInDirectoryWithID(int directoryDescriptor,
+                                                                    const char *name,
+                                                                    dev_t device,
+                                                                    uint64_t inode,
+                                                                    TOFileSystemUUID *uuid);
+
 /**
  A convenience category that wraps the ability
  to assign a specific extended attribute
@@ -46,6 +81,18 @@ NS_ASSUME_NONNULL_BEGIN
 /** Regardless if one exists, generate and save a new UUID. */
 - (NSString *)to_generateFileSystemUUID;
 
+/** Returns the UUID assigned to this file as a binary value, without creating an intermediate string. */
+- (nullable TOFileSystemUUID *)to_fileSystemUUIDValue;
+
+/** Reads the UUID assigned to this file, reporting whether it was missing, or couldn't be read at all. */
+- (TOFileSystemUUIDReadResult)to_readFileSystemUUIDValue:(TOFileSystemUUID * _Nullable __autoreleasing * _Nonnull)uuid;
+
+/** Sets a predetermined binary UUID to be the value of the file. Returns NO (with `errno` set) if it couldn't be written. */
+- (BOOL)to_setFileSystemUUIDValue:(TOFileSystemUUID *)uuid;
+
+/** Regardless if one exists, generate and save a new UUID, returning it as a binary value. */
+- (TOFileSystemUUID *)to_generateFileSystemUUIDValue;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -21,72 +21,212 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import "NSURL+TOFileSystemUUID.h"
+#import "TOFileSystemUUID.h"
+#import "TOFileSystemLock.h"
+#import <stdatomic.h>
 #import <sys/xattr.h>
+#import <errno.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/stat.h>
 
-static NSString *kTOFileSystemAttributeKey = @"dev.tim.fileSystemObserver.UUID";
+/** The name of the attribute the UUID is saved under, as a C string so it doesn't need to be converted on every read.
+    It may be read from any thread, so it's swapped atomically, and every name it has pointed to is kept alive. */
+static _Atomic(const char *) kTOFileSystemAttributeKeyName = "dev.tim.fileSystemObserver.UUID";
 
-@implementation NSURL (TOFileSystemUUID)
+/** Returns the name the UUID is currently saved under. */
+static inline const char *TOFileSystemUUIDAttributeKeyName(void)
+{
+    return atomic_load_explicit(&kTOFileSystemAttributeKeyName, memory_order_acquire);
+}
 
-+ (void)to_setKeyNamePrefix:(NSString *)prefix
+/** Works out the result of reading the attribute, based on what was returned by the system call. */
+static TOFileSystemUUIDReadResult TOFileSystemUUIDReadResultForValue(const char *value, ssize_t length,
+                                                                     int readError, TOFileSystemUUID **uuid)
 {
-    kTOFileSystemAttributeKey = [NSString stringWithFormat:@"%@.fileSystemObserver.UUID", prefix];
+    *uuid = nil;
+
+    if (length < 0) {
+        // The attribute doesn't exist, or is too long to be a UUID
+        if (readError == ENOATTR || readError == ERANGE) {
+            return TOFileSystemUUIDReadResultMissing;
+        }
+
+        errno = readError;
+        return TOFileSystemUUIDReadResultError;
+    }
+
+    // Decode the characters straight into bytes (which also verifies they are a valid UUID)
+    *uuid = [TOFileSystemUUID UUIDWithCharacters:value length:(size_t)length];
+    return *uuid ? TOFileSystemUUIDReadResultFound : TOFileSystemUUIDReadResultMissing;
 }
 
-- (NSString *)to_fileSystemUUID
+/**
+ Opens an item inside a directory, only so its attributes can be accessed.
+ This should only be used for regular files and directories. (Opening devices can have side effects.)
+ */
+static int TOFileSystemUUIDOpenItemInDirectory(int directoryDescriptor, const char *name)
 {
-    const char *filePath = [self.path fileSystemRepresentation];
-    const char *keyName = kTOFileSystemAttributeKey.UTF8String;
+    // Event-only access doesn't need read permission, and won't touch the contents of the file.
+    // In case the item was replaced since its type was checked, never wait (eg, for a writer
+    // to open a named pipe), and don't follow symbolic links to somewhere else.
+    return openat(directoryDescriptor, name, O_EVTONLY | O_CLOEXEC | O_NONBLOCK | O_NOFOLLOW);
+}
 
-    // Allocate a buffer for the value (UUID values are always 36 characters)
-    char value[36];
+TOFileSystemUUIDReadResult TOFileSystemUUIDReadFromItemInDirectory(int directoryDescriptor,
+                                                                    const char *name,
+                                                                    TOFileSystemUUID **uuid)
+{
+    *uuid = nil;
+
+    int fileDescriptor = TOFileSystemUUIDOpenItemInDirectory(directoryDescriptor, name);
+    if (fileDescriptor < 0) { return TOFileSystemUUIDReadResultError; }
+
+    // (UUID values are always 36 characters, so anything longer will fail with ERANGE)
+    char value[kTOFileSystemUUIDStringLength];
+    ssize_t length = fgetxattr(fileDescriptor, TOFileSystemUUIDAttributeKeyName(), value, sizeof(value), 0, 0);
+    int readError = errno;
+    close(fileDescriptor);
+
+    return TOFileSystemUUIDReadResultForValue(value, length, readError, uuid);
+}
+
+/** Saves a UUID to an item that is already open, and then closes it. */
+static BOOL TOFileSystemUUIDWriteToOpenItem(int fileDescriptor, TOFileSystemUUID *uuid)
+{
+    char value[kTOFileSystemUUIDStringLength];
+    [uuid getCharacters:value];
+
+    int result = fsetxattr(fileDescriptor, TOFileSystemUUIDAttributeKeyName(), value, sizeof(value), 0, 0);
+    int writeError = errno;
+    close(fileDescriptor);
+
+    if (result != 0) { errno = writeError; }
+    return result == 0;
+}
+
+BOOL TOFileSystemUUIDWriteToItemInDirectory(int directoryDescriptor, const char *name, TOFileSystemUUID *uuid)
+{
+    int fileDescriptor = TOFileSystemUUIDOpenItemInDirectory(directoryDescriptor, name);
+    if (fileDescriptor < 0) { return NO; }
+    return TOFileSystemUUIDWriteToOpenItem(fileDescriptor, uuid);
+}
+
+BOOL TOFileSystemUUIDWriteToItemInDirectoryWithID(int directoryDescriptor,
+                                                  const char *name,
+                                                  dev_t device,
+                                                  uint64_t inode,
+                                                  TOFileSystemUUID *uuid)
+{
+    // Make sure the name still belongs to the same item, and that it's something that can be opened
+    struct stat fileStat;
+    if (fstatat(directoryDescriptor, name, &fileStat, AT_SYMLINK_NOFOLLOW) != 0) { return NO; }
+    if (fileStat.st_dev != device || (uint64_t)fileStat.st_ino != inode) { errno = ESTALE; return NO; }
+    if (!S_ISREG(fileStat.st_mode) && !S_ISDIR(fileStat.st_mode)) { errno = EFTYPE; return NO; }
+
+    int fileDescriptor = TOFileSystemUUIDOpenItemInDirectory(directoryDescriptor, name);
+    if (fileDescriptor < 0) { return NO; }
+
+    // Check again now it's open, in case it was swapped for something else in between
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_dev != device || (uint64_t)fileStat.st_ino != inode) {
+        close(fileDescriptor);
+        errno = ESTALE;
+        return NO;
+    }
 
-    // Fetch the value from disk
-    getxattr(filePath, keyName, value, 36, 0, 0);
+    return TOFileSystemUUIDWriteToOpenItem(fileDescriptor, uuid);
+}
+
+@implementation NSURL (TOFileSystemUUID)
+
++ (void)to_setKeyNamePrefix:(NSString *)prefix
+{
+    static TOFileSystemLock lock;
+    static NSMutableDictionary<NSString *, NSData *> *keyNames;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        TOFileSystemLockInit(&lock);
+        keyNames = [NSMutableDictionary dictionary];
+    });
 
-    // Convert to a string, and return if successful
-    NSString *uuid = [[NSString alloc] initWithBytes:value length:36 encoding:NSUTF8StringEncoding];
-    if (uuid.length == 0) {
-        return nil;
+    // Each observer sets this when it starts, so it's usually the same prefix as last time
+    TOFileSystemLockLock(&lock);
+    NSData *keyName = keyNames[prefix];
+    if (keyName == nil) {
+        // Build the C string once per prefix, and keep it forever, since reads on other threads may still be using it
+        NSString *key = [NSString stringWithFormat:@"%@.fileSystemObserver.UUID", prefix];
+        const char *string = key.UTF8String;
+        keyName = [NSData dataWithBytes:string length:strlen(string) + 1];
+        keyNames[prefix] = keyName;
     }
-    
-    // Verify to make sure the provided value is a valid UUID string
-    NSString *uuidPattern = @"\\A[A-F0-9]{8}-[A-F0-9]{4}-[A-F0-9]{4}-[A-F0-9]{4}-[A-F0-9]{12}\\Z";
-    NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:uuidPattern
-                                                                           options:NSRegularExpressionCaseInsensitive
-                                                                             error:nil];
-    NSRange range = [regex rangeOfFirstMatchInString:uuid options:0 range:NSMakeRange(0, uuid.length)];
-    
-    // A valid regex was found.
-    if (range.location == NSNotFound) {
-        return nil;
+    if (TOFileSystemUUIDAttributeKeyName() != keyName.bytes) {
+        atomic_store_explicit(&kTOFileSystemAttributeKeyName, keyName.bytes, memory_order_release);
     }
+    TOFileSystemLockUnlock(&lock);
+}
 
-    return uuid;
+- (NSString *)to_fileSystemUUID
+{
+    return [self to_fileSystemUUIDValue].stringValue;
 }
 
 - (void)to_setFileSystemUUID:(NSString *)uuid
 {
-    if (uuid.length > 0 && uuid.length != 36) {
+    if (uuid.length > 0 && uuid.length != kTOFileSystemUUIDStringLength) {
         @throw [NSException exceptionWithName:NSInternalInconsistencyException
                                        reason:@"UUID must be 36 characters long!"
                                      userInfo:nil];
     }
 
-    // Determine the file path and destination key
+    // Determine the file path
     const char *filePath = [self.path fileSystemRepresentation];
-    const char *keyName = kTOFileSystemAttributeKey.UTF8String;
 
     // Convert the string to a C byte string
     const char *uuidString = [uuid cStringUsingEncoding:NSUTF8StringEncoding];
 
-    // Save it to this file
-    setxattr(filePath, keyName, uuidString, strlen(uuidString), 0, 0);
+    // Save it to this item (and not the destination, if it's a symbolic link)
+    setxattr(filePath, TOFileSystemUUIDAttributeKeyName(), uuidString, strlen(uuidString), 0, XATTR_NOFOLLOW);
 }
 
 - (NSString *)to_generateFileSystemUUID
 {
-    NSString *uuid = [NSUUID UUID].UUIDString;
-    [self to_setFileSystemUUID:uuid];
+    return [self to_generateFileSystemUUIDValue].stringValue;
+}
+
+- (nullable TOFileSystemUUID *)to_fileSystemUUIDValue
+{
+    TOFileSystemUUID *uuid = nil;
+    [self to_readFileSystemUUIDValue:&uuid];
+    return uuid;
+}
+
+- (TOFileSystemUUIDReadResult)to_readFileSystemUUIDValue:(TOFileSystemUUID **)uuid
+{
+    const char *filePath = [self.path fileSystemRepresentation];
+
+    // Allocate a buffer for the value (UUID values are always 36 characters)
+    char value[kTOFileSystemUUIDStringLength];
+
+    // Fetch the value from disk. (Symbolic links have their own UUID, just like they do when scanned.)
+    ssize_t length = getxattr(filePath, TOFileSystemUUIDAttributeKeyName(), value, sizeof(value), 0, XATTR_NOFOLLOW);
+    return TOFileSystemUUIDReadResultForValue(value, length, errno, uuid);
+}
+
+- (BOOL)to_setFileSystemUUIDValue:(TOFileSystemUUID *)uuid
+{
+    const char *filePath = [self.path fileSystemRepresentation];
+
+    // Encode the bytes back to their string form, which is what is saved on disk
+    char value[kTOFileSystemUUIDStringLength];
+    [uuid getCharacters:value];
+
+    return setxattr(filePath, TOFileSystemUUIDAttributeKeyName(), value, sizeof(value), 0, XATTR_NOFOLLOW) == 0;
+}
+
+- (TOFileSystemUUID *)to_generateFileSystemUUIDValue
+{
+    TOFileSystemUUID *uuid = [TOFileSystemUUID UUID];
+    [self to_setFileSystemUUIDValue:uuid];
     return uuid;
 }
 
@@ -24,6 +24,8 @@
 
 #import "TOFileSystemChanges.h"
 
+@class TOFileSystemUUID;
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface TOFileSystemChanges ()
@@ -35,16 +37,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setIsFullScan;
 
 /** Add a new discovered item to the list. */
-- (void)addDiscoveredItemWithUUID:(NSString *)uuid fileURL:(NSURL *)fileURL;
+- (void)addDiscoveredItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL;
 
 /** Add a new discovered item to the list. */
-- (void)addModifiedItemWithUUID:(NSString *)uuid fileURL:(NSURL *)fileURL;
+- (void)addModifiedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL;
 
 /** Add a new discovered item to the list. */
-- (void)addDeletedItemWithUUID:(NSString *)uuid fileURL:(NSURL *)fileURL;
+- (void)addDeletedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL;
 
 /** Add a new discovered item to the list. */
-- (void)addMovedItemWithUUID:(NSString *)uuid oldFileURL:(NSURL *)oldFileURL newFileURL:(NSURL *)newFileURL;
+- (void)addMovedItemWithUUID:(TOFileSystemUUID *)uuid oldFileURL:(NSURL *)oldFileURL newFileURL:(NSURL *)newFileURL;
 
 @end
 
@@ -21,6 +21,7 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import "TOFileSystemChanges.h"
+#import "TOFileSystemUUID.h"
 
 @interface TOFileSystemChanges ()
 
@@ -42,38 +43,38 @@
     return self;
 }
 
-- (void)addDiscoveredItemWithUUID:(NSString *)uuid fileURL:(NSURL *)fileURL
+- (void)addDiscoveredItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL
 {
     if (_discoveredItems == nil) {
         _discoveredItems = [NSMutableDictionary dictionary];
     }
-    _discoveredItems[uuid] = fileURL;
+    _discoveredItems[uuid.stringValue] = fileURL;
 }
 
-- (void)addModifiedItemWithUUID:(NSString *)uuid fileURL:(NSURL *)fileURL
+- (void)addModifiedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL
 {
     if (_modifiedItems == nil) {
         _modifiedItems = [NSMutableDictionary dictionary];
     }
-    _modifiedItems[uuid] = fileURL;
+    _modifiedItems[uuid.stringValue] = fileURL;
 }
 
-- (void)addDeletedItemWithUUID:(NSString *)uuid fileURL:(NSURL *)fileURL
+- (void)addDeletedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL
 {
     if (_deletedItems == nil) {
         _deletedItems = [NSMutableDictionary dictionary];
     }
-    _deletedItems[uuid] = fileURL;
+    _deletedItems[uuid.stringValue] = fileURL;
 }
 
-- (void)addMovedItemWithUUID:(NSString *)uuid
+- (void)addMovedItemWithUUID:(TOFileSystemUUID *)uuid
                   oldFileURL:(NSURL *)oldFileURL
                   newFileURL:(NSURL *)newFileURL
 {
     if (_movedItems == nil) {
         _movedItems = [NSMutableDictionary dictionary];
     }
-    _movedItems[uuid] = @[oldFileURL, newFileURL];
+    _movedItems[uuid.stringValue] = @[oldFileURL, newFileURL];
 }
 
 - (void)setIsFullScan
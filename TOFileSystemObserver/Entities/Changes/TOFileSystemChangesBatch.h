@@ -0,0 +1,88 @@
+//
+//  TOFileSystemChangesBatch.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class TOFileSystemObserver;
+@class TOFileSystemChanges;
+@class TOFileSystemUUID;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Collects the changes detected by a scan, so they can be broadcast together
+ in one `TOFileSystemChanges` object, and applied to any item lists on the main thread
+ as a single update per list.
+
+ Changes to the lists are recorded in the order they happen, so an item
+ that was added and then removed again inside the same batch cancels out.
+ This class isn't thread-safe, and should only be used from the scan operation queue.
+ */
+@interface TOFileSystemChangesBatch : NSObject
+
+/** The changes that will be broadcast to observers. */
+@property (nonatomic, readonly) TOFileSystemChanges *changes;
+
+/** The number of changes added to this batch. */
+@property (nonatomic, readonly) NSUInteger count;
+
+/** For each list (by its UUID), the items (UUID and URL) that need to be inserted into it. */
+@property (nonatomic, readonly) NSDictionary<TOFileSystemUUID *, NSDictionary<TOFileSystemUUID *, NSURL *> *> *insertedListItems;
+
+/** For each list (by its UUID), the UUIDs of the items that need to be removed from it. */
+@property (nonatomic, readonly) NSDictionary<TOFileSystemUUID *, NSSet<TOFileSystemUUID *> *> *removedListItems;
+
+/** The items that were deleted, mapped to the UUID of their parent directory (if there is one). */
+@property (nonatomic, readonly) NSDictionary<TOFileSystemUUID *, id> *deletedItems;
+
+/**
+ The directories (by UUID) that had items added, changed, moved or deleted inside them, so each one
+ only needs to be refreshed once per batch. Each is mapped to how many items it gained or lost,
+ or `NSNull` if that isn't known. (A full scan reports items that changed since the last scan,
+ rather than just now, so nothing is counted during one.)
+ */
+@property (nonatomic, readonly) NSDictionary<TOFileSystemUUID *, id> *parentItemChanges;
+
+/** Creates a new, empty batch. */
+- (instancetype)initWithFileSystemObserver:(TOFileSystemObserver *)fileSystemObserver isFullScan:(BOOL)isFullScan;
+
+/** Records a newly discovered item, and the list it should be inserted into. */
+- (void)addDiscoveredItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL parentUUID:(nullable TOFileSystemUUID *)parentUUID;
+
+/** Records an item that was modified. */
+- (void)addModifiedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL parentUUID:(nullable TOFileSystemUUID *)parentUUID;
+
+/** Records an item that moved from one list into another. */
+- (void)addMovedItemWithUUID:(TOFileSystemUUID *)uuid
+                  oldFileURL:(NSURL *)oldFileURL
+                  newFileURL:(NSURL *)newFileURL
+               oldParentUUID:(nullable TOFileSystemUUID *)oldParentUUID
+               newParentUUID:(nullable TOFileSystemUUID *)newParentUUID;
+
+/** Records an item that was deleted, so it can be removed from whichever list it is in. */
+- (void)addDeletedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL parentUUID:(nullable TOFileSystemUUID *)parentUUID;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,160 @@
+//
+//  TOFileSystemChangesBatch.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemChangesBatch.h"
+#import "TOFileSystemChanges+Private.h"
+
+@interface TOFileSystemChangesBatch ()
+
+@property (nonatomic, strong, readwrite) TOFileSystemChanges *changes;
+@property (nonatomic, assign, readwrite) NSUInteger count;
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, NSMutableDictionary<TOFileSystemUUID *, NSURL *> *> *insertions;
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, NSMutableSet<TOFileSystemUUID *> *> *removals;
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, id> *deletions;
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, id> *parentChanges;
+@property (nonatomic, assign) BOOL isFullScan;
+
+@end
+
+@implementation TOFileSystemChangesBatch
+
+- (instancetype)initWithFileSystemObserver:(TOFileSystemObserver *)fileSystemObserver isFullScan:(BOOL)isFullScan
+{
+    if (self = [super init]) {
+        _changes = [[TOFileSystemChanges alloc] initWithFileSystemObserver:fileSystemObserver];
+        if (isFullScan) { [_changes setIsFullScan]; }
+        _isFullScan = isFullScan;
+        _insertions = [NSMutableDictionary dictionary];
+        _removals = [NSMutableDictionary dictionary];
+        _deletions = [NSMutableDictionary dictionary];
+        _parentChanges = [NSMutableDictionary dictionary];
+    }
+
+    return self;
+}
+
+#pragma mark - Recording Changes -
+
+- (void)addDiscoveredItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL parentUUID:(TOFileSystemUUID *)parentUUID
+{
+    [self.changes addDiscoveredItemWithUUID:uuid fileURL:fileURL];
+    [self insertItemWithUUID:uuid fileURL:fileURL intoListWithUUID:parentUUID];
+    [self addChange:1 toParentWithUUID:parentUUID];
+    self.count++;
+}
+
+- (void)addModifiedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL parentUUID:(TOFileSystemUUID *)parentUUID
+{
+    [self.changes addModifiedItemWithUUID:uuid fileURL:fileURL];
+    [self addChange:0 toParentWithUUID:parentUUID];
+    self.count++;
+}
+
+- (void)addMovedItemWithUUID:(TOFileSystemUUID *)uuid
+                  oldFileURL:(NSURL *)oldFileURL
+                  newFileURL:(NSURL *)newFileURL
+               oldParentUUID:(TOFileSystemUUID *)oldParentUUID
+               newParentUUID:(TOFileSystemUUID *)newParentUUID
+{
+    [self.changes addMovedItemWithUUID:uuid oldFileURL:oldFileURL newFileURL:newFileURL];
+    [self removeItemWithUUID:uuid fromListWithUUID:oldParentUUID];
+    [self insertItemWithUUID:uuid fileURL:newFileURL intoListWithUUID:newParentUUID];
+    [self addChange:-1 toParentWithUUID:oldParentUUID];
+    [self addChange:1 toParentWithUUID:newParentUUID];
+    self.count++;
+}
+
+- (void)addDeletedItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL parentUUID:(TOFileSystemUUID *)parentUUID
+{
+    [self.changes addDeletedItemWithUUID:uuid fileURL:fileURL];
+
+    // If it was inserted earlier in this batch, it doesn't need to be inserted any more
+    for (NSMutableDictionary *items in self.insertions.allValues) {
+        [items removeObjectForKey:uuid];
+    }
+
+    // The list it's in will be looked up when the batch is applied
+    self.deletions[uuid] = parentUUID ?: [NSNull null];
+    [self addChange:-1 toParentWithUUID:parentUUID];
+    self.count++;
+}
+
+#pragma mark - Parent Updates -
+
+- (void)addChange:(NSInteger)change toParentWithUUID:(TOFileSystemUUID *)parentUUID
+{
+    if (parentUUID == nil) { return; }
+
+    // A full scan compares against what was found last time, not the current contents
+    // of the directory, so what it finds can't be counted towards the directory
+    id total = self.parentChanges[parentUUID];
+    if (self.isFullScan || total == [NSNull null]) {
+        self.parentChanges[parentUUID] = [NSNull null];
+        return;
+    }
+    self.parentChanges[parentUUID] = @([total integerValue] + change);
+}
+
+#pragma mark - List Updates -
+
+- (void)insertItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)fileURL intoListWithUUID:(TOFileSystemUUID *)listUUID
+{
+    // If it was deleted earlier in this batch, it has since reappeared
+    [self.deletions removeObjectForKey:uuid];
+    if (listUUID == nil) { return; }
+
+    NSMutableDictionary *items = self.insertions[listUUID];
+    if (items == nil) {
+        items = [NSMutableDictionary dictionary];
+        self.insertions[listUUID] = items;
+    }
+    items[uuid] = fileURL;
+}
+
+- (void)removeItemWithUUID:(TOFileSystemUUID *)uuid fromListWithUUID:(TOFileSystemUUID *)listUUID
+{
+    if (listUUID == nil) { return; }
+
+    // If it was inserted earlier in this batch, just cancel that out.
+    // (Since removals are applied before insertions, otherwise it would be re-added.)
+    NSMutableDictionary *items = self.insertions[listUUID];
+    if (items[uuid]) {
+        [items removeObjectForKey:uuid];
+        return;
+    }
+
+    NSMutableSet *uuids = self.removals[listUUID];
+    if (uuids == nil) {
+        uuids = [NSMutableSet set];
+        self.removals[listUUID] = uuids;
+    }
+    [uuids addObject:uuid];
+}
+
+#pragma mark - Accessors -
+
+- (NSDictionary *)insertedListItems { return self.insertions; }
+- (NSDictionary *)removedListItems { return self.removals; }
+- (NSDictionary *)deletedItems { return self.deletions; }
+- (NSDictionary *)parentItemChanges { return self.parentChanges; }
+
+@end
@@ -22,24 +22,48 @@
 
 #import <Foundation/Foundation.h>
 
+@class TOFileSystemUUID;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /**
  A thread-safe wrapper for the NSMapTable objects
  used to store re-usable instances of item and list
  objects.
+
+ The items are split between a number of map tables by UUID, each with its own lock,
+ so items can be looked up and created from any number of threads at once,
+ only waiting on each other when they land in the same map table.
  */
-@interface TOFileSystemItemMapTable : NSObject<NSFastEnumeration>
+@interface TOFileSystemItemMapTable : NSObject
 
 @property (nonatomic, readonly) NSInteger count;
 
-- (void)setItem:(id)object forUUID:(NSString *)uuid;
-- (id)itemForUUID:(NSString *)uuid;
-- (void)removeItemForUUID:(NSString *)uuid;
+- (void)setItem:(id)object forUUID:(TOFileSystemUUID *)uuid;
+- (nullable id)itemForUUID:(TOFileSystemUUID *)uuid;
+- (void)removeItemForUUID:(TOFileSystemUUID *)uuid;
+
+/**
+ Stores an item, unless another thread stored one for the same UUID first.
+ Returns whichever item ends up stored, so it can be used in place of the one provided.
+ */
+- (id)setItemIfAbsent:(id)object forUUID:(TOFileSystemUUID *)uuid;
+
+/** Looks up many items at once, taking each lock only once. Items that aren't stored are `NSNull` in the returned array. */
+- (NSArray *)itemsForUUIDs:(NSArray<TOFileSystemUUID *> *)uuids;
+
+/**
+ Stores many items at once (except for any that other threads stored first), taking each lock only once.
+ Returns whichever items ended up stored, in the same order as the UUIDs.
+ */
+- (NSArray *)setItemsIfAbsent:(NSArray *)objects forUUIDs:(NSArray<TOFileSystemUUID *> *)uuids;
+
+/** A snapshot of the UUIDs of every item currently stored. */
+- (NSArray<TOFileSystemUUID *> *)allUUIDs;
 
 /** Implementations for allowing dictionary style literal syntax. */
-- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull NSString *)key;
-- (nullable id)objectForKeyedSubscript:(NSString *)key;
+- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull TOFileSystemUUID *)key;
+- (nullable id)objectForKeyedSubscript:(TOFileSystemUUID *)key;
 
 @end
 
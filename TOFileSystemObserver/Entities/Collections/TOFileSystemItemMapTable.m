@@ -21,14 +21,18 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import "TOFileSystemItemMapTable.h"
+#import "TOFileSystemLock.h"
 
-@interface TOFileSystemItemMapTable ()
+/** The number of map tables the items are split between. */
+#define kTOFileSystemItemMapTableNumberOfStripes 16
 
-/** The map table to hold the items */
-@property (nonatomic, strong) NSMapTable *mapTable;
+@interface TOFileSystemItemMapTable () {
+    /** The lock guarding each map table */
+    TOFileSystemLock _locks[kTOFileSystemItemMapTableNumberOfStripes];
+}
 
-/** The dispatch queue for synchronzing reads */
-@property (nonatomic, strong) dispatch_queue_t dispatchQueue;
+/** The map tables to hold the items */
+@property (nonatomic, strong) NSArray<NSMapTable *> *mapTables;
 
 @end
 
@@ -37,67 +41,172 @@
 - (instancetype)init
 {
     if (self = [super init]) {
-        _mapTable = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory
-                                          valueOptions:NSPointerFunctionsWeakMemory];
-        _dispatchQueue = dispatch_queue_create("TOFileSystemObserver.itemMapTable", DISPATCH_QUEUE_CONCURRENT);
+        NSMutableArray *mapTables = [NSMutableArray arrayWithCapacity:kTOFileSystemItemMapTableNumberOfStripes];
+        for (NSInteger i = 0; i < kTOFileSystemItemMapTableNumberOfStripes; i++) {
+            [mapTables addObject:[NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory
+                                                       valueOptions:NSPointerFunctionsWeakMemory]];
+            TOFileSystemLockInit(&_locks[i]);
+        }
+        _mapTables = [NSArray arrayWithArray:mapTables];
     }
     
     return self;
 }
 
+- (void)dealloc
+{
+    for (NSInteger i = 0; i < kTOFileSystemItemMapTableNumberOfStripes; i++) {
+        TOFileSystemLockDestroy(&_locks[i]);
+    }
+}
+
+- (NSUInteger)stripeForUUID:(TOFileSystemUUID *)uuid
+{
+    // Mix the hash so every bit of it has a say in which stripe is picked
+    uint64_t hash = (uint64_t)uuid.hash;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (NSUInteger)(hash % kTOFileSystemItemMapTableNumberOfStripes);
+}
+
 - (NSInteger)count
 {
-    __block NSInteger count = 0;
-    dispatch_sync(self.dispatchQueue, ^{
-        count = self.mapTable.count;
-    });
+    NSInteger count = 0;
+    for (NSInteger i = 0; i < kTOFileSystemItemMapTableNumberOfStripes; i++) {
+        TOFileSystemLockLock(&_locks[i]);
+        count += self.mapTables[i].count;
+        TOFileSystemLockUnlock(&_locks[i]);
+    }
     
     return count;
 }
 
-- (void)setItem:(id)object forUUID:(NSString *)uuid
+- (void)setItem:(id)object forUUID:(TOFileSystemUUID *)uuid
 {
-    dispatch_barrier_async(self.dispatchQueue, ^{
-        [self.mapTable setObject:object forKey:uuid];
-    });
+    NSUInteger stripe = [self stripeForUUID:uuid];
+    TOFileSystemLockLock(&_locks[stripe]);
+    [self.mapTables[stripe] setObject:object forKey:uuid];
+    TOFileSystemLockUnlock(&_locks[stripe]);
 }
 
-- (id)itemForUUID:(NSString *)uuid
+- (id)setItemIfAbsent:(id)object forUUID:(TOFileSystemUUID *)uuid
 {
-    __block id item = nil;
-    dispatch_sync(self.dispatchQueue, ^{
-        @autoreleasepool {
-            item = [self.mapTable objectForKey:uuid];
-        }
-    });
+    NSUInteger stripe = [self stripeForUUID:uuid];
+    TOFileSystemLockLock(&_locks[stripe]);
+    NSMapTable *mapTable = self.mapTables[stripe];
+    id item = [mapTable objectForKey:uuid];
+    if (item == nil) {
+        [mapTable setObject:object forKey:uuid];
+        item = object;
+    }
+    TOFileSystemLockUnlock(&_locks[stripe]);
     
     return item;
 }
 
-- (void)removeItemForUUID:(NSString *)uuid
+- (nullable id)itemForUUID:(TOFileSystemUUID *)uuid
 {
-    dispatch_barrier_async(self.dispatchQueue, ^{
-        [self.mapTable removeObjectForKey:uuid];
-    });
+    if (uuid == nil) { return nil; }
+
+    NSUInteger stripe = [self stripeForUUID:uuid];
+    id item = nil;
+    @autoreleasepool {
+        TOFileSystemLockLock(&_locks[stripe]);
+        item = [self.mapTables[stripe] objectForKey:uuid];
+        TOFileSystemLockUnlock(&_locks[stripe]);
+    }
+    
+    return item;
 }
 
-- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull NSString *)key
+- (void)removeItemForUUID:(TOFileSystemUUID *)uuid
 {
-    [self setItem:object forUUID:key];
+    NSUInteger stripe = [self stripeForUUID:uuid];
+    TOFileSystemLockLock(&_locks[stripe]);
+    [self.mapTables[stripe] removeObjectForKey:uuid];
+    TOFileSystemLockUnlock(&_locks[stripe]);
 }
 
-- (nullable id)objectForKeyedSubscript:(NSString *)key
+- (void)performWithEachStripeOfUUIDs:(NSArray<TOFileSystemUUID *> *)uuids
+                          usingBlock:(void (^)(NSMapTable *mapTable, NSUInteger index))block
 {
-    return [self itemForUUID:key];
+    // Work out which stripe each UUID belongs to up front
+    NSUInteger count = uuids.count;
+    NSUInteger *stripes = malloc(sizeof(NSUInteger) * MAX(count, 1));
+    for (NSUInteger i = 0; i < count; i++) { stripes[i] = [self stripeForUUID:uuids[i]]; }
+
+    // Then visit each stripe with the lock held once, handling every UUID that belongs to it
+    for (NSUInteger stripe = 0; stripe < kTOFileSystemItemMapTableNumberOfStripes; stripe++) {
+        BOOL isLocked = NO;
+        for (NSUInteger i = 0; i < count; i++) {
+            if (stripes[i] != stripe) { continue; }
+            if (!isLocked) { TOFileSystemLockLock(&_locks[stripe]); isLocked = YES; }
+            block(self.mapTables[stripe], i);
+        }
+        if (isLocked) { TOFileSystemLockUnlock(&_locks[stripe]); }
+    }
+
+    free(stripes);
 }
 
-- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
-                                  objects:(id __unsafe_unretained _Nullable [_Nonnull])buffer
-                                    count:(NSUInteger)len
+- (NSArray *)itemsForUUIDs:(NSArray<TOFileSystemUUID *> *)uuids
 {
-    return [_mapTable countByEnumeratingWithState:state
-                                       objects:buffer
-                                         count:len];
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:uuids.count];
+    for (NSUInteger i = 0; i < uuids.count; i++) { [items addObject:[NSNull null]]; }
+
+    @autoreleasepool {
+        [self performWithEachStripeOfUUIDs:uuids usingBlock:^(NSMapTable *mapTable, NSUInteger index) {
+            id item = [mapTable objectForKey:uuids[index]];
+            if (item) { items[index] = item; }
+        }];
+    }
+
+    return items;
+}
+
+- (NSArray *)setItemsIfAbsent:(NSArray *)objects forUUIDs:(NSArray<TOFileSystemUUID *> *)uuids
+{
+    NSMutableArray *items = [NSMutableArray arrayWithArray:objects];
+
+    @autoreleasepool {
+        [self performWithEachStripeOfUUIDs:uuids usingBlock:^(NSMapTable *mapTable, NSUInteger index) {
+            id item = [mapTable objectForKey:uuids[index]];
+            if (item) {
+                items[index] = item;
+                return;
+            }
+            [mapTable setObject:objects[index] forKey:uuids[index]];
+        }];
+    }
+
+    return items;
+}
+
+- (NSArray<TOFileSystemUUID *> *)allUUIDs
+{
+    NSMutableArray *uuids = [NSMutableArray array];
+    for (NSInteger i = 0; i < kTOFileSystemItemMapTableNumberOfStripes; i++) {
+        TOFileSystemLockLock(&_locks[i]);
+        for (TOFileSystemUUID *uuid in self.mapTables[i]) { [uuids addObject:uuid]; }
+        TOFileSystemLockUnlock(&_locks[i]);
+    }
+
+    return uuids;
+}
+
+- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull TOFileSystemUUID *)key
+{
+    if (object == nil) {
+        [self removeItemForUUID:key];
+        return;
+    }
+    [self setItem:object forUUID:key];
+}
+
+- (nullable id)objectForKeyedSubscript:(TOFileSystemUUID *)key
+{
+    return [self itemForUUID:key];
 }
 
 @end
@@ -0,0 +1,112 @@
+//
+//  TOFileSystemItemMetadataTable.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+
+@class TOFileSystemUUID;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The type of item stored in a row of the table. */
+typedef NS_ENUM(uint8_t, TOFileSystemItemMetadataType) {
+    TOFileSystemItemMetadataTypeNone,       // The row is empty
+    TOFileSystemItemMetadataTypeFile,
+    TOFileSystemItemMetadataTypeDirectory
+};
+
+/**
+ Direct pointers to each column of the table, indexed by item identifier.
+ Times are stored as nanoseconds since 1970. Rows with a type of `None` are empty,
+ and the values in their other columns should be ignored.
+ */
+typedef struct {
+    NSUInteger numberOfRows;
+    const TOFileSystemItemMetadataType *types;
+    const int64_t *sizes;
+    const int64_t *creationTimes;
+    const int64_t *modificationTimes;
+    const int64_t *changeTimes;
+    const uint64_t *inodes;
+    const dev_t *devices;
+    const uint32_t *numberOfChildItems;
+} TOFileSystemItemMetadataColumns;
+
+/**
+ A thread-safe, compact table of the on-disk attributes of every item being observed.
+
+ Rather than storing a struct (or an object) per item, each attribute is stored
+ in its own contiguous column, and each item is given a dense integer identifier
+ to index them with. This keeps each row at 49 bytes (about 47MB per million items,
+ plus the UUID of each item, and the dictionary mapping UUIDs to identifiers),
+ and lets anything that needs one attribute of many items (eg, sorting or totalling sizes)
+ read through it in one pass, without creating any objects or touching the disk.
+
+ Identifiers of removed items are reused by the next items that are added.
+ */
+@interface TOFileSystemItemMetadataTable : NSObject
+
+/** The number of items stored in the table. */
+@property (nonatomic, readonly) NSUInteger count;
+
+/** The number of bytes currently allocated for the columns. */
+@property (nonatomic, readonly) size_t memoryUsage;
+
+/** The number of bytes each row takes across every column. */
++ (size_t)numberOfBytesPerRow;
+
+/** Stores the attributes of an item, returning the identifier of its row. (Or `NSNotFound` if the table couldn't grow to fit it.) */
+- (NSUInteger)setAttributes:(const TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid;
+
+/** Updates only the number of child items of a directory. Does nothing if the item isn't in the table. */
+- (void)setNumberOfChildItems:(uint32_t)numberOfChildItems forUUID:(TOFileSystemUUID *)uuid;
+
+/** Retrieves the attributes stored for an item. Returns NO if there are none. */
+- (BOOL)getAttributes:(TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid;
+
+/** Retrieves the attributes stored in a row. Returns NO if the row is empty. */
+- (BOOL)getAttributes:(TOFileSystemItemAttributes *)attributes forIdentifier:(NSUInteger)identifier;
+
+/** The identifier of the row storing an item, or `NSNotFound` if it isn't in the table. */
+- (NSUInteger)identifierForUUID:(TOFileSystemUUID *)uuid;
+
+/** The UUID of the item stored in a row, or nil if the row is empty. */
+- (nullable TOFileSystemUUID *)uuidForIdentifier:(NSUInteger)identifier;
+
+/** Removes the attributes of an item, freeing its row to be reused. */
+- (void)removeAttributesForUUID:(TOFileSystemUUID *)uuid;
+
+/** Removes every item. */
+- (void)removeAllAttributes;
+
+/**
+ Synchronously provides direct access to every column. The columns may only be read inside the
+ block, and the table can't be changed (by any thread) until it returns.
+ */
+- (void)performReadUsingBlock:(void (NS_NOESCAPE ^)(const TOFileSystemItemMetadataColumns *columns))block;
+
+/** The total size of every file in the table, added up straight from the size column. */
+- (long long)totalSizeOfFiles;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,336 @@
+//
+//  TOFileSystemItemMetadataTable.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemItemMetadataTable.h"
+#import "TOFileSystemUUID.h"
+
+#import <pthread.h>
+
+/** The number of rows allocated when the first item is added. */
+static const NSUInteger kTOFileSystemItemMetadataTableInitialCapacity = 1024;
+
+/** Converts a timestamp to the number of nanoseconds since 1970, as stored in the time columns. */
+static inline int64_t TOFileSystemNanosecondsFromTimespec(struct timespec time)
+{
+    return ((int64_t)time.tv_sec * (int64_t)NSEC_PER_SEC) + (int64_t)time.tv_nsec;
+}
+
+/** Converts a value from a time column back to a timestamp. */
+static inline struct timespec TOFileSystemTimespecFromNanoseconds(int64_t nanoseconds)
+{
+    struct timespec time;
+    time.tv_sec = (time_t)(nanoseconds / (int64_t)NSEC_PER_SEC);
+    time.tv_nsec = (long)(nanoseconds % (int64_t)NSEC_PER_SEC);
+
+    // Keep the nanoseconds positive for times before 1970
+    if (time.tv_nsec < 0) {
+        time.tv_nsec += NSEC_PER_SEC;
+        time.tv_sec -= 1;
+    }
+    return time;
+}
+
+@interface TOFileSystemItemMetadataTable () {
+    /** Held for reading while accessing the columns, and for writing while changing (or resizing) them. */
+    pthread_rwlock_t _lock;
+
+    /** The number of rows in use (including empty ones), and the number allocated. */
+    NSUInteger _numberOfRows;
+    NSUInteger _capacity;
+
+    /** The columns */
+    TOFileSystemItemMetadataType *_types;
+    int64_t *_sizes;
+    int64_t *_creationTimes;
+    int64_t *_modificationTimes;
+    int64_t *_changeTimes;
+    uint64_t *_inodes;
+    dev_t *_devices;
+    uint32_t *_numberOfChildItems;
+}
+
+/** The identifier of each item's row, by UUID. */
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, NSNumber *> *identifiers;
+
+/** The UUID of each row (or `NSNull` for empty rows), by identifier. */
+@property (nonatomic, strong) NSMutableArray *uuids;
+
+/** The identifiers of empty rows, to be reused before adding new ones. */
+@property (nonatomic, strong) NSMutableIndexSet *emptyIdentifiers;
+
+@end
+
+@implementation TOFileSystemItemMetadataTable
+
+#pragma mark - Class Lifecycle -
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _identifiers = [NSMutableDictionary dictionary];
+        _uuids = [NSMutableArray array];
+        _emptyIdentifiers = [NSMutableIndexSet indexSet];
+        pthread_rwlock_init(&_lock, NULL);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [self freeColumns];
+    pthread_rwlock_destroy(&_lock);
+}
+
++ (size_t)numberOfBytesPerRow
+{
+    return sizeof(TOFileSystemItemMetadataType) + (sizeof(int64_t) * 4) + sizeof(uint64_t)
+                + sizeof(dev_t) + sizeof(uint32_t);
+}
+
+#pragma mark - Column Management -
+
+/** Resizes a single column, leaving it untouched if there isn't enough memory. */
+static BOOL TOFileSystemItemMetadataTableResizeColumn(void **column, NSUInteger capacity, size_t elementSize)
+{
+    void *resizedColumn = realloc(*column, capacity * elementSize);
+    if (resizedColumn == NULL) { return NO; }
+    *column = resizedColumn;
+    return YES;
+}
+
+- (BOOL)resizeColumnsToCapacity:(NSUInteger)capacity
+{
+    // (Must be called while holding the lock for writing)
+    // If any column can't grow, the capacity stays the same. (Any columns that did grow are just larger than needed.)
+    BOOL success = TOFileSystemItemMetadataTableResizeColumn((void **)&_types, capacity, sizeof(TOFileSystemItemMetadataType)) &&
+                   TOFileSystemItemMetadataTableResizeColumn((void **)&_sizes, capacity, sizeof(int64_t)) &&
+                   TOFileSystemItemMetadataTableResizeColumn((void **)&_creationTimes, capacity, sizeof(int64_t)) &&
+                   TOFileSystemItemMetadataTableResizeColumn((void **)&_modificationTimes, capacity, sizeof(int64_t)) &&
+                   TOFileSystemItemMetadataTableResizeColumn((void **)&_changeTimes, capacity, sizeof(int64_t)) &&
+                   TOFileSystemItemMetadataTableResizeColumn((void **)&_inodes, capacity, sizeof(uint64_t)) &&
+                   TOFileSystemItemMetadataTableResizeColumn((void **)&_devices, capacity, sizeof(dev_t)) &&
+                   TOFileSystemItemMetadataTableResizeColumn((void **)&_numberOfChildItems, capacity, sizeof(uint32_t));
+    if (success) { _capacity = capacity; }
+    return success;
+}
+
+- (void)freeColumns
+{
+    free(_types); _types = NULL;
+    free(_sizes); _sizes = NULL;
+    free(_creationTimes); _creationTimes = NULL;
+    free(_modificationTimes); _modificationTimes = NULL;
+    free(_changeTimes); _changeTimes = NULL;
+    free(_inodes); _inodes = NULL;
+    free(_devices); _devices = NULL;
+    free(_numberOfChildItems); _numberOfChildItems = NULL;
+    _capacity = 0;
+    _numberOfRows = 0;
+}
+
+- (NSUInteger)identifierForNewRowWithUUID:(TOFileSystemUUID *)uuid
+{
+    // (Must be called while holding the lock for writing)
+    // Reuse an empty row if there is one, so the table stays dense
+    NSUInteger identifier = self.emptyIdentifiers.firstIndex;
+    if (identifier != NSNotFound) {
+        [self.emptyIdentifiers removeIndex:identifier];
+        self.uuids[identifier] = uuid;
+    }
+    else {
+        // Otherwise, add a row to the end, doubling the size of the columns when they're full
+        if (_numberOfRows == _capacity &&
+            ![self resizeColumnsToCapacity:MAX(_capacity * 2, kTOFileSystemItemMetadataTableInitialCapacity)]) {
+            return NSNotFound;
+        }
+        identifier = _numberOfRows++;
+        [self.uuids addObject:uuid];
+    }
+
+    self.identifiers[uuid] = @(identifier);
+    return identifier;
+}
+
+#pragma mark - Writing -
+
+- (NSUInteger)setAttributes:(const TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid
+{
+    pthread_rwlock_wrlock(&_lock);
+
+    NSNumber *number = self.identifiers[uuid];
+    NSUInteger identifier = number ? number.unsignedIntegerValue : [self identifierForNewRowWithUUID:uuid];
+    if (identifier == NSNotFound) {
+        pthread_rwlock_unlock(&_lock);
+        return NSNotFound;
+    }
+
+    _types[identifier] = attributes->isDirectory ? TOFileSystemItemMetadataTypeDirectory : TOFileSystemItemMetadataTypeFile;
+    _sizes[identifier] = attributes->size;
+    _creationTimes[identifier] = TOFileSystemNanosecondsFromTimespec(attributes->creationTime);
+    _modificationTimes[identifier] = TOFileSystemNanosecondsFromTimespec(attributes->modificationTime);
+    _changeTimes[identifier] = TOFileSystemNanosecondsFromTimespec(attributes->changeTime);
+    _inodes[identifier] = attributes->inode;
+    _devices[identifier] = attributes->device;
+    _numberOfChildItems[identifier] = attributes->numberOfChildItems;
+
+    pthread_rwlock_unlock(&_lock);
+    return identifier;
+}
+
+- (void)setNumberOfChildItems:(uint32_t)numberOfChildItems forUUID:(TOFileSystemUUID *)uuid
+{
+    pthread_rwlock_wrlock(&_lock);
+    NSNumber *number = self.identifiers[uuid];
+    if (number) { _numberOfChildItems[number.unsignedIntegerValue] = numberOfChildItems; }
+    pthread_rwlock_unlock(&_lock);
+}
+
+- (void)removeAttributesForUUID:(TOFileSystemUUID *)uuid
+{
+    pthread_rwlock_wrlock(&_lock);
+
+    NSNumber *number = self.identifiers[uuid];
+    if (number) {
+        NSUInteger identifier = number.unsignedIntegerValue;
+        _types[identifier] = TOFileSystemItemMetadataTypeNone;
+        self.uuids[identifier] = [NSNull null];
+        [self.identifiers removeObjectForKey:uuid];
+        [self.emptyIdentifiers addIndex:identifier];
+    }
+
+    pthread_rwlock_unlock(&_lock);
+}
+
+- (void)removeAllAttributes
+{
+    pthread_rwlock_wrlock(&_lock);
+    [self freeColumns];
+    [self.identifiers removeAllObjects];
+    [self.uuids removeAllObjects];
+    [self.emptyIdentifiers removeAllIndexes];
+    pthread_rwlock_unlock(&_lock);
+}
+
+#pragma mark - Reading -
+
+- (NSUInteger)count
+{
+    pthread_rwlock_rdlock(&_lock);
+    NSUInteger count = self.identifiers.count;
+    pthread_rwlock_unlock(&_lock);
+    return count;
+}
+
+- (size_t)memoryUsage
+{
+    pthread_rwlock_rdlock(&_lock);
+    size_t memoryUsage = _capacity * [TOFileSystemItemMetadataTable numberOfBytesPerRow];
+    pthread_rwlock_unlock(&_lock);
+    return memoryUsage;
+}
+
+- (NSUInteger)identifierForUUID:(TOFileSystemUUID *)uuid
+{
+    pthread_rwlock_rdlock(&_lock);
+    NSNumber *number = self.identifiers[uuid];
+    pthread_rwlock_unlock(&_lock);
+    return number ? number.unsignedIntegerValue : NSNotFound;
+}
+
+- (nullable TOFileSystemUUID *)uuidForIdentifier:(NSUInteger)identifier
+{
+    TOFileSystemUUID *uuid = nil;
+    pthread_rwlock_rdlock(&_lock);
+    if (identifier < _numberOfRows && _types[identifier] != TOFileSystemItemMetadataTypeNone) {
+        uuid = self.uuids[identifier];
+    }
+    pthread_rwlock_unlock(&_lock);
+    return uuid;
+}
+
+- (BOOL)getAttributes:(TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid
+{
+    if (uuid == nil) { return NO; }
+
+    pthread_rwlock_rdlock(&_lock);
+    NSNumber *number = self.identifiers[uuid];
+    if (number) { [self copyRowAtIndex:number.unsignedIntegerValue toAttributes:attributes]; }
+    pthread_rwlock_unlock(&_lock);
+    return (number != nil);
+}
+
+- (BOOL)getAttributes:(TOFileSystemItemAttributes *)attributes forIdentifier:(NSUInteger)identifier
+{
+    pthread_rwlock_rdlock(&_lock);
+    BOOL isRow = (identifier < _numberOfRows && _types[identifier] != TOFileSystemItemMetadataTypeNone);
+    if (isRow) { [self copyRowAtIndex:identifier toAttributes:attributes]; }
+    pthread_rwlock_unlock(&_lock);
+    return isRow;
+}
+
+- (void)copyRowAtIndex:(NSUInteger)identifier toAttributes:(TOFileSystemItemAttributes *)attributes
+{
+    // (Must be called while holding the lock)
+    attributes->isDirectory = (_types[identifier] == TOFileSystemItemMetadataTypeDirectory);
+    attributes->size = _sizes[identifier];
+    attributes->creationTime = TOFileSystemTimespecFromNanoseconds(_creationTimes[identifier]);
+    attributes->modificationTime = TOFileSystemTimespecFromNanoseconds(_modificationTimes[identifier]);
+    attributes->changeTime = TOFileSystemTimespecFromNanoseconds(_changeTimes[identifier]);
+    attributes->inode = _inodes[identifier];
+    attributes->device = _devices[identifier];
+    attributes->numberOfChildItems = _numberOfChildItems[identifier];
+}
+
+- (void)performReadUsingBlock:(void (NS_NOESCAPE ^)(const TOFileSystemItemMetadataColumns *))block
+{
+    pthread_rwlock_rdlock(&_lock);
+
+    TOFileSystemItemMetadataColumns columns = {
+        .numberOfRows = _numberOfRows,
+        .types = _types,
+        .sizes = _sizes,
+        .creationTimes = _creationTimes,
+        .modificationTimes = _modificationTimes,
+        .changeTimes = _changeTimes,
+        .inodes = _inodes,
+        .devices = _devices,
+        .numberOfChildItems = _numberOfChildItems
+    };
+    block(&columns);
+
+    pthread_rwlock_unlock(&_lock);
+}
+
+- (long long)totalSizeOfFiles
+{
+    __block long long totalSize = 0;
+    [self performReadUsingBlock:^(const TOFileSystemItemMetadataColumns *columns) {
+        for (NSUInteger i = 0; i < columns->numberOfRows; i++) {
+            if (columns->types[i] != TOFileSystemItemMetadataTypeFile) { continue; }
+            totalSize += columns->sizes[i];
+        }
+    }];
+    return totalSize;
+}
+
+@end
@@ -21,52 +21,104 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+#import "TOFileSystemUUID.h"
+#import "TOFileSystemItemMetadataTable.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 /**
  A thread-safe dictionary that stores the file paths
- to items using their on-disk UUID string as the key.
+ to items using their on-disk UUID as the key.
  
  This is used to store an in-memory graph of all of the files
  as they were at the start of the app session, so that any
  detected changes to the file system can be compared.
  
- The URLs are converted to and stored as relative URLs to
- save memory, and are converted back to absolute URLs when retrieved.
+ The URLs are stored as a tree of path components relative to the base URL,
+ so each directory's name is only stored once, no matter how many items are inside it.
+ Moving or renaming a directory only needs to update its own entry,
+ and every item inside it follows along. URLs are rebuilt when retrieved.
  */
 @interface TOFileSystemItemURLDictionary : NSObject
 
 /** The number of items currently in the dictionary. */
 @property (nonatomic, readonly) NSUInteger count;
 
+/** The attributes of every item that was stored with them, in one compact table. */
+@property (nonatomic, readonly) TOFileSystemItemMetadataTable *metadataTable;
+
 /** Create a new instance with the base URL that all items will be relatively saved against. */
 - (instancetype)initWithBaseURL:(NSURL *)baseURL;
 
-/** Adds an item URL to the dictionary. May be called from multiple threads. */
-- (void)setItemURL:(nullable NSURL *)itemURL forUUID:(nullable NSString *)uuid;
+/**
+ Adds an item URL to the dictionary. May be called from multiple threads.
+ If the item was already stored somewhere else, it's moved, along with every item inside it.
+ */
+- (void)setItemURL:(nullable NSURL *)itemURL forUUID:(nullable TOFileSystemUUID *)uuid;
+
+/** Adds many item URLs to the dictionary at once, applying them all as one change. */
+- (void)setItemURLs:(NSArray<NSURL *> *)itemURLs forUUIDs:(NSArray<TOFileSystemUUID *> *)uuids;
+
+/**
+ Adds an item URL to the dictionary, along with the attributes it had on disk when it was scanned.
+ May be called from multiple threads.
+ */
+- (void)setItemURL:(NSURL *)itemURL attributes:(const TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid;
+
+/** Retrieves the attributes last recorded for an item. Returns NO if none have been recorded. */
+- (BOOL)getAttributes:(TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid;
+
+/**
+ Looks up the UUID of an item by its file system ID, so that items that were moved or renamed can be
+ identified from their attributes alone. Only matches items whose recorded device, ID and creation time are the same.
+ */
+- (nullable TOFileSystemUUID *)uuidForItemWithAttributes:(const TOFileSystemItemAttributes *)attributes;
 
 /** Retrieves an item URL from the dictionary. May be called from multiple threads. */
-- (nullable NSURL *)itemURLForUUID:(nullable NSString *)uuid;
+- (nullable NSURL *)itemURLForUUID:(nullable TOFileSystemUUID *)uuid;
 
 /** Tries to retrieve a UUID value for a URL, if it exists */
-- (nullable NSString *)uuidForItemWithURL:(NSURL *)itemURL;
+- (nullable TOFileSystemUUID *)uuidForItemWithURL:(NSURL *)itemURL;
 
 /** Get all UUID keys. */
-- (nullable NSArray<NSString *> *)allUUIDs;
+- (nullable NSArray<TOFileSystemUUID *> *)allUUIDs;
 
 /** Get all URL objects. */
 - (nullable NSArray<NSURL *> *)allURLs;
 
-/** Delete an entry from the store. */
-- (void)removeItemURLForUUID:(NSString *)uuid;
+/** Finds every item stored directly inside the directory at the provided URL, mapped by UUID. */
+- (NSDictionary<TOFileSystemUUID *, NSURL *> *)itemURLsInDirectoryAtURL:(NSURL *)directoryURL;
+
+/** Loops through every item stored inside the directory at the provided URL, at any depth. */
+- (void)enumerateItemsInDirectoryAtURL:(NSURL *)directoryURL
+                            usingBlock:(void (^)(TOFileSystemUUID *uuid, NSURL *itemURL, BOOL *stop))block;
+
+/**
+ Synchronously loops through every item in the store, providing its path relative to the base URL,
+ and its attributes if any were recorded.
+ */
+- (void)enumerateItemsUsingBlock:(void (^)(TOFileSystemUUID *uuid, NSString *relativePath,
+                                           const TOFileSystemItemAttributes * _Nullable attributes))block;
+
+/** Converts an absolute item URL to the relative path format used to store it. */
+- (NSString *)relativePathForItemURL:(NSURL *)itemURL;
+
+/** Converts a relative path from the store back to an absolute item URL, without touching the disk. */
+- (NSURL *)itemURLForRelativePath:(NSString *)relativePath isDirectory:(BOOL)isDirectory;
+
+/** Delete an entry from the store. Any items stored inside it are kept. */
+- (void)removeItemURLForUUID:(TOFileSystemUUID *)uuid;
+
+/** Delete every item stored inside the directory at the provided URL, at any depth. */
+- (void)removeItemURLsInDirectoryAtURL:(NSURL *)directoryURL;
 
 /** Remove all items. */
 - (void)removeAllItems;
 
 /** Implementations for allowing dictionary style literal syntax. */
-- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull NSString *)key;
-- (nullable id)objectForKeyedSubscript:(NSString *)key;
+- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull TOFileSystemUUID *)key;
+- (nullable id)objectForKeyedSubscript:(TOFileSystemUUID *)key;
 
 - (instancetype)init NS_UNAVAILABLE;
 
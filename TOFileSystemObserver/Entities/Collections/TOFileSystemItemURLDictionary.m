@@ -21,20 +21,40 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemItemURLNode.h"
+#import "TOFileSystemItemMetadataTable.h"
+#import "TOFileSystemShardedDictionary.h"
 
-@interface TOFileSystemItemURLDictionary ()
+#import <pthread.h>
+
+@interface TOFileSystemItemURLDictionary () {
+    /**
+     Guards the tree of nodes. Writers take it exclusively, so each change is applied as a whole.
+     Readers collecting many items share it, but looking up a single item by UUID or URL never takes it.
+     */
+    pthread_rwlock_t _treeLock;
+}
 
 /** The base URL against which all other URLs are saved. */
 @property (nonatomic, strong) NSURL *baseURL;
 
-/** The dictionary that holds all of the item URLs */
-@property (nonatomic, strong) NSMutableDictionary<NSString *, NSURL*> *uuidItems;
+/** The path of the base URL, cached for converting item URLs to relative paths. */
+@property (nonatomic, copy) NSString *basePath;
+
+/** The node representing the base URL, which every other node is stored under. */
+@property (nonatomic, strong) TOFileSystemItemURLNode *rootNode;
+
+/** The node of every item, by UUID. */
+@property (nonatomic, strong) TOFileSystemShardedDictionary<TOFileSystemUUID *, TOFileSystemItemURLNode *> *uuidNodes;
+
+/** The on-disk attributes of each item, if they were supplied when it was stored */
+@property (nonatomic, strong, readwrite) TOFileSystemItemMetadataTable *metadataTable;
 
-/** A reverse dictionary tha stores UUIDs for URLs */
-@property (nonatomic, strong) NSMutableDictionary<NSURL*, NSString *> *urlItems;
+/** A reverse dictionary that stores UUIDs for the file system ID in each item's attributes */
+@property (nonatomic, strong) TOFileSystemShardedDictionary<NSNumber *, TOFileSystemUUID *> *inodeItems;
 
-/** The dispatch queue used to read and write safely to this dictionary. */
-@property (nonatomic, strong) dispatch_queue_t itemQueue;
+/** Every name in use by a node, so items with the same name share one copy of it. */
+@property (nonatomic, strong) NSHashTable<NSString *> *nodeNames;
 
 @end
 
@@ -46,102 +66,262 @@
 {
     if (self = [super init]) {
         _baseURL    = baseURL.URLByDeletingLastPathComponent.URLByStandardizingPath;
-        _uuidItems  = [NSMutableDictionary dictionary];
-        _urlItems   = [NSMutableDictionary dictionary];
-        _itemQueue  = dispatch_queue_create("TOFileSystemObserver.itemDictionaryQueue",
-                                                            DISPATCH_QUEUE_CONCURRENT);
+        _basePath   = _baseURL.path;
+        _rootNode   = [[TOFileSystemItemURLNode alloc] initWithName:@""];
+        _uuidNodes  = [[TOFileSystemShardedDictionary alloc] init];
+        _metadataTable = [[TOFileSystemItemMetadataTable alloc] init];
+        _inodeItems = [[TOFileSystemShardedDictionary alloc] init];
+        _nodeNames  = [NSHashTable weakObjectsHashTable];
+        pthread_rwlock_init(&_treeLock, NULL);
     }
     
     return self;
 }
 
+- (void)dealloc
+{
+    pthread_rwlock_destroy(&_treeLock);
+}
+
 - (NSUInteger)count
 {
-    __block NSInteger count = 0;
-    dispatch_sync(self.itemQueue, ^{
-        count = self.uuidItems.count;
-    });
-    
-    return count;
+    return self.uuidNodes.count;
 }
 
-- (void)setItemURL:(nullable NSURL *)itemURL forUUID:(nullable NSString *)uuid
+- (void)performWrite:(void (^)(void))block
 {
-    if (uuid.length == 0) { return; }
+    pthread_rwlock_wrlock(&_treeLock);
+    block();
+    pthread_rwlock_unlock(&_treeLock);
+}
+
+- (void)performRead:(void (^)(void))block
+{
+    pthread_rwlock_rdlock(&_treeLock);
+    block();
+    pthread_rwlock_unlock(&_treeLock);
+}
+
+#pragma mark - Storing Items -
+
+- (void)setItemURL:(nullable NSURL *)itemURL forUUID:(nullable TOFileSystemUUID *)uuid
+{
+    if (uuid == nil) { return; }
     
     // If the item is nil, remove it from the store
     if (itemURL == nil) {
-        dispatch_barrier_async(self.itemQueue, ^{
-            NSURL *url = self.uuidItems[uuid];
-            [self.urlItems removeObjectForKey:url];
-            [self.uuidItems removeObjectForKey:uuid];
-        });
+        [self removeItemURLForUUID:uuid];
         return;
     }
     
-    // Use dispatch barriers to block all reads when we mutate the dictionary
-    dispatch_barrier_async(self.itemQueue, ^{
-        // Purge the previously saved entries as they may be stale
-        NSURL *savedURL = self.uuidItems[uuid];
-        NSString *savedUUID = self.urlItems[savedURL];
-        if (savedUUID) { [self.uuidItems removeObjectForKey:savedUUID]; }
-        if (savedURL) { [self.urlItems removeObjectForKey:savedURL]; }
-        
-        // Remove the un-needed absolute path to save memory
-        NSURL *url = [self relativeURLForURL:itemURL];
-        self.uuidItems[uuid] = url;
-        self.urlItems[url] = uuid;
-    });
-}
-
-- (nullable NSURL *)itemURLForUUID:(NSString *)uuid
-{
-    if (uuid.length == 0) { return nil; }
-    
-    // Use dispatch barriers to allow asynchronouse reading
-    __block NSURL *itemURL = nil;
-    dispatch_sync(self.itemQueue, ^{
-        itemURL = self.uuidItems[uuid];
-    });
-    if (itemURL == nil) { return nil; }
+    NSString *relativePath = [self relativePathForItemURL:itemURL];
+    [self performWrite:^{
+        [self storeUUID:uuid atRelativePath:relativePath];
+    }];
+}
+
+- (void)setItemURLs:(NSArray<NSURL *> *)itemURLs forUUIDs:(NSArray<TOFileSystemUUID *> *)uuids
+{
+    // Convert the paths before taking the lock
+    NSMutableArray<NSString *> *relativePaths = [NSMutableArray arrayWithCapacity:itemURLs.count];
+    for (NSURL *itemURL in itemURLs) { [relativePaths addObject:[self relativePathForItemURL:itemURL]]; }
+
+    [self performWrite:^{
+        for (NSUInteger i = 0; i < uuids.count; i++) {
+            [self storeUUID:uuids[i] atRelativePath:relativePaths[i]];
+        }
+    }];
+}
+
+- (void)setItemURL:(NSURL *)itemURL attributes:(const TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid
+{
+    if (uuid == nil) { return; }
+
+    NSString *relativePath = [self relativePathForItemURL:itemURL];
+    NSNumber *inode = attributes->inode ? @(attributes->inode) : nil;
+    [self performWrite:^{
+        [self storeUUID:uuid atRelativePath:relativePath];
+        [self removeAttributesForUUID:uuid];
+        [self.metadataTable setAttributes:attributes forUUID:uuid];
+        if (inode) { self.inodeItems[inode] = uuid; }
+    }];
+}
+
+- (void)storeUUID:(TOFileSystemUUID *)uuid atRelativePath:(NSString *)relativePath
+{
+    // (Must be called inside a write block)
+    TOFileSystemItemURLNode *node = self.uuidNodes[uuid];
+    TOFileSystemItemURLNode *destinationNode = [self nodeForRelativePath:relativePath createIfMissing:YES];
+    if (node == destinationNode) { return; }
+
+    // If another item was stored at this location, this one replaces it
+    if (destinationNode.uuid) { [self removeUUIDFromNode:destinationNode]; }
+
+    // If this is a new item, or it was somehow moved inside itself, give it a node at the new location.
+    // (In the latter case, the old node stays as a placeholder for the items that were inside it.)
+    if (node == nil || [destinationNode isEqualToOrInsideNode:node]) {
+        if (node) {
+            node.uuid = nil;
+            [self pruneNode:node];
+        }
+        destinationNode.uuid = uuid;
+        self.uuidNodes[uuid] = destinationNode;
+        return;
+    }
+
+    // Otherwise, the item was moved or renamed. Move its node to the new location,
+    // which also moves every item inside it, without needing to visit any of them.
+    TOFileSystemItemURLNode *previousParentNode = node.parent;
+
+    // If the new location was holding items inside it, keep them. (Each is moved straight across,
+    // so walking up from any of them never finds it detached along the way.)
+    [destinationNode enumerateChildNodesUsingBlock:^(TOFileSystemItemURLNode *childNode) {
+        if ([node childNodeWithName:childNode.name] != nil) { return; }
+        [node addChildNode:childNode];
+    }];
+
+    // Swap the node in over the new location, taking it out of its previous directory
+    // and changing its name and parent in one step
+    [destinationNode.parent addChildNode:node withName:destinationNode.name];
+
+    // Clean up the directories it was moved out of, if they're no longer needed
+    [self pruneNode:previousParentNode];
+}
+
+- (void)removeUUIDFromNode:(TOFileSystemItemURLNode *)node
+{
+    // (Must be called inside a write block)
+    TOFileSystemUUID *uuid = node.uuid;
+    if (uuid == nil) { return; }
+
+    node.uuid = nil;
+    [self.uuidNodes removeObjectForKey:uuid];
+    [self removeAttributesForUUID:uuid];
+}
+
+- (void)removeAttributesForUUID:(TOFileSystemUUID *)uuid
+{
+    // (Must be called inside a write block)
+    TOFileSystemItemAttributes attributes;
+    if (![self.metadataTable getAttributes:&attributes forUUID:uuid]) { return; }
+
+    // Only remove the file system ID entry if it hasn't since been claimed by another item
+    NSNumber *inode = @(attributes.inode);
+    if ([self.inodeItems[inode] isEqualToUUID:uuid]) {
+        [self.inodeItems removeObjectForKey:inode];
+    }
+    [self.metadataTable removeAttributesForUUID:uuid];
+}
+
+- (void)removeItemURLForUUID:(TOFileSystemUUID *)uuid
+{
+    if (uuid == nil) { return; }
     
-    return [self.baseURL URLByAppendingPathComponent:itemURL.path].URLByStandardizingPath;
+    [self performWrite:^{
+        TOFileSystemItemURLNode *node = self.uuidNodes[uuid];
+        if (node == nil) { return; }
+
+        // If there are items inside it, the node is kept so they stay where they are
+        [self removeUUIDFromNode:node];
+        [self pruneNode:node];
+    }];
+}
+
+- (void)removeItemURLsInDirectoryAtURL:(NSURL *)directoryURL
+{
+    NSString *relativePath = [self relativePathForItemURL:directoryURL];
+    [self performWrite:^{
+        TOFileSystemItemURLNode *directoryNode = [self nodeForRelativePath:relativePath createIfMissing:NO];
+        if (directoryNode == nil) { return; }
+
+        // Detach everything inside the directory in one go, then clear out the UUIDs that were in it
+        NSMutableArray<TOFileSystemItemURLNode *> *nodes = [[directoryNode removeAllChildNodes] mutableCopy];
+        while (nodes.count > 0) {
+            TOFileSystemItemURLNode *node = nodes.lastObject;
+            [nodes removeLastObject];
+            [self removeUUIDFromNode:node];
+            [nodes addObjectsFromArray:[node removeAllChildNodes]];
+        }
+
+        [self pruneNode:directoryNode];
+    }];
+}
+
+- (void)removeAllItems
+{
+    [self performWrite:^{
+        [self.rootNode removeAllChildNodes];
+        [self.uuidNodes removeAllObjects];
+        [self.metadataTable removeAllAttributes];
+        [self.inodeItems removeAllObjects];
+    }];
+}
+
+- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull TOFileSystemUUID *)key
+{
+    [self setItemURL:object forUUID:key];
 }
 
-- (nullable NSString *)uuidForItemWithURL:(NSURL *)itemURL
+#pragma mark - Retrieving Items -
+
+- (nullable TOFileSystemUUID *)uuidForItemWithAttributes:(const TOFileSystemItemAttributes *)attributes
 {
-    // Convert the item URL to relative
-    NSURL *url = [self relativeURLForURL:itemURL];
+    if (attributes->inode == 0) { return nil; }
+
+    TOFileSystemUUID *uuid = self.inodeItems[@(attributes->inode)];
+    if (uuid == nil) { return nil; }
+
+    // Make sure it's the same item, and not a new one that was given a reused ID
+    TOFileSystemItemAttributes savedAttributes;
+    if (![self.metadataTable getAttributes:&savedAttributes forUUID:uuid]) { return nil; }
+    if (!TOFileSystemItemAttributesAreSameItem(&savedAttributes, attributes)) { return nil; }
+
+    return uuid;
+}
+
+- (BOOL)getAttributes:(TOFileSystemItemAttributes *)attributes forUUID:(TOFileSystemUUID *)uuid
+{
+    if (uuid == nil) { return NO; }
+    return [self.metadataTable getAttributes:attributes forUUID:uuid];
+}
+
+- (nullable NSURL *)itemURLForUUID:(TOFileSystemUUID *)uuid
+{
+    if (uuid == nil) { return nil; }
     
-    // Look up the URL in the dictionary
-    __block NSString *uuid = nil;
-    dispatch_sync(self.itemQueue, ^{
-        uuid = self.urlItems[url];
-    });
+    // Walk up from the item's node to build its path. (This doesn't need the lock, since
+    // each node's name and parent are swapped together in one step when it's moved.)
+    TOFileSystemItemURLNode *node = self.uuidNodes[uuid];
+    NSString *relativePath = [self relativePathForNode:node];
+    if (relativePath == nil) { return nil; }
     
-    return uuid;
+    return [self.baseURL URLByAppendingPathComponent:relativePath].URLByStandardizingPath;
+}
+
+- (nullable TOFileSystemUUID *)uuidForItemWithURL:(NSURL *)itemURL
+{
+    // (This doesn't need the lock either, since each node's children are swapped in as an immutable copy)
+    NSString *relativePath = [self relativePathForItemURL:itemURL];
+    return [self nodeForRelativePath:relativePath createIfMissing:NO].uuid;
 }
 
-- (nullable NSArray<NSString *> *)allUUIDs
+- (nullable id)objectForKeyedSubscript:(TOFileSystemUUID *)key
 {
-    __block NSArray *uuids = nil;
-    dispatch_sync(self.itemQueue, ^{
-        uuids = self.uuidItems.allKeys;
-    });
-    return uuids;
+    return [self itemURLForUUID:key];
+}
+
+- (nullable NSArray<TOFileSystemUUID *> *)allUUIDs
+{
+    return self.uuidNodes.allKeys;
 }
 
 - (nullable NSArray<NSURL *> *)allURLs
 {
     // Loop through each item in the store, and restore its URL
-    __block NSMutableArray *array = [NSMutableArray array];
-    dispatch_sync(self.itemQueue, ^{
-        for (NSString *uuid in self.uuidItems) {
-            NSString *path = self.uuidItems[uuid].path;
-            NSURL *url = [self.baseURL URLByAppendingPathComponent:path];
-            [array addObject:url.URLByStandardizingPath];
-        }
-    });
+    NSMutableArray *array = [NSMutableArray array];
+    [self enumerateItemsInNode:self.rootNode relativePath:@"" usingBlock:^(TOFileSystemUUID *uuid, NSString *relativePath) {
+        [array addObject:[self.baseURL URLByAppendingPathComponent:relativePath].URLByStandardizingPath];
+    }];
     
     // If the array was empty, return nil
     if (array.count == 0) { return nil; }
@@ -150,54 +330,175 @@
     return [NSArray arrayWithArray:array];
 }
 
-- (void)setObject:(nullable id)object forKeyedSubscript:(nonnull NSString *)key
+- (NSDictionary<TOFileSystemUUID *, NSURL *> *)itemURLsInDirectoryAtURL:(NSURL *)directoryURL
 {
-    [self setItemURL:object forUUID:key];
+    NSString *directoryPath = [self relativePathForItemURL:directoryURL];
+
+    // Only the directory's own node needs to be visited, rather than every item in the store
+    NSMutableDictionary *relativePaths = [NSMutableDictionary dictionary];
+    [self performRead:^{
+        TOFileSystemItemURLNode *directoryNode = [self nodeForRelativePath:directoryPath createIfMissing:NO];
+        [directoryNode enumerateChildNodesUsingBlock:^(TOFileSystemItemURLNode *node) {
+            TOFileSystemUUID *uuid = node.uuid;
+            if (uuid) { relativePaths[uuid] = [self relativePath:directoryPath byAppendingName:node.name]; }
+        }];
+    }];
+
+    NSMutableDictionary *items = [NSMutableDictionary dictionaryWithCapacity:relativePaths.count];
+    [relativePaths enumerateKeysAndObjectsUsingBlock:^(TOFileSystemUUID *uuid, NSString *relativePath, BOOL *stop) {
+        items[uuid] = [self.baseURL URLByAppendingPathComponent:relativePath].URLByStandardizingPath;
+    }];
+
+    return items;
 }
 
-- (void)removeItemURLForUUID:(NSString *)uuid
+- (void)enumerateItemsInDirectoryAtURL:(NSURL *)directoryURL
+                            usingBlock:(void (^)(TOFileSystemUUID *, NSURL *, BOOL *))block
 {
-    if (uuid == nil) { return; }
-    
-    dispatch_barrier_async(self.itemQueue, ^{
-        NSURL *url = self.uuidItems[uuid];
-        if (url == nil) { return; }
-        [self.urlItems removeObjectForKey:url];
-        [self.uuidItems removeObjectForKey:uuid];
-    });
+    NSString *directoryPath = [self relativePathForItemURL:directoryURL];
+
+    // Capture the items while holding the lock, and then call the block once it's released
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray array];
+    NSMutableArray<NSString *> *relativePaths = [NSMutableArray array];
+    [self performRead:^{
+        TOFileSystemItemURLNode *directoryNode = [self nodeForRelativePath:directoryPath createIfMissing:NO];
+        if (directoryNode == nil) { return; }
+        [self collectItemsInNode:directoryNode relativePath:directoryPath uuids:uuids relativePaths:relativePaths];
+    }];
+
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < uuids.count && !stop; i++) {
+        NSURL *itemURL = [self.baseURL URLByAppendingPathComponent:relativePaths[i]].URLByStandardizingPath;
+        block(uuids[i], itemURL, &stop);
+    }
 }
 
-- (void)removeAllItems
+- (void)enumerateItemsUsingBlock:(void (^)(TOFileSystemUUID *, NSString *, const TOFileSystemItemAttributes * _Nullable))block
 {
-    dispatch_barrier_async(self.itemQueue, ^{
-        [self.urlItems removeAllObjects];
-        [self.uuidItems removeAllObjects];
-    });
+    TOFileSystemItemAttributes attributes;
+    [self enumerateItemsInNode:self.rootNode relativePath:@"" usingBlock:^(TOFileSystemUUID *uuid, NSString *relativePath) {
+        BOOL hasAttributes = [self.metadataTable getAttributes:&attributes forUUID:uuid];
+        block(uuid, relativePath, hasAttributes ? &attributes : NULL);
+    }];
 }
 
-- (nullable id)objectForKeyedSubscript:(NSString *)key
+#pragma mark - Tree Traversal -
+
+- (nullable TOFileSystemItemURLNode *)nodeForRelativePath:(NSString *)relativePath createIfMissing:(BOOL)createIfMissing
 {
-    return [self itemURLForUUID:key];
+    // (Must be called inside a write block if creating nodes)
+    TOFileSystemItemURLNode *node = self.rootNode;
+    for (NSString *name in [relativePath componentsSeparatedByString:@"/"]) {
+        if (name.length == 0) { continue; }
+
+        TOFileSystemItemURLNode *childNode = [node childNodeWithName:name];
+        if (childNode == nil) {
+            if (!createIfMissing) { return nil; }
+            childNode = [[TOFileSystemItemURLNode alloc] initWithName:[self sharedNodeName:name]];
+            [node addChildNode:childNode];
+        }
+        node = childNode;
+    }
+
+    return node;
+}
+
+- (nullable NSString *)relativePathForNode:(nullable TOFileSystemItemURLNode *)node
+{
+    // If we don't reach the root, the node has been removed from the tree
+    return [node relativePathFromNode:self.rootNode];
+}
+
+- (NSString *)relativePath:(NSString *)relativePath byAppendingName:(NSString *)name
+{
+    if ([relativePath isEqualToString:@"/"]) { relativePath = @""; }
+    return [NSString stringWithFormat:@"%@/%@", relativePath, name];
+}
+
+- (void)collectItemsInNode:(TOFileSystemItemURLNode *)node
+              relativePath:(NSString *)relativePath
+                     uuids:(NSMutableArray<TOFileSystemUUID *> *)uuids
+             relativePaths:(NSMutableArray<NSString *> *)relativePaths
+{
+    // (Must be called inside a read block)
+    [node enumerateChildNodesUsingBlock:^(TOFileSystemItemURLNode *childNode) {
+        NSString *childPath = [self relativePath:relativePath byAppendingName:childNode.name];
+        TOFileSystemUUID *uuid = childNode.uuid;
+        if (uuid) {
+            [uuids addObject:uuid];
+            [relativePaths addObject:childPath];
+        }
+        [self collectItemsInNode:childNode relativePath:childPath uuids:uuids relativePaths:relativePaths];
+    }];
+}
+
+- (void)enumerateItemsInNode:(TOFileSystemItemURLNode *)node
+                relativePath:(NSString *)relativePath
+                  usingBlock:(void (^)(TOFileSystemUUID *uuid, NSString *relativePath))block
+{
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray array];
+    NSMutableArray<NSString *> *relativePaths = [NSMutableArray array];
+    [self performRead:^{
+        [self collectItemsInNode:node relativePath:relativePath uuids:uuids relativePaths:relativePaths];
+    }];
+
+    for (NSUInteger i = 0; i < uuids.count; i++) {
+        block(uuids[i], relativePaths[i]);
+    }
+}
+
+- (void)pruneNode:(nullable TOFileSystemItemURLNode *)node
+{
+    // (Must be called inside a write block)
+    // Remove nodes that no longer hold an item, or anything inside them, up until the root
+    while (node && node != self.rootNode && node.uuid == nil && node.numberOfChildren == 0) {
+        TOFileSystemItemURLNode *parentNode = node.parent;
+        [parentNode removeChildNode:node];
+        node = parentNode;
+    }
+}
+
+- (NSString *)sharedNodeName:(NSString *)name
+{
+    // (Must be called inside a write block)
+    NSString *sharedName = [self.nodeNames member:name];
+    if (sharedName) { return sharedName; }
+
+    sharedName = [name copy];
+    [self.nodeNames addObject:sharedName];
+    return sharedName;
 }
 
 #pragma mark - URL Conversion -
 
-- (NSURL *)relativeURLForURL:(NSURL *)url
+- (NSString *)relativePathForItemURL:(NSURL *)itemURL
+{
+    // Trim the base path off the front, as long as it's a whole directory name
+    NSString *basePath = self.basePath;
+    NSString *itemPath = itemURL.URLByStandardizingPath.path;
+    NSUInteger baseLength = basePath.length;
+    if (baseLength > 1 && [itemPath hasPrefix:basePath]
+        && (itemPath.length == baseLength || [itemPath characterAtIndex:baseLength] == '/')) {
+        itemPath = [itemPath substringFromIndex:baseLength];
+    }
+    
+    return itemPath.length > 0 ? itemPath : @"/";
+}
+
+- (NSURL *)itemURLForRelativePath:(NSString *)relativePath isDirectory:(BOOL)isDirectory
 {
-    NSString *basePath = self.baseURL.path;
-    NSString *itemPath = url.URLByStandardizingPath.path;
-    NSString *relativePath = [itemPath stringByReplacingOccurrencesOfString:basePath withString:@""];
-    return [NSURL fileURLWithPath:relativePath];
+    NSURL *url = [self.baseURL URLByAppendingPathComponent:relativePath isDirectory:isDirectory];
+    return url.URLByStandardizingPath;
 }
 
 #pragma mark - Debugging -
 
 - (NSString *)description
 {
-    NSString *descriptionString = @"";
-    for (NSString *key in self.uuidItems.allKeys) {
-        descriptionString = [descriptionString stringByAppendingFormat:@"%@ - %@\n", key, self.uuidItems[key]];
-    }
+    NSMutableString *descriptionString = [NSMutableString string];
+    [self enumerateItemsInNode:self.rootNode relativePath:@"" usingBlock:^(TOFileSystemUUID *uuid, NSString *relativePath) {
+        [descriptionString appendFormat:@"%@ - %@\n", uuid, relativePath];
+    }];
     
     return descriptionString;
 }
@@ -0,0 +1,88 @@
+//
+//  TOFileSystemItemURLNode.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "TOFileSystemUUID.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A single path component in the tree of items stored by `TOFileSystemItemURLDictionary`.
+
+ Each node only stores its own name, and a link back up to the directory that contains it,
+ so an item's full path is assembled by walking up to the root. This means that renaming
+ or moving a directory only needs to update its own node, and every item inside it follows along.
+
+ A node's name and parent are published together as one immutable pair, and its children as an
+ immutable snapshot, each swapped in atomically. So they may be read from any thread without
+ the owning dictionary's lock, and walking up from a node that's being moved always finds
+ either its old location or its new one. They may only be changed while holding the owning dictionary's lock.
+ */
+@interface TOFileSystemItemURLNode : NSObject
+
+/** The name of the item inside its parent directory. */
+@property (atomic, readonly) NSString *name;
+
+/** The node of the directory containing this item. Nil for the root node, or once this node has been removed. */
+@property (atomic, weak, readonly, nullable) TOFileSystemItemURLNode *parent;
+
+/** The UUID of the item. Nil if this node is only there to hold items inside it that are being tracked. */
+@property (atomic, strong, nullable) TOFileSystemUUID *uuid;
+
+/** The number of nodes directly inside this one. */
+@property (nonatomic, readonly) NSUInteger numberOfChildren;
+
+/** Create a new, detached node with the provided name. */
+- (instancetype)initWithName:(NSString *)name;
+
+/** Returns the node directly inside this one with the provided name. */
+- (nullable TOFileSystemItemURLNode *)childNodeWithName:(NSString *)name;
+
+/** Adds a node inside this one, under its current name, replacing any with the same name. */
+- (void)addChildNode:(TOFileSystemItemURLNode *)node;
+
+/**
+ Adds a node inside this one under a new name, replacing any with the same name. If the node is
+ currently inside another one, it's moved from there, changing its name and parent in one step.
+ */
+- (void)addChildNode:(TOFileSystemItemURLNode *)node withName:(NSString *)name;
+
+/** Removes a node from inside this one, if it's still stored here. */
+- (void)removeChildNode:(TOFileSystemItemURLNode *)node;
+
+/** Detaches every node inside this one, and returns them. */
+- (NSArray<TOFileSystemItemURLNode *> *)removeAllChildNodes;
+
+/** Loops through every node directly inside this one. */
+- (void)enumerateChildNodesUsingBlock:(void (^)(TOFileSystemItemURLNode *node))block;
+
+/** Builds the path of this node from the provided ancestor node. Returns nil if it's not inside that node. */
+- (nullable NSString *)relativePathFromNode:(TOFileSystemItemURLNode *)ancestorNode;
+
+/** Returns YES if this node is the provided node, or is stored somewhere inside it. */
+- (BOOL)isEqualToOrInsideNode:(TOFileSystemItemURLNode *)node;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,193 @@
+//
+//  TOFileSystemItemURLNode.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemItemURLNode.h"
+
+/** Where a node is stored. Immutable, so a node's name and parent can be swapped together in one step. */
+@interface TOFileSystemItemURLNodeLocation : NSObject
+
+/** The name of the node inside its parent. */
+@property (nonatomic, readonly) NSString *name;
+
+/** The node the node is stored inside. Nil if it hasn't been added to one, or has been removed. */
+@property (nonatomic, weak, readonly, nullable) TOFileSystemItemURLNode *parent;
+
+- (instancetype)initWithName:(NSString *)name parent:(nullable TOFileSystemItemURLNode *)parent;
+
+@end
+
+@implementation TOFileSystemItemURLNodeLocation
+
+- (instancetype)initWithName:(NSString *)name parent:(nullable TOFileSystemItemURLNode *)parent
+{
+    if (self = [super init]) {
+        _name = name;
+        _parent = parent;
+    }
+
+    return self;
+}
+
+@end
+
+// -------------------------------------------------------------------------
+
+@interface TOFileSystemItemURLNode ()
+
+/** The name and parent of this node, replaced as a whole whenever either changes. */
+@property (atomic, strong) TOFileSystemItemURLNodeLocation *location;
+
+/**
+ The nodes inside this one, by name. Replaced with a new copy whenever one is added or removed,
+ so readers can use it without a lock. (Only created once a node is added, since most items are files)
+ */
+@property (atomic, copy, nullable) NSDictionary<NSString *, TOFileSystemItemURLNode *> *children;
+
+@end
+
+@implementation TOFileSystemItemURLNode
+
+- (instancetype)initWithName:(NSString *)name
+{
+    if (self = [super init]) {
+        _location = [[TOFileSystemItemURLNodeLocation alloc] initWithName:name parent:nil];
+    }
+
+    return self;
+}
+
+- (NSString *)name
+{
+    return self.location.name;
+}
+
+- (nullable TOFileSystemItemURLNode *)parent
+{
+    return self.location.parent;
+}
+
+- (NSUInteger)numberOfChildren
+{
+    return self.children.count;
+}
+
+- (nullable TOFileSystemItemURLNode *)childNodeWithName:(NSString *)name
+{
+    return self.children[name];
+}
+
+- (void)addChildNode:(TOFileSystemItemURLNode *)node
+{
+    [self addChildNode:node withName:node.name];
+}
+
+- (void)addChildNode:(TOFileSystemItemURLNode *)node withName:(NSString *)name
+{
+    TOFileSystemItemURLNodeLocation *location = node.location;
+    if (location.parent == self && [location.name isEqualToString:name]) { return; }
+
+    NSMutableDictionary *children = [self.children mutableCopy] ?: [NSMutableDictionary dictionary];
+
+    // Take the node out of the one it's in now, but leave its location as it is,
+    // so readers walking up from it keep seeing the old location until the new one is set.
+    // (If it's only being renamed, both names are swapped in the same copy.)
+    TOFileSystemItemURLNode *previousParent = location.parent;
+    if (previousParent == self) {
+        if (children[location.name] == node) { [children removeObjectForKey:location.name]; }
+    }
+    else if (previousParent.children[location.name] == node) {
+        NSMutableDictionary *previousChildren = [previousParent.children mutableCopy];
+        [previousChildren removeObjectForKey:location.name];
+        previousParent.children = previousChildren.count ? previousChildren : nil;
+    }
+
+    // Detach any node that was previously stored under this name
+    [children[name] detachFromParent];
+
+    children[name] = node;
+    self.children = children;
+    node.location = [[TOFileSystemItemURLNodeLocation alloc] initWithName:name parent:self];
+}
+
+- (void)removeChildNode:(TOFileSystemItemURLNode *)node
+{
+    // Make sure the node wasn't already replaced by another with the same name
+    NSString *name = node.name;
+    if (self.children[name] != node) { return; }
+
+    NSMutableDictionary *children = [self.children mutableCopy];
+    [children removeObjectForKey:name];
+    self.children = children.count ? children : nil;
+    [node detachFromParent];
+}
+
+- (NSArray<TOFileSystemItemURLNode *> *)removeAllChildNodes
+{
+    NSArray *nodes = self.children.allValues ?: @[];
+    self.children = nil;
+    for (TOFileSystemItemURLNode *node in nodes) { [node detachFromParent]; }
+    return nodes;
+}
+
+- (void)detachFromParent
+{
+    self.location = [[TOFileSystemItemURLNodeLocation alloc] initWithName:self.name parent:nil];
+}
+
+- (void)enumerateChildNodesUsingBlock:(void (^)(TOFileSystemItemURLNode *))block
+{
+    for (TOFileSystemItemURLNode *node in self.children.objectEnumerator) {
+        block(node);
+    }
+}
+
+- (nullable NSString *)relativePathFromNode:(TOFileSystemItemURLNode *)ancestorNode
+{
+    // Collect each name on the way up, reading each node's name and parent together
+    NSMutableArray<NSString *> *names = [NSMutableArray array];
+    TOFileSystemItemURLNode *node = self;
+    while (node != ancestorNode) {
+        // If we didn't reach the ancestor, the node isn't inside it (or has been removed)
+        if (node == nil) { return nil; }
+        TOFileSystemItemURLNodeLocation *location = node.location;
+        [names addObject:location.name];
+        node = location.parent;
+    }
+
+    NSMutableString *relativePath = [NSMutableString string];
+    for (NSString *name in names.reverseObjectEnumerator) {
+        [relativePath appendFormat:@"/%@", name];
+    }
+    return relativePath;
+}
+
+- (BOOL)isEqualToOrInsideNode:(TOFileSystemItemURLNode *)node
+{
+    TOFileSystemItemURLNode *ancestor = self;
+    while (ancestor) {
+        if (ancestor == node) { return YES; }
+        ancestor = ancestor.parent;
+    }
+    return NO;
+}
+
+@end
@@ -0,0 +1,82 @@
+//
+//  TOFileSystemOrderStatisticTree.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A sorted collection of objects that can also be accessed by index.
+
+ Objects are stored in a balanced binary search tree (a treap), where each node
+ also records how many objects are beneath it. This means reading an object at an index,
+ finding the index of an object, and inserting or removing an object each take O(log n),
+ rather than needing to search or shift an array.
+
+ Objects are looked up by identity, not equality, and each object may only be stored once.
+ Objects the comparator considers equal keep the order they were inserted in.
+ This class isn't thread-safe.
+ */
+@interface TOFileSystemOrderStatisticTree<ObjectType> : NSObject
+
+/** The comparator that determines the order of the objects. Setting a new one re-sorts every object. */
+@property (nonatomic, copy) NSComparator comparator;
+
+/** The number of objects in the tree. */
+@property (nonatomic, readonly) NSUInteger count;
+
+/** Every object, in sorted order. */
+@property (nonatomic, readonly) NSArray<ObjectType> *allObjects;
+
+/** Creates a new, empty tree sorted with the provided comparator. */
+- (instancetype)initWithComparator:(NSComparator)comparator;
+
+/** Replaces every object in the tree, sorting them up front and building the tree in one pass. */
+- (void)setObjects:(NSArray<ObjectType> *)objects;
+
+/** Returns the object at an index in the sorted order. */
+- (ObjectType)objectAtIndex:(NSUInteger)index;
+- (ObjectType)objectAtIndexedSubscript:(NSUInteger)index;
+
+/** Returns the index of an object, or `NSNotFound` if it isn't in the tree. */
+- (NSUInteger)indexOfObject:(ObjectType)object;
+
+/** Returns whether the object is in the tree. */
+- (BOOL)containsObject:(ObjectType)object;
+
+/** Inserts an object into its sorted position, and returns its index. Does nothing if it's already in the tree. */
+- (NSUInteger)insertObject:(ObjectType)object;
+
+/** Removes an object, and returns the index it was at, or `NSNotFound` if it wasn't in the tree. */
+- (NSUInteger)removeObject:(ObjectType)object;
+
+/** Removes every object. */
+- (void)removeAllObjects;
+
+/** Calls the block with each object and its index, in sorted order. */
+- (void)enumerateObjectsUsingBlock:(void (NS_NOESCAPE ^)(ObjectType object, NSUInteger index, BOOL *stop))block;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,354 @@
+//
+//  TOFileSystemOrderStatisticTree.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemOrderStatisticTree.h"
+
+/** Trees with at least this many objects are sorted across multiple threads when they are rebuilt. */
+static const NSUInteger kTOFileSystemOrderStatisticTreeConcurrentSortThreshold = 4096;
+
+/** A single node in the tree. Its fields are accessed directly, as this is only used by the tree. */
+@interface TOFileSystemOrderStatisticTreeNode : NSObject {
+@public
+    id _object;
+    TOFileSystemOrderStatisticTreeNode *_left;
+    TOFileSystemOrderStatisticTreeNode *_right;
+    __unsafe_unretained TOFileSystemOrderStatisticTreeNode *_parent;
+    NSUInteger _count;      // The number of nodes in the subtree starting at this one (including itself)
+    uint32_t _priority;     // Random, and always lower than the priority of the node's parent
+}
+@end
+
+@implementation TOFileSystemOrderStatisticTreeNode
+@end
+
+typedef TOFileSystemOrderStatisticTreeNode TOTreeNode;
+
+static inline NSUInteger TOTreeNodeCount(TOTreeNode *node)
+{
+    return node ? node->_count : 0;
+}
+
+static inline void TOTreeNodeUpdateCount(TOTreeNode *node)
+{
+    node->_count = TOTreeNodeCount(node->_left) + TOTreeNodeCount(node->_right) + 1;
+}
+
+static inline TOTreeNode *TOTreeNodeLeftmost(TOTreeNode *node)
+{
+    while (node->_left) { node = node->_left; }
+    return node;
+}
+
+static inline TOTreeNode *TOTreeNodeSuccessor(TOTreeNode *node)
+{
+    if (node->_right) { return TOTreeNodeLeftmost(node->_right); }
+    while (node->_parent && node->_parent->_right == node) { node = node->_parent; }
+    return node->_parent;
+}
+
+static NSUInteger TOTreeNodeUpdateCounts(TOTreeNode *node)
+{
+    if (node == nil) { return 0; }
+    node->_count = TOTreeNodeUpdateCounts(node->_left) + TOTreeNodeUpdateCounts(node->_right) + 1;
+    return node->_count;
+}
+
+@interface TOFileSystemOrderStatisticTree ()
+
+/** The node at the top of the tree. */
+@property (nonatomic, strong) TOTreeNode *rootNode;
+
+/** The node holding each object, by identity. */
+@property (nonatomic, strong) NSMapTable *nodes;
+
+@end
+
+@implementation TOFileSystemOrderStatisticTree
+
+#pragma mark - Class Creation -
+
+- (instancetype)initWithComparator:(NSComparator)comparator
+{
+    if (self = [super init]) {
+        _comparator = [comparator copy];
+        _nodes = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality
+                                       valueOptions:NSPointerFunctionsStrongMemory];
+    }
+
+    return self;
+}
+
+#pragma mark - Accessing Objects -
+
+- (NSUInteger)count
+{
+    return TOTreeNodeCount(_rootNode);
+}
+
+- (id)objectAtIndex:(NSUInteger)index
+{
+    // Walk down, using the size of each left subtree to decide which way to go
+    const NSUInteger requestedIndex = index;
+    TOTreeNode *node = _rootNode;
+    while (node) {
+        NSUInteger leftCount = TOTreeNodeCount(node->_left);
+        if (index < leftCount) {
+            node = node->_left;
+        }
+        else if (index == leftCount) {
+            return node->_object;
+        }
+        else {
+            index -= leftCount + 1;
+            node = node->_right;
+        }
+    }
+
+    [NSException raise:NSRangeException format:@"Index %lu is beyond the bounds of the tree (count: %lu)",
+                        (unsigned long)requestedIndex, (unsigned long)self.count];
+    return nil;
+}
+
+- (id)objectAtIndexedSubscript:(NSUInteger)index
+{
+    return [self objectAtIndex:index];
+}
+
+- (NSUInteger)indexOfObject:(id)object
+{
+    TOTreeNode *node = [_nodes objectForKey:object];
+    if (node == nil) { return NSNotFound; }
+    return [self indexOfNode:node];
+}
+
+- (NSUInteger)indexOfNode:(TOTreeNode *)node
+{
+    // Count everything to the left of the node, and then everything to the
+    // left of each ancestor that the node is on the right-hand side of
+    NSUInteger index = TOTreeNodeCount(node->_left);
+    for (; node->_parent; node = node->_parent) {
+        if (node->_parent->_right == node) {
+            index += TOTreeNodeCount(node->_parent->_left) + 1;
+        }
+    }
+    return index;
+}
+
+- (BOOL)containsObject:(id)object
+{
+    return [_nodes objectForKey:object] != nil;
+}
+
+- (NSArray *)allObjects
+{
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:self.count];
+    [self enumerateObjectsUsingBlock:^(id object, NSUInteger index, BOOL *stop) {
+        [objects addObject:object];
+    }];
+    return [NSArray arrayWithArray:objects];
+}
+
+- (void)enumerateObjectsUsingBlock:(void (NS_NOESCAPE ^)(id, NSUInteger, BOOL *))block
+{
+    if (_rootNode == nil) { return; }
+
+    BOOL stop = NO;
+    NSUInteger index = 0;
+    for (TOTreeNode *node = TOTreeNodeLeftmost(_rootNode); node && !stop; node = TOTreeNodeSuccessor(node)) {
+        block(node->_object, index++, &stop);
+    }
+}
+
+#pragma mark - Changing Objects -
+
+- (NSUInteger)insertObject:(id)object
+{
+    if ([_nodes objectForKey:object]) { return [self indexOfObject:object]; }
+
+    TOTreeNode *node = [[TOTreeNode alloc] init];
+    node->_object = object;
+    node->_count = 1;
+    node->_priority = arc4random();
+    [_nodes setObject:node forKey:object];
+
+    if (_rootNode == nil) {
+        _rootNode = node;
+        return 0;
+    }
+
+    // Walk down to where the object belongs, counting it in each subtree along the way.
+    // (Objects that compare the same go to the right, so they stay in the order they were added.)
+    NSComparator comparator = _comparator;
+    TOTreeNode *parentNode = _rootNode;
+    while (YES) {
+        parentNode->_count++;
+        if (comparator(object, parentNode->_object) == NSOrderedAscending) {
+            if (parentNode->_left == nil) { parentNode->_left = node; break; }
+            parentNode = parentNode->_left;
+        }
+        else {
+            if (parentNode->_right == nil) { parentNode->_right = node; break; }
+            parentNode = parentNode->_right;
+        }
+    }
+    node->_parent = parentNode;
+
+    // Rotate it back up until its priority is lower than its parent's, which keeps the tree balanced
+    while (node->_parent && node->_parent->_priority < node->_priority) {
+        [self rotateNodeUp:node];
+    }
+
+    return [self indexOfNode:node];
+}
+
+- (NSUInteger)removeObject:(id)object
+{
+    TOTreeNode *node = [_nodes objectForKey:object];
+    if (node == nil) { return NSNotFound; }
+    NSUInteger index = [self indexOfNode:node];
+
+    // Rotate it down (lifting whichever child has the higher priority) until it has no children
+    while (node->_left || node->_right) {
+        TOTreeNode *childNode = node->_left;
+        if (childNode == nil || (node->_right && node->_right->_priority > childNode->_priority)) {
+            childNode = node->_right;
+        }
+        [self rotateNodeUp:childNode];
+    }
+
+    // Detach it, and remove it from the count of each of its ancestors
+    TOTreeNode *parentNode = node->_parent;
+    [self replaceChildNode:node ofNode:parentNode withNode:nil];
+    for (TOTreeNode *ancestorNode = parentNode; ancestorNode; ancestorNode = ancestorNode->_parent) {
+        ancestorNode->_count--;
+    }
+    [_nodes removeObjectForKey:object];
+
+    return index;
+}
+
+- (void)setObjects:(NSArray *)objects
+{
+    [self removeAllObjects];
+    if (objects.count == 0) { return; }
+
+    NSSortOptions options = NSSortStable;
+    if (objects.count >= kTOFileSystemOrderStatisticTreeConcurrentSortThreshold) { options |= NSSortConcurrent; }
+    NSArray *sortedObjects = [objects sortedArrayWithOptions:options usingComparator:_comparator];
+
+    // Since the objects are already in order, the tree can be built in one pass. Each new node
+    // goes at the far right, and lifts any nodes on the right-hand edge with a lower priority into its left.
+    NSMutableArray<TOTreeNode *> *rightEdge = [NSMutableArray array];
+    for (id object in sortedObjects) {
+        if ([_nodes objectForKey:object]) { continue; }
+
+        TOTreeNode *node = [[TOTreeNode alloc] init];
+        node->_object = object;
+        node->_priority = arc4random();
+        [_nodes setObject:node forKey:object];
+
+        TOTreeNode *lastNode = nil;
+        while (rightEdge.count > 0 && rightEdge.lastObject->_priority < node->_priority) {
+            lastNode = rightEdge.lastObject;
+            [rightEdge removeLastObject];
+        }
+
+        node->_left = lastNode;
+        if (lastNode) { lastNode->_parent = node; }
+
+        TOTreeNode *parentNode = rightEdge.lastObject;
+        if (parentNode) {
+            parentNode->_right = node;
+            node->_parent = parentNode;
+        }
+        [rightEdge addObject:node];
+    }
+
+    _rootNode = rightEdge.firstObject;
+    TOTreeNodeUpdateCounts(_rootNode);
+}
+
+- (void)removeAllObjects
+{
+    _rootNode = nil;
+    [_nodes removeAllObjects];
+}
+
+- (void)setComparator:(NSComparator)comparator
+{
+    _comparator = [comparator copy];
+    if (_rootNode == nil) { return; }
+
+    // Rebuild the tree in the new order
+    [self setObjects:self.allObjects];
+}
+
+#pragma mark - Rotations -
+
+- (void)replaceChildNode:(TOTreeNode *)childNode ofNode:(nullable TOTreeNode *)parentNode withNode:(nullable TOTreeNode *)node
+{
+    if (parentNode == nil) {
+        _rootNode = node;
+    }
+    else if (parentNode->_left == childNode) {
+        parentNode->_left = node;
+    }
+    else {
+        parentNode->_right = node;
+    }
+
+    if (node) { node->_parent = parentNode; }
+}
+
+- (void)rotateNodeUp:(TOTreeNode *)node
+{
+    // Swap the node with its parent, moving the parent down to the opposite side,
+    // and handing the node's inner subtree over to it
+    TOTreeNode *parentNode = node->_parent;
+    TOTreeNode *grandparentNode = parentNode->_parent;
+
+    [self replaceChildNode:parentNode ofNode:grandparentNode withNode:node];
+    if (parentNode->_left == node) {
+        parentNode->_left = node->_right;
+        if (parentNode->_left) { parentNode->_left->_parent = parentNode; }
+        node->_right = parentNode;
+    }
+    else {
+        parentNode->_right = node->_left;
+        if (parentNode->_right) { parentNode->_right->_parent = parentNode; }
+        node->_left = parentNode;
+    }
+    parentNode->_parent = node;
+
+    TOTreeNodeUpdateCount(parentNode);
+    TOTreeNodeUpdateCount(node);
+}
+
+#pragma mark - Debugging -
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> count: %lu, objects: %@",
+            NSStringFromClass(self.class), self, (unsigned long)self.count, self.allObjects];
+}
+
+@end
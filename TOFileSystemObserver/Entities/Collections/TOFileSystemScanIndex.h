@@ -0,0 +1,84 @@
+//
+//  TOFileSystemScanIndex.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+
+@class TOFileSystemItemURLDictionary;
+@class TOFileSystemUUID;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A read-only, memory-mapped snapshot of every item an observer
+ knew about at the end of a previous session, saved to disk.
+
+ Each record holds an item's UUID (as 16 raw bytes), its path relative to the observed
+ directory's parent, and the inode, size, modification time and (for directories)
+ number of child items it had when it was saved. Records are sorted by path, with a second table sorted
+ by UUID, so both lookups are binary searches straight out of the mapped file.
+
+ Loading only maps and validates the file, so it takes constant time regardless
+ of how many items are stored. If the file is missing, corrupt, or was written
+ by a different version of the format, it is simply ignored.
+ */
+@interface TOFileSystemScanIndex : NSObject
+
+/** The number of records in the index. */
+@property (nonatomic, readonly) NSUInteger count;
+
+/** Maps the index file at the provided URL. Returns nil if it doesn't exist or isn't valid. */
++ (nullable instancetype)indexWithContentsOfFileURL:(NSURL *)fileURL;
+
+/**
+ Writes every item in the provided dictionary (with its recorded attributes) to a new
+ index file. The file is replaced atomically, so existing mapped instances remain valid.
+ */
++ (BOOL)writeItems:(TOFileSystemItemURLDictionary *)items toFileURL:(NSURL *)fileURL;
+
+/** Returns the index of the record saved at the relative path, or NSNotFound. */
+- (NSUInteger)indexOfRecordWithRelativePath:(NSString *)relativePath;
+
+/** Returns the index of the record saved with the UUID, or NSNotFound. */
+- (NSUInteger)indexOfRecordWithUUID:(TOFileSystemUUID *)uuid;
+
+/** The UUID of the record at the provided index. */
+- (TOFileSystemUUID *)uuidOfRecordAtIndex:(NSUInteger)index;
+
+/** The relative path of the record at the provided index. */
+- (NSString *)relativePathOfRecordAtIndex:(NSUInteger)index;
+
+/** Whether the item is unchanged since the record was saved (ie, its inode, size, modification and creation times, and child count all match). */
+- (BOOL)recordAtIndex:(NSUInteger)index matchesAttributes:(const TOFileSystemItemAttributes *)attributes;
+
+/** Retrieves the attributes that were saved in the record at the provided index. */
+- (void)getAttributes:(TOFileSystemItemAttributes *)attributes ofRecordAtIndex:(NSUInteger)index;
+
+/** Loops through the records of every item directly inside the directory at the provided relative path. */
+- (void)enumerateChildRecordsOfDirectoryWithRelativePath:(NSString *)relativePath
+                                              usingBlock:(void (^)(NSUInteger index))block;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
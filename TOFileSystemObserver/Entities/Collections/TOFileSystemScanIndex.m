@@ -0,0 +1,353 @@
+//
+//  TOFileSystemScanIndex.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemScanIndex.h"
+#import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemUUID.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Identifies an index file ('TOFI'). */
+static const uint32_t kTOFileSystemScanIndexMagic = 0x49464F54;
+
+/** The version of the layout below. This must be incremented whenever the layout changes. */
+static const uint32_t kTOFileSystemScanIndexVersion = 4;
+
+/**
+ An index file is laid out as:
+ Header | Records (sorted by path) | Record numbers (sorted by UUID) | Path strings
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t numberOfRecords;
+    uint64_t stringsLength;
+} TOFileSystemScanIndexHeader;
+
+typedef struct {
+    uint64_t pathOffset;
+    uint64_t inode;
+    int64_t size;
+    int64_t modificationSeconds;
+    int64_t modificationNanoseconds;
+    int64_t creationSeconds;
+    int64_t creationNanoseconds;
+    int32_t device;
+    uint32_t pathLength;
+    uint32_t flags;
+    uint32_t numberOfChildItems;
+    uuid_t uuid;
+} TOFileSystemScanIndexRecord;
+
+/** Flags stored against each record. */
+typedef NS_OPTIONS(uint32_t, TOFileSystemScanIndexRecordFlags) {
+    TOFileSystemScanIndexRecordFlagDirectory = 1 << 0 // The item is a directory
+};
+
+/** Compares two paths byte-wise, with shorter paths ordered first when one prefixes the other. */
+static int TOFileSystemScanIndexComparePaths(const char *a, size_t aLength, const char *b, size_t bLength)
+{
+    int result = memcmp(a, b, MIN(aLength, bLength));
+    if (result != 0) { return result; }
+    if (aLength == bLength) { return 0; }
+    return (aLength < bLength) ? -1 : 1;
+}
+
+@interface TOFileSystemScanIndex () {
+    /** The mapped file, and its length */
+    void *_bytes;
+    size_t _length;
+
+    /** Pointers to each section of the mapped file */
+    const TOFileSystemScanIndexRecord *_records;
+    const uint32_t *_uuidOrder;
+    const char *_strings;
+    uint64_t _stringsLength;
+}
+
+@end
+
+@implementation TOFileSystemScanIndex
+
+#pragma mark - Class Lifecycle -
+
++ (nullable instancetype)indexWithContentsOfFileURL:(NSURL *)fileURL
+{
+    int fileDescriptor = open(fileURL.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0) { return nil; }
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(TOFileSystemScanIndexHeader)) {
+        close(fileDescriptor);
+        return nil;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    size_t length = (size_t)fileStat.st_size;
+    void *bytes = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (bytes == MAP_FAILED) { return nil; }
+
+    return [[self alloc] initWithMappedBytes:bytes length:length];
+}
+
+- (nullable instancetype)initWithMappedBytes:(void *)bytes length:(size_t)length
+{
+    if (self = [super init]) {
+        // Take ownership of the mapping first, so it is unmapped even if validation fails
+        _bytes = bytes;
+        _length = length;
+
+        const TOFileSystemScanIndexHeader *header = bytes;
+        if (header->magic != kTOFileSystemScanIndexMagic ||
+            header->version != kTOFileSystemScanIndexVersion) {
+            return nil;
+        }
+
+        // Make sure the sections exactly fill the file (checking the count first to avoid overflow)
+        size_t available = length - sizeof(TOFileSystemScanIndexHeader);
+        size_t recordSize = sizeof(TOFileSystemScanIndexRecord) + sizeof(uint32_t);
+        if (header->numberOfRecords > available / recordSize) { return nil; }
+        size_t recordsLength = (size_t)header->numberOfRecords * recordSize;
+        if (header->stringsLength != available - recordsLength) { return nil; }
+
+        _count = (NSUInteger)header->numberOfRecords;
+        _records = (const TOFileSystemScanIndexRecord *)((const char *)bytes + sizeof(TOFileSystemScanIndexHeader));
+        _uuidOrder = (const uint32_t *)(_records + _count);
+        _strings = (const char *)(_uuidOrder + _count);
+        _stringsLength = header->stringsLength;
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_bytes) { munmap(_bytes, _length); }
+}
+
+#pragma mark - Writing -
+
++ (BOOL)writeItems:(TOFileSystemItemURLDictionary *)items toFileURL:(NSURL *)fileURL
+{
+    NSMutableData *recordsData = [NSMutableData data];
+    NSMutableData *stringsData = [NSMutableData data];
+
+    // Capture every item into a record, in whatever order the dictionary provides them
+    [items enumerateItemsUsingBlock:^(TOFileSystemUUID *uuid, NSString *relativePath,
+                                      const TOFileSystemItemAttributes *attributes) {
+        // Items without attributes are still saved so they can be found by UUID,
+        // but with a zero inode so they will never be treated as unchanged.
+        TOFileSystemScanIndexRecord record = {0};
+        if (attributes) {
+            record.inode = attributes->inode;
+            record.size = attributes->size;
+            record.modificationSeconds = attributes->modificationTime.tv_sec;
+            record.modificationNanoseconds = attributes->modificationTime.tv_nsec;
+            record.creationSeconds = attributes->creationTime.tv_sec;
+            record.creationNanoseconds = attributes->creationTime.tv_nsec;
+            record.device = (int32_t)attributes->device;
+            record.numberOfChildItems = attributes->numberOfChildItems;
+            if (attributes->isDirectory) { record.flags |= TOFileSystemScanIndexRecordFlagDirectory; }
+        }
+        [uuid getBytes:record.uuid];
+
+        const char *path = relativePath.UTF8String;
+        record.pathOffset = stringsData.length;
+        record.pathLength = (uint32_t)strlen(path);
+        [stringsData appendBytes:path length:record.pathLength];
+        [recordsData appendBytes:&record length:sizeof(TOFileSystemScanIndexRecord)];
+    }];
+
+    TOFileSystemScanIndexRecord *records = recordsData.mutableBytes;
+    const char *strings = stringsData.bytes;
+    size_t numberOfRecords = recordsData.length / sizeof(TOFileSystemScanIndexRecord);
+
+    // Sort the records by path so they can be searched by the scanner
+    qsort_b(records, numberOfRecords, sizeof(TOFileSystemScanIndexRecord), ^int(const void *a, const void *b) {
+        const TOFileSystemScanIndexRecord *first = a, *second = b;
+        return TOFileSystemScanIndexComparePaths(strings + first->pathOffset, first->pathLength,
+                                                 strings + second->pathOffset, second->pathLength);
+    });
+
+    // Then build a second list of record numbers, sorted by UUID
+    NSMutableData *uuidOrderData = [NSMutableData dataWithLength:numberOfRecords * sizeof(uint32_t)];
+    uint32_t *uuidOrder = uuidOrderData.mutableBytes;
+    for (size_t i = 0; i < numberOfRecords; i++) { uuidOrder[i] = (uint32_t)i; }
+    qsort_b(uuidOrder, numberOfRecords, sizeof(uint32_t), ^int(const void *a, const void *b) {
+        return memcmp(records[*(const uint32_t *)a].uuid, records[*(const uint32_t *)b].uuid,
+                      sizeof(uuid_t));
+    });
+
+    TOFileSystemScanIndexHeader header = {0};
+    header.magic = kTOFileSystemScanIndexMagic;
+    header.version = kTOFileSystemScanIndexVersion;
+    header.numberOfRecords = numberOfRecords;
+    header.stringsLength = stringsData.length;
+
+    NSMutableData *fileData = [NSMutableData dataWithBytes:&header length:sizeof(TOFileSystemScanIndexHeader)];
+    [fileData appendData:recordsData];
+    [fileData appendData:uuidOrderData];
+    [fileData appendData:stringsData];
+
+    // Write to a temporary file and swap it in, so a mapped copy of the old file stays intact
+    return [fileData writeToURL:fileURL options:NSDataWritingAtomic error:nil];
+}
+
+#pragma mark - Lookup -
+
+- (NSUInteger)indexOfRecordWithRelativePath:(NSString *)relativePath
+{
+    const char *path = relativePath.UTF8String;
+    size_t pathLength = strlen(path);
+
+    NSUInteger lower = 0, upper = _count;
+    while (lower < upper) {
+        NSUInteger middle = lower + (upper - lower) / 2;
+        const TOFileSystemScanIndexRecord *record = &_records[middle];
+        if (![self isValidRecord:record]) { return NSNotFound; }
+
+        int result = TOFileSystemScanIndexComparePaths(_strings + record->pathOffset, record->pathLength,
+                                                       path, pathLength);
+        if (result == 0) { return middle; }
+        if (result < 0) { lower = middle + 1; }
+        else { upper = middle; }
+    }
+
+    return NSNotFound;
+}
+
+- (NSUInteger)indexOfRecordWithUUID:(TOFileSystemUUID *)uuid
+{
+    uuid_t bytes;
+    [uuid getBytes:bytes];
+
+    NSUInteger lower = 0, upper = _count;
+    while (lower < upper) {
+        NSUInteger middle = lower + (upper - lower) / 2;
+        uint32_t recordIndex = _uuidOrder[middle];
+        if (recordIndex >= _count) { return NSNotFound; }
+
+        int result = memcmp(_records[recordIndex].uuid, bytes, sizeof(uuid_t));
+        if (result == 0) { return recordIndex; }
+        if (result < 0) { lower = middle + 1; }
+        else { upper = middle; }
+    }
+
+    return NSNotFound;
+}
+
+- (TOFileSystemUUID *)uuidOfRecordAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _count, @"Record index out of bounds");
+    return [TOFileSystemUUID UUIDWithBytes:_records[index].uuid];
+}
+
+- (NSString *)relativePathOfRecordAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _count, @"Record index out of bounds");
+    const TOFileSystemScanIndexRecord *record = &_records[index];
+    if (![self isValidRecord:record]) { return @""; }
+    return [[NSString alloc] initWithBytes:_strings + record->pathOffset
+                                    length:record->pathLength
+                                  encoding:NSUTF8StringEncoding];
+}
+
+- (BOOL)recordAtIndex:(NSUInteger)index matchesAttributes:(const TOFileSystemItemAttributes *)attributes
+{
+    NSAssert(index < _count, @"Record index out of bounds");
+    const TOFileSystemScanIndexRecord *record = &_records[index];
+    return record->inode != 0 &&
+            record->inode == attributes->inode &&
+            record->device == (int32_t)attributes->device &&
+            record->size == attributes->size &&
+            record->modificationSeconds == attributes->modificationTime.tv_sec &&
+            record->modificationNanoseconds == attributes->modificationTime.tv_nsec &&
+            record->creationSeconds == attributes->creationTime.tv_sec &&
+            record->creationNanoseconds == attributes->creationTime.tv_nsec &&
+            record->numberOfChildItems == attributes->numberOfChildItems &&
+            ((record->flags & TOFileSystemScanIndexRecordFlagDirectory) != 0) == (attributes->isDirectory != NO);
+}
+
+- (void)getAttributes:(TOFileSystemItemAttributes *)attributes ofRecordAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _count, @"Record index out of bounds");
+    const TOFileSystemScanIndexRecord *record = &_records[index];
+
+    memset(attributes, 0, sizeof(TOFileSystemItemAttributes));
+    attributes->isDirectory = (record->flags & TOFileSystemScanIndexRecordFlagDirectory) != 0;
+    attributes->size = record->size;
+    attributes->modificationTime.tv_sec = (time_t)record->modificationSeconds;
+    attributes->modificationTime.tv_nsec = (long)record->modificationNanoseconds;
+    attributes->creationTime.tv_sec = (time_t)record->creationSeconds;
+    attributes->creationTime.tv_nsec = (long)record->creationNanoseconds;
+    attributes->inode = record->inode;
+    attributes->device = (dev_t)record->device;
+    attributes->numberOfChildItems = record->numberOfChildItems;
+}
+
+- (void)enumerateChildRecordsOfDirectoryWithRelativePath:(NSString *)relativePath
+                                              usingBlock:(void (^)(NSUInteger index))block
+{
+    // Every item inside the directory starts with its path plus a separator.
+    // Since records are sorted by path, they will all be next to each other.
+    NSString *prefixString = [relativePath stringByAppendingString:@"/"];
+    const char *prefix = prefixString.UTF8String;
+    size_t prefixLength = strlen(prefix);
+
+    // Find the first record that could start with the prefix
+    NSUInteger lower = 0, upper = _count;
+    while (lower < upper) {
+        NSUInteger middle = lower + (upper - lower) / 2;
+        const TOFileSystemScanIndexRecord *record = &_records[middle];
+        if (![self isValidRecord:record]) { return; }
+
+        int result = TOFileSystemScanIndexComparePaths(_strings + record->pathOffset, record->pathLength,
+                                                       prefix, prefixLength);
+        if (result < 0) { lower = middle + 1; }
+        else { upper = middle; }
+    }
+
+    // Walk forward until the prefix no longer matches, skipping anything nested deeper
+    for (NSUInteger i = lower; i < _count; i++) {
+        const TOFileSystemScanIndexRecord *record = &_records[i];
+        if (![self isValidRecord:record]) { return; }
+
+        const char *path = _strings + record->pathOffset;
+        if (record->pathLength <= prefixLength || memcmp(path, prefix, prefixLength) != 0) { break; }
+        if (memchr(path + prefixLength, '/', record->pathLength - prefixLength) != NULL) { continue; }
+        block(i);
+    }
+}
+
+- (BOOL)isValidRecord:(const TOFileSystemScanIndexRecord *)record
+{
+    // Guard against a corrupted file pointing outside of the strings section
+    return record->pathOffset <= _stringsLength &&
+            record->pathLength <= _stringsLength - record->pathOffset;
+}
+
+@end
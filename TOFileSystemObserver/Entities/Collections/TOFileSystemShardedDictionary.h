@@ -0,0 +1,74 @@
+//
+//  TOFileSystemShardedDictionary.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A thread-safe dictionary optimized for many concurrent readers.
+
+ The entries are split between a fixed number of shards by the hash of their key.
+ Each shard is an immutable snapshot: writers copy the shard they change, and then
+ swap the new copy in, so a reader only ever needs to grab the current snapshot
+ of one shard, and never waits for a writer to finish copying or mutating it.
+
+ Since each shard only holds a small slice of the entries, copying one on every
+ write stays cheap. Writes are serialized with each other, and take effect before
+ the write method returns, so a thread will always see its own changes.
+ */
+@interface TOFileSystemShardedDictionary<KeyType, ObjectType> : NSObject
+
+/** The number of entries in the dictionary. */
+@property (nonatomic, readonly) NSUInteger count;
+
+/** The number of shards the entries are split between. */
+@property (nonatomic, readonly) NSUInteger numberOfShards;
+
+/** Creates a new dictionary with the provided number of shards (rounded up to a power of two). */
+- (instancetype)initWithNumberOfShards:(NSUInteger)numberOfShards;
+
+/** Returns the object stored for the key, if there is one. Never waits for a writer to copy or change a shard. */
+- (nullable ObjectType)objectForKey:(KeyType)key;
+
+/** Stores an object for a key, replacing any existing one. */
+- (void)setObject:(ObjectType)object forKey:(KeyType)key;
+
+/** Removes the object for a key, if there is one. */
+- (void)removeObjectForKey:(KeyType)key;
+
+/** Removes every entry. */
+- (void)removeAllObjects;
+
+/** Every key in the dictionary, assembled from the current snapshot of each shard. */
+- (NSArray<KeyType> *)allKeys;
+
+/** Loops through every entry, one shard snapshot at a time. */
+- (void)enumerateKeysAndObjectsUsingBlock:(void (^)(KeyType key, ObjectType object, BOOL *stop))block;
+
+/** Implementations for allowing dictionary style literal syntax. */
+- (void)setObject:(nullable ObjectType)object forKeyedSubscript:(KeyType)key;
+- (nullable ObjectType)objectForKeyedSubscript:(KeyType)key;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,229 @@
+//
+//  TOFileSystemShardedDictionary.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemShardedDictionary.h"
+#import "TOFileSystemLock.h"
+
+#import <stdatomic.h>
+
+/** The number of shards used by default. (Enough that each stays small, even with hundreds of thousands of entries) */
+static const NSUInteger kTOFileSystemShardedDictionaryDefaultNumberOfShards = 4096;
+
+/**
+ The number of locks guarding the shard pointers. They are only held while swapping or
+ retaining a pointer, so they are shared between many shards to save memory.
+ */
+#define kTOFileSystemShardedDictionaryNumberOfLocks 64
+
+@interface TOFileSystemShardedDictionary () {
+    /** The current snapshot of each shard (nil if empty). */
+    __strong NSDictionary **_shards;
+    NSUInteger _numberOfShards;
+    atomic_ulong _count;
+
+    /** Serializes the writers with each other. Readers never take this. */
+    TOFileSystemLock _writeLock;
+
+    /** Guards reading and swapping the shard pointers, so a snapshot can't be released as it's retained. */
+    TOFileSystemLock _shardLocks[kTOFileSystemShardedDictionaryNumberOfLocks];
+}
+
+@end
+
+@implementation TOFileSystemShardedDictionary
+
+#pragma mark - Class Lifecycle -
+
+- (instancetype)init
+{
+    return [self initWithNumberOfShards:kTOFileSystemShardedDictionaryDefaultNumberOfShards];
+}
+
+- (instancetype)initWithNumberOfShards:(NSUInteger)numberOfShards
+{
+    if (self = [super init]) {
+        // Round up to a power of two, so the shard can be found with a mask
+        _numberOfShards = 1;
+        while (_numberOfShards < numberOfShards) { _numberOfShards <<= 1; }
+
+        _shards = (__strong NSDictionary **)calloc(_numberOfShards, sizeof(NSDictionary *));
+        TOFileSystemLockInit(&_writeLock);
+        for (NSUInteger i = 0; i < kTOFileSystemShardedDictionaryNumberOfLocks; i++) {
+            TOFileSystemLockInit(&_shardLocks[i]);
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    // Release every snapshot before freeing the array that holds them
+    for (NSUInteger i = 0; i < _numberOfShards; i++) { _shards[i] = nil; }
+    free(_shards);
+
+    TOFileSystemLockDestroy(&_writeLock);
+    for (NSUInteger i = 0; i < kTOFileSystemShardedDictionaryNumberOfLocks; i++) {
+        TOFileSystemLockDestroy(&_shardLocks[i]);
+    }
+}
+
+#pragma mark - Shards -
+
+- (NSUInteger)indexOfShardForKey:(id)key
+{
+    // Mix the hash, since many hashes (eg, of numbers) only vary in their lowest bits
+    uint64_t hash = (uint64_t)[key hash];
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return (NSUInteger)(hash & (_numberOfShards - 1));
+}
+
+- (nullable NSDictionary *)shardAtIndex:(NSUInteger)index
+{
+    // The lock is only held long enough to retain the current snapshot
+    TOFileSystemLock *lock = &_shardLocks[index % kTOFileSystemShardedDictionaryNumberOfLocks];
+    TOFileSystemLockLock(lock);
+    NSDictionary *shard = _shards[index];
+    TOFileSystemLockUnlock(lock);
+    return shard;
+}
+
+- (void)replaceShardAtIndex:(NSUInteger)index withShard:(nullable NSDictionary *)shard
+{
+    // (Must be called while holding the write lock)
+    // Hold on to the old snapshot so it's released after the lock, not while readers are waiting on it
+    NSDictionary *previousShard = _shards[index];
+
+    TOFileSystemLock *lock = &_shardLocks[index % kTOFileSystemShardedDictionaryNumberOfLocks];
+    TOFileSystemLockLock(lock);
+    _shards[index] = shard;
+    TOFileSystemLockUnlock(lock);
+}
+
+#pragma mark - Reading -
+
+- (nullable id)objectForKey:(id)key
+{
+    if (key == nil) { return nil; }
+    return [self shardAtIndex:[self indexOfShardForKey:key]][key];
+}
+
+- (NSUInteger)numberOfShards
+{
+    return _numberOfShards;
+}
+
+- (NSUInteger)count
+{
+    return atomic_load_explicit(&_count, memory_order_relaxed);
+}
+
+- (NSArray *)allKeys
+{
+    NSMutableArray *keys = [NSMutableArray array];
+    for (NSUInteger i = 0; i < _numberOfShards; i++) {
+        NSDictionary *shard = [self shardAtIndex:i];
+        if (shard) { [keys addObjectsFromArray:shard.allKeys]; }
+    }
+    return keys;
+}
+
+- (void)enumerateKeysAndObjectsUsingBlock:(void (^)(id, id, BOOL *))block
+{
+    __block BOOL stop = NO;
+    for (NSUInteger i = 0; i < _numberOfShards && !stop; i++) {
+        NSDictionary *shard = [self shardAtIndex:i];
+        [shard enumerateKeysAndObjectsUsingBlock:^(id key, id object, BOOL *shardStop) {
+            block(key, object, &stop);
+            *shardStop = stop;
+        }];
+    }
+}
+
+#pragma mark - Writing -
+
+- (void)setObject:(id)object forKey:(id)key
+{
+    if (key == nil) { return; }
+    if (object == nil) {
+        [self removeObjectForKey:key];
+        return;
+    }
+
+    NSUInteger index = [self indexOfShardForKey:key];
+
+    TOFileSystemLockLock(&_writeLock);
+
+    // Build the new snapshot before swapping it in. (The writer owns the shards, so can read them directly)
+    NSDictionary *shard = _shards[index];
+    NSMutableDictionary *newShard = shard ? [shard mutableCopy] : [NSMutableDictionary dictionaryWithCapacity:1];
+    if (newShard[key] == nil) { atomic_fetch_add_explicit(&_count, 1, memory_order_relaxed); }
+    newShard[key] = object;
+    [self replaceShardAtIndex:index withShard:newShard];
+
+    TOFileSystemLockUnlock(&_writeLock);
+}
+
+- (void)removeObjectForKey:(id)key
+{
+    if (key == nil) { return; }
+    NSUInteger index = [self indexOfShardForKey:key];
+
+    TOFileSystemLockLock(&_writeLock);
+
+    NSDictionary *shard = _shards[index];
+    if (shard[key] != nil) {
+        NSMutableDictionary *newShard = [shard mutableCopy];
+        [newShard removeObjectForKey:key];
+        [self replaceShardAtIndex:index withShard:(newShard.count > 0 ? newShard : nil)];
+        atomic_fetch_sub_explicit(&_count, 1, memory_order_relaxed);
+    }
+
+    TOFileSystemLockUnlock(&_writeLock);
+}
+
+- (void)removeAllObjects
+{
+    TOFileSystemLockLock(&_writeLock);
+    for (NSUInteger i = 0; i < _numberOfShards; i++) {
+        if (_shards[i] == nil) { continue; }
+        [self replaceShardAtIndex:i withShard:nil];
+    }
+    atomic_store_explicit(&_count, 0, memory_order_relaxed);
+    TOFileSystemLockUnlock(&_writeLock);
+}
+
+#pragma mark - Subscripting -
+
+- (void)setObject:(nullable id)object forKeyedSubscript:(id)key
+{
+    [self setObject:object forKey:key];
+}
+
+- (nullable id)objectForKeyedSubscript:(id)key
+{
+    return [self objectForKey:key];
+}
+
+@end
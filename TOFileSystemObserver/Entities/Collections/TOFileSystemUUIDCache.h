@@ -0,0 +1,67 @@
+//
+//  TOFileSystemUUIDCache.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+
+@class TOFileSystemUUID;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A fixed-size, thread-safe cache of the UUIDs that were read from items on disk,
+ keyed by the device and file system ID of each item.
+
+ Each entry also records the item's status change time when the UUID was read.
+ Since writing an extended attribute updates that time, an entry is only returned
+ while it still matches, letting an item's UUID be looked up from attributes that were
+ already fetched (eg, while reading a directory) without reading it from disk again.
+
+ When two items map to the same slot, the older entry is replaced, so the memory
+ used never grows past the capacity it was created with.
+ */
+@interface TOFileSystemUUIDCache : NSObject
+
+/** The maximum number of UUIDs that can be held at once. */
+@property (nonatomic, readonly) NSUInteger capacity;
+
+/** The number of lookups that returned a UUID. */
+@property (nonatomic, readonly) NSUInteger numberOfHits;
+
+/** The number of lookups that didn't find a matching UUID. */
+@property (nonatomic, readonly) NSUInteger numberOfMisses;
+
+/** Creates a new cache that holds up to the provided number of UUIDs (rounded up to a power of two). */
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+/** Returns the UUID cached for the item, if its attributes haven't changed since it was added. */
+- (nullable TOFileSystemUUID *)uuidForItemWithAttributes:(const TOFileSystemItemAttributes *)attributes;
+
+/** Caches the UUID that was read from an item with the provided attributes. */
+- (void)setUUID:(TOFileSystemUUID *)uuid forItemWithAttributes:(const TOFileSystemItemAttributes *)attributes;
+
+/** Removes every UUID, and resets the hit and miss counts. */
+- (void)removeAllUUIDs;
+
+@end
+
+NS_ASSUME_NONNULL_END
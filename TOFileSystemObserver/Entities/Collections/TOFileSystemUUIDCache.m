@@ -0,0 +1,168 @@
+//
+//  TOFileSystemUUIDCache.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemUUIDCache.h"
+#import "TOFileSystemUUID.h"
+#import "TOFileSystemLock.h"
+
+/** The number of UUIDs held by default. (At 48 bytes each, this is around 768KB) */
+static const NSUInteger kTOFileSystemUUIDCacheDefaultCapacity = 16384;
+
+/** A single cached UUID, along with the attributes of the item it was read from. */
+typedef struct {
+    uint64_t inode;
+    dev_t device;
+    struct timespec changeTime;
+    uuid_t uuid;
+} TOFileSystemUUIDCacheEntry;
+
+/** Whether the attributes can be used as a key. (Some volumes and older records don't supply every value.) */
+static inline BOOL TOFileSystemUUIDCacheCanCacheAttributes(const TOFileSystemItemAttributes *attributes) {
+    return attributes->inode != 0 && (attributes->changeTime.tv_sec != 0 || attributes->changeTime.tv_nsec != 0);
+}
+
+@interface TOFileSystemUUIDCache () {
+    TOFileSystemLock _lock;
+    TOFileSystemUUIDCacheEntry *_entries;
+    NSUInteger _capacity;
+    NSUInteger _numberOfHits;
+    NSUInteger _numberOfMisses;
+}
+
+@end
+
+@implementation TOFileSystemUUIDCache
+
+#pragma mark - Class Lifecycle -
+
+- (instancetype)init
+{
+    return [self initWithCapacity:kTOFileSystemUUIDCacheDefaultCapacity];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+{
+    if (self = [super init]) {
+        // Round up to a power of two, so the slot can be found with a mask
+        _capacity = 1;
+        while (_capacity < capacity) { _capacity <<= 1; }
+
+        // (An empty entry has an inode of 0, which never matches a lookup)
+        _entries = calloc(_capacity, sizeof(TOFileSystemUUIDCacheEntry));
+        TOFileSystemLockInit(&_lock);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_entries);
+    TOFileSystemLockDestroy(&_lock);
+}
+
+#pragma mark - Accessing UUIDs -
+
+- (nullable TOFileSystemUUID *)uuidForItemWithAttributes:(const TOFileSystemItemAttributes *)attributes
+{
+    if (!TOFileSystemUUIDCacheCanCacheAttributes(attributes)) { return nil; }
+
+    uuid_t bytes;
+    BOOL isHit = NO;
+
+    TOFileSystemLockLock(&_lock);
+    const TOFileSystemUUIDCacheEntry *entry = [self entryForAttributes:attributes];
+    if (entry->inode == attributes->inode && entry->device == attributes->device &&
+        entry->changeTime.tv_sec == attributes->changeTime.tv_sec &&
+        entry->changeTime.tv_nsec == attributes->changeTime.tv_nsec) {
+        memcpy(bytes, entry->uuid, sizeof(uuid_t));
+        isHit = YES;
+        _numberOfHits++;
+    }
+    else {
+        _numberOfMisses++;
+    }
+    TOFileSystemLockUnlock(&_lock);
+
+    return isHit ? [TOFileSystemUUID UUIDWithBytes:bytes] : nil;
+}
+
+- (void)setUUID:(TOFileSystemUUID *)uuid forItemWithAttributes:(const TOFileSystemItemAttributes *)attributes
+{
+    if (uuid == nil || !TOFileSystemUUIDCacheCanCacheAttributes(attributes)) { return; }
+
+    uuid_t bytes;
+    [uuid getBytes:bytes];
+
+    TOFileSystemLockLock(&_lock);
+    TOFileSystemUUIDCacheEntry *entry = [self entryForAttributes:attributes];
+    entry->inode = attributes->inode;
+    entry->device = attributes->device;
+    entry->changeTime = attributes->changeTime;
+    memcpy(entry->uuid, bytes, sizeof(uuid_t));
+    TOFileSystemLockUnlock(&_lock);
+}
+
+- (void)removeAllUUIDs
+{
+    TOFileSystemLockLock(&_lock);
+    memset(_entries, 0, _capacity * sizeof(TOFileSystemUUIDCacheEntry));
+    _numberOfHits = 0;
+    _numberOfMisses = 0;
+    TOFileSystemLockUnlock(&_lock);
+}
+
+- (TOFileSystemUUIDCacheEntry *)entryForAttributes:(const TOFileSystemItemAttributes *)attributes
+{
+    // (Must be called while holding the lock)
+    // Mix the bits of the ID, since IDs created together only differ in their lowest bits
+    uint64_t key = attributes->inode ^ ((uint64_t)attributes->device << 32);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return &_entries[key & (_capacity - 1)];
+}
+
+#pragma mark - Accessors -
+
+- (NSUInteger)capacity
+{
+    return _capacity;
+}
+
+- (NSUInteger)numberOfHits
+{
+    TOFileSystemLockLock(&_lock);
+    NSUInteger numberOfHits = _numberOfHits;
+    TOFileSystemLockUnlock(&_lock);
+    return numberOfHits;
+}
+
+- (NSUInteger)numberOfMisses
+{
+    TOFileSystemLockLock(&_lock);
+    NSUInteger numberOfMisses = _numberOfMisses;
+    TOFileSystemLockUnlock(&_lock);
+    return numberOfMisses;
+}
+
+@end
@@ -0,0 +1,65 @@
+//
+//  TOFileSystemExclusionMatcher.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A pre-compiled set of patterns for items that should be excluded from observation,
+ built once and then checked against every item found while scanning.
+
+ Patterns are paths relative to the base directory, and are sorted into the cheapest structure that can match them:
+
+ - Plain paths (eg, `Inbox` or `Folder/Cache`) only match that exact item, via a hashed lookup.
+ - Wildcard patterns without a slash (eg, `*.tmp`) match the name of an item at any depth.
+ - A name after a leading `**` segment (eg, `node_modules` after one) also matches that name at any depth.
+ - Any other pattern (eg, `Folder/[Cc]ache?`) is matched one path segment at a time,
+   where `*`, `?` and `[...]` match within a segment, and a `**` segment matches any number of segments.
+
+ Excluded directories are checked before they are read, so none of their contents are ever scanned.
+ */
+@interface TOFileSystemExclusionMatcher : NSObject
+
+/** The directory that all of the patterns are relative to. */
+@property (nonatomic, readonly) NSURL *baseURL;
+
+/** The original list of patterns this matcher was compiled from. */
+@property (nonatomic, readonly) NSArray<NSString *> *patterns;
+
+/** Compiles a list of patterns, relative to the provided directory. */
+- (instancetype)initWithPatterns:(NSArray<NSString *> *)patterns baseURL:(NSURL *)baseURL;
+
+/** Whether the item at the provided URL matches any of the patterns. */
+- (BOOL)matchesItemAtURL:(NSURL *)itemURL;
+
+/** Whether the item, or any of the directories it is inside, matches any of the patterns. */
+- (BOOL)matchesItemOrParentOfItemAtURL:(NSURL *)itemURL;
+
+/** Whether the path (relative to the base directory) matches any of the patterns. */
+- (BOOL)matchesRelativePath:(NSString *)relativePath;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
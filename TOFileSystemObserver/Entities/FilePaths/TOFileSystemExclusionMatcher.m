@@ -0,0 +1,223 @@
+//
+//  TOFileSystemExclusionMatcher.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemExclusionMatcher.h"
+
+#import <fnmatch.h>
+
+/** The segment that matches any number of directory levels. */
+static NSString * const kTOFileSystemExclusionAnySegments = @"**";
+
+/** Whether a pattern contains any characters that `fnmatch` would treat specially. */
+static inline BOOL TOFileSystemExclusionPatternIsGlob(NSString *pattern)
+{
+    static NSCharacterSet *globCharacters = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        globCharacters = [NSCharacterSet characterSetWithCharactersInString:@"*?["];
+    });
+    return [pattern rangeOfCharacterFromSet:globCharacters].location != NSNotFound;
+}
+
+/** Recursively matches the pattern segments against the path components, starting from the provided indexes. */
+static BOOL TOFileSystemExclusionSegmentsMatch(NSArray<NSString *> *segments, NSUInteger segmentIndex,
+                                               NSArray<NSString *> *components, NSUInteger componentIndex)
+{
+    while (segmentIndex < segments.count) {
+        NSString *segment = segments[segmentIndex];
+
+        // Try consuming every possible number of components (including none) for this segment
+        if ([segment isEqualToString:kTOFileSystemExclusionAnySegments]) {
+            for (NSUInteger i = componentIndex; i <= components.count; i++) {
+                if (TOFileSystemExclusionSegmentsMatch(segments, segmentIndex + 1, components, i)) { return YES; }
+            }
+            return NO;
+        }
+
+        // Otherwise, each segment must match exactly one component
+        if (componentIndex >= components.count) { return NO; }
+        if (fnmatch(segment.fileSystemRepresentation, components[componentIndex].fileSystemRepresentation, 0) != 0) {
+            return NO;
+        }
+
+        segmentIndex++;
+        componentIndex++;
+    }
+
+    return componentIndex == components.count;
+}
+
+@interface TOFileSystemExclusionMatcher () {
+    /** Wildcard patterns matched against just the name of each item, pre-converted for `fnmatch`. */
+    char **_namePatterns;
+    NSUInteger _numberOfNamePatterns;
+}
+
+/** The absolute path of the base directory, used to convert item URLs to relative paths. */
+@property (nonatomic, copy) NSString *basePath;
+
+/** Patterns without wildcards, matched against the whole relative path. */
+@property (nonatomic, strong) NSSet<NSString *> *exactPaths;
+
+/** Names without wildcards that are matched at any depth. */
+@property (nonatomic, strong) NSSet<NSString *> *exactNames;
+
+/** Every other pattern, broken up into its path segments. */
+@property (nonatomic, strong) NSArray<NSArray<NSString *> *> *segmentPatterns;
+
+@end
+
+@implementation TOFileSystemExclusionMatcher
+
+#pragma mark - Class Lifecycle -
+
+- (instancetype)initWithPatterns:(NSArray<NSString *> *)patterns baseURL:(NSURL *)baseURL
+{
+    if (self = [super init]) {
+        _patterns = [patterns copy];
+        _baseURL = baseURL.URLByStandardizingPath;
+        _basePath = [_baseURL.path copy];
+        [self compilePatterns];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < _numberOfNamePatterns; i++) {
+        free(_namePatterns[i]);
+    }
+    free(_namePatterns);
+}
+
+#pragma mark - Compiling -
+
+- (void)compilePatterns
+{
+    NSMutableSet *exactPaths = [NSMutableSet set];
+    NSMutableSet *exactNames = [NSMutableSet set];
+    NSMutableArray *namePatterns = [NSMutableArray array];
+    NSMutableArray *segmentPatterns = [NSMutableArray array];
+
+    for (NSString *pattern in self.patterns) {
+        // Break the pattern into segments, ignoring any leading, trailing or duplicate slashes
+        NSMutableArray *segments = [[pattern componentsSeparatedByString:@"/"] mutableCopy];
+        [segments removeObject:@""];
+        if (segments.count == 0) { continue; }
+
+        // Plain paths (the original format) are only ever matched from the base directory
+        NSString *relativePath = [segments componentsJoinedByString:@"/"];
+        if (!TOFileSystemExclusionPatternIsGlob(relativePath)) {
+            [exactPaths addObject:relativePath];
+            continue;
+        }
+
+        // A leading '**' before a single name is the same as matching that name at any depth
+        if (segments.count == 2 && [segments.firstObject isEqualToString:kTOFileSystemExclusionAnySegments]) {
+            [segments removeObjectAtIndex:0];
+            if (!TOFileSystemExclusionPatternIsGlob(segments.firstObject)) {
+                [exactNames addObject:segments.firstObject];
+                continue;
+            }
+        }
+
+        // Single wildcard names are matched against the name of every item
+        if (segments.count == 1 && ![segments.firstObject isEqualToString:kTOFileSystemExclusionAnySegments]) {
+            [namePatterns addObject:segments.firstObject];
+            continue;
+        }
+
+        [segmentPatterns addObject:[segments copy]];
+    }
+
+    _exactPaths = [exactPaths copy];
+    _exactNames = [exactNames copy];
+    _segmentPatterns = [segmentPatterns copy];
+
+    // Convert the name patterns to C strings up front, since they are checked for every single item
+    _numberOfNamePatterns = namePatterns.count;
+    _namePatterns = calloc(MAX(_numberOfNamePatterns, 1), sizeof(char *));
+    for (NSUInteger i = 0; i < _numberOfNamePatterns; i++) {
+        _namePatterns[i] = strdup([namePatterns[i] fileSystemRepresentation]);
+    }
+}
+
+#pragma mark - Matching -
+
+- (nullable NSString *)relativePathForItemURL:(NSURL *)itemURL
+{
+    // Items outside of the base directory (or the base directory itself) are never excluded
+    NSString *path = itemURL.path;
+    NSString *basePath = self.basePath;
+    if (path.length <= basePath.length + 1 || ![path hasPrefix:basePath]) { return nil; }
+    if ([path characterAtIndex:basePath.length] != '/') { return nil; }
+    return [path substringFromIndex:basePath.length + 1];
+}
+
+- (BOOL)matchesItemAtURL:(NSURL *)itemURL
+{
+    NSString *relativePath = [self relativePathForItemURL:itemURL];
+    if (relativePath == nil) { return NO; }
+    return [self matchesRelativePath:relativePath];
+}
+
+- (BOOL)matchesItemOrParentOfItemAtURL:(NSURL *)itemURL
+{
+    NSString *relativePath = [self relativePathForItemURL:itemURL];
+
+    // Work up through each parent directory until we reach the base directory
+    while (relativePath.length > 0) {
+        if ([self matchesRelativePath:relativePath]) { return YES; }
+        relativePath = relativePath.stringByDeletingLastPathComponent;
+    }
+
+    return NO;
+}
+
+- (BOOL)matchesRelativePath:(NSString *)relativePath
+{
+    // Check the hashed lookups first
+    if ([self.exactPaths containsObject:relativePath]) { return YES; }
+
+    NSString *name = relativePath.lastPathComponent;
+    if ([self.exactNames containsObject:name]) { return YES; }
+
+    // Check the item's name against every wildcard name
+    if (_numberOfNamePatterns > 0) {
+        const char *fileSystemName = name.fileSystemRepresentation;
+        for (NSUInteger i = 0; i < _numberOfNamePatterns; i++) {
+            if (fnmatch(_namePatterns[i], fileSystemName, 0) == 0) { return YES; }
+        }
+    }
+
+    // Finally, fall back to matching each segment of the path
+    if (self.segmentPatterns.count == 0) { return NO; }
+    NSArray<NSString *> *components = [relativePath componentsSeparatedByString:@"/"];
+    for (NSArray<NSString *> *segments in self.segmentPatterns) {
+        if (TOFileSystemExclusionSegmentsMatch(segments, 0, components, 0)) { return YES; }
+    }
+
+    return NO;
+}
+
+@end
@@ -22,18 +22,32 @@
 
 #import <Foundation/Foundation.h>
 #import "TOFileSystemItem.h"
+#import "NSURL+TOFileSystemAttributes.h"
 
 @class TOFileSystemObserver;
+@class TOFileSystemUUID;
 
 NS_ASSUME_NONNULL_BEGIN
 
 /** Private interface for creating item objects */
 @interface TOFileSystemItem ()
 
+/** The UUID of the item as a binary value. (`uuid` converts this to a string.) */
+@property (nonatomic, readonly) TOFileSystemUUID *uuidValue;
+
 /** Creates a new instance of an item for the target item. */
 - (instancetype)initWithItemAtFileURL:(NSURL *)fileURL
                    fileSystemObserver:(TOFileSystemObserver *)observer;
 
+/**
+ Creates a new instance of an item from a UUID and attributes that were already read,
+ (eg, when resolving many items at once) without touching the disk again.
+ */
+- (instancetype)initWithItemAtFileURL:(NSURL *)fileURL
+                                 uuid:(TOFileSystemUUID *)uuid
+                           attributes:(const TOFileSystemItemAttributes *)attributes
+                   fileSystemObserver:(TOFileSystemObserver *)observer;
+
 /** Adds this item as a child of a list. */
 - (void)addToList:(TOFileSystemItemList *)list;
 
@@ -47,6 +61,11 @@ NS_ASSUME_NONNULL_BEGIN
     Returns true if there were changes. */
 - (BOOL)refreshWithURL:(nullable NSURL *)itemURL;
 
+/** Notify this directory that the observer added or removed items inside it, so it can re-fetch its
+    properties, and adjust its number of sub-items by `change` instead of reading the directory again.
+    (Pass `NSNotFound` if the change isn't known.) Returns true if there were changes. */
+- (BOOL)refreshWithNumberOfSubItemsChange:(NSInteger)change;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -21,6 +21,7 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import "TOFileSystemObserverConstants.h"
+#import "TOFileSystemItemSnapshot.h"
 
 @class TOFileSystemObserver;
 @class TOFileSystemItemList;
@@ -34,6 +35,13 @@ NS_ASSUME_NONNULL_BEGIN
 NS_SWIFT_NAME(FileSystemItem)
 @interface TOFileSystemItem : NSObject
 
+/**
+ An immutable copy of all of the properties below, captured together.
+ Reading this once is cheaper than calling each getter individually (which
+ each take the item's lock), and guarantees the values are consistent with each other.
+ */
+@property (nonatomic, readonly) TOFileSystemItemSnapshot *snapshot;
+
 /** The absolute URL path to this item. */
 @property (nonatomic, readonly) NSURL *fileURL;
 
@@ -22,11 +22,13 @@
 
 #import "TOFileSystemItem.h"
 #import "TOFileSystemItemList+Private.h"
+#import "TOFileSystemItemSnapshot+Private.h"
 #import "TOFileSystemPath.h"
 #import "TOFileSystemObserver.h"
 #import "TOFileSystemPresenter.h"
 #import "NSURL+TOFileSystemAttributes.h"
 #import "NSURL+TOFileSystemUUID.h"
+#import "TOFileSystemUUID.h"
 #import "TOFileSystemObserverConstants.h"
 
 #import <os/lock.h>
@@ -45,13 +47,18 @@
 /** Internal writing overrides for public properties */
 @property (nonatomic, strong, readwrite) NSURL *fileURL;
 @property (nonatomic, assign, readwrite) TOFileSystemItemType type;
-@property (nonatomic, copy,   readwrite) NSString *uuid;
+@property (nonatomic, strong, readwrite) TOFileSystemUUID *uuidValue;
 @property (nonatomic, copy,   readwrite) NSString *name;
 @property (nonatomic, assign, readwrite) long long size;
 @property (nonatomic, strong, readwrite) NSDate *creationDate;
 @property (nonatomic, strong, readwrite) NSDate *modificationDate;
 @property (nonatomic, assign, readwrite) BOOL isCopying;
-@property (nonatomic, assign, readwrite) NSInteger numberOfSubItems;
+
+/** The most recently published copy of the item's properties. Replaced (never mutated) under the lock. */
+@property (nonatomic, strong) TOFileSystemItemSnapshot *currentSnapshot;
+
+/** The attributes last read from disk, so the UUID can be looked up from the cache. */
+@property (nonatomic, assign) TOFileSystemItemAttributes attributes;
 
 /** Thread safe locks */
 #pragma clang diagnostic push
@@ -72,32 +79,59 @@
     if (self = [super init]) {
         _fileURL = fileURL;
         _fileSystemObserver = observer;
+        [self commonInit];
         
-        // Initialize the lock
-        if (@available(iOS 10.0, *)) {
-            self.unfairLock = OS_UNFAIR_LOCK_INIT;
-        } else {
-            pthread_mutex_init(&_pthreadMutexLock, NULL);
-        }
-        
-        // If this item represents a deleted file, skip gathering the data
-        if (!self.isDeleted) {
-            [self performWithLock:^{
-                [self configureUUIDForceRefresh:NO];
+        [self performWithLock:^{
+            // If this item represents a deleted file, skip gathering the data
+            if ([[NSFileManager defaultManager] fileExistsAtPath:fileURL.path]) {
                 [self refreshFromItemAtURL:fileURL];
-            }];
-        }
+                [self configureUUIDForceRefresh:NO];
+            }
+            [self publishSnapshot];
+        }];
+    }
+
+    return self;
+}
+
+- (instancetype)initWithItemAtFileURL:(NSURL *)fileURL
+                                 uuid:(TOFileSystemUUID *)uuid
+                           attributes:(const TOFileSystemItemAttributes *)attributes
+                   fileSystemObserver:(TOFileSystemObserver *)observer
+{
+    if (self = [super init]) {
+        _fileURL = fileURL;
+        _fileSystemObserver = observer;
+        _uuidValue = uuid;
+        _name = fileURL.lastPathComponent;
+        [self commonInit];
+
+        // Nothing else can see this item yet, so it can be populated without taking the lock
+        [self updateWithAttributes:attributes];
+        [self publishSnapshot];
     }
 
     return self;
 }
 
+- (void)commonInit
+{
+    // Initialize the lock
+    if (@available(iOS 10.0, *)) {
+        self.unfairLock = OS_UNFAIR_LOCK_INIT;
+    } else {
+        pthread_mutex_init(&_pthreadMutexLock, NULL);
+    }
+}
+
 #pragma mark - Update Properties -
 
 - (void)configureUUIDForceRefresh:(BOOL)forceRefresh
 {
+    // Unless a fresh read was requested, the attributes that were just read can be used to skip the disk
     TOFileSystemPresenter *presenter = self.fileSystemObserver.fileSystemPresenter;
-    _uuid = [presenter uuidForItemAtURL:_fileURL];
+    const TOFileSystemItemAttributes *attributes = (!forceRefresh && _attributes.inode != 0) ? &_attributes : NULL;
+    _uuidValue = [presenter uuidForItemAtURL:_fileURL attributes:attributes];
 }
 
 - (BOOL)refreshFromItemAtURL:(NSURL *)url
@@ -116,8 +150,24 @@
         hasChanges = YES;
     }
 
+    // Fetch all of the item's attributes from disk at once
+    TOFileSystemItemAttributes attributes = {0};
+    if (![_fileURL to_getAttributes:&attributes]) {
+        _attributes = (TOFileSystemItemAttributes){0};
+        return hasChanges;
+    }
+
+    hasChanges |= [self updateWithAttributes:&attributes];
+    return hasChanges;
+}
+
+- (BOOL)updateWithAttributes:(const TOFileSystemItemAttributes *)attributes
+{
+    BOOL hasChanges = NO;
+    _attributes = *attributes;
+
     // Check if it is a file or directory
-    TOFileSystemItemType type = _fileURL.to_isDirectory ? TOFileSystemItemTypeDirectory :
+    TOFileSystemItemType type = attributes->isDirectory ? TOFileSystemItemTypeDirectory :
                                                         TOFileSystemItemTypeFile;
     if (type != _type) {
         _type = type;
@@ -125,14 +175,14 @@
     }
 
     // Get its creation date
-    NSDate *creationDate = _fileURL.to_creationDate;
+    NSDate *creationDate = TOFileSystemDateFromTimespec(attributes->creationTime);
     if (![_creationDate isEqualToDate:creationDate]) {
         _creationDate = creationDate;
         hasChanges = YES;
     }
     
     // Get its modification date
-    NSDate *modificationDate = _fileURL.to_modificationDate;
+    NSDate *modificationDate = TOFileSystemDateFromTimespec(attributes->modificationTime);
     if (![_modificationDate isEqualToDate:modificationDate]) {
         _modificationDate = modificationDate;
         hasChanges = YES;
@@ -141,46 +191,100 @@
     // If the type is a file
     if (_type == TOFileSystemItemTypeFile) {
         // Fetch the item file size
-        long long fileSize = _fileURL.to_size;
+        long long fileSize = attributes->size;
         if (fileSize != _size) {
             _size = fileSize;
             hasChanges = YES;
         }
         
         // Check to see if it is copying
-        BOOL isCopying = _fileURL.to_isCopying;
+        // (While still being copied, the modification date will be close to the current time)
+        BOOL isCopying = [modificationDate timeIntervalSinceNow] >
+                                (-kTOFileSystemObserverCopyingTimeDelay - FLT_EPSILON);
         if (isCopying != _isCopying) {
             _isCopying = isCopying;
             hasChanges = YES;
         }
     }
-    else {
-        // Else, it's a directory, count the number of items inside
-        NSInteger numberOfChildItems = [_fileURL to_numberOfSubItems];
-        if (_numberOfSubItems != numberOfChildItems) {
-            _numberOfSubItems = numberOfChildItems;
-            hasChanges = YES;
-        }
-    }
     
+    // Directories aren't counted here, as that would mean reading every entry
+    // on each refresh. Adding or removing an item changes the directory's
+    // modification date, which is enough to know the count needs refreshing.
     return hasChanges;
 }
 
+- (void)publishSnapshot
+{
+    [self publishSnapshotWithNumberOfSubItemsChange:NSNotFound];
+}
+
+- (void)publishSnapshotWithNumberOfSubItemsChange:(NSInteger)change
+{
+    // Must be called while holding the lock, once all of the properties have been updated.
+    // Readers only ever retain the pointer, so they always see a complete set of values.
+
+    // Carry over the directory's count from the last snapshot if it was read, and is still valid.
+    // Otherwise, it will be counted again the next time it's needed.
+    NSInteger numberOfSubItems = -1;
+    NSDate *countedModificationDate = nil;
+    TOFileSystemItemSnapshot *previousSnapshot = _currentSnapshot;
+    if (previousSnapshot.type == TOFileSystemItemTypeDirectory && _type == TOFileSystemItemTypeDirectory &&
+        [previousSnapshot.fileURL isEqual:_fileURL]) {
+        NSDate *previousCountedDate = nil;
+        NSInteger previousCount = [previousSnapshot cachedNumberOfSubItemsWithModificationDate:&previousCountedDate];
+        if (previousCount >= 0 && [previousCountedDate isEqualToDate:_modificationDate]) {
+            // The directory hasn't changed since it was counted
+            numberOfSubItems = previousCount;
+            countedModificationDate = previousCountedDate;
+        }
+        else if (previousCount >= 0 && change != NSNotFound &&
+                 [previousCountedDate isEqualToDate:previousSnapshot.modificationDate]) {
+            // It was counted before the changes the observer just reported, so apply them to the count.
+            // The modification date just read may already include changes that haven't been reported yet
+            // (or excluded items the observer never reports), so the adjusted count isn't marked as
+            // valid for it. It will be used until the next refresh, which will count it again.
+            numberOfSubItems = MAX(previousCount + change, 0);
+        }
+    }
+
+    _currentSnapshot = [[TOFileSystemItemSnapshot alloc] initWithFileURL:_fileURL
+                                                                    type:_type
+                                                                    uuid:_uuidValue
+                                                                    name:_name
+                                                                    size:_size
+                                                            creationDate:_creationDate
+                                                        modificationDate:_modificationDate
+                                                        numberOfSubItems:numberOfSubItems
+                                                 countedModificationDate:countedModificationDate
+                                                               isCopying:_isCopying];
+}
+
 - (BOOL)isDeleted
 {
-    return ![[NSFileManager defaultManager] fileExistsAtPath:self.fileURL.path];
+    return ![[NSFileManager defaultManager] fileExistsAtPath:self.snapshot.fileURL.path];
 }
 
 - (void)regenerateUUID
 {
     [self performWithLock:^{
         [self configureUUIDForceRefresh:YES];
+        [self publishSnapshot];
     }];
 }
 
 #pragma mark - Lists -
 
 - (BOOL)refreshWithURL:(nullable NSURL *)itemURL
+{
+    return [self refreshWithURL:itemURL numberOfSubItemsChange:NSNotFound];
+}
+
+- (BOOL)refreshWithNumberOfSubItemsChange:(NSInteger)change
+{
+    return [self refreshWithURL:nil numberOfSubItemsChange:change];
+}
+
+- (BOOL)refreshWithURL:(nullable NSURL *)itemURL numberOfSubItemsChange:(NSInteger)change
 {
     // Perform a re-fetch of all of the properties of the
     // item from disk, and re-populate all of the properties.
@@ -190,6 +294,7 @@
     __block BOOL hasChanges = NO;
     [self performWithLock:^{
         hasChanges = [self refreshFromItemAtURL:itemURL];
+        [self publishSnapshotWithNumberOfSubItemsChange:change];
     }];
     
     // If it was detected one or more of the properties were
@@ -198,7 +303,7 @@
     if (hasChanges) {
         [NSOperationQueue.mainQueue addOperationWithBlock:^{
             if (self.list == nil) { return; }
-            [self.list itemDidRefreshWithUUID:self.uuid];
+            [self.list itemDidRefreshWithUUID:self.uuidValue];
         }];
     }
     
@@ -223,46 +328,38 @@
     if (![object isKindOfClass:TOFileSystemItem.class]) { return NO; }
     
     TOFileSystemItem *item = (TOFileSystemItem *)object;
-    return [item.uuid isEqualToString:self.uuid];
+    return [item.uuidValue isEqualToUUID:self.uuidValue];
 }
 
 - (NSUInteger)hash
 {
-    return self.uuid.hash;
+    return self.uuidValue.hash;
 }
 
 #pragma mark - Thread-Safe Accessors -
 
-// To ensure thread safety, fetch the value of an object
-// on the barrier queue
-- (id)fetchValueForObject:(NSString *)objectName
-{
-    __block id objectValue = nil;
-    [self performWithLock:^{
-        objectValue = [self valueForKey:objectName];
-    }];
-    
-    return objectValue;
-}
-
-- (long long)fetchValueForInteger:(NSString *)integerName
+- (TOFileSystemItemSnapshot *)snapshot
 {
-    __block long long intValue = 0;
+    // Only the pointer swap needs to be guarded. Once retained,
+    // the snapshot can be read without holding the lock.
+    __block TOFileSystemItemSnapshot *snapshot = nil;
     [self performWithLock:^{
-        intValue = [[self valueForKey:integerName] longLongValue];
+        snapshot = self->_currentSnapshot;
     }];
     
-    return intValue;
+    return snapshot;
 }
 
-- (NSURL *)fileURL { return (NSURL *)[self fetchValueForObject:@"_fileURL"]; }
-- (NSString *)uuid { return (NSString *)[self fetchValueForObject:@"_uuid"]; }
-- (NSString *)name { return (NSString *)[self fetchValueForObject:@"_name"]; }
-- (long long)size { return (long long)[self fetchValueForInteger:@"_size"]; }
-- (NSDate *)creationDate { return (NSDate *)[self fetchValueForObject:@"_creationDate"]; }
-- (NSDate *)modificationDate { return (NSDate *)[self fetchValueForObject:@"_modificationDate"]; }
-- (BOOL)isCopying { return (BOOL)[self fetchValueForInteger:@"_isCopying"]; }
-- (NSInteger)numberOfSubItems { return (NSInteger)[self fetchValueForInteger:@"_numberOfSubItems"]; }
+- (NSURL *)fileURL { return self.snapshot.fileURL; }
+- (TOFileSystemItemType)type { return self.snapshot.type; }
+- (NSString *)uuid { return self.snapshot.uuid; }
+- (TOFileSystemUUID *)uuidValue { return self.snapshot.uuidValue; }
+- (NSString *)name { return self.snapshot.name; }
+- (long long)size { return self.snapshot.size; }
+- (NSDate *)creationDate { return self.snapshot.creationDate; }
+- (NSDate *)modificationDate { return self.snapshot.modificationDate; }
+- (BOOL)isCopying { return self.snapshot.isCopying; }
+- (NSInteger)numberOfSubItems { return self.snapshot.numberOfSubItems; }
 
 #pragma mark - Thread Safe Access -
 
@@ -297,13 +394,14 @@
                             @"Created:  %@\n"
                             @"Modified: %@\n";
     
+    TOFileSystemItemSnapshot *snapshot = self.snapshot;
     return [NSString stringWithFormat:description,
-            self.name,
-            self.uuid,
-            self.type != 0 ? @"Folder" : @"File",
-            self.size,
-            self.creationDate,
-            self.modificationDate];
+            snapshot.name,
+            snapshot.uuid,
+            snapshot.type != 0 ? @"Folder" : @"File",
+            snapshot.size,
+            snapshot.creationDate,
+            snapshot.modificationDate];
 }
 
 @end
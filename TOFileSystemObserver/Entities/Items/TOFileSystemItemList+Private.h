@@ -28,22 +28,33 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @class TOFileSystemObserver;
+@class TOFileSystemUUID;
 
 /** Private interface for creating item objects */
 @interface TOFileSystemItemList ()
 
+/** The UUID of the directory as a binary value. (`uuid` converts this to a string.) */
+@property (nonatomic, readonly, nullable) TOFileSystemUUID *uuidValue;
+
 /** Creates a new instance of an item for the target item. */
 - (instancetype)initWithDirectoryURL:(NSURL *)directoryURL
                   fileSystemObserver:(TOFileSystemObserver *)observer;
 
 /** Add a new item to the list. */
-- (void)addItemWithUUID:(NSString *)uuid itemURL:(NSURL *)url;
+- (void)addItemWithUUID:(TOFileSystemUUID *)uuid itemURL:(NSURL *)url;
+
+/**
+ Removes and adds a group of items in one update, and notifies observers with a single set of changes.
+ Deletion indices refer to the list before the update, and insertion indices to the list after it.
+ */
+- (void)removeItemsWithUUIDs:(nullable NSSet<TOFileSystemUUID *> *)removedUUIDs
+                    addItems:(nullable NSDictionary<TOFileSystemUUID *, NSURL *> *)addedItems;
 
 /** Triggered when an item's properties have changed. */
-- (void)itemDidRefreshWithUUID:(NSString *)uuid;
+- (void)itemDidRefreshWithUUID:(TOFileSystemUUID *)uuid;
 
 /** Remove an object from the list (It was deleted or moved away). */
-- (void)removeItemWithUUID:(NSString *)uuid fileURL:(NSURL *)url;
+- (void)removeItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)url;
 
 /** If the folder was moved, update it's own reference to its file path. */
 - (BOOL)refreshWithURL:(nullable NSURL *)directoryURL;
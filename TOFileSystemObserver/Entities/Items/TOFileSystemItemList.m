@@ -23,15 +23,17 @@
 #import "TOFileSystemItemList.h"
 #import "TOFileSystemItem.h"
 #import "TOFileSystemItem+Private.h"
+#import "TOFileSystemItemSortKey.h"
+#import "TOFileSystemOrderStatisticTree.h"
 #import "TOFileSystemObserver.h"
 #import "TOFileSystemPath.h"
 #import "TOFileSystemNotificationToken.h"
 #import "TOFileSystemNotificationToken+Private.h"
 #import "TOFileSystemItemListChanges.h"
 #import "TOFileSystemItemListChanges+Private.h"
+#import "TOFileSystemPresenter.h"
 
-#import "NSURL+TOFileSystemUUID.h"
-#import "NSFileManager+TOFileSystemDirectoryEnumerator.h"
+#import "TOFileSystemUUID.h"
 
 // Because the block is stored as a generic id, we must cast it back before we can call it.
 static inline void TOFileSystemItemListCallBlock(id block, id observer, id changes) {
@@ -39,10 +41,15 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     _block(observer, changes);
 };
 
+/** Private interface to expose the file presenter for reading UUIDs that haven't been written yet. */
+@interface TOFileSystemObserver ()
+@property (nonatomic, readonly) TOFileSystemPresenter *fileSystemPresenter;
+@end
+
 @interface TOFileSystemItemList () <TOFileSystemNotifying>
 
-/** The UUID string of the directory backing this object */
-@property (nonatomic, copy, readwrite) NSString *uuid;
+/** The UUID of the directory backing this object */
+@property (nonatomic, strong, readwrite, nullable) TOFileSystemUUID *uuidValue;
 
 /** A weak reference to the observer object we were created by. */
 @property (nonatomic, weak, readwrite) TOFileSystemObserver *fileSystemObserver;
@@ -51,10 +58,13 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
 @property (nonatomic, strong, readwrite) NSURL *directoryURL;
 
 /** An dictionary of the items in this dictionary, stored by their UUID. */
-@property (nonatomic, strong) NSMutableDictionary<NSString *, TOFileSystemItem *> *items;
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, TOFileSystemItem *> *items;
+
+/** The values each item is sorted by, captured whenever it changes, by UUID. */
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, TOFileSystemItemSortKey *> *sortKeys;
 
-/** An array of the item UUIDs, sorted in the order specified. */
-@property (nonatomic, strong) NSMutableArray<NSString *> *sortedItems;
+/** The sort keys of each item, sorted in the order specified, and indexable in O(log n). */
+@property (nonatomic, strong) TOFileSystemOrderStatisticTree<TOFileSystemItemSortKey *> *sortedItems;
 
 /** A set that holds all of the notification tokens generated by this list */
 @property (nonatomic, strong) NSHashTable *notificationTokens;
@@ -69,7 +79,7 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     if (self = [super init]) {
         _fileSystemObserver = observer;
         _directoryURL = directoryURL;
-        _uuid = [directoryURL to_fileSystemUUID];
+        _uuidValue = [observer.fileSystemPresenter existingUUIDForItemAtURL:directoryURL];
         [self commonInit];
     }
     
@@ -80,28 +90,25 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
 {
     // Create the file list stores
     _items = [NSMutableDictionary dictionary];
-    _sortedItems = [NSMutableArray array];
+    _sortKeys = [NSMutableDictionary dictionary];
+    _sortedItems = [[TOFileSystemOrderStatisticTree alloc] initWithComparator:self.sortComparator];
 }
 
 - (void)buildItemsList
 {
-    NSFileManager *fileManager = [NSFileManager defaultManager];
-    NSDirectoryEnumerator *enumerator = [fileManager to_fileSystemEnumeratorForDirectoryAtURL:_directoryURL];
-    
     // Build a new list of files from what is currently on disk
-    for (NSURL *url in enumerator) {
-        TOFileSystemItem *item = [self.fileSystemObserver itemForFileAtURL:url];
-
+    NSArray<TOFileSystemItem *> *items = [self.fileSystemObserver itemsInDirectoryAtURL:_directoryURL];
+    for (TOFileSystemItem *item in items) {
         // Add the list to the item's store so it can notify of updates
         [item addToList:self];
         
         // Capture the item with its UUID in the dictionary
-        _items[item.uuid] = item;
+        _items[item.uuidValue] = item;
+        [self updateSortKeyForItem:item];
     }
     
     // Sort according to our current sort settings
-    _sortedItems = _items.allKeys.mutableCopy;
-    [self sortItemsList];
+    [_sortedItems setObjects:_sortKeys.allValues];
 }
 
 - (void)rebuildItemListForListingOrder
@@ -109,24 +116,16 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     if (self.sortedItems.count == 0) { return; }
     
     // Grab a copy of the current list
-    NSArray *previousList = [self.sortedItems copy];
+    NSArray<TOFileSystemItemSortKey *> *previousList = self.sortedItems.allObjects;
     
     // Sort the list to the new order
     [self sortItemsList];
     
-    // Build a dictionary of all of the UUIDs so we can map the old
-    // ordering to the new ordering, but use the hashing features of the
-    // dictionary to avoid doing random lookup each time for each item
-    NSMutableDictionary *newSortedItemsDict = [NSMutableDictionary dictionary];
-    for (NSInteger i = 0; i < self.sortedItems.count; i++) {
-        newSortedItemsDict[self.sortedItems[i]] = @(i);
-    }
-    
     // Loop through and build a list of indices for each moved cell.
     TOFileSystemItemListChanges *changes = [[TOFileSystemItemListChanges alloc] init];
     for (NSInteger i = 0; i < previousList.count; i++) {
         // Work out where the item in the new list went
-        NSInteger newIndex = [newSortedItemsDict[previousList[i]] intValue];
+        NSInteger newIndex = [self.sortedItems indexOfObject:previousList[i]];
         [changes addMovementWithSourceIndex:i destinationIndex:newIndex];
     }
     
@@ -140,56 +139,23 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
 
 - (NSComparator)sortComparator
 {
-    __weak typeof(self) weakSelf = self;
-    return ^NSComparisonResult(NSString *firstUUID, NSString *secondUUID) {
-        // Check if the UUID matches
-        if ([firstUUID isEqualToString:secondUUID]) {
-            return NSOrderedSame;
-        }
-        
-        TOFileSystemItem *firstItem = weakSelf.items[firstUUID];
-        TOFileSystemItem *secondItem = weakSelf.items[secondUUID];
-        
-        // If the order is flipped, swap around the two items
-        if (self.isDescending) {
-            TOFileSystemItem *tempItem = firstItem;
-            firstItem = secondItem;
-            secondItem = tempItem;
-        }
-        
-        switch (weakSelf.listOrder) {
-            case TOFileSystemItemListOrderAlphanumeric:
-            {
-                return [firstItem.name localizedStandardCompare:secondItem.name];
-            }
-            case TOFileSystemItemListOrderDate:
-            {
-                return [firstItem.modificationDate compare:secondItem.modificationDate];
-            }
-            default:
-            {
-                // File sizes always go descending by default.
-                // Compare file names if the sizes match to keep clean ordering (Because folders are always 0)
-                NSComparisonResult result = [@(secondItem.size) compare:@(firstItem.size)];
-                if (result == NSOrderedSame) { return [firstItem.name localizedStandardCompare:secondItem.name]; }
-                return result;
-            }
-        }
-    };
+    // Items are compared by the values captured in their sort keys,
+    // so sorting never needs to touch the items themselves
+    return [TOFileSystemItemSortKey comparatorForListOrder:self.listOrder isDescending:self.isDescending];
 }
 
-- (void)sortItemsList
+- (TOFileSystemItemSortKey *)updateSortKeyForItem:(TOFileSystemItem *)item
 {
-    // Sort all of the UUIDS
-    [_sortedItems sortUsingComparator:self.sortComparator];
+    TOFileSystemUUID *uuid = item.uuidValue;
+    TOFileSystemItemSortKey *sortKey = [[TOFileSystemItemSortKey alloc] initWithUUID:uuid snapshot:item.snapshot];
+    self.sortKeys[uuid] = sortKey;
+    return sortKey;
 }
 
-- (NSUInteger)sortedIndexForItemWithUUID:(NSString *)uuid
+- (void)sortItemsList
 {
-    return [self.sortedItems indexOfObject:uuid
-                             inSortedRange:(NSRange){0, self.sortedItems.count}
-                                   options:NSBinarySearchingInsertionIndex
-                           usingComparator:self.sortComparator];
+    // Re-sort all of the items with the current order. (Large lists are sorted across multiple threads.)
+    _sortedItems.comparator = self.sortComparator;
 }
 
 #pragma mark - External Item Access -
@@ -206,12 +172,12 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
 
 - (TOFileSystemItem *)objectAtIndex:(NSUInteger)index
 {
-    return self.items[self.sortedItems[index]];
+    return self.items[self.sortedItems[index].uuid];
 }
 
 - (id)objectAtIndexedSubscript:(NSUInteger)index
 {
-    return self.items[self.sortedItems[index]];
+    return self.items[self.sortedItems[index].uuid];
 }
 
 - (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
@@ -225,7 +191,7 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
 
 #pragma mark - Live Item Updating -
 
-- (void)addItemWithUUID:(NSString *)uuid itemURL:(NSURL *)url
+- (void)addItemWithUUID:(TOFileSystemUUID *)uuid itemURL:(NSURL *)url
 {
     // Skip if this item is already in the list
     if (self.items[uuid]) { return; }
@@ -233,11 +199,11 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     // Generate a new item and add it to our list
     TOFileSystemItem *item = [self.fileSystemObserver itemForFileAtURL:url];
     [item addToList:self];
-    self.items[item.uuid] = item;
+    self.items[item.uuidValue] = item;
     
-    // Work out where the item should go in our sorted list
-    NSUInteger sortedIndex = [self sortedIndexForItemWithUUID:item.uuid];
-    [self.sortedItems insertObject:item.uuid atIndex:sortedIndex];
+    // Insert the item into its sorted position in our list
+    TOFileSystemItemSortKey *sortKey = [self updateSortKeyForItem:item];
+    NSUInteger sortedIndex = [self.sortedItems insertObject:sortKey];
     
     // Perform the broadcast to any observing objects that this update ocurred
     TOFileSystemItemListChanges *changes = [[TOFileSystemItemListChanges alloc] init];
@@ -247,21 +213,21 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     }
 }
 
-- (void)removeItemWithUUID:(NSString *)uuid fileURL:(NSURL *)url
+- (void)removeItemWithUUID:(TOFileSystemUUID *)uuid fileURL:(NSURL *)url
 {
     // Verify the item is still here
     if (self.items[uuid] == nil) { return; }
     
-    // Work out where the item is in the list
-    NSInteger index = [self.sortedItems indexOfObject:uuid];
+    // Remove the item from the sorted list, capturing where it was
+    NSInteger index = [self.sortedItems removeObject:self.sortKeys[uuid]];
     NSAssert(index != NSNotFound, @"items and sortedItems should never be out of sync");
     
     // Un-assign the list
     [self.items[uuid] removeFromList];
     
-    // Remove the item from both stores
+    // Remove the item from the other stores
     [self.items removeObjectForKey:uuid];
-    [self.sortedItems removeObjectAtIndex:index];
+    [self.sortKeys removeObjectForKey:uuid];
     
     // Trigger the notification blocks
     TOFileSystemItemListChanges *changes = [[TOFileSystemItemListChanges alloc] init];
@@ -272,29 +238,86 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     }
 }
 
-- (void)itemDidRefreshWithUUID:(NSString *)uuid
+- (void)removeItemsWithUUIDs:(NSSet<TOFileSystemUUID *> *)removedUUIDs addItems:(NSDictionary<TOFileSystemUUID *, NSURL *> *)addedItems
+{
+    TOFileSystemItemListChanges *changes = [[TOFileSystemItemListChanges alloc] init];
+
+    // Work out where each removed item was in the list before anything changes
+    NSMutableIndexSet *deletedIndexes = [NSMutableIndexSet indexSet];
+    NSMutableArray<TOFileSystemItemSortKey *> *deletedSortKeys = [NSMutableArray array];
+    for (TOFileSystemUUID *uuid in removedUUIDs) {
+        if (self.items[uuid] == nil) { continue; }
+
+        TOFileSystemItemSortKey *sortKey = self.sortKeys[uuid];
+        NSUInteger index = [self.sortedItems indexOfObject:sortKey];
+        NSAssert(index != NSNotFound, @"items and sortedItems should never be out of sync");
+        [deletedIndexes addIndex:index];
+        [deletedSortKeys addObject:sortKey];
+
+        [self.items[uuid] removeFromList];
+        [self.items removeObjectForKey:uuid];
+        [self.sortKeys removeObjectForKey:uuid];
+    }
+    for (TOFileSystemItemSortKey *sortKey in deletedSortKeys) {
+        [self.sortedItems removeObject:sortKey];
+    }
+    [deletedIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [changes addDeletionIndex:index];
+    }];
+
+    // Insert each new item into its sorted position
+    NSMutableArray<TOFileSystemItemSortKey *> *insertedSortKeys = [NSMutableArray array];
+    for (TOFileSystemUUID *uuid in addedItems) {
+        if (self.items[uuid]) { continue; }
+
+        TOFileSystemItem *item = [self.fileSystemObserver itemForFileAtURL:addedItems[uuid]];
+        if (item == nil) { continue; }
+        [item addToList:self];
+        self.items[item.uuidValue] = item;
+
+        TOFileSystemItemSortKey *sortKey = [self updateSortKeyForItem:item];
+        [self.sortedItems insertObject:sortKey];
+        [insertedSortKeys addObject:sortKey];
+    }
+
+    // Once they're all in, capture where they ended up (in ascending order)
+    NSMutableIndexSet *insertedIndexes = [NSMutableIndexSet indexSet];
+    for (TOFileSystemItemSortKey *sortKey in insertedSortKeys) {
+        [insertedIndexes addIndex:[self.sortedItems indexOfObject:sortKey]];
+    }
+    [insertedIndexes enumerateIndexesUsingBlock:^(NSUInteger index, BOOL *stop) {
+        [changes addInsertionIndex:index];
+    }];
+
+    // Skip if nothing actually changed
+    if (deletedIndexes.count == 0 && insertedIndexes.count == 0) { return; }
+
+    // Perform the broadcast to any observing objects that this update ocurred
+    for (TOFileSystemNotificationToken *token in self.notificationTokens) {
+        TOFileSystemItemListCallBlock(token.notificationBlock, self, changes);
+    }
+}
+
+- (void)itemDidRefreshWithUUID:(TOFileSystemUUID *)uuid
 {
     // Verify the item is still here
-    if (self.items[uuid] == nil) { return; }
+    TOFileSystemItem *item = self.items[uuid];
+    if (item == nil) { return; }
     
     // Create a changes object for the notification blocks
     TOFileSystemItemListChanges *changes = [[TOFileSystemItemListChanges alloc] init];
     
-    // Work out where it is in the list
-    NSInteger oldIndex = [self.sortedItems indexOfObject:uuid];
+    // Take it out of the list, noting where it was
+    NSInteger oldIndex = [self.sortedItems removeObject:self.sortKeys[uuid]];
     
-    // Work out where it should go in the list
-    [self.sortedItems removeObjectAtIndex:oldIndex];
-    NSInteger newIndex = [self sortedIndexForItemWithUUID:uuid];
+    // Capture its new values, and insert it where it now belongs
+    TOFileSystemItemSortKey *sortKey = [self updateSortKeyForItem:item];
+    NSInteger newIndex = [self.sortedItems insertObject:sortKey];
     
-    // Move it to the new location
+    // Record if it moved
     if (oldIndex != newIndex) {
-        [self.sortedItems insertObject:uuid atIndex:newIndex];
         [changes addMovementWithSourceIndex:oldIndex destinationIndex:newIndex];
     }
-    else {
-        [self.sortedItems insertObject:uuid atIndex:oldIndex];
-    }
     
     // Set the change object to reload the item
     [changes addModificationIndex:newIndex];
@@ -312,21 +335,23 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     
     // Loop through every file in this list, and double-check it's still on disk
     TOFileSystemItemListChanges *changes = [[TOFileSystemItemListChanges alloc] init];
-    for (NSInteger i = 0; i < self.sortedItems.count; i++) {
-        TOFileSystemItem *item = self.items[self.sortedItems[i]];
+    NSMutableArray<TOFileSystemItemSortKey *> *deletedSortKeys = [NSMutableArray array];
+    [self.sortedItems enumerateObjectsUsingBlock:^(TOFileSystemItemSortKey *sortKey, NSUInteger index, BOOL *stop) {
+        TOFileSystemItem *item = self.items[sortKey.uuid];
         if (item.isDeleted) {
-            [changes addDeletionIndex:i];
+            [changes addDeletionIndex:index];
+            [deletedSortKeys addObject:sortKey];
         }
-    }
+    }];
     
     // Skip if every file was accounted for
     if (changes.deletions.count == 0) { return; }
     
     // Remove all of the deleted files from the list
-    for (NSNumber *deletedIndex in changes.deletions) {
-        NSString *uuid = self.sortedItems[deletedIndex.intValue];
-        [self.sortedItems removeObjectAtIndex:deletedIndex.intValue];
-        [self.items removeObjectForKey:uuid];
+    for (TOFileSystemItemSortKey *sortKey in deletedSortKeys) {
+        [self.sortedItems removeObject:sortKey];
+        [self.items removeObjectForKey:sortKey.uuid];
+        [self.sortKeys removeObjectForKey:sortKey.uuid];
     }
     
     // Broadcast the changes
@@ -370,6 +395,11 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
     [self rebuildItemListForListingOrder];
 }
 
+- (NSString *)uuid
+{
+    return self.uuidValue.stringValue;
+}
+
 - (BOOL)refreshWithURL:(NSURL *)directoryURL
 {
     if (directoryURL == nil) { return NO; }
@@ -391,7 +421,7 @@ static inline void TOFileSystemItemListCallBlock(id block, id observer, id chang
 {
     return [NSString stringWithFormat:@"url = '%@', uuid = '%@', listOrder = %ld, isDescending = %d, items = '%@'",
             _directoryURL,
-            _uuid,
+            _uuidValue,
             (long)_listOrder,
             _isDescending,
             _items];
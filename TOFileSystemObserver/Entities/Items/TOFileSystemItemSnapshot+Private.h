@@ -0,0 +1,63 @@
+//
+//  TOFileSystemItemSnapshot+Private.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "TOFileSystemItemSnapshot.h"
+
+@class TOFileSystemUUID;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** Private interface for creating snapshot objects */
+@interface TOFileSystemItemSnapshot ()
+
+/** The UUID of the item as a binary value. (`uuid` converts this to a string.) */
+@property (nonatomic, readonly, nullable) TOFileSystemUUID *uuidValue;
+
+/**
+ Creates a new snapshot with the current values of an item.
+ For directories, pass a negative `numberOfSubItems` to have it counted on first read.
+ Otherwise, `countedModificationDate` is the modification date of the directory the count is valid for.
+ */
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+                           type:(TOFileSystemItemType)type
+                           uuid:(nullable TOFileSystemUUID *)uuid
+                           name:(nullable NSString *)name
+                           size:(long long)size
+                   creationDate:(nullable NSDate *)creationDate
+               modificationDate:(nullable NSDate *)modificationDate
+               numberOfSubItems:(NSInteger)numberOfSubItems
+        countedModificationDate:(nullable NSDate *)countedModificationDate
+                      isCopying:(BOOL)isCopying NS_DESIGNATED_INITIALIZER;
+
+/**
+ Returns the number of sub-items if it has already been counted, or a negative value if not.
+ Unlike `numberOfSubItems`, this never touches the disk.
+
+ @param countedModificationDate Set to the modification date of the directory when it was counted,
+                                or nil if that isn't known (eg, it changed while being counted).
+ */
+- (NSInteger)cachedNumberOfSubItemsWithModificationDate:(NSDate * _Nullable * _Nonnull)countedModificationDate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,73 @@
+//
+//  TOFileSystemItemSnapshot.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "TOFileSystemObserverConstants.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ An immutable copy of the properties of a file system item,
+ captured at a single point in time.
+
+ Since the values can't change after creation, a snapshot may be freely
+ read from any thread, and its properties will always be consistent with each other.
+ */
+NS_SWIFT_NAME(FileSystemItemSnapshot)
+@interface TOFileSystemItemSnapshot : NSObject
+
+/** The absolute URL path to the item. */
+@property (nonatomic, readonly) NSURL *fileURL;
+
+/** The type of the item (either a file or folder) */
+@property (nonatomic, readonly) TOFileSystemItemType type;
+
+/** The unique UUID that was assigned to the file by this library. */
+@property (nonatomic, readonly) NSString *uuid;
+
+/** The name on disk of the item. */
+@property (nonatomic, readonly) NSString *name;
+
+/** The size (in bytes) of the item. (0 for directories). */
+@property (nonatomic, readonly) long long size;
+
+/** The creation date of the item. */
+@property (nonatomic, readonly) NSDate *creationDate;
+
+/** The last modification date of the item. */
+@property (nonatomic, readonly) NSDate *modificationDate;
+
+/**
+ If a directory, the number of files/subdirectories inside the item.
+ This is counted the first time it is read, and then kept for as long as the directory is unchanged.
+ */
+@property (nonatomic, readonly) NSInteger numberOfSubItems;
+
+/** Whether the item was still being copied into the app container. */
+@property (nonatomic, readonly) BOOL isCopying;
+
+- (instancetype)init NS_UNAVAILABLE;
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
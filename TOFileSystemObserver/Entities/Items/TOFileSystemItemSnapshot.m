@@ -0,0 +1,115 @@
+//
+//  TOFileSystemItemSnapshot.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemItemSnapshot.h"
+#import "TOFileSystemItemSnapshot+Private.h"
+#import "TOFileSystemUUID.h"
+#import "NSURL+TOFileSystemAttributes.h"
+#import "TOFileSystemLock.h"
+
+@implementation TOFileSystemItemSnapshot {
+    // Counted lazily, since it requires reading every entry of the directory.
+    // The count and the directory state it was taken from are updated together under the lock.
+    NSInteger _numberOfSubItems;
+    NSDate *_countedModificationDate;
+    TOFileSystemLock _countLock;
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL
+                           type:(TOFileSystemItemType)type
+                           uuid:(nullable TOFileSystemUUID *)uuid
+                           name:(nullable NSString *)name
+                           size:(long long)size
+                   creationDate:(nullable NSDate *)creationDate
+               modificationDate:(nullable NSDate *)modificationDate
+               numberOfSubItems:(NSInteger)numberOfSubItems
+        countedModificationDate:(nullable NSDate *)countedModificationDate
+                      isCopying:(BOOL)isCopying
+{
+    if (self = [super init]) {
+        _fileURL = fileURL;
+        _type = type;
+        _uuidValue = uuid;
+        _name = [name copy];
+        _size = size;
+        _creationDate = creationDate;
+        _modificationDate = modificationDate;
+        _isCopying = isCopying;
+        if (type == TOFileSystemItemTypeDirectory) {
+            _numberOfSubItems = numberOfSubItems;
+            _countedModificationDate = (numberOfSubItems >= 0) ? countedModificationDate : nil;
+        }
+        TOFileSystemLockInit(&_countLock);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    TOFileSystemLockDestroy(&_countLock);
+}
+
+- (NSString *)uuid { return _uuidValue.stringValue; }
+
+- (NSInteger)cachedNumberOfSubItemsWithModificationDate:(NSDate * _Nullable __autoreleasing *)countedModificationDate
+{
+    TOFileSystemLockLock(&_countLock);
+    NSInteger numberOfSubItems = _numberOfSubItems;
+    *countedModificationDate = _countedModificationDate;
+    TOFileSystemLockUnlock(&_countLock);
+    return numberOfSubItems;
+}
+
+- (NSInteger)numberOfSubItems
+{
+    NSDate *countedModificationDate = nil;
+    NSInteger numberOfSubItems = [self cachedNumberOfSubItemsWithModificationDate:&countedModificationDate];
+    if (numberOfSubItems >= 0) { return numberOfSubItems; }
+
+    // Count outside of the lock. If two threads race here, the first result to be stored is kept.
+    struct timespec modificationTime;
+    numberOfSubItems = [_fileURL to_numberOfSubItemsWithModificationTime:&modificationTime];
+    if (modificationTime.tv_sec != 0 || modificationTime.tv_nsec != 0) {
+        countedModificationDate = TOFileSystemDateFromTimespec(modificationTime);
+    }
+
+    TOFileSystemLockLock(&_countLock);
+    if (_numberOfSubItems < 0) {
+        _numberOfSubItems = numberOfSubItems;
+        _countedModificationDate = countedModificationDate;
+    }
+    numberOfSubItems = _numberOfSubItems;
+    TOFileSystemLockUnlock(&_countLock);
+
+    return numberOfSubItems;
+}
+
+#pragma mark - Debugging -
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> name: %@, uuid: %@, size: %lld, modified: %@",
+            NSStringFromClass(self.class), self, _name, self.uuid, _size, _modificationDate];
+}
+
+@end
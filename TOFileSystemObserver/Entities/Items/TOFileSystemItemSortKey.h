@@ -0,0 +1,67 @@
+//
+//  TOFileSystemItemSortKey.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "TOFileSystemObserverConstants.h"
+
+@class TOFileSystemUUID;
+@class TOFileSystemItemSnapshot;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The values an item list sorts an item by, captured once each time the item changes,
+ so sorting never needs to look up the item, take its lock, or box any values.
+
+ Names are given a binary collation key that orders the same way as `localizedStandardCompare:`,
+ so most comparisons are a single `memcmp`. Names that can't be given one (eg, ones containing
+ characters outside of ASCII, or when the current locale collates ASCII differently), or names
+ whose keys are equal (eg, they only differ by case), fall back to comparing the names themselves.
+ */
+@interface TOFileSystemItemSortKey : NSObject
+
+/** The UUID of the item. */
+@property (nonatomic, readonly) TOFileSystemUUID *uuid;
+
+/** The name of the item on disk. */
+@property (nonatomic, readonly) NSString *name;
+
+/** The modification date of the item, as seconds since the reference date. */
+@property (nonatomic, readonly) NSTimeInterval modificationTime;
+
+/** The size of the item, in bytes. */
+@property (nonatomic, readonly) long long size;
+
+/** Captures the sort values of an item from a snapshot of its properties. */
+- (instancetype)initWithUUID:(TOFileSystemUUID *)uuid snapshot:(nullable TOFileSystemItemSnapshot *)snapshot;
+
+/** Compares the names of two items, in the same order as `localizedStandardCompare:`. */
+- (NSComparisonResult)compareName:(TOFileSystemItemSortKey *)sortKey;
+
+/** Creates a comparator for sorting sort keys in the given order. It can be called from multiple threads at once. */
++ (NSComparator)comparatorForListOrder:(TOFileSystemItemListOrder)listOrder isDescending:(BOOL)isDescending;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
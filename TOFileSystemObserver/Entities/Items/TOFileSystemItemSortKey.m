@@ -0,0 +1,230 @@
+//
+//  TOFileSystemItemSortKey.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemItemSortKey.h"
+#import "TOFileSystemItemSnapshot.h"
+#import "TOFileSystemUUID.h"
+
+/** The primary collation weight of each ASCII character, or 0 if it can't be given a key. */
+static uint8_t TOFileSystemCollationWeights[128];
+
+/** Whether the weights were able to be built for the current locale. */
+static BOOL TOFileSystemCollationIsAvailable = NO;
+
+/** The longest name (in characters) that will be given a key. Longer names fall back to comparing the strings. */
+static const NSUInteger kTOFileSystemCollationMaximumLength = 255;
+
+#pragma mark - Collation Weights -
+
+static NSComparisonResult TOFileSystemCollationCompare(NSString *first, NSString *second)
+{
+    return [first localizedStandardCompare:second];
+}
+
+static BOOL TOFileSystemCollationPrepareWeights(void)
+{
+    // Rather than hard-coding an order, sort a representative of each printable ASCII character
+    // with the same method used for names, so the weights match the current locale.
+    // (Upper case letters share the weight of their lower case letter, and digits are compared
+    // as whole numbers, so '0' stands in for all of them.)
+    NSMutableArray<NSString *> *characters = [NSMutableArray array];
+    for (unichar c = 0x20; c < 0x7F; c++) {
+        if ((c >= 'A' && c <= 'Z') || (c >= '1' && c <= '9')) { continue; }
+        [characters addObject:[NSString stringWithCharacters:&c length:1]];
+    }
+    [characters sortUsingComparator:^NSComparisonResult(NSString *first, NSString *second) {
+        return TOFileSystemCollationCompare(first, second);
+    }];
+
+    // Assign increasing weights, starting at 1 so 0 can mark characters without one
+    uint8_t weight = 0;
+    NSString *previousCharacter = nil;
+    for (NSString *character in characters) {
+        if (previousCharacter == nil || TOFileSystemCollationCompare(previousCharacter, character) != NSOrderedSame) {
+            weight++;
+        }
+        TOFileSystemCollationWeights[[character characterAtIndex:0]] = weight;
+        previousCharacter = character;
+    }
+    for (unichar c = 'A'; c <= 'Z'; c++) { TOFileSystemCollationWeights[c] = TOFileSystemCollationWeights[c - 'A' + 'a']; }
+    for (unichar c = '1'; c <= '9'; c++) { TOFileSystemCollationWeights[c] = TOFileSystemCollationWeights['0']; }
+
+    // Make sure each character keeps its order when it's followed by more characters.
+    // (This fails if the locale ignores punctuation, or doesn't compare character by character.)
+    for (NSString *first in characters) {
+        uint8_t firstWeight = TOFileSystemCollationWeights[[first characterAtIndex:0]];
+        NSString *longerString = [NSString stringWithFormat:@"a%@z", first];
+        for (NSString *second in characters) {
+            uint8_t secondWeight = TOFileSystemCollationWeights[[second characterAtIndex:0]];
+            if (firstWeight == secondWeight) { continue; }
+
+            NSComparisonResult expectedResult = (firstWeight < secondWeight) ? NSOrderedAscending : NSOrderedDescending;
+            NSString *shorterString = [@"a" stringByAppendingString:second];
+            if (TOFileSystemCollationCompare(longerString, shorterString) != expectedResult) { return NO; }
+        }
+    }
+
+    // Make sure no pair of letters is sorted as a single letter (eg, "aa" in Danish)
+    NSMutableArray<NSString *> *letters = [NSMutableArray array];
+    for (NSString *character in characters) {
+        unichar c = [character characterAtIndex:0];
+        if (c >= 'a' && c <= 'z') { [letters addObject:character]; }
+    }
+    for (NSUInteger i = 0; i < letters.count; i++) {
+        NSString *nextLetter = (i + 1 < letters.count) ? letters[i + 1] : nil;
+        for (NSString *letter in letters) {
+            NSString *pair = [letters[i] stringByAppendingString:letter];
+            if (TOFileSystemCollationCompare(pair, letters[i]) != NSOrderedDescending) { return NO; }
+            if (nextLetter && TOFileSystemCollationCompare(pair, nextLetter) != NSOrderedAscending) { return NO; }
+        }
+    }
+
+    return YES;
+}
+
+static NSData *TOFileSystemCollationKeyForName(NSString *name)
+{
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        TOFileSystemCollationIsAvailable = TOFileSystemCollationPrepareWeights();
+    });
+    if (!TOFileSystemCollationIsAvailable) { return nil; }
+
+    NSUInteger length = name.length;
+    if (length == 0 || length > kTOFileSystemCollationMaximumLength) { return nil; }
+
+    unichar characters[kTOFileSystemCollationMaximumLength];
+    [name getCharacters:characters range:NSMakeRange(0, length)];
+
+    // Each character is at most three bytes (a run of digits is a weight, a length, and then each digit)
+    uint8_t key[kTOFileSystemCollationMaximumLength * 3];
+    NSUInteger keyLength = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar c = characters[i];
+        if (c >= 128 || TOFileSystemCollationWeights[c] == 0) { return nil; }
+
+        // Letters and punctuation are written as their weight
+        if (c < '0' || c > '9') {
+            key[keyLength++] = TOFileSystemCollationWeights[c];
+            continue;
+        }
+
+        // Numbers are compared by value, so skip leading zeros, and write the
+        // number of digits before the digits themselves. (Numbers that only differ by
+        // their leading zeros end up with the same key, and are compared by name.)
+        NSUInteger end = i;
+        while (end < length && characters[end] >= '0' && characters[end] <= '9') { end++; }
+        NSUInteger start = i;
+        while (start < end - 1 && characters[start] == '0') { start++; }
+
+        key[keyLength++] = TOFileSystemCollationWeights['0'];
+        key[keyLength++] = (uint8_t)(end - start);
+        for (NSUInteger j = start; j < end; j++) { key[keyLength++] = (uint8_t)characters[j]; }
+        i = end - 1;
+    }
+
+    return [NSData dataWithBytes:key length:keyLength];
+}
+
+#pragma mark - Sort Key -
+
+@implementation TOFileSystemItemSortKey {
+    NSData *_nameKey;
+}
+
+- (instancetype)initWithUUID:(TOFileSystemUUID *)uuid snapshot:(TOFileSystemItemSnapshot *)snapshot
+{
+    if (self = [super init]) {
+        _uuid = uuid;
+        _name = snapshot.name ?: @"";
+        _nameKey = TOFileSystemCollationKeyForName(_name);
+        _modificationTime = snapshot.modificationDate.timeIntervalSinceReferenceDate;
+        _size = snapshot.size;
+    }
+
+    return self;
+}
+
+- (NSComparisonResult)compareName:(TOFileSystemItemSortKey *)sortKey
+{
+    NSData *firstKey = _nameKey;
+    NSData *secondKey = sortKey->_nameKey;
+    if (firstKey && secondKey) {
+        NSUInteger firstLength = firstKey.length;
+        NSUInteger secondLength = secondKey.length;
+        int result = memcmp(firstKey.bytes, secondKey.bytes, MIN(firstLength, secondLength));
+        if (result < 0) { return NSOrderedAscending; }
+        if (result > 0) { return NSOrderedDescending; }
+        if (firstLength < secondLength) { return NSOrderedAscending; }
+        if (firstLength > secondLength) { return NSOrderedDescending; }
+    }
+
+    return [_name localizedStandardCompare:sortKey->_name];
+}
+
++ (NSComparator)comparatorForListOrder:(TOFileSystemItemListOrder)listOrder isDescending:(BOOL)isDescending
+{
+    return ^NSComparisonResult(TOFileSystemItemSortKey *firstKey, TOFileSystemItemSortKey *secondKey) {
+        // Check if the UUID matches
+        if (firstKey == secondKey || [firstKey.uuid isEqualToUUID:secondKey.uuid]) {
+            return NSOrderedSame;
+        }
+
+        // If the order is flipped, swap around the two items
+        if (isDescending) {
+            TOFileSystemItemSortKey *tempKey = firstKey;
+            firstKey = secondKey;
+            secondKey = tempKey;
+        }
+
+        switch (listOrder) {
+            case TOFileSystemItemListOrderAlphanumeric:
+            {
+                return [firstKey compareName:secondKey];
+            }
+            case TOFileSystemItemListOrderDate:
+            {
+                if (firstKey->_modificationTime < secondKey->_modificationTime) { return NSOrderedAscending; }
+                if (firstKey->_modificationTime > secondKey->_modificationTime) { return NSOrderedDescending; }
+                return NSOrderedSame;
+            }
+            default:
+            {
+                // File sizes always go descending by default.
+                // Compare file names if the sizes match to keep clean ordering (Because folders are always 0)
+                if (secondKey->_size < firstKey->_size) { return NSOrderedAscending; }
+                if (secondKey->_size > firstKey->_size) { return NSOrderedDescending; }
+                return [firstKey compareName:secondKey];
+            }
+        }
+    };
+}
+
+#pragma mark - Debugging -
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> name: %@, size: %lld, modified: %f",
+            NSStringFromClass(self.class), self, _name, _size, _modificationTime];
+}
+
+@end
@@ -0,0 +1,84 @@
+//
+//  TOFileSystemUUID.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import <uuid/uuid.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The number of characters in the string form of a UUID (eg, `E621E1F8-C36C-495A-93FC-0C247A3E6E5F`). */
+#define kTOFileSystemUUIDStringLength 36
+
+/**
+ An immutable, 16-byte UUID value used to identify items internally.
+
+ UUIDs are stored as raw bytes rather than 36-character strings, so they
+ are cheap to hash, compare and keep around as dictionary keys. They are
+ converted to and from their string form with a plain hex codec, and are only
+ turned into strings when they are handed out through the public API.
+ */
+@interface TOFileSystemUUID : NSObject <NSCopying>
+
+/** The UUID in its uppercase string form. A new string is created each time this is called. */
+@property (nonatomic, readonly) NSString *stringValue;
+
+/** Creates a new, randomly generated UUID. */
++ (instancetype)UUID;
+
+/** Creates a UUID from its string form. Returns nil if the string isn't a valid UUID. */
++ (nullable instancetype)UUIDWithString:(nullable NSString *)string;
+
+/**
+ Creates a UUID from a buffer of UTF-8 characters in the string form (eg, straight out of an extended attribute).
+ Returns nil if the characters aren't a valid UUID.
+ */
++ (nullable instancetype)UUIDWithCharacters:(const char *)characters length:(size_t)length;
+
+/** Creates a UUID from its 16 raw bytes. */
++ (instancetype)UUIDWithBytes:(const uuid_t)bytes;
+
+/** Copies the 16 raw bytes of the UUID into the provided buffer. */
+- (void)getBytes:(uuid_t)bytes;
+
+/** Writes the 36 uppercase characters of the string form into the buffer (without a null terminator). */
+- (void)getCharacters:(char *)characters;
+
+/** Compares the bytes of two UUIDs. */
+- (BOOL)isEqualToUUID:(nullable TOFileSystemUUID *)uuid;
+
+/** Orders two UUIDs by their raw bytes. */
+- (NSComparisonResult)compare:(TOFileSystemUUID *)uuid;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+/**
+ Decodes the string form of a UUID into its raw bytes, accepting upper or lowercase hex digits.
+ Returns false if the characters aren't exactly in the form `XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX`.
+ */
+FOUNDATION_EXTERN BOOL TOFileSystemUUIDDecode(const char *characters, size_t length, uuid_t bytes);
+
+/** Encodes the raw bytes of a UUID into the 36 uppercase characters of its string form. */
+FOUNDATION_EXTERN void TOFileSystemUUIDEncode(const uuid_t bytes, char *characters);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,195 @@
+//
+//  TOFileSystemUUID.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemUUID.h"
+
+/** The uppercase hex digits used when encoding. */
+static const char kTOFileSystemUUIDHexDigits[] = "0123456789ABCDEF";
+
+/** The positions of the dashes in the string form. */
+static inline BOOL TOFileSystemUUIDIsDashIndex(size_t index)
+{
+    return index == 8 || index == 13 || index == 18 || index == 23;
+}
+
+/** Converts a single hex character to its value, or returns -1 if it isn't a hex digit. */
+static inline int TOFileSystemUUIDHexValue(char character)
+{
+    if (character >= '0' && character <= '9') { return character - '0'; }
+    if (character >= 'A' && character <= 'F') { return character - 'A' + 10; }
+    if (character >= 'a' && character <= 'f') { return character - 'a' + 10; }
+    return -1;
+}
+
+BOOL TOFileSystemUUIDDecode(const char *characters, size_t length, uuid_t bytes)
+{
+    if (characters == NULL || length != kTOFileSystemUUIDStringLength) { return NO; }
+
+    size_t byteIndex = 0;
+    for (size_t i = 0; i < kTOFileSystemUUIDStringLength; i++) {
+        if (TOFileSystemUUIDIsDashIndex(i)) {
+            if (characters[i] != '-') { return NO; }
+            continue;
+        }
+
+        // Each byte is made up of two consecutive digits
+        int high = TOFileSystemUUIDHexValue(characters[i]);
+        int low = TOFileSystemUUIDHexValue(characters[++i]);
+        if (high < 0 || low < 0) { return NO; }
+        bytes[byteIndex++] = (unsigned char)((high << 4) | low);
+    }
+
+    return YES;
+}
+
+void TOFileSystemUUIDEncode(const uuid_t bytes, char *characters)
+{
+    size_t characterIndex = 0;
+    for (size_t i = 0; i < sizeof(uuid_t); i++) {
+        if (TOFileSystemUUIDIsDashIndex(characterIndex)) { characters[characterIndex++] = '-'; }
+        characters[characterIndex++] = kTOFileSystemUUIDHexDigits[bytes[i] >> 4];
+        characters[characterIndex++] = kTOFileSystemUUIDHexDigits[bytes[i] & 0x0F];
+    }
+}
+
+@interface TOFileSystemUUID () {
+    /** The raw bytes, split into two words so they can be hashed and compared quickly */
+    uint64_t _words[2];
+}
+
+@end
+
+@implementation TOFileSystemUUID
+
+#pragma mark - Class Creation -
+
+- (instancetype)initWithBytes:(const uuid_t)bytes
+{
+    if (self = [super init]) {
+        memcpy(_words, bytes, sizeof(uuid_t));
+    }
+
+    return self;
+}
+
++ (instancetype)UUID
+{
+    uuid_t bytes;
+    uuid_generate_random(bytes);
+    return [[self alloc] initWithBytes:bytes];
+}
+
++ (nullable instancetype)UUIDWithString:(nullable NSString *)string
+{
+    if (string.length != kTOFileSystemUUIDStringLength) { return nil; }
+
+    // Copy the characters out rather than creating a C string in an autoreleased buffer
+    char characters[kTOFileSystemUUIDStringLength];
+    NSUInteger usedLength = 0;
+    if (![string getBytes:characters
+                maxLength:kTOFileSystemUUIDStringLength
+               usedLength:&usedLength
+                 encoding:NSASCIIStringEncoding
+                  options:0
+                    range:NSMakeRange(0, kTOFileSystemUUIDStringLength)
+           remainingRange:NULL]) {
+        return nil;
+    }
+
+    return [self UUIDWithCharacters:characters length:usedLength];
+}
+
++ (nullable instancetype)UUIDWithCharacters:(const char *)characters length:(size_t)length
+{
+    uuid_t bytes;
+    if (!TOFileSystemUUIDDecode(characters, length, bytes)) { return nil; }
+    return [[self alloc] initWithBytes:bytes];
+}
+
++ (instancetype)UUIDWithBytes:(const uuid_t)bytes
+{
+    return [[self alloc] initWithBytes:bytes];
+}
+
+#pragma mark - Conversion -
+
+- (void)getBytes:(uuid_t)bytes
+{
+    memcpy(bytes, _words, sizeof(uuid_t));
+}
+
+- (void)getCharacters:(char *)characters
+{
+    TOFileSystemUUIDEncode((const unsigned char *)_words, characters);
+}
+
+- (NSString *)stringValue
+{
+    char characters[kTOFileSystemUUIDStringLength];
+    [self getCharacters:characters];
+    return [[NSString alloc] initWithBytes:characters
+                                    length:kTOFileSystemUUIDStringLength
+                                  encoding:NSASCIIStringEncoding];
+}
+
+#pragma mark - Equality -
+
+- (NSUInteger)hash
+{
+    // Random UUIDs are already evenly distributed, so the bytes can be used as they are
+    return (NSUInteger)(_words[0] ^ _words[1]);
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (object == self) { return YES; }
+    if (![object isKindOfClass:[TOFileSystemUUID class]]) { return NO; }
+    return [self isEqualToUUID:object];
+}
+
+- (BOOL)isEqualToUUID:(nullable TOFileSystemUUID *)uuid
+{
+    if (uuid == nil) { return NO; }
+    return _words[0] == uuid->_words[0] && _words[1] == uuid->_words[1];
+}
+
+- (NSComparisonResult)compare:(TOFileSystemUUID *)uuid
+{
+    int result = memcmp(_words, uuid->_words, sizeof(uuid_t));
+    if (result == 0) { return NSOrderedSame; }
+    return result < 0 ? NSOrderedAscending : NSOrderedDescending;
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // Instances are immutable, so they can be shared
+    return self;
+}
+
+#pragma mark - Debugging -
+
+- (NSString *)description
+{
+    return self.stringValue;
+}
+
+@end
@@ -0,0 +1,88 @@
+//
+//  TOFileSystemDirectoryReader.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+#import "NSURL+TOFileSystemUUID.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** A single item read out of a directory by `TOFileSystemDirectoryReader`. */
+typedef struct {
+    TOFileSystemItemAttributes attributes;  // The attributes of the item
+    NSUInteger nameOffset;                  // The offset of the item's name in the reader's name buffer
+    NSUInteger nameLength;                  // The length of the name, in bytes (not including its NUL terminator)
+    BOOL isFileOrDirectory;                 // Whether the item is a regular file or directory (eg, not a link, pipe or device)
+} TOFileSystemDirectoryEntry;
+
+/**
+ Reads the names and attributes of every item in a directory
+ in as few system calls as possible, using `getattrlistbulk` (with a
+ `readdir` and `fstatat` fallback for volumes that don't support it).
+
+ Every entry is packed into a buffer that is reused between reads, so
+ a single reader can scan many directories without allocating per item.
+ A reader is not thread-safe, so each scanning thread should own its own.
+
+ The directory stays open until the next read (or until the reader is released),
+ so the UUIDs of its entries can be accessed relative to it, without resolving
+ the full path of each item again.
+ */
+@interface TOFileSystemDirectoryReader : NSObject
+
+/** The number of entries captured by the last read. */
+@property (nonatomic, readonly) NSUInteger numberOfEntries;
+
+/** The entries captured by the last read. Only valid until the next read. */
+@property (nonatomic, readonly) const TOFileSystemDirectoryEntry *entries;
+
+/**
+ Reads every (non-hidden) item in the directory, replacing the previous contents of the reader.
+ Returns NO if the directory couldn't be opened or read, in which case the reader will be empty.
+ */
+- (BOOL)readDirectoryAtURL:(NSURL *)directoryURL;
+
+/** Returns the file name of the entry at the provided index. */
+- (NSString *)nameOfEntryAtIndex:(NSUInteger)index;
+
+/** Returns the absolute URL of the entry at the provided index. */
+- (NSURL *)URLOfEntryAtIndex:(NSUInteger)index;
+
+/** Returns the hash of the full path of the entry at the provided index (the same as `TOFileSystemPathHash` of its URL). */
+- (uint64_t)pathHashOfEntryAtIndex:(NSUInteger)index;
+
+/**
+ Reads the UUID saved to the entry at the provided index.
+ Only regular files and directories are opened to do so. Anything else is read by its path, without following links.
+ */
+- (TOFileSystemUUIDReadResult)readUUID:(TOFileSystemUUID * _Nullable __autoreleasing * _Nonnull)uuid
+                        ofEntryAtIndex:(NSUInteger)index;
+
+/** Saves a UUID to the entry at the provided index. Returns NO (with `errno` set) if it couldn't be written. */
+- (BOOL)writeUUID:(TOFileSystemUUID *)uuid toEntryAtIndex:(NSUInteger)index;
+
+/** Closes the directory that was last read. Its entries remain available, but their UUIDs can no longer be accessed. */
+- (void)closeDirectory;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,314 @@
+//
+//  TOFileSystemDirectoryReader.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemDirectoryReader.h"
+#import "TOFileSystemAttributeList.h"
+#import "TOFileSystemStripedLock.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** The size of the buffer `getattrlistbulk` fills on each call. */
+static const size_t kTOFileSystemAttributeBufferSize = 64 * 1024;
+
+@interface TOFileSystemDirectoryReader () {
+    /** The packed list of entries, and how many can fit before it needs to grow. */
+    TOFileSystemDirectoryEntry *_entries;
+    NSUInteger _entriesCapacity;
+
+    /** The names of every entry, stored back to back (each with a NUL terminator). */
+    char *_names;
+    NSUInteger _namesLength;
+    NSUInteger _namesCapacity;
+
+    /** The scratch buffer that the kernel writes the raw attribute records into. */
+    void *_attributeBuffer;
+
+    /** The directory that was last read, kept open so its entries can be accessed relative to it. */
+    int _directoryDescriptor;
+
+    /** The hash of the path of the directory that was last read, used to build the hashes of its entries. */
+    uint64_t _directoryPathHash;
+}
+
+/** The directory that was last read, used to build the URLs of its entries. */
+@property (nonatomic, strong) NSURL *directoryURL;
+
+@end
+
+@implementation TOFileSystemDirectoryReader
+
+#pragma mark - Class Lifecycle -
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _directoryDescriptor = -1;
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [self closeDirectory];
+    free(_entries);
+    free(_names);
+    free(_attributeBuffer);
+}
+
+#pragma mark - Reading Directories -
+
+- (BOOL)readDirectoryAtURL:(NSURL *)directoryURL
+{
+    [self closeDirectory];
+    [self removeAllEntries];
+    self.directoryURL = directoryURL;
+
+    int directoryDescriptor = open(directoryURL.fileSystemRepresentation, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryDescriptor < 0) { return NO; }
+    _directoryPathHash = TOFileSystemPathHashForDirectoryPath(directoryURL.path);
+
+    // Try and read everything in large batches. If the volume
+    // doesn't support it, start again, reading each entry one at a time.
+    BOOL success = [self readEntriesInBulkFromDirectory:directoryDescriptor];
+    if (!success) {
+        [self removeAllEntries];
+        success = [self readEntriesIndividuallyFromDirectory:directoryDescriptor];
+    }
+
+    // Keep the directory open so the entries can be accessed relative to it
+    if (!success) {
+        close(directoryDescriptor);
+        [self removeAllEntries];
+        return NO;
+    }
+
+    _directoryDescriptor = directoryDescriptor;
+    return YES;
+}
+
+- (void)closeDirectory
+{
+    if (_directoryDescriptor < 0) { return; }
+    close(_directoryDescriptor);
+    _directoryDescriptor = -1;
+}
+
+- (BOOL)readEntriesInBulkFromDirectory:(int)directoryDescriptor
+{
+    if (_attributeBuffer == NULL) {
+        _attributeBuffer = malloc(kTOFileSystemAttributeBufferSize);
+        if (_attributeBuffer == NULL) { return NO; }
+    }
+
+    struct attrlist attributeList;
+    TOFileSystemAttributeListPrepare(&attributeList, YES);
+
+    while (1) {
+        int count = getattrlistbulk(directoryDescriptor, &attributeList, _attributeBuffer,
+                                    kTOFileSystemAttributeBufferSize, 0);
+        if (count < 0) { return NO; }
+        if (count == 0) { break; }
+
+        // Each record is prefixed with its total length
+        char *record = _attributeBuffer;
+        for (int i = 0; i < count; i++) {
+            uint32_t recordLength;
+            memcpy(&recordLength, record, sizeof(uint32_t));
+            if (![self addEntryFromAttributeRecord:record]) { return NO; }
+            record += recordLength;
+        }
+    }
+
+    return YES;
+}
+
+- (BOOL)addEntryFromAttributeRecord:(const char *)record
+{
+    // Skip any entries that the kernel couldn't read
+    const char *name = NULL;
+    fsobj_type_t objectType;
+    TOFileSystemItemAttributes attributes;
+    if (!TOFileSystemAttributeListParseRecord(record, &attributes, &name, &objectType)) { return YES; }
+
+    // Skip hidden files, the same as the system enumerator would
+    if (name == NULL || name[0] == '.') { return YES; }
+
+    return [self addEntryWithName:name attributes:&attributes isFileOrDirectory:(objectType == VREG || objectType == VDIR)];
+}
+
+- (BOOL)readEntriesIndividuallyFromDirectory:(int)directoryDescriptor
+{
+    // Duplicate the descriptor so the directory stream can own (and close) its own copy
+    int streamDescriptor = dup(directoryDescriptor);
+    if (streamDescriptor < 0) { return NO; }
+
+    DIR *directory = fdopendir(streamDescriptor);
+    if (directory == NULL) {
+        close(streamDescriptor);
+        return NO;
+    }
+
+    // The bulk read may have already advanced the shared offset
+    rewinddir(directory);
+
+    struct dirent *entry;
+    struct stat fileStat;
+    while ((entry = readdir(directory)) != NULL) {
+        if (entry->d_name[0] == '.') { continue; }
+        if (fstatat(directoryDescriptor, entry->d_name, &fileStat, AT_SYMLINK_NOFOLLOW) != 0) { continue; }
+
+        TOFileSystemItemAttributes attributes = {0};
+        attributes.isDirectory = S_ISDIR(fileStat.st_mode);
+        attributes.size = attributes.isDirectory ? 0 : (long long)fileStat.st_size;
+        attributes.creationTime = fileStat.st_birthtimespec;
+        attributes.modificationTime = fileStat.st_mtimespec;
+        attributes.changeTime = fileStat.st_ctimespec;
+        attributes.inode = (uint64_t)fileStat.st_ino;
+        attributes.device = fileStat.st_dev;
+        BOOL isFileOrDirectory = S_ISREG(fileStat.st_mode) || S_ISDIR(fileStat.st_mode);
+        if (![self addEntryWithName:entry->d_name attributes:&attributes isFileOrDirectory:isFileOrDirectory]) {
+            closedir(directory);
+            return NO;
+        }
+    }
+
+    closedir(directory);
+    return YES;
+}
+
+#pragma mark - Entry Storage -
+
+- (BOOL)addEntryWithName:(const char *)name
+              attributes:(const TOFileSystemItemAttributes *)attributes
+       isFileOrDirectory:(BOOL)isFileOrDirectory
+{
+    NSUInteger nameLength = strlen(name);
+
+    // Grow the buffers geometrically so they settle at the size of the largest directory.
+    // (If either can't grow, the existing buffers are left intact and the read is abandoned.)
+    if (_numberOfEntries == _entriesCapacity) {
+        NSUInteger entriesCapacity = MAX(_entriesCapacity * 2, 64);
+        TOFileSystemDirectoryEntry *entries = realloc(_entries, entriesCapacity * sizeof(TOFileSystemDirectoryEntry));
+        if (entries == NULL) { return NO; }
+        _entries = entries;
+        _entriesCapacity = entriesCapacity;
+    }
+
+    // Leave room for a NUL terminator, so the name can be passed straight to system calls
+    if (_namesLength + nameLength + 1 > _namesCapacity) {
+        NSUInteger namesCapacity = MAX(_namesCapacity * 2, _namesLength + nameLength + 1);
+        namesCapacity = MAX(namesCapacity, 4096);
+        char *names = realloc(_names, namesCapacity);
+        if (names == NULL) { return NO; }
+        _names = names;
+        _namesCapacity = namesCapacity;
+    }
+
+    memcpy(_names + _namesLength, name, nameLength);
+    _names[_namesLength + nameLength] = '\0';
+
+    TOFileSystemDirectoryEntry *entry = &_entries[_numberOfEntries++];
+    entry->attributes = *attributes;
+    entry->nameOffset = _namesLength;
+    entry->nameLength = nameLength;
+    entry->isFileOrDirectory = isFileOrDirectory;
+    _namesLength += nameLength + 1;
+    return YES;
+}
+
+- (void)removeAllEntries
+{
+    _numberOfEntries = 0;
+    _namesLength = 0;
+}
+
+#pragma mark - Accessors -
+
+- (const TOFileSystemDirectoryEntry *)entries
+{
+    return _entries;
+}
+
+- (NSString *)nameOfEntryAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _numberOfEntries, @"Entry index out of bounds");
+    const TOFileSystemDirectoryEntry *entry = &_entries[index];
+    return [[NSString alloc] initWithBytes:_names + entry->nameOffset
+                                    length:entry->nameLength
+                                  encoding:NSUTF8StringEncoding];
+}
+
+- (NSURL *)URLOfEntryAtIndex:(NSUInteger)index
+{
+    BOOL isDirectory = _entries[index].attributes.isDirectory;
+    return [self.directoryURL URLByAppendingPathComponent:[self nameOfEntryAtIndex:index]
+                                              isDirectory:isDirectory];
+}
+
+- (uint64_t)pathHashOfEntryAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _numberOfEntries, @"Entry index out of bounds");
+    return TOFileSystemPathHashAppendComponent(_directoryPathHash, _names + _entries[index].nameOffset);
+}
+
+#pragma mark - UUIDs -
+
+- (TOFileSystemUUIDReadResult)readUUID:(TOFileSystemUUID **)uuid ofEntryAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _numberOfEntries, @"Entry index out of bounds");
+    if (_directoryDescriptor < 0) {
+        *uuid = nil;
+        errno = EBADF;
+        return TOFileSystemUUIDReadResultError;
+    }
+
+    // Opening anything other than a file or directory could block (eg, a named pipe) or have side effects (eg, a device)
+    if (!_entries[index].isFileOrDirectory) {
+        return [[self URLOfEntryAtIndex:index] to_readFileSystemUUIDValue:uuid];
+    }
+
+    const char *name = _names + _entries[index].nameOffset;
+    return TOFileSystemUUIDReadFromItemInDirectory(_directoryDescriptor, name, uuid);
+}
+
+- (BOOL)writeUUID:(TOFileSystemUUID *)uuid toEntryAtIndex:(NSUInteger)index
+{
+    NSAssert(index < _numberOfEntries, @"Entry index out of bounds");
+    if (_directoryDescriptor < 0) {
+        errno = EBADF;
+        return NO;
+    }
+
+    if (!_entries[index].isFileOrDirectory) {
+        return [[self URLOfEntryAtIndex:index] to_setFileSystemUUIDValue:uuid];
+    }
+
+    const char *name = _names + _entries[index].nameOffset;
+    return TOFileSystemUUIDWriteToItemInDirectory(_directoryDescriptor, name, uuid);
+}
+
+@end
@@ -21,6 +21,12 @@
 //  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #import <Foundation/Foundation.h>
+#import "TOFileSystemStripedLock.h"
+#import "NSURL+TOFileSystemAttributes.h"
+
+@class TOFileSystemUUID;
+@class TOFileSystemDirectoryReader;
+@class TOFileSystemUUIDCache;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -39,6 +45,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** The presenter is actively listening for events. */
 @property (nonatomic, readonly) BOOL isRunning;
 
+/** A cache of the UUIDs read from disk (shared between every presenter), including how often it was hit. */
+@property (nonatomic, readonly) TOFileSystemUUIDCache *uuidCache;
+
 /**
  Since multiple events can come through, a timer is used to
  coalesce batches of events and trigger an update periodically.
@@ -56,17 +65,48 @@ NS_ASSUME_NONNULL_BEGIN
 /** Start listening for file events in the target directory. */
 - (void)start;
 
-/** Perform a synchronous coordinated read on a file. */
-- (void)performCoordinatedRead:(void (^)(void))block;
+/**
+ Perform a synchronous coordinated read on a file.
+ Only accesses of the same file (or of files sharing the same lock stripe) will wait on each other.
+ */
+- (void)performCoordinatedReadForItemAtURL:(NSURL *)itemURL usingBlock:(void (^)(void))block;
+
+/** Perform a synchronous write operation on a file, excluding any other reads or writes of it. */
+- (void)performCoordinatedWriteForItemAtURL:(NSURL *)itemURL usingBlock:(void (^)(void))block;
 
-/** Perform a synchronous write operation on a file */
-- (void)performCoordinatedWrite:(void (^)(void))block;
+/** How many coordinated reads and writes have been made in this process, and how long they waited for, and held, their locks. */
+@property (nonatomic, readonly) TOFileSystemStripedLockStatistics coordinationStatistics;
 
 /** Stop listening and cancel any pending timer events. */
 - (void)stop;
 
-/** Coordinates reading (and writing if need be) a UUID string for the supplied item */
-- (nullable NSString *)uuidForItemAtURL:(NSURL *)itemURL;
+/**
+ Coordinates reading a UUID for the supplied item. If it doesn't have one,
+ a new one is returned straight away, and written to the item in the background.
+ */
+- (nullable TOFileSystemUUID *)uuidForItemAtURL:(NSURL *)itemURL;
+
+/**
+ Coordinates reading (and generating if need be) a UUID for the supplied item. If attributes that were just
+ read from the item are supplied, and it hasn't changed since its UUID was last read, the cached UUID is returned instead.
+ */
+- (nullable TOFileSystemUUID *)uuidForItemAtURL:(NSURL *)itemURL
+                                      attributes:(nullable const TOFileSystemItemAttributes *)attributes;
+
+/**
+ Coordinates reading (and generating if need be) a UUID for an entry in a directory reader,
+ accessing it relative to the reader's open directory. Returns nil if the item couldn't be read.
+ */
+- (nullable TOFileSystemUUID *)uuidForEntryAtIndex:(NSUInteger)index inDirectoryReader:(TOFileSystemDirectoryReader *)reader;
+
+/**
+ Returns the UUID already assigned to an item, without generating a new one.
+ This includes UUIDs that were handed out, but haven't been written to disk yet.
+ */
+- (nullable TOFileSystemUUID *)existingUUIDForItemAtURL:(NSURL *)itemURL;
+
+/** Blocks until every newly generated UUID has been written to its item on disk. */
+- (void)flushPendingUUIDWrites;
 
 @end
 
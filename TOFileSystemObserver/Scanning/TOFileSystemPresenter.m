@@ -22,6 +22,11 @@
 
 #import "TOFileSystemPresenter.h"
 #import "NSURL+TOFileSystemUUID.h"
+#import "TOFileSystemUUID.h"
+#import "TOFileSystemDirectoryReader.h"
+#import "TOFileSystemUUIDWriteQueue.h"
+#import "TOFileSystemStripedLock.h"
+#import "TOFileSystemUUIDCache.h"
 
 @interface TOFileSystemPresenter ()
 
@@ -31,8 +36,8 @@
 /** The operation queue that will receive all of the file events*/
 @property (nonatomic, strong) NSOperationQueue *eventsOperationQueue;
 
-/** The list of items currently detected. */
-@property (nonatomic, strong) NSMutableArray *items;
+/** The list of items currently detected. (An item changed several times is only listed once.) */
+@property (nonatomic, strong) NSMutableOrderedSet *items;
 
 /** A serial queue for managing access to the list (including the timer) */
 @property (nonatomic, strong) dispatch_queue_t itemListAccessQueue;
@@ -40,8 +45,11 @@
 /** Whether a timer has been set yet or not */
 @property (nonatomic, assign) BOOL isTiming;
 
-/** A concurrent queue used to coordinate writing UUIDs to files. */
-@property (nonatomic, readonly) dispatch_queue_t fileCoordinatorQueue;
+/** A lock, striped by file path, used to coordinate writing UUIDs to files. */
+@property (nonatomic, readonly) TOFileSystemStripedLock *coordinationLock;
+
+/** A queue that saves newly generated UUIDs to their files in the background. */
+@property (nonatomic, readonly) TOFileSystemUUIDWriteQueue *uuidWriteQueue;
 
 @end
 
@@ -68,18 +76,36 @@
     return self;
 }
 
-- (dispatch_queue_t)fileCoordinatorQueue
+- (TOFileSystemStripedLock *)coordinationLock
 {
     // In case we have multiple file observers, we must share this
-    // coordinator amongst all of them in case two separate instances
-    // try and write to the same file.
-    static dispatch_queue_t _fileCoordinatorQueue = NULL;
+    // lock amongst all of them in case two separate instances
+    // try and write to the same file. (Since it's striped by path,
+    // observers of unrelated directories still won't wait on each other.)
+    return [TOFileSystemStripedLock sharedLock];
+}
+
+- (TOFileSystemUUIDWriteQueue *)uuidWriteQueue
+{
+    // Like the coordination lock, this is shared so that every observer
+    // sees the UUIDs generated by the others before they are written.
+    static TOFileSystemUUIDWriteQueue *_uuidWriteQueue = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        _uuidWriteQueue = [[TOFileSystemUUIDWriteQueue alloc] initWithCoordinationLock:self.coordinationLock];
+    });
+    return _uuidWriteQueue;
+}
+
+- (TOFileSystemUUIDCache *)uuidCache
+{
+    // Since items are identified by their device and file system ID, one cache can serve every observer
+    static TOFileSystemUUIDCache *_uuidCache = nil;
     static dispatch_once_t onceToken;
     dispatch_once(&onceToken, ^{
-        _fileCoordinatorQueue = dispatch_queue_create("TOFileSystemObserver.fileCoordinatorQueue",
-                                                      DISPATCH_QUEUE_CONCURRENT);
+        _uuidCache = [[TOFileSystemUUIDCache alloc] init];
     });
-    return _fileCoordinatorQueue;
+    return _uuidCache;
 }
 
 - (void)commonInit
@@ -89,7 +115,7 @@
     _eventsOperationQueue.qualityOfService = NSQualityOfServiceBackground;
 
     // Create the array to hold the items detected
-    _items = [NSMutableArray array];
+    _items = [NSMutableOrderedSet orderedSet];
 
     // Create the dispatch queue for the items
     _itemListAccessQueue = dispatch_queue_create("TOFileSystemObserver.itemListAccessQueue", DISPATCH_QUEUE_SERIAL);
@@ -114,7 +140,7 @@
         self.isTiming = NO;
 
         @autoreleasepool {
-            NSArray *items = [self.items copy];
+            NSArray *items = self.items.array.copy;
             [self.items removeAllObjects];
             if (items.count == 0) { return; }
 
@@ -156,22 +182,21 @@
     self.isRunning = YES;
 }
 
-- (void)performCoordinatedRead:(void (^)(void))block
+- (void)performCoordinatedReadForItemAtURL:(NSURL *)itemURL usingBlock:(void (^)(void))block
 {
-    dispatch_sync(self.fileCoordinatorQueue, ^{
-        @autoreleasepool {
-            if (block) { block(); }
-        }
-    });
+    uint64_t pathHash = TOFileSystemPathHashForItemPath(itemURL.path);
+    [self.coordinationLock performReadWithPathHash:pathHash usingBlock:block];
 }
 
-- (void)performCoordinatedWrite:(void (^)(void))block
+- (void)performCoordinatedWriteForItemAtURL:(NSURL *)itemURL usingBlock:(void (^)(void))block
 {
-    dispatch_barrier_sync(self.fileCoordinatorQueue, ^{
-        @autoreleasepool {
-            if (block) { block(); }
-        }
-    });
+    uint64_t pathHash = TOFileSystemPathHashForItemPath(itemURL.path);
+    [self.coordinationLock performWriteWithPathHash:pathHash usingBlock:block];
+}
+
+- (TOFileSystemStripedLockStatistics)coordinationStatistics
+{
+    return [self.coordinationLock statistics];
 }
 
 - (void)stop
@@ -181,27 +206,85 @@
     self.isRunning = NO;
 }
 
-- (nullable NSString *)uuidForItemAtURL:(NSURL *)itemURL
+- (nullable TOFileSystemUUID *)uuidForItemAtURL:(NSURL *)itemURL
+{
+    return [self uuidForItemAtURL:itemURL attributes:NULL];
+}
+
+- (nullable TOFileSystemUUID *)uuidForItemAtURL:(NSURL *)itemURL
+                                      attributes:(nullable const TOFileSystemItemAttributes *)attributes
 {
-    __block NSString *uuid = nil;
+    // If the item hasn't changed since its UUID was last read, skip reading it again
+    TOFileSystemUUID *cachedUUID = attributes ? [self.uuidCache uuidForItemWithAttributes:attributes] : nil;
+    if (cachedUUID) { return cachedUUID; }
+
+    __block TOFileSystemUUID *uuid = nil;
     
     // If the file exists, but it's not in the store yet,
     // attempt to access it from disk
-    [self performCoordinatedRead:^{
-        uuid = [itemURL to_fileSystemUUID];
+    NSUInteger numberOfCompletedWrites = self.uuidWriteQueue.numberOfCompletedWrites;
+    [self performCoordinatedReadForItemAtURL:itemURL usingBlock:^{
+        uuid = [itemURL to_fileSystemUUIDValue];
     }];
-    if (uuid.length) { return uuid; }
+    if (uuid) {
+        if (attributes) { [self.uuidCache setUUID:uuid forItemWithAttributes:attributes]; }
+        return uuid;
+    }
     
-    // If even that failed, then it's necessary to generate a new one
-    [self performCoordinatedWrite:^{
-        // Try again in case a previous operation already generated one
-        uuid = [itemURL to_fileSystemUUID];
-        if (uuid.length == 0) {
-            uuid = [itemURL to_generateFileSystemUUID];
-        }
+    // If even that failed, hand out a new one straight away, and save it to disk in the background
+    return [self.uuidWriteQueue uuidForNewItemAtURL:itemURL
+                                         attributes:attributes
+                            numberOfCompletedWrites:numberOfCompletedWrites];
+}
+
+- (nullable TOFileSystemUUID *)uuidForEntryAtIndex:(NSUInteger)index inDirectoryReader:(TOFileSystemDirectoryReader *)reader
+{
+    // If the item hasn't changed since its UUID was last read, skip reading it again
+    const TOFileSystemItemAttributes *attributes = &reader.entries[index].attributes;
+    TOFileSystemUUID *cachedUUID = [self.uuidCache uuidForItemWithAttributes:attributes];
+    if (cachedUUID) { return cachedUUID; }
+
+    __block TOFileSystemUUID *uuid = nil;
+    __block TOFileSystemUUIDReadResult result = TOFileSystemUUIDReadResultMissing;
+
+    // Read the UUID relative to the directory, which is already open
+    uint64_t pathHash = [reader pathHashOfEntryAtIndex:index];
+    NSUInteger numberOfCompletedWrites = self.uuidWriteQueue.numberOfCompletedWrites;
+    [self.coordinationLock performReadWithPathHash:pathHash usingBlock:^{
+        TOFileSystemUUID *savedUUID = nil;
+        result = [reader readUUID:&savedUUID ofEntryAtIndex:index];
+        uuid = savedUUID;
     }];
-    
-    return uuid;
+    if (result == TOFileSystemUUIDReadResultFound) {
+        [self.uuidCache setUUID:uuid forItemWithAttributes:attributes];
+        return uuid;
+    }
+
+    // If the item couldn't be read (eg, it was deleted since the directory was read), don't try to write to it
+    if (result == TOFileSystemUUIDReadResultError) { return nil; }
+
+    // Otherwise, the item doesn't have one yet, so hand out a new one and save it in the background
+    return [self.uuidWriteQueue uuidForNewItemAtURL:[reader URLOfEntryAtIndex:index]
+                                         attributes:attributes
+                            numberOfCompletedWrites:numberOfCompletedWrites];
+}
+
+- (nullable TOFileSystemUUID *)existingUUIDForItemAtURL:(NSURL *)itemURL
+{
+    // Check the UUIDs that haven't been written yet first
+    TOFileSystemUUID *uuid = [self.uuidWriteQueue pendingUUIDForItemAtURL:itemURL];
+    if (uuid) { return uuid; }
+
+    __block TOFileSystemUUID *savedUUID = nil;
+    [self performCoordinatedReadForItemAtURL:itemURL usingBlock:^{
+        savedUUID = [itemURL to_fileSystemUUIDValue];
+    }];
+    return savedUUID;
+}
+
+- (void)flushPendingUUIDWrites
+{
+    [self.uuidWriteQueue flush];
 }
 
 #pragma mark - NSFilePresenter Delegate Events -
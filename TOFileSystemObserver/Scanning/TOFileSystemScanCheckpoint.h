@@ -0,0 +1,75 @@
+//
+//  TOFileSystemScanCheckpoint.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+
+@class TOFileSystemScanIndex;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A snapshot of how far a full scan got before it was cancelled.
+
+ Full scans commit their progress one directory at a time, so when one is cancelled,
+ every directory it visited has been completely stored, and every directory it
+ discovered but hadn't reached yet is pending. A new scan can then be started from this
+ checkpoint to carry on from the pending directories instead of starting again.
+
+ Since the file system may have changed while the scan was stopped, the attributes of each
+ visited directory are also captured, so it can be cheaply checked, and read again if its contents changed.
+ */
+@interface TOFileSystemScanCheckpoint : NSObject
+
+/** The base directory of the full scan that was cancelled. */
+@property (nonatomic, readonly) NSURL *directoryURL;
+
+/** The directories that were discovered, but hadn't been scanned yet. */
+@property (nonatomic, readonly) NSArray<NSURL *> *pendingDirectoryURLs;
+
+/** The directories that were completely scanned, mapped to their attributes at the time. */
+@property (nonatomic, readonly) NSDictionary<NSURL *, NSValue *> *scannedDirectories;
+
+/** If the scan was reconciling against a saved index, the index it was using. */
+@property (nonatomic, readonly, nullable) TOFileSystemScanIndex *scanIndex;
+
+/** If the scan was reconciling against a saved index, the records that were already matched to an item. */
+@property (nonatomic, readonly, nullable) NSIndexSet *reconciledRecords;
+
+/** Creates a new checkpoint with the state of a cancelled scan. */
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL
+                pendingDirectoryURLs:(NSArray<NSURL *> *)pendingDirectoryURLs
+                  scannedDirectories:(NSDictionary<NSURL *, NSValue *> *)scannedDirectories
+                           scanIndex:(nullable TOFileSystemScanIndex *)scanIndex
+                   reconciledRecords:(nullable NSIndexSet *)reconciledRecords;
+
+/**
+ Whether the directory was scanned before the checkpoint was made, and
+ its modification date and number of items haven't changed since.
+ */
+- (BOOL)containsUnchangedDirectoryAtURL:(NSURL *)directoryURL;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
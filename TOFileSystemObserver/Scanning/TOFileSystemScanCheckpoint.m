@@ -0,0 +1,70 @@
+//
+//  TOFileSystemScanCheckpoint.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemScanCheckpoint.h"
+
+@implementation TOFileSystemScanCheckpoint
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL
+                pendingDirectoryURLs:(NSArray<NSURL *> *)pendingDirectoryURLs
+                  scannedDirectories:(NSDictionary<NSURL *, NSValue *> *)scannedDirectories
+                           scanIndex:(TOFileSystemScanIndex *)scanIndex
+                   reconciledRecords:(NSIndexSet *)reconciledRecords
+{
+    if (self = [super init]) {
+        _directoryURL = directoryURL;
+        _pendingDirectoryURLs = [pendingDirectoryURLs copy];
+        _scannedDirectories = [scannedDirectories copy];
+        _scanIndex = scanIndex;
+        _reconciledRecords = [reconciledRecords copy];
+    }
+
+    return self;
+}
+
+- (BOOL)containsUnchangedDirectoryAtURL:(NSURL *)directoryURL
+{
+    NSValue *value = self.scannedDirectories[directoryURL];
+    if (value == nil) { return NO; }
+
+    TOFileSystemItemAttributes savedAttributes;
+    [value getValue:&savedAttributes];
+
+    TOFileSystemItemAttributes attributes;
+    if (![directoryURL to_getAttributes:&attributes]) { return NO; }
+
+    // Adding, removing or renaming anything inside the directory will have changed one of these
+    return attributes.inode == savedAttributes.inode &&
+            attributes.numberOfChildItems == savedAttributes.numberOfChildItems &&
+            attributes.modificationTime.tv_sec == savedAttributes.modificationTime.tv_sec &&
+            attributes.modificationTime.tv_nsec == savedAttributes.modificationTime.tv_nsec;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@: %p> %lu scanned, %lu pending",
+            NSStringFromClass([self class]), self,
+            (unsigned long)self.scannedDirectories.count,
+            (unsigned long)self.pendingDirectoryURLs.count];
+}
+
+@end
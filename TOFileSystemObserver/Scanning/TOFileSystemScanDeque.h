@@ -0,0 +1,55 @@
+//
+//  TOFileSystemScanDeque.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ A thread-safe double-ended queue used to share directories
+ between the workers of a parallel scan.
+
+ The worker that owns the queue pushes and pops from the back,
+ so it scans the directories it discovered most recently first.
+ Idle workers steal from the front, taking the oldest (and
+ usually shallowest, so largest) pending directories.
+ */
+@interface TOFileSystemScanDeque : NSObject
+
+/** The number of objects currently in the queue. */
+@property (nonatomic, readonly) NSUInteger count;
+
+/** Adds an object to the back of the queue. */
+- (void)pushObject:(id)object;
+
+/** Removes and returns the object at the back of the queue (Owning worker only). */
+- (nullable id)popObject;
+
+/** Removes and returns the object at the front of the queue (Other workers). */
+- (nullable id)stealObject;
+
+/** A snapshot of every object currently in the queue, front to back, without removing them. */
+- (NSArray *)allObjects;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,93 @@
+//
+//  TOFileSystemScanDeque.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemScanDeque.h"
+#import "TOFileSystemLock.h"
+
+@interface TOFileSystemScanDeque () {
+    TOFileSystemLock _lock;
+}
+
+/** The objects in the queue, front to back. */
+@property (nonatomic, strong) NSMutableArray *objects;
+
+@end
+
+@implementation TOFileSystemScanDeque
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _objects = [NSMutableArray array];
+        TOFileSystemLockInit(&_lock);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    TOFileSystemLockDestroy(&_lock);
+}
+
+- (NSUInteger)count
+{
+    TOFileSystemLockLock(&_lock);
+    NSUInteger count = _objects.count;
+    TOFileSystemLockUnlock(&_lock);
+    return count;
+}
+
+- (void)pushObject:(id)object
+{
+    TOFileSystemLockLock(&_lock);
+    [_objects addObject:object];
+    TOFileSystemLockUnlock(&_lock);
+}
+
+- (nullable id)popObject
+{
+    TOFileSystemLockLock(&_lock);
+    id object = _objects.lastObject;
+    if (object) { [_objects removeLastObject]; }
+    TOFileSystemLockUnlock(&_lock);
+    return object;
+}
+
+- (nullable id)stealObject
+{
+    TOFileSystemLockLock(&_lock);
+    id object = _objects.firstObject;
+    if (object) { [_objects removeObjectAtIndex:0]; }
+    TOFileSystemLockUnlock(&_lock);
+    return object;
+}
+
+- (NSArray *)allObjects
+{
+    TOFileSystemLockLock(&_lock);
+    NSArray *objects = [_objects copy];
+    TOFileSystemLockUnlock(&_lock);
+    return objects;
+}
+
+@end
@@ -24,7 +24,11 @@
 
 @class TOFileSystemPresenter;
 @class TOFileSystemItemURLDictionary;
+@class TOFileSystemScanIndex;
+@class TOFileSystemScanCheckpoint;
+@class TOFileSystemExclusionMatcher;
 @class TOFileSystemScanOperation;
+@class TOFileSystemUUID;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -37,18 +41,18 @@ NS_ASSUME_NONNULL_BEGIN
  This is called every time for full-system scans, but will then only be called on items not previously found before
  in subsequent scans.
  */
-- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDiscoverItemAtURL:(NSURL *)itemURL withUUID:(NSString *)uuid;
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDiscoverItemAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid;
 
 /** Called when the properties of an object have been changed (eg, renamed etc) */
-- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemDidChangeAtURL:(NSURL *)itemURL withUUID:(NSString *)uuid;
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemDidChangeAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid;
 
 /** Called when the file has been moved to another part of the sandbox. */
-- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemWithUUID:(NSString *)uuid
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemWithUUID:(TOFileSystemUUID *)uuid
         didMoveFromURL:(NSURL *)previousURL
                 toURL:(NSURL *)url;
 
 /** Called when the file has been deleted. */
-- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDeleteItemAtURL:(NSURL *)itemURL withUUID:(NSString *)uuid;
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDeleteItemAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid;
 
 /** Called before a full directory scan has started to allow any delegates to prepare in advance. */
 - (void)scanOperationWillBeginFullScan:(TOFileSystemScanOperation *)scanOperation;
@@ -56,6 +60,20 @@ NS_ASSUME_NONNULL_BEGIN
 /** Called when a full directory scan has been completed so we can do some final clean-up. */
 - (void)scanOperationDidCompleteFullScan:(TOFileSystemScanOperation *)scanOperation;
 
+/**
+ Called when a full directory scan was cancelled before it could complete.
+ Every directory scanned up to that point has been fully committed, and the checkpoint
+ can be provided to a new scan operation to carry on from where this one stopped.
+ */
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
+    didCancelFullScanWithCheckpoint:(TOFileSystemScanCheckpoint *)checkpoint;
+
+/**
+ Called during a full scan once every prioritized directory (and everything inside them) has been scanned,
+ so any changes found in them can be delivered straight away, without waiting for the rest of the scan.
+ */
+- (void)scanOperationDidScanPriorityDirectories:(TOFileSystemScanOperation *)scanOperation;
+
 @end
 
 /**
@@ -74,16 +92,58 @@ NS_ASSUME_NONNULL_BEGIN
 /** When scanning hierarchies, the numbers deep to scan (-1 is all of them) */
 @property (nonatomic, assign) NSInteger subDirectoryLevelLimit;
 
+/**
+ On full scans, the number of worker threads that will scan subdirectories in parallel.
+ Idle workers will steal pending directories from busy ones. (Default is 1, which scans serially).
+ */
+@property (nonatomic, assign) NSInteger numberOfWorkers;
+
+/**
+ On full scans, an index of the items that were found in a previous session.
+ Items that are unchanged since the index was saved will reuse their recorded UUID instead of
+ reading it from disk, and only items that were added, changed, moved or deleted will be reported.
+ */
+@property (nonatomic, strong, nullable) TOFileSystemScanIndex *scanIndex;
+
+/**
+ When reconciling against a scan index, directories whose modification date and child count
+ haven't changed will not be read again, and their recorded contents will be used instead.
+ Their subdirectories are still checked individually. (Default is NO).
+ */
+@property (nonatomic, assign) BOOL skipsUnchangedDirectories;
+
+/**
+ On full scans, a checkpoint from a previously cancelled scan to resume from.
+ Instead of starting again, only the directories that were still pending, or that changed since
+ they were scanned, will be read. (A resumed scan doesn't call `scanOperationWillBeginFullScan:` again).
+ */
+@property (nonatomic, strong, nullable) TOFileSystemScanCheckpoint *checkpoint;
+
 /** Create a new instance that will scan all of the child items of the provided directory */
 - (instancetype)initForFullScanWithDirectoryAtURL:(NSURL *)directoryURL
-                                    skippingItems:(NSArray *)skippedItems
+                                    skippingItems:(nullable TOFileSystemExclusionMatcher *)skippedItems
                                allItemsDictionary:(nonnull TOFileSystemItemURLDictionary *)allItems
                                     filePresenter:(TOFileSystemPresenter *)filePresenter;
 
+/**
+ On full scans, moves a directory, and everything inside it, ahead of the rest of the scan.
+ They are scanned at a higher quality of service, and once they're done, the delegate is informed so
+ their changes can be delivered before the rest of the scan completes. May be called from any thread,
+ before or during the scan. (If the directory was already scanned, only its subdirectories still waiting are moved.)
+ */
+- (void)prioritizeDirectoryAtURL:(NSURL *)directoryURL;
+
+/**
+ For item scans that haven't started yet, merges more items into the list that will be scanned.
+ Duplicates are ignored, and once enough items in the same directory have been added, the whole
+ directory will be rescanned instead. Returns NO if the scan has already started, or isn't an item scan.
+ */
+- (BOOL)addItemURLs:(NSArray<NSURL *> *)itemURLs;
+
 /** Create a new instance that will scan all of the files/folders provided. */
 - (instancetype)initForItemScanWithItemURLs:(NSArray<NSURL *> *)itemURLs
                                     baseURL:(NSURL *)baseURL
-                              skippingItems:(NSArray *)skippedItems
+                              skippingItems:(nullable TOFileSystemExclusionMatcher *)skippedItems
                          allItemsDictionary:(nonnull TOFileSystemItemURLDictionary *)allItems
                               filePresenter:(TOFileSystemPresenter *)filePresenter;
 
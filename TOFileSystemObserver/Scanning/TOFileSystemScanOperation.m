@@ -23,39 +23,113 @@
 #import "TOFileSystemScanOperation.h"
 #import "TOFileSystemPresenter.h"
 #import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemScanIndex.h"
+#import "TOFileSystemScanCheckpoint.h"
+#import "TOFileSystemExclusionMatcher.h"
+#import "TOFileSystemScanDeque.h"
+#import "TOFileSystemDirectoryReader.h"
+#import "TOFileSystemLock.h"
 
 #import "NSURL+TOFileSystemUUID.h"
+#import "TOFileSystemUUID.h"
 #import "NSURL+TOFileSystemAttributes.h"
-#import "NSFileManager+TOFileSystemDirectoryEnumerator.h"
+
+#import <stdatomic.h>
 
 /** In iOS, files deleted via the Files app are moved to this private folder. */
 NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
 
-@interface TOFileSystemScanOperation ()
+/** In item scans, once this many items in the same directory have changed, the whole directory is rescanned instead. */
+static const NSUInteger kTOFileSystemScanDirectoryCollapseThreshold = 50;
+
+/** The state of an item captured while reading a directory, before it is committed. */
+typedef struct {
+    TOFileSystemItemAttributes attributes;  // The attributes read from disk
+    BOOL isUnchanged;                       // The item matches its record in the scan index
+} TOFileSystemScannedItem;
+
+@interface TOFileSystemScanOperation () {
+    /** Serializes updating the stores and calling the delegate when scanning in parallel. */
+    TOFileSystemLock _commitLock;
+
+    /** In parallel scans, the number of directories queued or being scanned across all workers. */
+    atomic_long _numberOfPendingDirectories;
+
+    /** In parallel scans, parks idle workers until more directories are queued, or the scan is finished. */
+    NSCondition *_workCondition;
+
+    /** Bumped whenever idle workers should check again, so a worker about to park can tell if it missed it. */
+    atomic_long _workGeneration;
+
+    /** The number of workers parked on the work condition, so busy workers only wake them when needed. */
+    atomic_long _numberOfIdleWorkers;
+
+    /** The state of the base directory when this scan started, in case we need to make a checkpoint. */
+    TOFileSystemItemAttributes _baseDirectoryAttributes;
+
+    /** Guards adding more items to an item scan until it starts. */
+    TOFileSystemLock _itemURLsLock;
+
+    /** Set once an item scan has started, after which no more items may be added. */
+    BOOL _hasStartedScanningItems;
+
+    /** Guards the directories that have been requested to be prioritized, but not yet moved ahead. */
+    TOFileSystemLock _priorityLock;
+
+    /** The number of prioritized directories waiting to be scanned, so workers can skip the commit lock when there are none. */
+    atomic_long _numberOfQueuedPriorityDirectories;
+
+    /** The number of prioritized directories currently being scanned. (Guarded by the commit lock.) */
+    NSInteger _numberOfPriorityDirectoriesInProgress;
+}
 
 /** When scanning folder hierarchy, this is the top level directory */
 @property (nonatomic, strong) NSURL *directoryURL;
 
-/** A flat list of file URLs to scan. */
-@property (nonatomic, strong) NSArray *itemURLs;
+/** A flat list of file URLs to scan, without duplicates. */
+@property (nonatomic, strong) NSMutableOrderedSet<NSURL *> *itemURLs;
+
+/** In item scans, directories where so many items changed that their whole contents will be rescanned. */
+@property (nonatomic, strong) NSMutableOrderedSet<NSURL *> *directoryURLs;
+
+/** In item scans, the number of items added in each directory (by path), to decide when to rescan the whole directory. */
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *numberOfItemsInDirectories;
 
 /** A reference to the file system presenter object so we may pause when causing file writes. */
 @property (nonatomic, strong) TOFileSystemPresenter *filePresenter;
 
-/** A local file manager object we can use for retrieving disk contents. */
-@property (nonatomic, strong) NSFileManager *fileManager;
+/** A reusable reader for retrieving directory contents on the scanning thread. */
+@property (nonatomic, strong) TOFileSystemDirectoryReader *directoryReader;
 
 /** When iterating through all the files, this array stores pending directories that need scanning*/
 @property (nonatomic, strong) NSMutableArray *pendingDirectories;
 
-/** A list of items we've been instructed to skip. */
-@property (nonatomic, strong) NSArray *skippedItems;
+/** On full scans, every directory that has been scanned, so none are scanned twice, and so they can be checkpointed. */
+@property (nonatomic, strong) NSMutableSet<NSURL *> *scannedDirectoryURLs;
+
+/** Directories that have been requested to be prioritized, waiting to be moved ahead of the rest of the scan. */
+@property (nonatomic, strong) NSMutableOrderedSet<NSURL *> *requestedPriorityDirectoryURLs;
+
+/** The paths of the prioritized directories. Any subdirectory discovered inside them is prioritized too. */
+@property (nonatomic, strong) NSMutableSet<NSString *> *priorityDirectoryPaths;
+
+/** The prioritized directories waiting to be scanned, which are scanned before any others. */
+@property (nonatomic, strong) NSMutableArray<NSURL *> *priorityDirectories;
+
+/** In parallel scans, the queues of each worker, so prioritized directories can be found in them. */
+@property (nonatomic, copy, nullable) NSArray<TOFileSystemScanDeque *> *workerDeques;
+
+/** A matcher for the items we've been instructed to skip. */
+@property (nonatomic, strong) TOFileSystemExclusionMatcher *skippedItems;
 
 /** A reference to the master list of items maintained by this observer. */
 @property (nonatomic, strong) TOFileSystemItemURLDictionary *allItems;
 
 /** A store for items that have disappeared inside this operation, either deleted or moved. */
-@property (nonatomic, strong) NSMutableDictionary<NSString *, NSURL *> *missingItems;
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, NSURL *> *missingItems;
+
+/** When reconciling against a scan index, the records that have been matched to an item on disk. */
+@property (nonatomic, strong) NSMutableIndexSet *reconciledRecords;
 
 /** A check to see if we are performing a full scan, or just focusing on one or two items. */
 @property (nonatomic, assign, readwrite) BOOL isFullScan;
@@ -67,7 +141,7 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
 #pragma - Class Lifecycle -
 
 - (instancetype)initForFullScanWithDirectoryAtURL:(NSURL *)directoryURL
-                                    skippingItems:(NSArray *)skippedItems
+                                    skippingItems:(TOFileSystemExclusionMatcher *)skippedItems
                     allItemsDictionary:(nonnull TOFileSystemItemURLDictionary *)allItems
                          filePresenter:(nonnull TOFileSystemPresenter *)filePresenter
 {
@@ -78,6 +152,10 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
         _skippedItems = skippedItems;
         _allItems = allItems;
         _pendingDirectories = [NSMutableArray array];
+        _scannedDirectoryURLs = [NSMutableSet set];
+        _requestedPriorityDirectoryURLs = [NSMutableOrderedSet orderedSet];
+        _priorityDirectoryPaths = [NSMutableSet set];
+        _priorityDirectories = [NSMutableArray array];
         [self commonInit];
     }
 
@@ -86,7 +164,7 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
 
 - (instancetype)initForItemScanWithItemURLs:(NSArray<NSURL *> *)itemURLs
                                     baseURL:(NSURL *)baseURL
-                              skippingItems:(NSArray *)skippedItems
+                              skippingItems:(TOFileSystemExclusionMatcher *)skippedItems
               allItemsDictionary:(nonnull TOFileSystemItemURLDictionary *)allItems
                    filePresenter:(nonnull TOFileSystemPresenter *)filePresenter
 {
@@ -94,11 +172,14 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
         _directoryURL = baseURL.URLByStandardizingPath;
         _filePresenter = filePresenter;
         _skippedItems = skippedItems;
-        _itemURLs = itemURLs;
         _allItems = allItems;
         _pendingDirectories = [NSMutableArray array];
         _missingItems = [NSMutableDictionary dictionary];
+        _itemURLs = [NSMutableOrderedSet orderedSet];
+        _directoryURLs = [NSMutableOrderedSet orderedSet];
+        _numberOfItemsInDirectories = [NSMutableDictionary dictionary];
         [self commonInit];
+        [self insertItemURLs:itemURLs];
     }
 
     return self;
@@ -107,17 +188,35 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
 - (void)commonInit
 {
     _subDirectoryLevelLimit = -1;
-    _fileManager = [[NSFileManager alloc] init];
+    _numberOfWorkers = 1;
+    _directoryReader = [[TOFileSystemDirectoryReader alloc] init];
+    _workCondition = [[NSCondition alloc] init];
+    TOFileSystemLockInit(&_commitLock);
+    TOFileSystemLockInit(&_itemURLsLock);
+    TOFileSystemLockInit(&_priorityLock);
+}
+
+- (void)dealloc
+{
+    TOFileSystemLockDestroy(&_commitLock);
+    TOFileSystemLockDestroy(&_itemURLsLock);
+    TOFileSystemLockDestroy(&_priorityLock);
 }
 
 #pragma mark - Scanning Implementation -
 
 - (void)main
 {
-    // Terminate out if this operation was cancelled before it started
-    // Once it's started however, we need to see it through to completion
-    // to prevent leaving things in an inconsistent state.
-    if (self.isCancelled) { return; }
+    // Terminate out if this operation was cancelled before it started.
+    // (If we were resuming another scan, hand its checkpoint back so it isn't lost.)
+    // Once started, full scans only stop between directories, and item scans always complete,
+    // so the stores are never left in an inconsistent state.
+    if (self.isCancelled) {
+        if (self.isFullScan && self.checkpoint) {
+            [self.delegate scanOperation:self didCancelFullScanWithCheckpoint:self.checkpoint];
+        }
+        return;
+    }
 
     // Depending on if a base directory,
     // or a flat list of files was provided, perform
@@ -125,129 +224,766 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     if (self.isFullScan) {
         [self scanAllSubdirectoriesFromBaseURL];
     }
-    else if (self.itemURLs) {
+    else {
+        // Lock the list of items now that we're about to scan them
+        TOFileSystemLockLock(&_itemURLsLock);
+        _hasStartedScanningItems = YES;
+        TOFileSystemLockUnlock(&_itemURLsLock);
+
         [self scanItemURLsList];
     }
 }
 
+#pragma mark - Adding Items -
+
+- (BOOL)addItemURLs:(NSArray<NSURL *> *)itemURLs
+{
+    if (self.isFullScan) { return NO; }
+
+    TOFileSystemLockLock(&_itemURLsLock);
+    BOOL canAddItems = !_hasStartedScanningItems && !self.isCancelled;
+    if (canAddItems) { [self insertItemURLs:itemURLs]; }
+    TOFileSystemLockUnlock(&_itemURLsLock);
+
+    return canAddItems;
+}
+
+- (void)insertItemURLs:(NSArray<NSURL *> *)itemURLs
+{
+    for (NSURL *url in itemURLs) {
+        NSURL *itemURL = url.URLByStandardizingPath;
+        NSString *directoryPath = itemURL.path.stringByDeletingLastPathComponent;
+
+        // Skip duplicates, as well as any items in a directory that is already being rescanned
+        if ([self.itemURLs containsObject:itemURL]) { continue; }
+        NSNumber *numberOfItems = self.numberOfItemsInDirectories[directoryPath];
+        if (numberOfItems.unsignedIntegerValue >= kTOFileSystemScanDirectoryCollapseThreshold) { continue; }
+
+        [self.itemURLs addObject:itemURL];
+        self.numberOfItemsInDirectories[directoryPath] = @(numberOfItems.unsignedIntegerValue + 1);
+
+        // Once enough items in one directory have changed, it's cheaper to read the directory in bulk
+        if (numberOfItems.unsignedIntegerValue + 1 == kTOFileSystemScanDirectoryCollapseThreshold) {
+            [self collapseItemsIntoDirectoryAtPath:directoryPath];
+        }
+    }
+}
+
+- (void)collapseItemsIntoDirectoryAtPath:(NSString *)directoryPath
+{
+    NSIndexSet *indexes = [self.itemURLs indexesOfObjectsPassingTest:^BOOL(NSURL *url, NSUInteger index, BOOL *stop) {
+        return [url.path.stringByDeletingLastPathComponent isEqualToString:directoryPath];
+    }];
+    [self.itemURLs removeObjectsAtIndexes:indexes];
+    [self.directoryURLs addObject:[NSURL fileURLWithPath:directoryPath isDirectory:YES]];
+}
+
 #pragma mark - Deep Hierarcy Directory Scan -
 
 - (void)scanAllSubdirectoriesFromBaseURL
+{
+    // Capture the state of the base directory before we read it
+    [self.directoryURL to_getAttributes:&_baseDirectoryAttributes];
+    [self.scannedDirectoryURLs addObject:self.directoryURL];
+
+    // Either carry on from where a cancelled scan stopped, or start scanning from the base directory
+    if (self.checkpoint) {
+        [self resumeFromCheckpoint:self.checkpoint];
+    }
+    else if (![self scanBaseDirectory]) {
+        return;
+    }
+
+    // If we were only scanning the immediate contents
+    // of the base directory, we can skip this step.
+    // Otherwise, scan all of the directories discovered in the base
+    // directory (and then scan their directories).
+    if (self.subDirectoryLevelLimit != 0 && !self.isCancelled) {
+        [self scanPendingSubdirectories];
+    }
+
+    // If we were cancelled part way through, save where we got up to so we can carry on later
+    if (self.isCancelled) {
+        [self.delegate scanOperation:self didCancelFullScanWithCheckpoint:[self makeCheckpoint]];
+        return;
+    }
+
+    // Send a notification so we can do some final clean up
+    [self reportItemsMissingFromScanIndex];
+    [self.delegate scanOperationDidCompleteFullScan:self];
+}
+
+- (BOOL)scanBaseDirectory
 {
     // Start scanning every item in our base directory
-    NSArray *childItemURLs = [self.fileManager to_fileSystemEnumeratorForDirectoryAtURL:self.directoryURL].allObjects;
-    if (childItemURLs.count == 0) { return; }
+    TOFileSystemDirectoryReader *reader = self.directoryReader;
+    [reader readDirectoryAtURL:self.directoryURL];
+
+    // (If we have an index, an empty directory may mean everything was deleted)
+    if (reader.numberOfEntries == 0 && self.scanIndex.count == 0) { return NO; }
+    self.reconciledRecords = [NSMutableIndexSet indexSet];
 
     // Post the "will begin" notification
     [self.delegate scanOperationWillBeginFullScan:self];
-    
+
     // Scan all of the items in the base directory
-    for (NSURL *url in childItemURLs) {
-        [self scanItemAtURL:url
-         pendingDirectories:self.pendingDirectories];
+    [self scanEntriesInReader:reader pendingDirectories:self.pendingDirectories];
+    return YES;
+}
+
+- (void)resumeFromCheckpoint:(TOFileSystemScanCheckpoint *)checkpoint
+{
+    // Restore the reconciliation state of the previous scan
+    self.scanIndex = checkpoint.scanIndex;
+    self.reconciledRecords = [NSMutableIndexSet indexSet];
+    if (checkpoint.reconciledRecords) {
+        [self.reconciledRecords addIndexes:checkpoint.reconciledRecords];
     }
 
-    void (^didCompletedNotification)(void) = ^{
-        [self.delegate scanOperationDidCompleteFullScan:self];
-    };
-    
-    // If we were only scanning the immediate contents
-    // of the base directory, we can exit here
-    if (self.subDirectoryLevelLimit == 0) {
-        didCompletedNotification();
-        return;
+    // Re-read the base directory if its contents changed while we were stopped
+    TOFileSystemDirectoryReader *reader = self.directoryReader;
+    if ([self shouldScanDirectoryAtURL:self.directoryURL] && [reader readDirectoryAtURL:self.directoryURL]) {
+        [self scanEntriesInReader:reader pendingDirectories:self.pendingDirectories];
     }
 
-    // Otherwise, scan all of the directories discovered in the base
-    // directory (and then scan their directories).
-    [self scanPendingSubdirectories];
-    
-    // Send a notification so we can do some final clean up
-    didCompletedNotification();
+    // Queue up every directory that was still pending, as well as every one that was already
+    // scanned, so they can be checked for changes. (Any duplicates will be skipped when reached.)
+    [self.pendingDirectories addObjectsFromArray:checkpoint.pendingDirectoryURLs];
+    [self.pendingDirectories addObjectsFromArray:checkpoint.scannedDirectories.allKeys];
+}
+
+- (BOOL)shouldScanDirectoryAtURL:(NSURL *)directoryURL
+{
+    // Directories the checkpointed scan never reached always need scanning
+    TOFileSystemScanCheckpoint *checkpoint = self.checkpoint;
+    if (checkpoint.scannedDirectories[directoryURL] == nil) { return YES; }
+
+    // Directories that were scanned only need to be read again if something inside them changed
+    if ([checkpoint containsUnchangedDirectoryAtURL:directoryURL]) { return NO; }
+
+    // Since items may have been deleted from it, its records will all need to be matched again
+    if (self.scanIndex) {
+        NSString *relativePath = [self.allItems relativePathForItemURL:directoryURL];
+        [self performCommit:^{
+            [self.scanIndex enumerateChildRecordsOfDirectoryWithRelativePath:relativePath usingBlock:^(NSUInteger index) {
+                [self.reconciledRecords removeIndex:index];
+            }];
+        }];
+    }
+
+    return YES;
+}
+
+- (BOOL)markDirectoryAsScannedAtURL:(NSURL *)directoryURL
+{
+    // Returns NO if the directory had already been scanned
+    __block BOOL isNewDirectory = NO;
+    [self performCommit:^{
+        isNewDirectory = ![self.scannedDirectoryURLs containsObject:directoryURL];
+        [self.scannedDirectoryURLs addObject:directoryURL];
+    }];
+    return isNewDirectory;
+}
+
+- (TOFileSystemScanCheckpoint *)makeCheckpoint
+{
+    // Capture the state of every directory we scanned, so we can tell if they change before resuming.
+    // Each directory's attributes were recorded when it was found in its parent.
+    NSMutableDictionary<NSURL *, NSValue *> *scannedDirectories = [NSMutableDictionary dictionary];
+    for (NSURL *directoryURL in self.scannedDirectoryURLs) {
+        TOFileSystemItemAttributes attributes = _baseDirectoryAttributes;
+        if (![directoryURL isEqual:self.directoryURL]) {
+            TOFileSystemUUID *uuid = [self.allItems uuidForItemWithURL:directoryURL];
+            if (uuid == nil || ![self.allItems getAttributes:&attributes forUUID:uuid]) { continue; }
+        }
+        scannedDirectories[directoryURL] = [NSValue valueWithBytes:&attributes
+                                                          objCType:@encode(TOFileSystemItemAttributes)];
+    }
+
+    return [[TOFileSystemScanCheckpoint alloc] initWithDirectoryURL:self.directoryURL
+                                               pendingDirectoryURLs:self.pendingDirectories
+                                                 scannedDirectories:scannedDirectories
+                                                          scanIndex:self.scanIndex
+                                                  reconciledRecords:self.reconciledRecords];
 }
 
 - (void)scanPendingSubdirectories
 {
+    // Hand off to the worker threads if we've been configured to run in parallel
+    if (self.numberOfWorkers > 1) {
+        [self scanPendingSubdirectoriesInParallel];
+        return;
+    }
+
     NSMutableArray *pendingDirectories = self.pendingDirectories;
 
     // If there were any directories in the base, start a flat loop to scan
     // all subdirectories too (Avoiding potential stack overflows!)
-    while (pendingDirectories.count > 0) {
+    // Stop between directories if we were cancelled, leaving the rest pending for the checkpoint.
+    while (!self.isCancelled) {
+        // Scan any prioritized directories first
+        NSURL *url = [self dequeuePriorityDirectory];
+        if (url) {
+            [self scanPriorityDirectoryAtURL:url reader:self.directoryReader pendingDirectories:pendingDirectories];
+            continue;
+        }
+
         // Extract the item, and then remove it from the pending list
-        NSURL *url = pendingDirectories.firstObject;
+        if (pendingDirectories.count == 0) { break; }
+        url = pendingDirectories.firstObject;
         [pendingDirectories removeObjectAtIndex:0];
 
-        // Exit out if we've gone deeper than the specified limit
-        if (self.subDirectoryLevelLimit > 0) {
-            NSInteger levels = [self numberOfDirectoryLevelsToURL:url];
-            if (levels >= self.subDirectoryLevelLimit) { continue; }
+        // Scan all of the items in this directory
+        [self scanDirectoryAtURL:url reader:self.directoryReader pendingDirectories:pendingDirectories];
+    }
+
+    // If we were cancelled, any prioritized directories still waiting need to go in the checkpoint too
+    [self performCommit:^{
+        [pendingDirectories addObjectsFromArray:self.priorityDirectories];
+        [self.priorityDirectories removeAllObjects];
+        atomic_store(&self->_numberOfQueuedPriorityDirectories, 0);
+    }];
+}
+
+- (void)scanDirectoryAtURL:(NSURL *)directoryURL
+                    reader:(TOFileSystemDirectoryReader *)reader
+        pendingDirectories:(NSMutableArray *)pendingDirectories
+{
+    // Exit out if we've gone deeper than the specified limit
+    if (self.subDirectoryLevelLimit > 0) {
+        NSInteger levels = [self numberOfDirectoryLevelsToURL:directoryURL];
+        if (levels >= self.subDirectoryLevelLimit) { return; }
+    }
+
+    // Skip directories that were already scanned, or were checkpointed and haven't changed since
+    if (![self markDirectoryAsScannedAtURL:directoryURL]) { return; }
+    if (self.checkpoint && ![self shouldScanDirectoryAtURL:directoryURL]) { return; }
+
+    // If the directory is unchanged since the index was saved, reuse its recorded contents
+    if (self.skipsUnchangedDirectories && [self scanUnchangedDirectoryAtURL:directoryURL
+                                                         pendingDirectories:pendingDirectories]) {
+        return;
+    }
+
+    if (![reader readDirectoryAtURL:directoryURL]) { return; }
+    [self scanEntriesInReader:reader pendingDirectories:pendingDirectories];
+}
+
+- (BOOL)scanUnchangedDirectoryAtURL:(NSURL *)directoryURL pendingDirectories:(NSMutableArray *)pendingDirectories
+{
+    TOFileSystemScanIndex *scanIndex = self.scanIndex;
+    if (scanIndex == nil) { return NO; }
+
+    // Check the directory's modification date and child count against its record.
+    // Adding, removing or renaming anything inside will have changed one of them.
+    NSString *relativePath = [self.allItems relativePathForItemURL:directoryURL];
+    NSUInteger recordIndex = [scanIndex indexOfRecordWithRelativePath:relativePath];
+    if (recordIndex == NSNotFound) { return NO; }
+
+    TOFileSystemItemAttributes attributes;
+    if (![directoryURL to_getAttributes:&attributes]) { return NO; }
+    if (![scanIndex recordAtIndex:recordIndex matchesAttributes:&attributes]) { return NO; }
+
+    // Treat each recorded child as if it had just been read from disk unchanged.
+    // Any subdirectories will still be queued, and checked in the same way when they are reached.
+    NSMutableArray<NSURL *> *itemURLs = [NSMutableArray array];
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray array];
+    NSMutableData *scannedItems = [NSMutableData data];
+    [scanIndex enumerateChildRecordsOfDirectoryWithRelativePath:relativePath usingBlock:^(NSUInteger index) {
+        TOFileSystemScannedItem scannedItem = {0};
+        [scanIndex getAttributes:&scannedItem.attributes ofRecordAtIndex:index];
+        scannedItem.isUnchanged = YES;
+
+        NSString *childPath = [scanIndex relativePathOfRecordAtIndex:index];
+        NSURL *itemURL = [self.allItems itemURLForRelativePath:childPath isDirectory:scannedItem.attributes.isDirectory];
+        if ([self shouldSkipItemAtURL:itemURL]) { return; }
+
+        [itemURLs addObject:itemURL];
+        [uuids addObject:[scanIndex uuidOfRecordAtIndex:index]];
+        [scannedItems appendBytes:&scannedItem length:sizeof(TOFileSystemScannedItem)];
+    }];
+
+    [self commitScannedItems:scannedItems itemURLs:itemURLs uuids:uuids pendingDirectories:pendingDirectories];
+    return YES;
+}
+
+- (void)scanEntriesInReader:(TOFileSystemDirectoryReader *)reader
+         pendingDirectories:(NSMutableArray *)pendingDirectories
+{
+    // Perform all of the disk reads for the items in this directory first.
+    // In parallel scans, this is the part that every worker can do at once.
+    NSUInteger numberOfEntries = reader.numberOfEntries;
+    NSMutableArray<NSURL *> *itemURLs = [NSMutableArray arrayWithCapacity:numberOfEntries];
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray arrayWithCapacity:numberOfEntries];
+    NSMutableData *scannedItems = [NSMutableData dataWithCapacity:numberOfEntries * sizeof(TOFileSystemScannedItem)];
+    for (NSUInteger i = 0; i < numberOfEntries; i++) {
+        NSURL *itemURL = [reader URLOfEntryAtIndex:i].URLByStandardizingPath;
+
+        TOFileSystemScannedItem scannedItem = {0};
+        scannedItem.attributes = reader.entries[i].attributes;
+        TOFileSystemUUID *uuid = [self uuidForScannableItemAtURL:itemURL
+                                                      attributes:&scannedItem.attributes
+                                                     isUnchanged:&scannedItem.isUnchanged
+                                                          reader:reader
+                                                      entryIndex:i];
+        if (uuid == nil) { continue; }
+
+        [itemURLs addObject:itemURL];
+        [uuids addObject:uuid];
+        [scannedItems appendBytes:&scannedItem length:sizeof(TOFileSystemScannedItem)];
+    }
+
+    [self commitScannedItems:scannedItems itemURLs:itemURLs uuids:uuids pendingDirectories:pendingDirectories];
+}
+
+- (void)commitScannedItems:(NSData *)scannedItems
+                  itemURLs:(NSArray<NSURL *> *)itemURLs
+                     uuids:(NSArray<TOFileSystemUUID *> *)uuids
+        pendingDirectories:(NSMutableArray *)pendingDirectories
+{
+    // Commit the whole directory in one go so its items are
+    // always reported together, and in the order they were enumerated.
+    [self performCommit:^{
+        const TOFileSystemScannedItem *items = scannedItems.bytes;
+        for (NSInteger i = 0; i < itemURLs.count; i++) {
+            [self commitItemAtURL:itemURLs[i]
+                             uuid:uuids[i]
+                       attributes:&items[i].attributes
+                      isUnchanged:items[i].isUnchanged
+               pendingDirectories:pendingDirectories];
         }
+    }];
+}
+
+#pragma mark - Parallel Directory Scan -
+
+- (void)scanPendingSubdirectoriesInParallel
+{
+    NSInteger numberOfWorkers = self.numberOfWorkers;
+
+    // Create a queue for each worker, and deal out the base level directories between them
+    NSMutableArray<TOFileSystemScanDeque *> *deques = [NSMutableArray arrayWithCapacity:numberOfWorkers];
+    for (NSInteger i = 0; i < numberOfWorkers; i++) {
+        [deques addObject:[[TOFileSystemScanDeque alloc] init]];
+    }
+
+    NSArray *pendingDirectories = [self.pendingDirectories copy];
+    [self.pendingDirectories removeAllObjects];
+    for (NSInteger i = 0; i < pendingDirectories.count; i++) {
+        [deques[i % numberOfWorkers] pushObject:pendingDirectories[i]];
+    }
+    atomic_store(&_numberOfPendingDirectories, (long)pendingDirectories.count);
+    [self performCommit:^{ self.workerDeques = deques; }];
+
+    // Run every worker at the same QoS as this operation, and block until they've all finished
+    dispatch_queue_t queue = dispatch_get_global_queue(qos_class_self(), 0);
+    dispatch_apply(numberOfWorkers, queue, ^(size_t index) {
+        [self runScanWorkerAtIndex:index withDeques:deques];
+    });
+
+    [self performCommit:^{ self.workerDeques = nil; }];
 
-        // Create a new enumerator for it
-        NSDirectoryEnumerator *enumerator = [self.fileManager to_fileSystemEnumeratorForDirectoryAtURL:url];
-        for (NSURL *url in enumerator) {
-            [self scanItemAtURL:url pendingDirectories:pendingDirectories];
+    // If we were cancelled, gather up every directory the workers hadn't reached yet
+    if (!self.isCancelled) { return; }
+    [self performCommit:^{
+        [self.pendingDirectories addObjectsFromArray:self.priorityDirectories];
+        [self.priorityDirectories removeAllObjects];
+        atomic_store(&self->_numberOfQueuedPriorityDirectories, 0);
+    }];
+    for (TOFileSystemScanDeque *deque in deques) {
+        NSURL *url = nil;
+        while ((url = [deque stealObject])) {
+            [self.pendingDirectories addObject:url];
         }
     }
 }
 
+- (void)runScanWorkerAtIndex:(NSUInteger)index withDeques:(NSArray<TOFileSystemScanDeque *> *)deques
+{
+    TOFileSystemScanDeque *deque = deques[index];
+    TOFileSystemDirectoryReader *reader = [[TOFileSystemDirectoryReader alloc] init];
+    NSMutableArray *discoveredDirectories = [NSMutableArray array];
+
+    // Workers stop between directories when cancelled, leaving what remains in the queues
+    while (!self.isCancelled) {
+        @autoreleasepool {
+            // Note where things stood before looking for work, in case we need to wait for more
+            long generation = atomic_load(&_workGeneration);
+
+            // Any prioritized directories are shared between every worker, and taken first
+            NSURL *url = [self dequeuePriorityDirectory];
+            if (url) {
+                [self scanPriorityDirectoryAtURL:url reader:reader pendingDirectories:discoveredDirectories];
+                [self pushDiscoveredDirectories:discoveredDirectories ontoDeque:deque];
+                continue;
+            }
+
+            // Take the most recently discovered directory from our own queue,
+            // and if that's empty, try and steal one from another worker
+            url = [deque popObject];
+            if (url == nil) {
+                url = [self stealDirectoryFromDeques:deques forWorkerAtIndex:index];
+            }
+
+            // If there was nothing to steal, we're done once every other worker is
+            // finished too. Otherwise, wait for them to discover some more.
+            if (url == nil) {
+                if (atomic_load(&_numberOfPendingDirectories) == 0) { break; }
+                [self waitForMoreDirectoriesSinceGeneration:generation];
+                continue;
+            }
+
+            [self scanDirectoryAtURL:url reader:reader pendingDirectories:discoveredDirectories];
+            [self pushDiscoveredDirectories:discoveredDirectories ontoDeque:deque];
+        }
+    }
+}
+
+- (void)pushDiscoveredDirectories:(NSMutableArray *)discoveredDirectories ontoDeque:(TOFileSystemScanDeque *)deque
+{
+    // Queue up any subdirectories before marking the directory they were found in as complete,
+    // so the pending count can't touch zero while there is still work
+    for (NSURL *directoryURL in discoveredDirectories) {
+        atomic_fetch_add(&_numberOfPendingDirectories, 1);
+        [deque pushObject:directoryURL];
+    }
+    BOOL didDiscoverDirectories = (discoveredDirectories.count > 0);
+    [discoveredDirectories removeAllObjects];
+
+    // Wake any idle workers to take the new directories, or to finish if this was the last one
+    BOOL isFinished = (atomic_fetch_sub(&_numberOfPendingDirectories, 1) == 1);
+    if (didDiscoverDirectories || isFinished) {
+        [self wakeIdleWorkers];
+    }
+}
+
+- (void)waitForMoreDirectoriesSinceGeneration:(long)generation
+{
+    // Count ourselves as idle before checking the generation, so any worker that
+    // queues more directories after we've checked is sure to see us and wake us
+    atomic_fetch_add(&_numberOfIdleWorkers, 1);
+    [_workCondition lock];
+    while (atomic_load(&_workGeneration) == generation &&
+           atomic_load(&_numberOfPendingDirectories) > 0 && !self.isCancelled) {
+        [_workCondition wait];
+    }
+    [_workCondition unlock];
+    atomic_fetch_sub(&_numberOfIdleWorkers, 1);
+}
+
+- (void)wakeIdleWorkers
+{
+    // Bump the generation first, so a worker that's about to wait will see it and look again instead
+    atomic_fetch_add(&_workGeneration, 1);
+    if (atomic_load(&_numberOfIdleWorkers) == 0) { return; }
+
+    [_workCondition lock];
+    [_workCondition broadcast];
+    [_workCondition unlock];
+}
+
+- (void)cancel
+{
+    [super cancel];
+
+    // Idle workers would otherwise wait for directories that won't be scanned now
+    [self wakeIdleWorkers];
+}
+
+- (nullable NSURL *)stealDirectoryFromDeques:(NSArray<TOFileSystemScanDeque *> *)deques
+                            forWorkerAtIndex:(NSUInteger)index
+{
+    // Start with our neighbour, and work around the whole list of workers
+    NSUInteger numberOfDeques = deques.count;
+    for (NSUInteger i = 1; i < numberOfDeques; i++) {
+        NSURL *url = [deques[(index + i) % numberOfDeques] stealObject];
+        if (url) { return url; }
+    }
+
+    return nil;
+}
+
+#pragma mark - Priority Directories -
+
+- (void)prioritizeDirectoryAtURL:(NSURL *)directoryURL
+{
+    if (!self.isFullScan || directoryURL == nil) { return; }
+
+    // Hold onto it until the scanning thread is between directories
+    TOFileSystemLockLock(&_priorityLock);
+    [self.requestedPriorityDirectoryURLs addObject:directoryURL.URLByStandardizingPath];
+    TOFileSystemLockUnlock(&_priorityLock);
+}
+
+- (nullable NSURL *)dequeuePriorityDirectory
+{
+    // Take any newly requested directories
+    TOFileSystemLockLock(&_priorityLock);
+    NSArray<NSURL *> *requestedDirectoryURLs = nil;
+    if (self.requestedPriorityDirectoryURLs.count > 0) {
+        requestedDirectoryURLs = self.requestedPriorityDirectoryURLs.array;
+        [self.requestedPriorityDirectoryURLs removeAllObjects];
+    }
+    TOFileSystemLockUnlock(&_priorityLock);
+
+    // In the usual case of nothing being prioritized, avoid contending with the other workers
+    if (requestedDirectoryURLs == nil && atomic_load(&_numberOfQueuedPriorityDirectories) == 0) {
+        return nil;
+    }
+
+    __block NSURL *url = nil;
+    [self performCommit:^{
+        for (NSURL *directoryURL in requestedDirectoryURLs) {
+            [self moveDirectoryAheadAtURL:directoryURL];
+        }
+
+        // Scan breadth-first, so the contents nearest the top of a prioritized directory come first
+        url = self.priorityDirectories.firstObject;
+        if (url == nil) { return; }
+        [self.priorityDirectories removeObjectAtIndex:0];
+        atomic_fetch_sub(&self->_numberOfQueuedPriorityDirectories, 1);
+        self->_numberOfPriorityDirectoriesInProgress++;
+    }];
+
+    return url;
+}
+
+- (void)moveDirectoryAheadAtURL:(NSURL *)directoryURL
+{
+    // The base directory is always scanned first anyway, and excluded directories are never scanned
+    NSString *basePath = self.directoryURL.path;
+    NSString *path = directoryURL.path;
+    if (![path hasPrefix:[basePath stringByAppendingString:@"/"]]) { return; }
+    if ([self.skippedItems matchesItemOrParentOfItemAtURL:directoryURL]) { return; }
+    if ([self isPriorityDirectoryAtURL:directoryURL]) { return; }
+    [self.priorityDirectoryPaths addObject:path];
+
+    // If it hasn't been reached yet, it can go to the front by itself
+    if (![self.scannedDirectoryURLs containsObject:directoryURL]) {
+        [self addPriorityDirectoryAtURL:directoryURL];
+    }
+
+    // Find every directory inside it that is still waiting to be scanned.
+    // (Anything the workers discover inside it from now on will be prioritized as it's found.)
+    if (self.workerDeques == nil) {
+        NSIndexSet *indexes = [self.pendingDirectories indexesOfObjectsPassingTest:^BOOL(NSURL *url, NSUInteger i, BOOL *stop) {
+            return [self isPriorityDirectoryAtURL:url];
+        }];
+        for (NSURL *url in [self.pendingDirectories objectsAtIndexes:indexes]) {
+            [self addPriorityDirectoryAtURL:url];
+        }
+        [self.pendingDirectories removeObjectsAtIndexes:indexes];
+        return;
+    }
+
+    // Objects can't be taken out of the middle of a worker's queue, so queue copies of them.
+    // (The originals will be skipped once they are reached, since they'll already have been scanned.)
+    for (TOFileSystemScanDeque *deque in self.workerDeques) {
+        for (NSURL *url in deque.allObjects) {
+            if ([self isPriorityDirectoryAtURL:url]) { [self addPriorityDirectoryAtURL:url]; }
+        }
+    }
+}
+
+- (BOOL)isPriorityDirectoryAtURL:(NSURL *)directoryURL
+{
+    // (Only ever a handful of directories are prioritized at once)
+    NSString *path = directoryURL.path;
+    for (NSString *priorityPath in self.priorityDirectoryPaths) {
+        if (![path hasPrefix:priorityPath]) { continue; }
+        if (path.length == priorityPath.length || [path characterAtIndex:priorityPath.length] == '/') {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+- (void)addPriorityDirectoryAtURL:(NSURL *)directoryURL
+{
+    // In parallel scans, prioritized directories count towards the work still pending
+    [self.priorityDirectories addObject:directoryURL];
+    atomic_fetch_add(&_numberOfQueuedPriorityDirectories, 1);
+    atomic_fetch_add(&_numberOfPendingDirectories, 1);
+    [self wakeIdleWorkers];
+}
+
+- (void)scanPriorityDirectoryAtURL:(NSURL *)directoryURL
+                            reader:(TOFileSystemDirectoryReader *)reader
+                pendingDirectories:(NSMutableArray *)pendingDirectories
+{
+    // Invoking a block with an enforced QoS class raises this thread to it while the block runs
+    dispatch_block_t block = dispatch_block_create_with_qos_class(DISPATCH_BLOCK_ENFORCE_QOS_CLASS,
+                                                                  QOS_CLASS_USER_INITIATED, 0, ^{
+        [self scanDirectoryAtURL:directoryURL reader:reader pendingDirectories:pendingDirectories];
+    });
+    block();
+
+    // Once there is nothing prioritized left, the changes found in them can be delivered.
+    // (Nothing will be discovered inside them again, so they can be forgotten.)
+    [self performCommit:^{
+        self->_numberOfPriorityDirectoriesInProgress--;
+        if (self.priorityDirectories.count > 0 || self->_numberOfPriorityDirectoriesInProgress > 0) { return; }
+        [self.priorityDirectoryPaths removeAllObjects];
+        [self.delegate scanOperationDidScanPriorityDirectories:self];
+    }];
+}
+
 #pragma mark - Flat File List Scan -
 
 - (void)scanItemURLsList
 {
     // Loop through each reported file URL and perform a scan to see what changed
     for (NSURL *itemURL in self.itemURLs) {
+        // Skip any items inside a directory that we're excluding
+        if ([self.skippedItems matchesItemOrParentOfItemAtURL:itemURL]) { continue; }
+
         [self verifyEveryParentDirectoryForURL:itemURL];
         [self scanItemAtURL:itemURL pendingDirectories:self.pendingDirectories];
     }
+
+    // Rescan the contents of any directories where too many items changed to check one by one
+    for (NSURL *directoryURL in self.directoryURLs) {
+        [self rescanContentsOfDirectoryAtURL:directoryURL];
+    }
     
     // After all files are scanned, clean out any files
     [self cleanUpFilesPendingDeletion];
 }
 
+- (void)rescanContentsOfDirectoryAtURL:(NSURL *)directoryURL
+{
+    if ([self.skippedItems matchesItemOrParentOfItemAtURL:directoryURL]) { return; }
+
+    // Check the directory itself (unless it's the base directory, which isn't tracked as an item)
+    if (![directoryURL.path isEqualToString:self.directoryURL.path]) {
+        [self verifyEveryParentDirectoryForURL:directoryURL];
+        [self scanItemAtURL:directoryURL pendingDirectories:self.pendingDirectories];
+    }
+
+    // Capture what we previously knew was in the directory, then scan everything in it now
+    NSDictionary<TOFileSystemUUID *, NSURL *> *previousItems = [self.allItems itemURLsInDirectoryAtURL:directoryURL];
+    TOFileSystemDirectoryReader *reader = self.directoryReader;
+    if ([reader readDirectoryAtURL:directoryURL]) {
+        [self scanEntriesInReader:reader pendingDirectories:self.pendingDirectories];
+    }
+
+    // Any items that are no longer there were either moved or deleted
+    for (NSURL *itemURL in previousItems.allValues) {
+        [self verifyItemIsNotMissingAtURL:itemURL attributes:NULL];
+    }
+}
+
 #pragma mark - Scanning Logic -
 
 - (void)scanItemAtURL:(NSURL *)url pendingDirectories:(NSMutableArray *)pendingDirectories
 {
     // Sanitize the URL so we can use it in comparisons
     url = url.URLByStandardizingPath;
-    
+
+    // Read the item's attributes (If it's missing, that will be handled when fetching the UUID)
+    TOFileSystemItemAttributes attributes = {0};
+    [url to_getAttributes:&attributes];
+
+    // Fetch the UUID of the item, or skip it if it isn't one we're tracking
+    TOFileSystemUUID *uuid = [self uuidForScannableItemAtURL:url
+                                                  attributes:&attributes
+                                                 isUnchanged:NULL
+                                                      reader:nil
+                                                  entryIndex:0];
+    if (uuid == nil) { return; }
+
+    // Update the stores with the item's state
+    [self performCommit:^{
+        [self commitItemAtURL:url uuid:uuid attributes:&attributes isUnchanged:NO pendingDirectories:pendingDirectories];
+    }];
+}
+
+- (BOOL)shouldSkipItemAtURL:(NSURL *)url
+{
     // Make sure it's not a hidden file
     NSString *name = url.lastPathComponent;
-    if ([name characterAtIndex:0] == '.') { return; }
+    if ([name characterAtIndex:0] == '.') { return YES; }
     
-    // Check if it's a skipped one
-    for (NSString *skippedFileName in self.skippedItems) {
-        NSURL *skippedURL = [self.directoryURL URLByAppendingPathComponent:skippedFileName];
-        if ([url isEqual:skippedURL]) {
-            return;
-        }
-    }
+    // Check if it's a skipped one. (Since skipped directories are never queued for scanning,
+    // nothing inside them will be reached, so only the item itself needs checking.)
+    return [self.skippedItems matchesItemAtURL:url];
+}
+
+- (nullable TOFileSystemUUID *)uuidForScannableItemAtURL:(NSURL *)url
+                                              attributes:(const TOFileSystemItemAttributes *)attributes
+                                             isUnchanged:(nullable BOOL *)isUnchanged
+                                                  reader:(nullable TOFileSystemDirectoryReader *)reader
+                                              entryIndex:(NSUInteger)entryIndex
+{
+    // Make sure it's an item we're tracking
+    if ([self shouldSkipItemAtURL:url]) { return nil; }
     
     // Double-check the file is still at that URL
     // (The file presenter will sometimes provide the old URL for moved files)
-    if (![self verifyItemIsNotMissingAtURL:url]) {
-        return;
+    if (![self verifyItemIsNotMissingAtURL:url attributes:attributes]) {
+        return nil;
     }
     
-    // Check if we've already assigned an on-disk UUID
-    NSString *uuid = [self.filePresenter uuidForItemAtURL:url];
-     
+    // If the item hasn't changed since the index was saved, we can trust the UUID it had then
+    if (self.scanIndex) {
+        NSString *relativePath = [self.allItems relativePathForItemURL:url];
+        NSUInteger recordIndex = [self.scanIndex indexOfRecordWithRelativePath:relativePath];
+        if (recordIndex != NSNotFound && [self.scanIndex recordAtIndex:recordIndex matchesAttributes:attributes]) {
+            if (isUnchanged) { *isUnchanged = YES; }
+            return [self.scanIndex uuidOfRecordAtIndex:recordIndex];
+        }
+    }
+
+    // If we've seen this exact item before (even if it's since been moved or renamed), reuse its UUID
+    TOFileSystemUUID *uuid = [self.allItems uuidForItemWithAttributes:attributes];
+    if (uuid) { return uuid; }
+
+    // Check if we've already assigned an on-disk UUID.
+    // If the item was read out of a directory that's still open, access it relative to that instead.
+    if (reader) {
+        return [self.filePresenter uuidForEntryAtIndex:entryIndex inDirectoryReader:reader];
+    }
+    return [self.filePresenter uuidForItemAtURL:url attributes:attributes];
+}
+
+- (void)commitItemAtURL:(NSURL *)url
+                   uuid:(TOFileSystemUUID *)uuid
+             attributes:(const TOFileSystemItemAttributes *)attributes
+            isUnchanged:(BOOL)isUnchanged
+     pendingDirectories:(NSMutableArray *)pendingDirectories
+{
     // If the item is a directory, add it to the pending list to scan later
-    if (url.to_isDirectory) {
+    // (or ahead of everything else if it's inside a prioritized directory)
+    if (attributes->isDirectory && self.priorityDirectoryPaths.count > 0 && [self isPriorityDirectoryAtURL:url]) {
+        [self addPriorityDirectoryAtURL:url];
+    }
+    else if (attributes->isDirectory) {
         [pendingDirectories addObject:url];
     }
+
+    // When reconciling against a previous session, only the differences are reported
+    if (self.scanIndex) {
+        [self reconcileItemAtURL:url uuid:uuid attributes:attributes isUnchanged:isUnchanged];
+        return;
+    }
     
     // Check if the item had been moved
-    if (![self verifyIfItemWasMovedOrDeletedWithURL:url uuid:uuid]) {
+    if (![self verifyIfItemWasMovedOrDeletedWithURL:url uuid:uuid attributes:attributes]) {
         return;
     }
     
     // Verify this file has a unique UUID.
-    uuid = [self uniqueUUIDForItemAtURL:url withUUID:uuid];
+    uuid = [self uniqueUUIDForItemAtURL:url withUUID:uuid attributes:attributes];
     
     // Perform a verification of the item, and trigger the appropriate notifications
-    [self verifyItemAtURL:url uuid:uuid];
+    [self verifyItemAtURL:url uuid:uuid attributes:attributes];
+}
+
+- (void)performCommit:(void (^)(void))block
+{
+    TOFileSystemLockLock(&_commitLock);
+    block();
+    TOFileSystemLockUnlock(&_commitLock);
 }
 
 - (void)verifyEveryParentDirectoryForURL:(NSURL *)url
@@ -270,7 +1006,7 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
         if ([url isEqual:directoryURL]) { break; }
         
         // Check if we have a UUID for this folder, and skip if we do
-        NSString *uuid = [self.allItems uuidForItemWithURL:url];
+        TOFileSystemUUID *uuid = [self.allItems uuidForItemWithURL:url];
         if (uuid) { continue; }
         
         // If we didn't have a UUID, try and get one from the folder
@@ -287,18 +1023,20 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     }
 }
 
-- (BOOL)verifyItemIsNotMissingAtURL:(NSURL *)url
+- (BOOL)verifyItemIsNotMissingAtURL:(NSURL *)url attributes:(nullable const TOFileSystemItemAttributes *)attributes
 {
     // Exit out if we're not interested in tracking deleted files in this operation
     if (self.missingItems == nil) { return YES; }
     
     // Check if the file is still present at that URL
+    // (If we've just read its attributes, it must be, so we don't need to check again)
+    if (attributes && attributes->inode != 0) { return YES; }
     if ([[NSFileManager defaultManager] fileExistsAtPath:url.path]) {
         return YES;
     }
     
     // Look up in the all items store to see if we have a UUID
-    NSString *uuid = [self.allItems uuidForItemWithURL:url];
+    TOFileSystemUUID *uuid = [self.allItems uuidForItemWithURL:url];
     if (uuid == nil) { return NO; }
     
     // Save a reference to this file in case it turns up later in this operation
@@ -307,7 +1045,9 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     return NO;
 }
 
-- (BOOL)verifyIfItemWasMovedOrDeletedWithURL:(NSURL *)url uuid:(NSString *)uuid
+- (BOOL)verifyIfItemWasMovedOrDeletedWithURL:(NSURL *)url
+                                         uuid:(TOFileSystemUUID *)uuid
+                                   attributes:(const TOFileSystemItemAttributes *)attributes
 {
     NSURL *savedURL = self.allItems[uuid];
     if (savedURL == nil) { return YES; }
@@ -317,12 +1057,15 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
         return YES;
     }
     
-    // Check that the saved URL still has a file there, and the UUID of that file matches this one,
+    // If it's the same item on disk as the one we recorded, it was definitely moved, so we can skip checking the old location.
+    // Otherwise, check that the saved URL still has a file there, and the UUID of that file matches this one,
     // (in case the user potentially deleted the file, and replaced it with one with the same name)
-    NSString *savedUUID = [savedURL to_fileSystemUUID];
-    BOOL fileExists = [[NSFileManager defaultManager] fileExistsAtPath:savedURL.path];
-    if (fileExists && [savedUUID isEqualToString:uuid]) {
-        return YES;
+    if (![self isRecordedItemWithUUID:uuid matchingAttributes:attributes]) {
+        TOFileSystemUUID *savedUUID = [self.filePresenter existingUUIDForItemAtURL:savedURL];
+        BOOL fileExists = [[NSFileManager defaultManager] fileExistsAtPath:savedURL.path];
+        if (fileExists && [savedUUID isEqualToUUID:uuid]) {
+            return YES;
+        }
     }
     
     // If the file still exists, but it was moved to the Trashes folder, this means
@@ -343,6 +1086,17 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     
     // We've confirmed that this file has been moved or renamed.
     
+    // Moving a directory's entry in the store moves everything inside it along with it,
+    // so capture where each of those items was beforehand, so they can be reported too
+    NSMutableArray<TOFileSystemUUID *> *childUUIDs = [NSMutableArray array];
+    NSMutableArray<NSURL *> *childURLs = [NSMutableArray array];
+    if (attributes->isDirectory) {
+        [self.allItems enumerateItemsInDirectoryAtURL:savedURL usingBlock:^(TOFileSystemUUID *childUUID, NSURL *childURL, BOOL *stop) {
+            [childUUIDs addObject:childUUID];
+            [childURLs addObject:childURL];
+        }];
+    }
+    
     // Update the store for the new location
     [self.allItems setItemURL:url forUUID:uuid];
     
@@ -352,9 +1106,19 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     // Post a notification that this operation happened
     [self.delegate scanOperation:self itemWithUUID:uuid didMoveFromURL:savedURL toURL:url];
     
+    // Report every item inside it as moved too, the same as if each one had been found at its new location
+    for (NSUInteger i = 0; i < childUUIDs.count; i++) {
+        TOFileSystemUUID *childUUID = childUUIDs[i];
+        NSURL *childURL = self.allItems[childUUID];
+        if (childURL == nil || [childURL isEqual:childURLs[i]]) { continue; }
+        
+        [self.missingItems removeObjectForKey:childUUID];
+        [self.delegate scanOperation:self itemWithUUID:childUUID didMoveFromURL:childURLs[i] toURL:childURL];
+    }
+    
     return YES;
 }
-- (void)verifyItemAtURL:(NSURL *)url uuid:(NSString *)uuid
+- (void)verifyItemAtURL:(NSURL *)url uuid:(TOFileSystemUUID *)uuid attributes:(const TOFileSystemItemAttributes *)attributes
 {
     NSURL *savedURL = self.allItems[uuid];
     
@@ -367,14 +1131,14 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     // To remedy this, use an inverse dictionary to access any previous UUID
     // values stored against this current URL, and if they don't match,
     // delete the previous entry
-    NSString *savedUUID = [self.allItems uuidForItemWithURL:url];
-    if (savedUUID && ![savedUUID isEqualToString:uuid]) {
+    TOFileSystemUUID *savedUUID = [self.allItems uuidForItemWithURL:url];
+    if (savedUUID && ![savedUUID isEqualToUUID:uuid]) {
         [self.allItems removeItemURLForUUID:savedUUID];
         [self.delegate scanOperation:self didDeleteItemAtURL:url withUUID:savedUUID];
     }
     
     // Save/update the item to our master items list
-    [self.allItems setItemURL:url forUUID:uuid];
+    [self.allItems setItemURL:url attributes:attributes forUUID:uuid];
     
     // If this item wasn't in the master store yet, trigger an alert that it was discovered
     // (On full scans, this happens regardless)
@@ -387,12 +1151,74 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     [self.delegate scanOperation:self itemDidChangeAtURL:url withUUID:uuid];
 }
 
+- (void)reconcileItemAtURL:(NSURL *)url
+                      uuid:(TOFileSystemUUID *)uuid
+                attributes:(const TOFileSystemItemAttributes *)attributes
+               isUnchanged:(BOOL)isUnchanged
+{
+    // If another item in this scan already claimed this UUID, this one must be a duplicate
+    NSURL *savedURL = self.allItems[uuid];
+    if (savedURL && ![savedURL.path isEqualToString:url.path]) {
+        uuid = [self uniqueUUIDForItemAtURL:url withUUID:uuid attributes:attributes];
+        isUnchanged = NO;
+    }
+
+    // Save/update the item to our master items list
+    [self.allItems setItemURL:url attributes:attributes forUUID:uuid];
+
+    // If the index doesn't have a record of it, it's new since the last session
+    TOFileSystemScanIndex *scanIndex = self.scanIndex;
+    NSUInteger recordIndex = [scanIndex indexOfRecordWithUUID:uuid];
+    if (recordIndex == NSNotFound) {
+        [self.delegate scanOperation:self didDiscoverItemAtURL:url withUUID:uuid];
+        return;
+    }
+    [self.reconciledRecords addIndex:recordIndex];
+
+    // If it was recorded somewhere else, it was moved while we weren't observing
+    NSString *relativePath = [scanIndex relativePathOfRecordAtIndex:recordIndex];
+    NSURL *previousURL = [self.allItems itemURLForRelativePath:relativePath isDirectory:attributes->isDirectory];
+    if (![previousURL.path isEqualToString:url.path]) {
+        [self.delegate scanOperation:self itemWithUUID:uuid didMoveFromURL:previousURL toURL:url];
+        return;
+    }
+
+    // Otherwise, it's only worth reporting if something about it changed
+    if (!isUnchanged) {
+        [self.delegate scanOperation:self itemDidChangeAtURL:url withUUID:uuid];
+    }
+}
+
+- (void)reportItemsMissingFromScanIndex
+{
+    TOFileSystemScanIndex *scanIndex = self.scanIndex;
+    if (scanIndex == nil) { return; }
+
+    // Any records that weren't matched to an item on disk were deleted while we weren't observing
+    for (NSUInteger i = 0; i < scanIndex.count; i++) {
+        if ([self.reconciledRecords containsIndex:i]) { continue; }
+
+        // (When resuming from a checkpoint, the item may have been found elsewhere before the scan was cancelled)
+        TOFileSystemUUID *uuid = [scanIndex uuidOfRecordAtIndex:i];
+        NSURL *savedURL = self.allItems[uuid];
+        if (savedURL && [[NSFileManager defaultManager] fileExistsAtPath:savedURL.path]) { continue; }
+        [self.allItems removeItemURLForUUID:uuid];
+
+        TOFileSystemItemAttributes attributes;
+        [scanIndex getAttributes:&attributes ofRecordAtIndex:i];
+
+        NSString *relativePath = [scanIndex relativePathOfRecordAtIndex:i];
+        NSURL *url = [self.allItems itemURLForRelativePath:relativePath isDirectory:attributes.isDirectory];
+        [self.delegate scanOperation:self didDeleteItemAtURL:url withUUID:uuid];
+    }
+}
+
 - (void)cleanUpFilesPendingDeletion
 {
     if (self.missingItems.count == 0) { return; }
     
     // Loop through each missing item entry
-    for (NSString *uuid in self.missingItems.allKeys) {
+    for (TOFileSystemUUID *uuid in self.missingItems.allKeys) {
         // Remove it from the master store
         [self.allItems removeItemURLForUUID:uuid];
         
@@ -403,7 +1229,9 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
 
 #pragma mark - State Tracking -
 
-- (NSString *)uniqueUUIDForItemAtURL:(NSURL *)url withUUID:(NSString *)uuid
+- (TOFileSystemUUID *)uniqueUUIDForItemAtURL:(NSURL *)url
+                             withUUID:(TOFileSystemUUID *)uuid
+                           attributes:(const TOFileSystemItemAttributes *)attributes
 {
     // Check if we already stored an item with that same UUID
     NSURL *savedURL = self.allItems[uuid];
@@ -413,6 +1241,11 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     if ([url.URLByStandardizingPath isEqual:savedURL]) {
         return uuid;
     }
+
+    // If it's the same item on disk as the one stored, it was moved rather than duplicated
+    if ([self isRecordedItemWithUUID:uuid matchingAttributes:attributes]) {
+        return uuid;
+    }
     
     // If the old one no longer exists, assume we moved files
     if (![[NSFileManager defaultManager] fileExistsAtPath:savedURL.path]) {
@@ -421,18 +1254,26 @@ NSString * const kTOFileSystemTrashFolderName = @"/.Trash/";
     
     // Otherwise, the user must have duplicated a file, so re-gen the UUID
     // and assign it to this file
-    __block NSString *newUUID;
-    [self.filePresenter performCoordinatedWrite:^{
+    __block TOFileSystemUUID *newUUID;
+    [self.filePresenter performCoordinatedWriteForItemAtURL:url usingBlock:^{
         // Do a sanity check to verify the UUID didn't change while this queue was waiting
-        newUUID = [url to_fileSystemUUID];
-        if ([uuid isEqualToString:newUUID]) {
-            newUUID = [url to_generateFileSystemUUID];
+        newUUID = [url to_fileSystemUUIDValue];
+        if ([uuid isEqualToUUID:newUUID]) {
+            newUUID = [url to_generateFileSystemUUIDValue];
         }
     }];
         
     return newUUID;
 }
 
+- (BOOL)isRecordedItemWithUUID:(TOFileSystemUUID *)uuid matchingAttributes:(const TOFileSystemItemAttributes *)attributes
+{
+    // Compare the file system IDs, which stay the same when an item is moved or renamed
+    TOFileSystemItemAttributes savedAttributes;
+    if (![self.allItems getAttributes:&savedAttributes forUUID:uuid]) { return NO; }
+    return TOFileSystemItemAttributesAreSameItem(&savedAttributes, attributes);
+}
+
 - (NSInteger)numberOfDirectoryLevelsToURL:(NSURL *)url
 {
     NSInteger levels = 0;
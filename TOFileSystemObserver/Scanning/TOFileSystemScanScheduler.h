@@ -0,0 +1,71 @@
+//
+//  TOFileSystemScanScheduler.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class TOFileSystemScanOperation;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Sits between the file presenter and the scanning operation queue,
+ coalescing bursts of file events into as few scans as possible.
+
+ While an item scan is still waiting in the queue, any new items are merged into
+ it rather than queueing another scan behind it. (The scan itself removes duplicates, and
+ rescans a whole directory once enough items inside it have changed.) If a full scan
+ that will read every item is still waiting to start, item scans are dropped entirely.
+
+ Directories can also be prioritized, so that while a full scan is queued or running,
+ they're scanned (and their changes delivered) before the rest of the directory tree.
+ */
+@interface TOFileSystemScanScheduler : NSObject
+
+/** The queue that scan operations are added to. */
+@property (nonatomic, readonly) NSOperationQueue *operationQueue;
+
+/** Creates a new scheduler that will add its operations to the provided queue. */
+- (instancetype)initWithOperationQueue:(NSOperationQueue *)operationQueue;
+
+/** Adds a full scan to the queue. Until it starts, it will absorb any new item scans. */
+- (void)addFullScanOperation:(TOFileSystemScanOperation *)operation;
+
+/**
+ Tries to fold a list of changed items into a scan that is already queued.
+ Returns NO if there wasn't one, and a new item scan should be created for them.
+ */
+- (BOOL)addItemURLsToPendingScan:(NSArray<NSURL *> *)itemURLs;
+
+/** Adds a new item scan to the queue. Until it starts, any new items will be merged into it. */
+- (void)addItemScanOperation:(TOFileSystemScanOperation *)operation;
+
+/**
+ Moves a directory, and everything inside it, ahead of the rest of the current full scan.
+ If no full scan has been queued yet, it's held and applied to the next one that is.
+ */
+- (void)prioritizeDirectoryAtURL:(NSURL *)directoryURL;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
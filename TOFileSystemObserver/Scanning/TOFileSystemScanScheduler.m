@@ -0,0 +1,135 @@
+//
+//  TOFileSystemScanScheduler.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemScanScheduler.h"
+#import "TOFileSystemScanOperation.h"
+#import "TOFileSystemLock.h"
+
+@interface TOFileSystemScanScheduler () {
+    /** Guards the pending operations, since events arrive on the presenter's queue. */
+    TOFileSystemLock _lock;
+}
+
+/** The queue that scan operations are added to. */
+@property (nonatomic, strong, readwrite) NSOperationQueue *operationQueue;
+
+/** The most recently queued full scan. (It stays set while it's running, so directories can be prioritized in it.) */
+@property (nonatomic, weak) TOFileSystemScanOperation *pendingFullScan;
+
+/** The most recently queued item scan. */
+@property (nonatomic, weak) TOFileSystemScanOperation *pendingItemScan;
+
+/** Directories that were prioritized before any full scan was queued. */
+@property (nonatomic, strong) NSMutableOrderedSet<NSURL *> *priorityDirectoryURLs;
+
+@end
+
+@implementation TOFileSystemScanScheduler
+
+- (instancetype)initWithOperationQueue:(NSOperationQueue *)operationQueue
+{
+    if (self = [super init]) {
+        _operationQueue = operationQueue;
+        _priorityDirectoryURLs = [NSMutableOrderedSet orderedSet];
+        TOFileSystemLockInit(&_lock);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    TOFileSystemLockDestroy(&_lock);
+}
+
+#pragma mark - Scheduling -
+
+- (void)addFullScanOperation:(TOFileSystemScanOperation *)operation
+{
+    TOFileSystemLockLock(&_lock);
+    self.pendingFullScan = operation;
+
+    // Hand over any directories that were prioritized while there was no scan to apply them to
+    for (NSURL *directoryURL in self.priorityDirectoryURLs) {
+        [operation prioritizeDirectoryAtURL:directoryURL];
+    }
+    [self.priorityDirectoryURLs removeAllObjects];
+    TOFileSystemLockUnlock(&_lock);
+
+    [self.operationQueue addOperation:operation];
+}
+
+- (BOOL)addItemURLsToPendingScan:(NSArray<NSURL *> *)itemURLs
+{
+    TOFileSystemLockLock(&_lock);
+
+    // If a full scan that will read every item hasn't started yet, it will find these changes anyway
+    BOOL isCovered = [self fullScanCoversItemScans:self.pendingFullScan];
+
+    // Otherwise, merge them into the last item scan if it's still waiting in the queue
+    if (!isCovered) {
+        isCovered = [self.pendingItemScan addItemURLs:itemURLs];
+    }
+
+    TOFileSystemLockUnlock(&_lock);
+    return isCovered;
+}
+
+- (void)addItemScanOperation:(TOFileSystemScanOperation *)operation
+{
+    TOFileSystemLockLock(&_lock);
+    self.pendingItemScan = operation;
+    TOFileSystemLockUnlock(&_lock);
+
+    [self.operationQueue addOperation:operation];
+}
+
+- (void)prioritizeDirectoryAtURL:(NSURL *)directoryURL
+{
+    TOFileSystemLockLock(&_lock);
+
+    // If the last full scan has already finished, hold onto it for the next one
+    TOFileSystemScanOperation *operation = self.pendingFullScan;
+    if (operation == nil || operation.isFinished || operation.isCancelled) {
+        [self.priorityDirectoryURLs addObject:directoryURL];
+    }
+    else {
+        [operation prioritizeDirectoryAtURL:directoryURL];
+    }
+
+    TOFileSystemLockUnlock(&_lock);
+}
+
+#pragma mark - Coverage -
+
+- (BOOL)fullScanCoversItemScans:(TOFileSystemScanOperation *)operation
+{
+    // Only scans that are still waiting will read the changes
+    if (operation == nil || operation.isExecuting || operation.isFinished || operation.isCancelled) {
+        return NO;
+    }
+
+    // Scans that reuse previous results may skip over items that were modified in place
+    return operation.checkpoint == nil && !operation.skipsUnchangedDirectories;
+}
+
+@end
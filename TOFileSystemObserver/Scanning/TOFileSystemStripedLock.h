@@ -0,0 +1,111 @@
+//
+//  TOFileSystemStripedLock.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** The starting value of a path hash (The FNV-1a offset basis). */
+static const uint64_t kTOFileSystemPathHashSeed = 14695981039346656037ULL;
+
+/** Adds a string of bytes to a path hash. */
+static inline uint64_t TOFileSystemPathHashAppendBytes(uint64_t hash, const char *bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ Hashes a file system path. Trailing slashes are ignored, so the hash of a directory
+ extended with `TOFileSystemPathHashAppendComponent` matches the hash of the full path.
+ */
+static inline uint64_t TOFileSystemPathHash(const char *path) {
+    size_t length = strlen(path);
+    while (length > 0 && path[length - 1] == '/') { length--; }
+    return TOFileSystemPathHashAppendBytes(kTOFileSystemPathHashSeed, path, length);
+}
+
+/** Extends the hash of a directory's path to the hash of an item inside it. */
+static inline uint64_t TOFileSystemPathHashAppendComponent(uint64_t directoryHash, const char *name) {
+    uint64_t hash = TOFileSystemPathHashAppendBytes(directoryHash, "/", 1);
+    return TOFileSystemPathHashAppendBytes(hash, name, strlen(name));
+}
+
+/**
+ Hashes the path of a directory by where it really is on disk. Symlinks in the path are resolved first,
+ so different ways of reaching the same directory (eg, through `/var` and `/private/var`) share a stripe.
+ (This touches the disk, so hash each directory once, and extend it for each item inside.)
+ */
+FOUNDATION_EXTERN uint64_t TOFileSystemPathHashForDirectoryPath(NSString *directoryPath);
+
+/** Hashes the path of an item, resolving the directory it's in, but not the item itself. */
+FOUNDATION_EXTERN uint64_t TOFileSystemPathHashForItemPath(NSString *itemPath);
+
+/** How many accesses were made through a striped lock, and how long they waited for, and held it. */
+typedef struct {
+    uint64_t numberOfReads;             // The number of reads performed
+    uint64_t numberOfWrites;            // The number of writes performed
+    NSTimeInterval totalWaitTime;       // The total time spent waiting to acquire the lock, in seconds
+    NSTimeInterval longestWaitTime;     // The longest any single access waited, in seconds
+    NSTimeInterval totalHoldTime;       // The total time the lock was held for, in seconds
+} TOFileSystemStripedLockStatistics;
+
+/**
+ A readers-writer lock split into a fixed number of stripes,
+ where each file path is assigned to a stripe by its hash.
+
+ Reads of the same item can happen at the same time, while a write
+ excludes everything else on its stripe. Accesses of items on
+ different stripes never wait on each other, so writing to one file
+ doesn't stall every other read in the process.
+ */
+@interface TOFileSystemStripedLock : NSObject
+
+/** The number of separate locks that paths are divided between. */
+@property (nonatomic, readonly) NSUInteger numberOfStripes;
+
+/**
+ A lock shared by every observer in the process, so two observers
+ accessing the same file are still coordinated with each other.
+ */
++ (instancetype)sharedLock;
+
+/** Creates a new lock with the provided number of stripes. */
+- (instancetype)initWithNumberOfStripes:(NSUInteger)numberOfStripes;
+
+/** Performs a block while holding the stripe of the path for reading. */
+- (void)performReadWithPathHash:(uint64_t)pathHash usingBlock:(void (^)(void))block;
+
+/** Performs a block while holding the stripe of the path exclusively. */
+- (void)performWriteWithPathHash:(uint64_t)pathHash usingBlock:(void (^)(void))block;
+
+/** Adds up the statistics of every stripe since the lock was created (or last reset). */
+- (TOFileSystemStripedLockStatistics)statistics;
+
+/** Clears the statistics of every stripe back to zero. */
+- (void)resetStatistics;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,226 @@
+//
+//  TOFileSystemStripedLock.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemStripedLock.h"
+
+#import <pthread/pthread.h>
+#import <mach/mach_time.h>
+#import <stdatomic.h>
+#import <stdlib.h>
+
+/** The number of stripes in the shared lock. */
+static const NSUInteger kTOFileSystemSharedLockNumberOfStripes = 64;
+
+/** The size of a cache line. (128 bytes on Apple silicon, which also covers the 64 bytes on Intel.) */
+#define kTOFileSystemCacheLineSize 128
+
+/**
+ A single stripe, along with its own statistics. Each stripe is aligned
+ to its own cache line, so threads using neighbouring stripes don't slow each other down.
+ */
+typedef struct {
+    pthread_rwlock_t lock;
+    atomic_ullong numberOfReads;
+    atomic_ullong numberOfWrites;
+    atomic_ullong waitTime;     // In mach absolute time units
+    atomic_ullong longestWaitTime;
+    atomic_ullong holdTime;
+} __attribute__((aligned(kTOFileSystemCacheLineSize))) TOFileSystemLockStripe;
+
+_Static_assert(sizeof(TOFileSystemLockStripe) % kTOFileSystemCacheLineSize == 0,
+               "Each stripe must fill a whole number of cache lines, so no two stripes share one");
+
+uint64_t TOFileSystemPathHashForDirectoryPath(NSString *directoryPath)
+{
+    // (Resolving symlinks also removes the `/private` prefix that the system's directories can be reached through)
+    NSString *path = directoryPath.stringByResolvingSymlinksInPath;
+    if (path.length == 0) { return kTOFileSystemPathHashSeed; }
+    return TOFileSystemPathHash(path.fileSystemRepresentation);
+}
+
+uint64_t TOFileSystemPathHashForItemPath(NSString *itemPath)
+{
+    // The item itself isn't resolved, since it may be a symlink, which has its own UUID
+    NSString *directoryPath = itemPath.stringByDeletingLastPathComponent;
+    if (directoryPath.length == 0 || [directoryPath isEqualToString:itemPath]) {
+        return TOFileSystemPathHashForDirectoryPath(itemPath);
+    }
+    uint64_t directoryHash = TOFileSystemPathHashForDirectoryPath(directoryPath);
+    return TOFileSystemPathHashAppendComponent(directoryHash, itemPath.lastPathComponent.fileSystemRepresentation);
+}
+
+@interface TOFileSystemStripedLock () {
+    TOFileSystemLockStripe *_stripes;
+    NSUInteger _numberOfStripes;
+}
+
+@end
+
+@implementation TOFileSystemStripedLock
+
+#pragma mark - Class Lifecycle -
+
++ (instancetype)sharedLock
+{
+    static TOFileSystemStripedLock *_sharedLock = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        _sharedLock = [[TOFileSystemStripedLock alloc] initWithNumberOfStripes:kTOFileSystemSharedLockNumberOfStripes];
+    });
+    return _sharedLock;
+}
+
+- (instancetype)init
+{
+    return [self initWithNumberOfStripes:kTOFileSystemSharedLockNumberOfStripes];
+}
+
+- (instancetype)initWithNumberOfStripes:(NSUInteger)numberOfStripes
+{
+    if (self = [super init]) {
+        numberOfStripes = MAX(numberOfStripes, 1);
+        size_t length = numberOfStripes * sizeof(TOFileSystemLockStripe);
+        if (posix_memalign((void **)&_stripes, kTOFileSystemCacheLineSize, length) != 0) {
+            _stripes = NULL;
+            return nil;
+        }
+        memset(_stripes, 0, length);
+        _numberOfStripes = numberOfStripes;
+        for (NSUInteger i = 0; i < _numberOfStripes; i++) {
+            pthread_rwlock_init(&_stripes[i].lock, NULL);
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    for (NSUInteger i = 0; i < _numberOfStripes; i++) {
+        pthread_rwlock_destroy(&_stripes[i].lock);
+    }
+    free(_stripes);
+}
+
+#pragma mark - Locking -
+
+- (void)performReadWithPathHash:(uint64_t)pathHash usingBlock:(void (^)(void))block
+{
+    TOFileSystemLockStripe *stripe = [self stripeForPathHash:pathHash];
+
+    uint64_t startTime = mach_absolute_time();
+    pthread_rwlock_rdlock(&stripe->lock);
+    uint64_t lockedTime = mach_absolute_time();
+
+    @autoreleasepool {
+        if (block) { block(); }
+    }
+
+    uint64_t endTime = mach_absolute_time();
+    pthread_rwlock_unlock(&stripe->lock);
+
+    atomic_fetch_add_explicit(&stripe->numberOfReads, 1, memory_order_relaxed);
+    [self recordWaitTime:(lockedTime - startTime) holdTime:(endTime - lockedTime) inStripe:stripe];
+}
+
+- (void)performWriteWithPathHash:(uint64_t)pathHash usingBlock:(void (^)(void))block
+{
+    TOFileSystemLockStripe *stripe = [self stripeForPathHash:pathHash];
+
+    uint64_t startTime = mach_absolute_time();
+    pthread_rwlock_wrlock(&stripe->lock);
+    uint64_t lockedTime = mach_absolute_time();
+
+    @autoreleasepool {
+        if (block) { block(); }
+    }
+
+    uint64_t endTime = mach_absolute_time();
+    pthread_rwlock_unlock(&stripe->lock);
+
+    atomic_fetch_add_explicit(&stripe->numberOfWrites, 1, memory_order_relaxed);
+    [self recordWaitTime:(lockedTime - startTime) holdTime:(endTime - lockedTime) inStripe:stripe];
+}
+
+- (TOFileSystemLockStripe *)stripeForPathHash:(uint64_t)pathHash
+{
+    // Fold the upper bits in, since the lower bits of the hash alone can be less evenly spread
+    return &_stripes[(pathHash ^ (pathHash >> 32)) % _numberOfStripes];
+}
+
+#pragma mark - Statistics -
+
+- (void)recordWaitTime:(uint64_t)waitTime holdTime:(uint64_t)holdTime inStripe:(TOFileSystemLockStripe *)stripe
+{
+    atomic_fetch_add_explicit(&stripe->waitTime, waitTime, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stripe->holdTime, holdTime, memory_order_relaxed);
+
+    unsigned long long longestWaitTime = atomic_load_explicit(&stripe->longestWaitTime, memory_order_relaxed);
+    while (waitTime > longestWaitTime) {
+        if (atomic_compare_exchange_weak_explicit(&stripe->longestWaitTime, &longestWaitTime, waitTime,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+    }
+}
+
+- (TOFileSystemStripedLockStatistics)statistics
+{
+    uint64_t waitTime = 0, longestWaitTime = 0, holdTime = 0;
+    TOFileSystemStripedLockStatistics statistics = {0};
+    for (NSUInteger i = 0; i < _numberOfStripes; i++) {
+        TOFileSystemLockStripe *stripe = &_stripes[i];
+        statistics.numberOfReads += atomic_load_explicit(&stripe->numberOfReads, memory_order_relaxed);
+        statistics.numberOfWrites += atomic_load_explicit(&stripe->numberOfWrites, memory_order_relaxed);
+        waitTime += atomic_load_explicit(&stripe->waitTime, memory_order_relaxed);
+        holdTime += atomic_load_explicit(&stripe->holdTime, memory_order_relaxed);
+        longestWaitTime = MAX(longestWaitTime, atomic_load_explicit(&stripe->longestWaitTime, memory_order_relaxed));
+    }
+
+    // Convert from mach time units to seconds
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    double secondsPerUnit = ((double)timebase.numer / (double)timebase.denom) / NSEC_PER_SEC;
+    statistics.totalWaitTime = waitTime * secondsPerUnit;
+    statistics.longestWaitTime = longestWaitTime * secondsPerUnit;
+    statistics.totalHoldTime = holdTime * secondsPerUnit;
+    return statistics;
+}
+
+- (void)resetStatistics
+{
+    for (NSUInteger i = 0; i < _numberOfStripes; i++) {
+        TOFileSystemLockStripe *stripe = &_stripes[i];
+        atomic_store_explicit(&stripe->numberOfReads, 0, memory_order_relaxed);
+        atomic_store_explicit(&stripe->numberOfWrites, 0, memory_order_relaxed);
+        atomic_store_explicit(&stripe->waitTime, 0, memory_order_relaxed);
+        atomic_store_explicit(&stripe->longestWaitTime, 0, memory_order_relaxed);
+        atomic_store_explicit(&stripe->holdTime, 0, memory_order_relaxed);
+    }
+}
+
+- (NSUInteger)numberOfStripes
+{
+    return _numberOfStripes;
+}
+
+@end
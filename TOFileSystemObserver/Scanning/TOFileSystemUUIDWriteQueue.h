@@ -0,0 +1,92 @@
+//
+//  TOFileSystemUUIDWriteQueue.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+
+@class TOFileSystemUUID;
+@class TOFileSystemStripedLock;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Hands out UUIDs for items that don't have one saved on disk yet,
+ and writes them to their items in the background.
+
+ New UUIDs can be used straight away, and are held as pending until
+ they've been written. Pending UUIDs are grouped by their parent directory,
+ so each directory is only opened once to write all of its UUIDs,
+ instead of every new item being written as soon as it's found.
+
+ Each pending UUID also records the file system ID of the item it was generated for.
+ If the item is renamed or moved before it's written, looking it up with its new attributes
+ finds the same UUID, and a UUID is never written to a different item that has taken its old name.
+ */
+@interface TOFileSystemUUIDWriteQueue : NSObject
+
+/** How long to wait, in seconds, to collect new UUIDs before writing them. (Default is 0.25 seconds) */
+@property (nonatomic, assign) NSTimeInterval writeInterval;
+
+/** The number of UUIDs that are still waiting to be written. */
+@property (nonatomic, readonly) NSUInteger numberOfPendingUUIDs;
+
+/**
+ Increases each time a set of pending UUIDs finishes being written.
+ Read this before checking the disk for an item's UUID, and pass it along if it wasn't found.
+ */
+@property (nonatomic, readonly) NSUInteger numberOfCompletedWrites;
+
+/**
+ Creates a new queue that holds each item's stripe of the provided lock
+ while writing to it, so it never overlaps with coordinated reads of that item.
+ */
+- (instancetype)initWithCoordinationLock:(TOFileSystemStripedLock *)coordinationLock;
+
+/** Returns the UUID assigned to an item that hasn't been written to disk yet, if there is one. */
+- (nullable TOFileSystemUUID *)pendingUUIDForItemAtURL:(NSURL *)itemURL;
+
+/**
+ Returns the UUID for an item that doesn't have one on disk, generating a new one
+ and queueing it to be written if it doesn't have a pending one either.
+ This checks the disk again first, so should only be used when the caller hasn't just done so.
+ */
+- (TOFileSystemUUID *)uuidForNewItemAtURL:(NSURL *)itemURL;
+
+/**
+ Returns the UUID for an item that the caller just found has no UUID on disk, generating a new one
+ and queueing it to be written if it doesn't have a pending one either.
+
+ @param itemURL The URL of the item.
+ @param attributes The attributes of the item, if they've been read already. (Otherwise, they're read from disk.)
+ @param numberOfCompletedWrites The value of `numberOfCompletedWrites` from before the caller checked the disk.
+                                The disk is only checked again if a write has completed since then.
+ */
+- (TOFileSystemUUID *)uuidForNewItemAtURL:(NSURL *)itemURL
+                               attributes:(nullable const TOFileSystemItemAttributes *)attributes
+                  numberOfCompletedWrites:(NSUInteger)numberOfCompletedWrites;
+
+/** Blocks the current thread until every pending UUID has been written to disk. */
+- (void)flush;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,366 @@
+//
+//  TOFileSystemUUIDWriteQueue.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import "TOFileSystemUUIDWriteQueue.h"
+#import "TOFileSystemUUID.h"
+#import "NSURL+TOFileSystemUUID.h"
+#import "TOFileSystemLock.h"
+#import "TOFileSystemStripedLock.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** A UUID waiting to be written, along with where, and to which item. */
+@interface TOFileSystemPendingUUID : NSObject
+
+@property (nonatomic, strong) TOFileSystemUUID *uuid;
+@property (nonatomic, copy) NSString *directoryPath;
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, assign) dev_t device;
+@property (nonatomic, assign) uint64_t inode;   // 0 if the item couldn't be found, in which case it's never written
+
+@end
+
+@implementation TOFileSystemPendingUUID
+@end
+
+/** The pending UUIDs of the items in one directory, keyed by item name. */
+typedef NSMutableDictionary<NSString *, TOFileSystemPendingUUID *> TOFileSystemPendingUUIDs;
+
+/** Builds the key that pending UUIDs are looked up by, from an item's file system ID. */
+static NSData *TOFileSystemPendingUUIDKey(dev_t device, uint64_t inode)
+{
+    if (inode == 0) { return nil; }
+    struct { uint64_t inode; int64_t device; } key = { inode, (int64_t)device };
+    return [NSData dataWithBytes:&key length:sizeof(key)];
+}
+
+@interface TOFileSystemUUIDWriteQueue () {
+    TOFileSystemLock _lock;
+    NSUInteger _numberOfCompletedWrites;
+}
+
+/** The lock that every coordinated read and write is performed with. */
+@property (nonatomic, strong) TOFileSystemStripedLock *coordinationLock;
+
+/** A serial queue that the writes are performed on, in the background. */
+@property (nonatomic, strong) dispatch_queue_t writeQueue;
+
+/** The UUIDs waiting to be written, grouped by the path of their parent directory. */
+@property (nonatomic, strong) NSMutableDictionary<NSString *, TOFileSystemPendingUUIDs *> *pendingDirectories;
+
+/** The same UUIDs, keyed by the file system ID of their items, so they can be found after a rename. */
+@property (nonatomic, strong) NSMutableDictionary<NSData *, TOFileSystemPendingUUID *> *pendingItems;
+
+/** The UUIDs currently being written. (They still count as pending until the write completes.) */
+@property (nonatomic, strong, nullable) NSDictionary<NSString *, TOFileSystemPendingUUIDs *> *writingDirectories;
+@property (nonatomic, strong, nullable) NSDictionary<NSData *, TOFileSystemPendingUUID *> *writingItems;
+
+/** Whether a write has been scheduled for the current pending UUIDs yet. */
+@property (nonatomic, assign) BOOL isWriteScheduled;
+
+@end
+
+@implementation TOFileSystemUUIDWriteQueue
+
+#pragma mark - Class Lifecycle -
+
+- (instancetype)initWithCoordinationLock:(TOFileSystemStripedLock *)coordinationLock
+{
+    if (self = [super init]) {
+        _coordinationLock = coordinationLock;
+        _writeQueue = dispatch_queue_create("TOFileSystemObserver.uuidWriteQueue", DISPATCH_QUEUE_SERIAL);
+        _pendingDirectories = [NSMutableDictionary dictionary];
+        _pendingItems = [NSMutableDictionary dictionary];
+        _writeInterval = 0.25f;
+        TOFileSystemLockInit(&_lock);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    TOFileSystemLockDestroy(&_lock);
+}
+
+#pragma mark - Pending UUIDs -
+
+- (NSUInteger)numberOfPendingUUIDs
+{
+    NSUInteger count = 0;
+    TOFileSystemLockLock(&_lock);
+    for (TOFileSystemPendingUUIDs *uuids in _pendingDirectories.objectEnumerator) { count += uuids.count; }
+    for (TOFileSystemPendingUUIDs *uuids in _writingDirectories.objectEnumerator) { count += uuids.count; }
+    TOFileSystemLockUnlock(&_lock);
+    return count;
+}
+
+- (NSUInteger)numberOfCompletedWrites
+{
+    TOFileSystemLockLock(&_lock);
+    NSUInteger numberOfCompletedWrites = _numberOfCompletedWrites;
+    TOFileSystemLockUnlock(&_lock);
+    return numberOfCompletedWrites;
+}
+
+- (nullable TOFileSystemUUID *)pendingUUIDForItemAtURL:(NSURL *)itemURL
+{
+    // Skip building the path when nothing is waiting (which is almost always the case)
+    TOFileSystemLockLock(&_lock);
+    BOOL hasPendingUUIDs = (_pendingDirectories.count > 0 || _writingDirectories.count > 0);
+    TOFileSystemLockUnlock(&_lock);
+    if (!hasPendingUUIDs) { return nil; }
+
+    NSString *path = itemURL.URLByStandardizingPath.path;
+    NSString *directoryPath = path.stringByDeletingLastPathComponent;
+    NSString *name = path.lastPathComponent;
+
+    TOFileSystemLockLock(&_lock);
+    TOFileSystemUUID *uuid = [self pendingUUIDForItemNamed:name inDirectoryAtPath:directoryPath itemKey:nil].uuid;
+    TOFileSystemLockUnlock(&_lock);
+    return uuid;
+}
+
+- (TOFileSystemUUID *)uuidForNewItemAtURL:(NSURL *)itemURL
+{
+    // (No count of completed writes will ever match this, so the disk is always checked first)
+    return [self uuidForNewItemAtURL:itemURL attributes:NULL numberOfCompletedWrites:NSNotFound];
+}
+
+- (TOFileSystemUUID *)uuidForNewItemAtURL:(NSURL *)itemURL
+                               attributes:(nullable const TOFileSystemItemAttributes *)attributes
+                  numberOfCompletedWrites:(NSUInteger)numberOfCompletedWrites
+{
+    NSString *path = itemURL.URLByStandardizingPath.path;
+    NSString *directoryPath = path.stringByDeletingLastPathComponent;
+    NSString *name = path.lastPathComponent;
+
+    // Capture which item is at this path, so its UUID can follow it, and never be written to anything else
+    dev_t device = 0;
+    uint64_t inode = 0;
+    if (attributes) {
+        device = attributes->device;
+        inode = attributes->inode;
+    }
+    else {
+        struct stat fileStat;
+        if (lstat(path.fileSystemRepresentation, &fileStat) == 0) {
+            device = fileStat.st_dev;
+            inode = (uint64_t)fileStat.st_ino;
+        }
+    }
+    NSData *itemKey = TOFileSystemPendingUUIDKey(device, inode);
+
+    TOFileSystemUUID *uuid = nil;
+    BOOL needsScheduling = NO;
+    while (uuid == nil) {
+        TOFileSystemLockLock(&_lock);
+
+        // Another thread may have already queued a UUID for this item (possibly under its old name)
+        TOFileSystemPendingUUID *pendingUUID = [self pendingUUIDForItemNamed:name
+                                                           inDirectoryAtPath:directoryPath
+                                                                     itemKey:itemKey];
+        if (pendingUUID) {
+            uuid = pendingUUID.uuid;
+
+            // If it has moved since, write it to its new location instead
+            if (![pendingUUID.name isEqualToString:name] || ![pendingUUID.directoryPath isEqualToString:directoryPath]) {
+                needsScheduling = [self queueUUID:uuid forItemNamed:name inDirectoryAtPath:directoryPath
+                                           device:device inode:inode replacingPendingUUID:pendingUUID];
+            }
+        }
+        else if (numberOfCompletedWrites == _numberOfCompletedWrites) {
+            // Nothing has been written since the caller found no UUID on disk, so it's safe to generate one
+            uuid = [TOFileSystemUUID UUID];
+            needsScheduling = [self queueUUID:uuid forItemNamed:name inDirectoryAtPath:directoryPath
+                                       device:device inode:inode replacingPendingUUID:nil];
+        }
+        numberOfCompletedWrites = _numberOfCompletedWrites;
+
+        TOFileSystemLockUnlock(&_lock);
+        if (uuid) { break; }
+
+        // A write finished since the disk was last checked, and it may have been this item's UUID.
+        // (Pending UUIDs are only removed once written, so either the disk or the queue will have it.)
+        // Check again, only locking out other accesses of this item while doing so.
+        __block TOFileSystemUUID *savedUUID = nil;
+        [self.coordinationLock performReadWithPathHash:TOFileSystemPathHashForItemPath(path) usingBlock:^{
+            savedUUID = [itemURL to_fileSystemUUIDValue];
+        }];
+        if (savedUUID) { return savedUUID; }
+    }
+
+    if (needsScheduling) { [self scheduleWrite]; }
+    return uuid;
+}
+
+- (nullable TOFileSystemPendingUUID *)pendingUUIDForItemNamed:(NSString *)name
+                                            inDirectoryAtPath:(NSString *)directoryPath
+                                                      itemKey:(nullable NSData *)itemKey
+{
+    // (Must be called while holding the lock)
+
+    // Prefer the item's file system ID, which stays the same if it was renamed or moved
+    TOFileSystemPendingUUID *pendingUUID = nil;
+    if (itemKey) {
+        pendingUUID = _pendingItems[itemKey] ?: _writingItems[itemKey];
+        if (pendingUUID) { return pendingUUID; }
+    }
+
+    pendingUUID = _pendingDirectories[directoryPath][name] ?: _writingDirectories[directoryPath][name];
+
+    // If the item is known, don't hand out the UUID of a different item that used to have this name
+    if (pendingUUID && itemKey && ![TOFileSystemPendingUUIDKey(pendingUUID.device, pendingUUID.inode) isEqualToData:itemKey]) {
+        return nil;
+    }
+    return pendingUUID;
+}
+
+- (BOOL)queueUUID:(TOFileSystemUUID *)uuid
+     forItemNamed:(NSString *)name
+inDirectoryAtPath:(NSString *)directoryPath
+           device:(dev_t)device
+            inode:(uint64_t)inode
+replacingPendingUUID:(nullable TOFileSystemPendingUUID *)previousPendingUUID
+{
+    // (Must be called while holding the lock. Returns whether a write needs to be scheduled.)
+
+    // Stop the previous entry from being written if it hasn't started yet.
+    // (If it has, it'll be skipped, since its name now belongs to a different item, or none at all.)
+    if (previousPendingUUID) {
+        TOFileSystemPendingUUIDs *uuids = _pendingDirectories[previousPendingUUID.directoryPath];
+        if (uuids[previousPendingUUID.name] == previousPendingUUID) {
+            [uuids removeObjectForKey:previousPendingUUID.name];
+            if (uuids.count == 0) { [_pendingDirectories removeObjectForKey:previousPendingUUID.directoryPath]; }
+        }
+    }
+
+    TOFileSystemPendingUUID *pendingUUID = [[TOFileSystemPendingUUID alloc] init];
+    pendingUUID.uuid = uuid;
+    pendingUUID.directoryPath = directoryPath;
+    pendingUUID.name = name;
+    pendingUUID.device = device;
+    pendingUUID.inode = inode;
+
+    TOFileSystemPendingUUIDs *uuids = _pendingDirectories[directoryPath];
+    if (uuids == nil) {
+        uuids = [NSMutableDictionary dictionary];
+        _pendingDirectories[directoryPath] = uuids;
+    }
+    uuids[name] = pendingUUID;
+
+    NSData *itemKey = TOFileSystemPendingUUIDKey(device, inode);
+    if (itemKey) { _pendingItems[itemKey] = pendingUUID; }
+
+    BOOL needsScheduling = !_isWriteScheduled;
+    _isWriteScheduled = YES;
+    return needsScheduling;
+}
+
+#pragma mark - Writing -
+
+- (void)scheduleWrite
+{
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.writeInterval * NSEC_PER_SEC)),
+                   self.writeQueue, ^{
+        [self writePendingUUIDs];
+    });
+}
+
+- (void)flush
+{
+    dispatch_sync(self.writeQueue, ^{
+        [self writePendingUUIDs];
+    });
+}
+
+- (void)writePendingUUIDs
+{
+    // Move the pending UUIDs aside so new ones can keep being queued while these are written.
+    // Any added from here will schedule a write of their own.
+    TOFileSystemLockLock(&_lock);
+    NSDictionary<NSString *, TOFileSystemPendingUUIDs *> *directories = _pendingDirectories;
+    _writingDirectories = directories;
+    _writingItems = _pendingItems;
+    _pendingDirectories = [NSMutableDictionary dictionary];
+    _pendingItems = [NSMutableDictionary dictionary];
+    _isWriteScheduled = NO;
+    TOFileSystemLockUnlock(&_lock);
+
+    if (directories.count == 0) { return; }
+
+    // Write each directory's UUIDs in one go, so it only needs to be opened once
+    [directories enumerateKeysAndObjectsUsingBlock:^(NSString *directoryPath,
+                                                     TOFileSystemPendingUUIDs *uuids,
+                                                     BOOL *stop) {
+        @autoreleasepool {
+            [self writeUUIDs:uuids toDirectoryAtPath:directoryPath];
+        }
+    }];
+
+    // Now they're on disk, they no longer need to be tracked.
+    // Bumping the count lets anyone who checked the disk before this know to check again.
+    TOFileSystemLockLock(&_lock);
+    _writingDirectories = nil;
+    _writingItems = nil;
+    _numberOfCompletedWrites++;
+    TOFileSystemLockUnlock(&_lock);
+}
+
+- (void)writeUUIDs:(TOFileSystemPendingUUIDs *)uuids toDirectoryAtPath:(NSString *)directoryPath
+{
+    // If the directory has since been deleted or moved, there's nothing left to write to
+    const char *directoryFilePath = directoryPath.fileSystemRepresentation;
+    int directoryDescriptor = open(directoryFilePath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryDescriptor < 0) { return; }
+
+    // Write each one relative to the directory, only locking out other accesses of that item.
+    // Items that have since gone, or been replaced by a different item, are skipped.
+    uint64_t directoryPathHash = TOFileSystemPathHashForDirectoryPath(directoryPath);
+    [uuids enumerateKeysAndObjectsUsingBlock:^(NSString *name, TOFileSystemPendingUUID *pendingUUID, BOOL *stop) {
+        if (pendingUUID.inode == 0) { return; }
+
+        const char *fileName = name.fileSystemRepresentation;
+        uint64_t pathHash = TOFileSystemPathHashAppendComponent(directoryPathHash, fileName);
+        [self.coordinationLock performWriteWithPathHash:pathHash usingBlock:^{
+            if (TOFileSystemUUIDWriteToItemInDirectoryWithID(directoryDescriptor, fileName, pendingUUID.device,
+                                                             pendingUUID.inode, pendingUUID.uuid) || errno != EFTYPE) {
+                return;
+            }
+
+            // Links, pipes and devices aren't opened, so write to them by path instead
+            NSString *path = [directoryPath stringByAppendingPathComponent:name];
+            struct stat fileStat;
+            if (lstat(path.fileSystemRepresentation, &fileStat) == 0 && fileStat.st_dev == pendingUUID.device &&
+                (uint64_t)fileStat.st_ino == pendingUUID.inode) {
+                [[NSURL fileURLWithPath:path] to_setFileSystemUUIDValue:pendingUUID.uuid];
+            }
+        }];
+    }];
+
+    close(directoryDescriptor);
+}
+
+@end
@@ -24,6 +24,7 @@
 
 #import "TOFileSystemItemList.h"
 #import "TOFileSystemItem.h"
+#import "TOFileSystemItemSnapshot.h"
 #import "TOFileSystemNotificationToken.h"
 #import "TOFileSystemItemListChanges.h"
 #import "TOFileSystemChanges.h"
@@ -49,6 +50,12 @@ NS_SWIFT_NAME(FileSystemObserver)
  Optionally, a list of relative file paths from `directoryURL` to directories that
  will not be monitored. By default, this includes the 'Inbox' directory in the
  Documents directory.
+
+ As well as plain paths, glob patterns are supported. A wildcard pattern without a slash
+ (eg, `*.tmp`) matches items with that name anywhere, `*`, `?` and `[...]` match within a
+ path segment, and a `**` segment matches any number of directories (so a leading `**` segment
+ followed by `node_modules` will exclude every directory with that name). Excluded directories are
+ never read. Changes made to this list are applied the next time the observer is started.
  */
 @property (nonatomic, strong, nullable) NSArray<NSString *> *excludedItems;
 
@@ -58,6 +65,45 @@ NS_SWIFT_NAME(FileSystemObserver)
  */
 @property (nonatomic, assign) NSInteger includedDirectoryLevels;
 
+/**
+ The number of threads that will scan subdirectories in parallel during a full scan.
+ On large directory trees, setting this to the number of available processor cores can
+ significantly reduce the time the initial scan takes. (Default is 1, which scans serially).
+ */
+@property (nonatomic, assign) NSInteger numberOfFullScanWorkers;
+
+/**
+ Optionally, a file URL where the observer will save an index of every item it has discovered.
+ On the next `start`, the index is loaded and the initial scan will reuse the UUIDs of any
+ items that are unchanged since, instead of reading them from disk. Only the items that were added,
+ changed, moved or deleted in the meantime will then be reported. The index is saved after each
+ full scan, and when the observer is stopped. (Default is nil, where every start performs a complete rescan).
+ */
+@property (nonatomic, strong, nullable) NSURL *indexFileURL;
+
+/**
+ When starting from a saved index, skips reading the contents of any directory whose modification date
+ and number of items haven't changed since the index was saved, reusing what was recorded instead.
+ Subdirectories are still checked individually, so additions, deletions and renames anywhere are still found.
+ However, files that were modified in place (rather than being replaced) inside an unchanged directory won't
+ be reported, so only enable this if that is acceptable for your app. (Default is NO).
+ */
+@property (nonatomic, assign) BOOL skipsUnchangedDirectories;
+
+/**
+ The maximum number of changes that will be collected into a single `TOFileSystemChanges` object
+ before it is broadcast. Larger batches greatly reduce the number of notifications during a full scan,
+ and any item lists in memory are updated once per batch. Any remaining changes are always broadcast when
+ each scan finishes (and before the full scan completion notification). (Default is 1, where each change is broadcast as soon as it is found).
+ */
+@property (nonatomic, assign) NSUInteger maximumChangesBatchSize;
+
+/**
+ When batching changes, the longest time in seconds a batch will be held for after its first change is found,
+ before it is broadcast, even if it isn't full yet and no more changes arrive. (Default is 0.25 seconds).
+ */
+@property (nonatomic, assign) NSTimeInterval maximumChangesBatchInterval;
+
 /**
  The item that represents the base directory that was set to be observed
  by this file system observer.
@@ -87,32 +133,65 @@ NS_SWIFT_NAME(FileSystemObserver)
  Starts the file system observer monitoring the target directory for changes.
  Upon starting, the observer will perform a full file system scan, and will post a 'did discover'
  event for every item it finds. This can be used in order to ensure any caches, or previously
- expected locations of files can be updated.
+ expected locations of files can be updated. (If `indexFileURL` has been set, and an index was saved
+ from a previous session, only the items that changed since then will be posted.)
  */
 - (void)start;
 
 /** Completely stops the file observer from running and resets all of the internal state. When
- calling 'start' from after this state, another full file system scan will be performed. */
+ calling 'start' from after this state, another full file system scan will be performed.
+ If the initial full scan is still in progress, it will be stopped at the next directory, and the next call to
+ `start` will resume it from there, only re-reading the directories that changed in the meantime. */
 - (void)stop;
 
 /**
  Returns a list of directories and files inside the directory specified.
  While the file observer is running, this list is live, and will be automatically
  updated whenever any of the underlying files on disk are changed.
+ May be called from any thread.
  
  @param directoryURL The URL to target. Use `nil` for the observer's base directory.
  */
 - (nullable TOFileSystemItemList *)itemListForDirectoryAtURL:(nullable NSURL *)directoryURL;
 
+/**
+ While the initial full scan is in progress, moves the directory at the URL specified, and everything
+ inside it, ahead of the rest of the scan, so its changes are delivered first regardless of how large the
+ rest of the directory tree is. This is done automatically for directories that have an item list.
+
+ @param directoryURL The URL of the directory to scan first.
+ */
+- (void)prioritizeDirectoryAtURL:(NSURL *)directoryURL;
+
 /**
  Returns an item object representing the file or directory at the URL specified.
  While the file observer is running, this object is live, and will be automatically
  updated whenever the system detects that the file has changed.
+ May be called from any thread.
  
   @param fileURL The URL to target.
  */
 - (nullable TOFileSystemItem *)itemForFileAtURL:(NSURL *)fileURL;
 
+/**
+ Returns item objects for many files at once, in the same order as the URLs provided.
+ Files that no longer exist are skipped. Since the files' attributes and UUIDs are each read
+ once, and every item is looked up and stored in one pass, this is much faster than calling
+ `itemForFileAtURL:` for each URL. May be called from any thread.
+
+ @param fileURLs The URLs to target.
+ */
+- (NSArray<TOFileSystemItem *> *)itemsForFilesAtURLs:(NSArray<NSURL *> *)fileURLs;
+
+/**
+ Returns item objects for every (non-hidden) file and directory inside a directory.
+ The directory is read in bulk, so the attributes and UUIDs of its items are gathered
+ in as few system calls as possible. May be called from any thread.
+
+ @param directoryURL The directory to read. Use `nil` for the observer's base directory.
+ */
+- (NSArray<TOFileSystemItem *> *)itemsInDirectoryAtURL:(nullable NSURL *)directoryURL;
+
 /**
  Returns the unique UUID string that's been associated with the file at the provided URL from disk.
  This will attempt to retrieve the UUID while avoiding performing a file read if it can help it.
@@ -130,6 +209,14 @@ NS_SWIFT_NAME(FileSystemObserver)
  */
 - (nullable NSString *)uuidForParentOfItemAtURL:(NSURL *)itemURL;
 
+/**
+ UUIDs generated for new items are available straight away, but are written to their files
+ in the background, in batches per directory. This blocks the calling thread until every
+ one of them has been written to disk (eg, before the app is suspended, or before the files
+ are accessed by another process).
+ */
+- (void)flushPendingUUIDWrites;
+
  /**
  Registers a new notification block that will be triggered each time an update is detected.
  It is your responsibility to strongly retain the token object, and release it only
@@ -24,17 +24,25 @@
 
 #import "TOFileSystemPath.h"
 #import "TOFileSystemScanOperation.h"
+#import "TOFileSystemScanScheduler.h"
 #import "TOFileSystemPresenter.h"
 #import "TOFileSystemItemList+Private.h"
 #import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemScanIndex.h"
+#import "TOFileSystemScanCheckpoint.h"
+#import "TOFileSystemExclusionMatcher.h"
 #import "TOFileSystemItemMapTable.h"
+#import "TOFileSystemDirectoryReader.h"
 #import "TOFileSystemItem+Private.h"
 #import "TOFileSystemNotificationToken.h"
 #import "TOFileSystemNotificationToken+Private.h"
 #import "TOFileSystemObserverConstants.h"
 #import "TOFileSystemChanges+Private.h"
+#import "TOFileSystemChangesBatch.h"
+#import "TOFileSystemLock.h"
 
 #import "NSURL+TOFileSystemUUID.h"
+#import "TOFileSystemUUID.h"
 #import "NSURL+TOFileSystemAttributes.h"
 
 // Because the block is stored as a generic id, we must cast it back before we can call it.
@@ -58,13 +66,16 @@ NSString * const TOFileSystemObserverChangesUserInfoKey
 /** The instance held as the app-wide singleton */
 static TOFileSystemObserver *_sharedObserver = nil;
 
-@interface TOFileSystemObserver() <TOFileSystemScanOperationDelegate, TOFileSystemNotifying>
+@interface TOFileSystemObserver() <TOFileSystemScanOperationDelegate, TOFileSystemNotifying> {
+    /** Guards adding changes to the batch and detaching it to be broadcast. (Never held while it's broadcast.) */
+    TOFileSystemLock _changesBatchLock;
+}
 
 /** The absolute path to our observed directory's super directory so we can build paths. */
 @property (nonatomic, strong) NSURL *parentDirectoryURL;
 
 /** The UUID of the observed directory on disk, so we can easily access it in scans. */
-@property (nonatomic, copy) NSString *baseDirectoryUUID;
+@property (nonatomic, strong) TOFileSystemUUID *baseDirectoryUUID;
 
 /** Read-write access for the running state */
 @property (nonatomic, assign, readwrite) BOOL isRunning;
@@ -78,9 +89,33 @@ static TOFileSystemObserver *_sharedObserver = nil;
 /** The operation queue we will perform our scanning on. */
 @property (nonatomic, strong) NSOperationQueue *operationQueue;
 
+/** Adds scans to the operation queue, coalescing bursts of file events into fewer scans. */
+@property (nonatomic, strong) TOFileSystemScanScheduler *scanScheduler;
+
+/** The excluded items, compiled when the observer starts. */
+@property (nonatomic, strong) TOFileSystemExclusionMatcher *exclusionMatcher;
+
+/** The full scan operation currently queued or running, so it can be cancelled. */
+@property (nonatomic, weak) TOFileSystemScanOperation *fullScanOperation;
+
+/** If the last full scan was cancelled before it completed, the point where it stopped. (Only accessed on the operation queue.) */
+@property (nonatomic, strong) TOFileSystemScanCheckpoint *scanCheckpoint;
+
+/** The changes detected by the current scan that haven't been broadcast yet. (Guarded by the changes batch lock.) */
+@property (nonatomic, strong) TOFileSystemChangesBatch *changesBatch;
+
+/** Broadcasts the current batch once it has been held for the maximum interval, unless it's cancelled first. */
+@property (nonatomic, copy) dispatch_block_t changesBatchTimer;
+
+/** A serial queue that every batch is broadcast on, so batches are always delivered one at a time, in order. */
+@property (nonatomic, strong) dispatch_queue_t changesDeliveryQueue;
+
 /** A thread-safe store for every item URL discovered on disk to ensure there are no duplicate UUIDs. */
 @property (nonatomic, strong) TOFileSystemItemURLDictionary *allItems;
 
+/** The attributes of every item found while scanning, stored in columns. (Owned by `allItems`) */
+@property (nonatomic, readonly) TOFileSystemItemMetadataTable *itemMetadata;
+
 /** A thread-safe store for items that were observered to still being copied during the last update. */
 @property (nonatomic, strong) TOFileSystemItemURLDictionary *copyingItems;
 
@@ -122,6 +157,11 @@ static TOFileSystemObserver *_sharedObserver = nil;
     return self;
 }
 
+- (void)dealloc
+{
+    TOFileSystemLockDestroy(&_changesBatchLock);
+}
+
 + (instancetype)sharedObserver
 {
     if (_sharedObserver) { return _sharedObserver; }
@@ -151,11 +191,17 @@ static TOFileSystemObserver *_sharedObserver = nil;
     _isRunning = NO;
     _excludedItems = @[@"Inbox"];
     _includedDirectoryLevels = -1;
+    _numberOfFullScanWorkers = 1;
+    _maximumChangesBatchSize = 1;
+    _maximumChangesBatchInterval = 0.25;
+    TOFileSystemLockInit(&_changesBatchLock);
+    _changesDeliveryQueue = dispatch_queue_create("TOFileSystemObserver.changesDeliveryQueue", DISPATCH_QUEUE_SERIAL);
     
     // Set-up the operation queue
     _operationQueue = [[NSOperationQueue alloc] init];
     _operationQueue.maxConcurrentOperationCount = 1;
     _operationQueue.qualityOfService = NSQualityOfServiceBackground;
+    _scanScheduler = [[TOFileSystemScanScheduler alloc] initWithOperationQueue:_operationQueue];
 
     // Set up the file system presenter
     _fileSystemPresenter = [[TOFileSystemPresenter alloc] init];
@@ -173,6 +219,11 @@ static TOFileSystemObserver *_sharedObserver = nil;
     [NSURL to_setKeyNamePrefix:bundleIdentifier];
 }
 
+- (TOFileSystemItemMetadataTable *)itemMetadata
+{
+    return self.allItems.metadataTable;
+}
+
 #pragma mark - Observer Setup -
 
 - (void)configureFilePresenter
@@ -206,7 +257,11 @@ static TOFileSystemObserver *_sharedObserver = nil;
 
     // Lock in the properties of the base directory
     _parentDirectoryURL = [_directoryURL URLByDeletingLastPathComponent];
-    _baseDirectoryUUID = self.directoryItem.uuid;
+    _baseDirectoryUUID = self.directoryItem.uuidValue;
+
+    // Compile the list of excluded items once, so each scan can quickly check against it
+    _exclusionMatcher = [[TOFileSystemExclusionMatcher alloc] initWithPatterns:self.excludedItems ?: @[]
+                                                                       baseURL:self.directoryURL];
 
     // Start the observer to watch for any system level changes
     [self beginObservingBaseDirectory];
@@ -222,42 +277,119 @@ static TOFileSystemObserver *_sharedObserver = nil;
     // Set the running state to off
     self.isRunning = NO;
 
-    // Clear out all of the items in memory (since we'll do a rebuild next time)
-    [self.allItems removeAllItems];
+    // If the initial scan is still running, stop it at the next directory
+    [self.fullScanOperation cancel];
+
+    // Once any scan in progress has stopped, tidy up its state
+    [self.operationQueue addOperationWithBlock:^{
+        // Make sure every UUID handed out during this session has been saved to disk
+        [self.fileSystemPresenter flushPendingUUIDWrites];
+
+        // If the full scan was cancelled part-way, keep what it found so the next start can resume it.
+        // The saved index is left as it was, since a partial one would be missing items.
+        if (self.scanCheckpoint) { return; }
+
+        // Save the current state of every item so the next start can reconcile against it
+        [self saveScanIndex];
+
+        // Clear out all of the items in memory (since we'll do a rebuild next time)
+        [self.allItems removeAllItems];
+    }];
     
     // Remove all of the observers
     [self.fileSystemPresenter stop];
 }
 
 - (void)performFullDirectoryScan
+{
+    // Configure the scan on the operation queue, so any scan cancelled by a previous `stop` has finished
+    [self.operationQueue addOperationWithBlock:^{
+        if (!self.isRunning) { return; }
+        [self enqueueFullDirectoryScan];
+    }];
+}
+
+- (void)enqueueFullDirectoryScan
 {
     // Create a new scan operation
     TOFileSystemScanOperation *scanOperation = nil;
     scanOperation = [[TOFileSystemScanOperation alloc] initForFullScanWithDirectoryAtURL:self.directoryURL
-                                                                           skippingItems:self.excludedItems
+                                                                           skippingItems:self.exclusionMatcher
                                                                       allItemsDictionary:self.allItems
                                                                            filePresenter:self.fileSystemPresenter];
     scanOperation.subDirectoryLevelLimit = self.includedDirectoryLevels;
+    scanOperation.numberOfWorkers = self.numberOfFullScanWorkers;
     scanOperation.delegate = self;
+
+    // If a previous scan of this directory was cancelled, carry on from where it stopped.
+    // Otherwise, discard what it found, since it was for a different directory.
+    TOFileSystemScanCheckpoint *checkpoint = self.scanCheckpoint;
+    self.scanCheckpoint = nil;
+    if (checkpoint && [checkpoint.directoryURL isEqual:self.directoryURL.URLByStandardizingPath]) {
+        scanOperation.checkpoint = checkpoint;
+    }
+    else if (checkpoint) {
+        [self.allItems removeAllItems];
+    }
+
+    // If we saved an index in a previous session, only the differences from it will be scanned
+    if (self.indexFileURL && scanOperation.checkpoint == nil) {
+        scanOperation.scanIndex = [TOFileSystemScanIndex indexWithContentsOfFileURL:self.indexFileURL];
+        scanOperation.skipsUnchangedDirectories = self.skipsUnchangedDirectories;
+    }
+
+    // Any directories that still have lists from a previous session are scanned first
+    for (TOFileSystemUUID *listUUID in self.itemListTable.allUUIDs) {
+        TOFileSystemItemList *list = self.itemListTable[listUUID];
+        if (list) { [scanOperation prioritizeDirectoryAtURL:list.directoryURL]; }
+    }
     
     // Begin asynchronous execution
-    [self.operationQueue addOperation:scanOperation];
+    self.fullScanOperation = scanOperation;
+    [self.scanScheduler addFullScanOperation:scanOperation];
+    [self enqueueChangesBatchFlush];
+}
+
+- (void)enqueueChangesBatchFlush
+{
+    // Once the scan before this has finished, broadcast anything it left in the batch
+    [self.operationQueue addOperationWithBlock:^{
+        [self flushChangesBatch];
+    }];
+}
+
+- (void)saveScanIndex
+{
+    if (self.indexFileURL == nil) { return; }
+    [TOFileSystemScanIndex writeItems:self.allItems toFileURL:self.indexFileURL];
 }
 
 - (void)updateObservingObjectsWithChangedItemURLs:(NSArray *)itemURLs
 {
+    // If a scan that will pick these items up is still waiting in the queue, fold them into that
+    if ([self.scanScheduler addItemURLsToPendingScan:itemURLs]) {
+        return;
+    }
+
     // Create a new scan operation to analyse what changed
     TOFileSystemScanOperation *scanOperation = nil;
     scanOperation = [[TOFileSystemScanOperation alloc] initForItemScanWithItemURLs:itemURLs
                                                                            baseURL:self.directoryURL
-                                                                     skippingItems:self.excludedItems
+                                                                     skippingItems:self.exclusionMatcher
                                                                 allItemsDictionary:self.allItems
                                                                      filePresenter:self.fileSystemPresenter];
     scanOperation.subDirectoryLevelLimit = self.includedDirectoryLevels;
     scanOperation.delegate = self;
 
     // Begin asynchronous execution
-    [self.operationQueue addOperation:scanOperation];
+    [self.scanScheduler addItemScanOperation:scanOperation];
+    [self enqueueChangesBatchFlush];
+}
+
+- (void)prioritizeDirectoryAtURL:(NSURL *)directoryURL
+{
+    if (!self.isRunning || directoryURL == nil) { return; }
+    [self.scanScheduler prioritizeDirectoryAtURL:directoryURL];
 }
 
 - (TOFileSystemNotificationToken *)addNotificationBlock:(TOFileSystemNotificationBlock)block
@@ -279,26 +411,50 @@ static TOFileSystemObserver *_sharedObserver = nil;
 #pragma mark - Creating and Observing Items -
 
 - (nullable NSString *)uuidForItemAtURL:(NSURL *)itemURL
+{
+    return [self uuidValueForItemAtURL:itemURL].stringValue;
+}
+
+- (nullable NSString *)uuidForParentOfItemAtURL:(NSURL *)itemURL
+{
+    return [self uuidValueForParentOfItemAtURL:itemURL].stringValue;
+}
+
+- (nullable TOFileSystemUUID *)uuidValueForItemAtURL:(NSURL *)itemURL
 {
     // See if we already have a UUID entry for this file in the global store
-    __block NSString *uuid = nil;
-    uuid = [self.allItems uuidForItemWithURL:itemURL];
-    if (uuid.length) { return uuid; }
+    TOFileSystemUUID *uuid = [self.allItems uuidForItemWithURL:itemURL];
+    if (uuid) { return uuid; }
     
     // If it's not in the store, perform a sanity check that the file exists
-    // before we start doing potentially long file
-    if (![[NSFileManager defaultManager] fileExistsAtPath:itemURL.path]) {
+    // before we start doing potentially long file reads.
+    // (Its attributes also let the UUID be fetched from the cache if it hasn't changed)
+    TOFileSystemItemAttributes attributes;
+    if (![itemURL to_getAttributes:&attributes]) {
         return nil;
     }
     
     // Defer to the file presenter to perform a thread-safe access of the UUID
     // string associated with the file
-    return [self.fileSystemPresenter uuidForItemAtURL:itemURL];
+    return [self.fileSystemPresenter uuidForItemAtURL:itemURL attributes:&attributes];
 }
 
-- (nullable NSString *)uuidForParentOfItemAtURL:(NSURL *)itemURL
+- (nullable TOFileSystemUUID *)uuidValueForParentOfItemAtURL:(NSURL *)itemURL
 {
-    return [self uuidForItemAtURL:itemURL.URLByDeletingLastPathComponent];
+    NSURL *parentURL = itemURL.URLByDeletingLastPathComponent;
+
+    // The base directory isn't in the store, but its UUID was captured when the observer started,
+    // so items at the top level (the most common parent) don't need to touch the disk
+    if (self.isRunning && self.baseDirectoryUUID && [parentURL.URLByStandardizingPath isEqual:self.directoryURL.URLByStandardizingPath]) {
+        return self.baseDirectoryUUID;
+    }
+
+    return [self uuidValueForItemAtURL:parentURL];
+}
+
+- (void)flushPendingUUIDWrites
+{
+    [self.fileSystemPresenter flushPendingUUIDWrites];
 }
 
 - (TOFileSystemItemList *)itemListForDirectoryAtURL:(NSURL *)directoryURL
@@ -308,31 +464,23 @@ static TOFileSystemObserver *_sharedObserver = nil;
         directoryURL = self.directoryURL;
     }
     
-    // Create a block to generate or re-fetch a list object
-    __block TOFileSystemItemList *itemList = nil;
-    void (^getListBlock)(void) = ^{
-        @autoreleasepool {
-            // Fetch the UUID for this item and see if we've cached it already
-            NSString *uuid = [self uuidForItemAtURL:directoryURL];
-            uuid = [self verifiedUniqueUUIDForItemAtURL:directoryURL uuid:uuid];
-            itemList = self.itemListTable[uuid];
-            if (itemList) { return; }
-            
-            // Create a new one, and save it to the map table
-            itemList = [[TOFileSystemItemList alloc] initWithDirectoryURL:directoryURL
-                                                       fileSystemObserver:self];
-            self.itemListTable[uuid] = itemList;
-            self.allItems[uuid] = directoryURL;
-        }
-    };
-    
-    if (![NSThread isMainThread]) {
-        dispatch_queue_t mainQueue = dispatch_get_main_queue();
-        dispatch_sync(mainQueue, getListBlock);
-    }
-    else {
-        getListBlock();
-    }
+    // Fetch the UUID for this item and see if we've cached it already
+    TOFileSystemUUID *uuid = [self uuidValueForItemAtURL:directoryURL];
+    uuid = [self verifiedUniqueUUIDForItemAtURL:directoryURL uuid:uuid];
+    if (uuid == nil) { return nil; }
+    TOFileSystemItemList *itemList = self.itemListTable[uuid];
+    if (itemList) { return itemList; }
+
+    // Create a new one, and save it to the map table.
+    // (If another thread got there first, use the one it created instead.)
+    itemList = [[TOFileSystemItemList alloc] initWithDirectoryURL:directoryURL
+                                               fileSystemObserver:self];
+    TOFileSystemItemList *savedItemList = [self.itemListTable setItemIfAbsent:itemList forUUID:uuid];
+    if (savedItemList != itemList) { return savedItemList; }
+    self.allItems[uuid] = directoryURL;
+
+    // Since it's about to be displayed, make sure it's scanned before anything else
+    [self prioritizeDirectoryAtURL:directoryURL];
 
     return itemList;
 }
@@ -344,37 +492,129 @@ static TOFileSystemObserver *_sharedObserver = nil;
         return nil;
     }
     
-    // Create a block to generate or re-fetch an existing object
-    __block TOFileSystemItem *item = nil;
-    void (^getItemBlock)(void) = ^{
-        @autoreleasepool {
-            // Fetch the UUID for this item and see if we've cached it already
-            NSString *uuid = [self uuidForItemAtURL:fileURL];
-            uuid = [self verifiedUniqueUUIDForItemAtURL:fileURL uuid:uuid];
-            item = self.itemTable[uuid];
-            if (item) { return; }
-            
-            // Create a new one, and save it to the map table
-            item = [[TOFileSystemItem alloc] initWithItemAtFileURL:fileURL
-                                                fileSystemObserver:self];
-            self.itemTable[uuid] = item;
-            self.allItems[uuid] = fileURL;
-        }
-    };
-    
-    // Since map tables can internally mutate, perform all access on the main thread
-    if (![NSThread isMainThread]) {
-        dispatch_queue_t mainQueue = dispatch_get_main_queue();
-        dispatch_sync(mainQueue, getItemBlock);
+    // Fetch the UUID for this item and see if we've cached it already
+    TOFileSystemUUID *uuid = [self uuidValueForItemAtURL:fileURL];
+    uuid = [self verifiedUniqueUUIDForItemAtURL:fileURL uuid:uuid];
+    if (uuid == nil) { return nil; }
+    TOFileSystemItem *item = self.itemTable[uuid];
+    if (item) { return item; }
+
+    // Create a new one, and save it to the map table.
+    // (The map table may be accessed from any thread, so if another thread
+    // created an item for this UUID at the same time, use that one instead.)
+    item = [[TOFileSystemItem alloc] initWithItemAtFileURL:fileURL
+                                        fileSystemObserver:self];
+    TOFileSystemItem *savedItem = [self.itemTable setItemIfAbsent:item forUUID:uuid];
+    if (savedItem != item) { return savedItem; }
+    self.allItems[uuid] = fileURL;
+
+    return item;
+}
+
+- (NSArray<TOFileSystemItem *> *)itemsForFilesAtURLs:(NSArray<NSURL *> *)fileURLs
+{
+    NSMutableArray<NSURL *> *urls = [NSMutableArray arrayWithCapacity:fileURLs.count];
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray arrayWithCapacity:fileURLs.count];
+    NSMutableData *attributesData = [NSMutableData dataWithLength:sizeof(TOFileSystemItemAttributes) * fileURLs.count];
+    TOFileSystemItemAttributes *attributes = attributesData.mutableBytes;
+
+    for (NSURL *fileURL in fileURLs) {
+        // Reading the attributes confirms the file exists, and lets its UUID be fetched from the cache
+        TOFileSystemItemAttributes *itemAttributes = &attributes[urls.count];
+        if (![fileURL to_getAttributes:itemAttributes]) { continue; }
+
+        TOFileSystemUUID *uuid = [self.allItems uuidForItemWithURL:fileURL];
+        if (uuid == nil) { uuid = [self.fileSystemPresenter uuidForItemAtURL:fileURL attributes:itemAttributes]; }
+        if (uuid == nil) { continue; }
+
+        [urls addObject:fileURL];
+        [uuids addObject:uuid];
     }
-    else {
-        getItemBlock();
+
+    return [self itemsForFileURLs:urls uuids:uuids attributes:attributes];
+}
+
+- (NSArray<TOFileSystemItem *> *)itemsInDirectoryAtURL:(nullable NSURL *)directoryURL
+{
+    // Default to the base directory if nil is supplied
+    if (directoryURL == nil) {
+        directoryURL = self.directoryURL;
     }
 
-    return item;
+    // Read the names and attributes of everything in the directory at once
+    TOFileSystemDirectoryReader *reader = [[TOFileSystemDirectoryReader alloc] init];
+    if (![reader readDirectoryAtURL:directoryURL]) { return @[]; }
+
+    NSUInteger numberOfEntries = reader.numberOfEntries;
+    NSMutableArray<NSURL *> *urls = [NSMutableArray arrayWithCapacity:numberOfEntries];
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray arrayWithCapacity:numberOfEntries];
+    NSMutableData *attributesData = [NSMutableData dataWithLength:sizeof(TOFileSystemItemAttributes) * numberOfEntries];
+    TOFileSystemItemAttributes *attributes = attributesData.mutableBytes;
+
+    for (NSUInteger i = 0; i < numberOfEntries; i++) {
+        // Use the UUID of items we've already seen, and otherwise read it relative to the open directory
+        NSURL *url = [reader URLOfEntryAtIndex:i];
+        TOFileSystemUUID *uuid = [self.allItems uuidForItemWithURL:url];
+        if (uuid == nil) { uuid = [self.fileSystemPresenter uuidForEntryAtIndex:i inDirectoryReader:reader]; }
+        if (uuid == nil) { continue; }
+
+        attributes[urls.count] = reader.entries[i].attributes;
+        [urls addObject:url];
+        [uuids addObject:uuid];
+    }
+    [reader closeDirectory];
+
+    return [self itemsForFileURLs:urls uuids:uuids attributes:attributes];
+}
+
+- (NSArray<TOFileSystemItem *> *)itemsForFileURLs:(NSArray<NSURL *> *)fileURLs
+                                            uuids:(NSArray<TOFileSystemUUID *> *)uuids
+                                       attributes:(const TOFileSystemItemAttributes *)attributes
+{
+    // Make sure none of the items are duplicates of another item
+    NSMutableArray<TOFileSystemUUID *> *verifiedUUIDs = [NSMutableArray arrayWithCapacity:uuids.count];
+    for (NSUInteger i = 0; i < uuids.count; i++) {
+        TOFileSystemUUID *uuid = [self verifiedUniqueUUIDForItemAtURL:fileURLs[i] uuid:uuids[i]];
+        [verifiedUUIDs addObject:uuid ?: uuids[i]];
+    }
+
+    // Look up every item that's already live in one pass
+    NSMutableArray *items = [[self.itemTable itemsForUUIDs:verifiedUUIDs] mutableCopy];
+
+    // Create the rest from the attributes that were already read
+    NSMutableArray<NSNumber *> *newIndices = [NSMutableArray array];
+    NSMutableArray<TOFileSystemItem *> *newItems = [NSMutableArray array];
+    NSMutableArray<TOFileSystemUUID *> *newUUIDs = [NSMutableArray array];
+    for (NSUInteger i = 0; i < items.count; i++) {
+        if (items[i] != [NSNull null]) { continue; }
+
+        TOFileSystemItem *item = [[TOFileSystemItem alloc] initWithItemAtFileURL:fileURLs[i]
+                                                                            uuid:verifiedUUIDs[i]
+                                                                      attributes:&attributes[i]
+                                                              fileSystemObserver:self];
+        [newIndices addObject:@(i)];
+        [newItems addObject:item];
+        [newUUIDs addObject:verifiedUUIDs[i]];
+    }
+    if (newItems.count == 0) { return items; }
+
+    // Store them all at once. (If another thread created any of the same items in the meantime, use those instead)
+    NSArray *savedItems = [self.itemTable setItemsIfAbsent:newItems forUUIDs:newUUIDs];
+    NSMutableArray<NSURL *> *storedURLs = [NSMutableArray array];
+    NSMutableArray<TOFileSystemUUID *> *storedUUIDs = [NSMutableArray array];
+    for (NSUInteger i = 0; i < savedItems.count; i++) {
+        NSUInteger index = newIndices[i].unsignedIntegerValue;
+        items[index] = savedItems[i];
+        if (savedItems[i] != newItems[i]) { continue; }
+        [storedURLs addObject:fileURLs[index]];
+        [storedUUIDs addObject:newUUIDs[i]];
+    }
+    [self.allItems setItemURLs:storedURLs forUUIDs:storedUUIDs];
+
+    return items;
 }
 
-- (NSString *)verifiedUniqueUUIDForItemAtURL:(NSURL *)itemURL uuid:(NSString *)uuid
+- (TOFileSystemUUID *)verifiedUniqueUUIDForItemAtURL:(NSURL *)itemURL uuid:(TOFileSystemUUID *)uuid
 {
     // If it was detected that there are two items with the same UUID
     // in the master list, regenerate the UUID for this one
@@ -396,12 +636,12 @@ static TOFileSystemObserver *_sharedObserver = nil;
     
     // If another file with the same UUID exists alongside this one, they are clearly duplicated.
     // Create a new UUID for this item
-    __block NSString *newUUID = nil;
-    [self.fileSystemPresenter performCoordinatedWrite:^{
+    __block TOFileSystemUUID *newUUID = nil;
+    [self.fileSystemPresenter performCoordinatedWriteForItemAtURL:itemURL usingBlock:^{
         // Do a sanity check to verify the UUID didn't change while this queue was waiting
-        newUUID = [itemURL to_fileSystemUUID];
-        if ([uuid isEqualToString:newUUID]) {
-            newUUID = [itemURL to_generateFileSystemUUID];
+        newUUID = [itemURL to_fileSystemUUIDValue];
+        if ([uuid isEqualToUUID:newUUID]) {
+            newUUID = [itemURL to_generateFileSystemUUIDValue];
         }
     }];
     
@@ -411,7 +651,7 @@ static TOFileSystemObserver *_sharedObserver = nil;
 #pragma mark - Item Refreshing -
 
 - (BOOL)refreshItemAtURL:(NSURL *)itemURL
-                    uuid:(NSString *)uuid
+                    uuid:(TOFileSystemUUID *)uuid
 {
     // Perform an update on the item and see if we need to trigger
     // any visual updates
@@ -423,10 +663,10 @@ static TOFileSystemObserver *_sharedObserver = nil;
     return hasChanges;
 }
 
-- (BOOL)refreshParentItemWithUUID:(NSString *)uuid
+- (BOOL)refreshParentItemWithUUID:(TOFileSystemUUID *)uuid numberOfSubItemsChange:(NSInteger)change
 {
     // If the parent item is an item, do a check on it to see if it has changes
-    BOOL hasChanges = [self.itemTable[uuid] refreshWithURL:nil];
+    BOOL hasChanges = [self.itemTable[uuid] refreshWithNumberOfSubItemsChange:change];
     
     // If the parent item has a list entry, perform an update on that too
     [self.itemListTable[uuid] refreshWithURL:nil];
@@ -484,32 +724,24 @@ static TOFileSystemObserver *_sharedObserver = nil;
 
 - (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
  didDiscoverItemAtURL:(NSURL *)itemURL
-             withUUID:(NSString *)uuid
+             withUUID:(TOFileSystemUUID *)uuid
 {
     // Get the UUID of the parent so we can see if there is a list for it
-    NSString *parentUUID = [self uuidForParentOfItemAtURL:itemURL];
+    TOFileSystemUUID *parentUUID = [self uuidValueForParentOfItemAtURL:itemURL];
     
-    // Refresh all of the properties of this item and its parent
+    // Refresh all of the properties of this item. (Its parent is refreshed once the batch is sent.)
     [self refreshItemAtURL:itemURL uuid:uuid];
-    [self refreshParentItemWithUUID:parentUUID];
     
-    // Broadcast this event to all of the observers.
-    TOFileSystemChanges *changes = [[TOFileSystemChanges alloc] initWithFileSystemObserver:self];
-    if (scanOperation.isFullScan) { [changes setIsFullScan]; }
-    [changes addDiscoveredItemWithUUID:uuid fileURL:itemURL];
-    [self postNotificationsWithChanges:changes];
-    
-    id mainBlock = ^{
-        // If this is a new item that belongs to an existing list, append it
-        TOFileSystemItemList *parentList = self.itemListTable[parentUUID];
-        if (parentList) { [parentList addItemWithUUID:uuid itemURL:itemURL]; }
-    };
-    [[NSOperationQueue mainQueue] addOperationWithBlock:mainBlock];
+    // Broadcast this event to all of the observers, and
+    // if it belongs to an existing list, append it
+    [self addChangesToBatchForScanOperation:scanOperation usingBlock:^(TOFileSystemChangesBatch *batch) {
+        [batch addDiscoveredItemWithUUID:uuid fileURL:itemURL parentUUID:parentUUID];
+    }];
 }
 
 - (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
    itemDidChangeAtURL:(NSURL *)itemURL
-             withUUID:(NSString *)uuid
+             withUUID:(TOFileSystemUUID *)uuid
 {
     // If the item is still copying at this point (Potentially lag during the write?)
     // add it to our copying list so we can poll it again in a few seconds
@@ -519,19 +751,17 @@ static TOFileSystemObserver *_sharedObserver = nil;
     }
     
     // See if there is a list had been made for the parent, and add it
-    NSString *parentUUID = [self uuidForParentOfItemAtURL:itemURL];
+    TOFileSystemUUID *parentUUID = [self uuidValueForParentOfItemAtURL:itemURL];
     [self refreshItemAtURL:itemURL uuid:uuid];
-    [self refreshParentItemWithUUID:parentUUID];
     
     // Broadcast this event to all of the observers.
-    TOFileSystemChanges *changes = [[TOFileSystemChanges alloc] initWithFileSystemObserver:self];
-    if (scanOperation.isFullScan) { [changes setIsFullScan]; }
-    [changes addModifiedItemWithUUID:uuid fileURL:itemURL];
-    [self postNotificationsWithChanges:changes];
+    [self addChangesToBatchForScanOperation:scanOperation usingBlock:^(TOFileSystemChangesBatch *batch) {
+        [batch addModifiedItemWithUUID:uuid fileURL:itemURL parentUUID:parentUUID];
+    }];
 }
 
 - (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
-         itemWithUUID:(NSString *)uuid
+         itemWithUUID:(TOFileSystemUUID *)uuid
         didMoveFromURL:(NSURL *)previousURL
                 toURL:(NSURL *)url
 {
@@ -542,58 +772,34 @@ static TOFileSystemObserver *_sharedObserver = nil;
     if ([oldParentURL isEqual:newParentURL]) { return; }
     
     // See if moved from, or into a new list
-    NSString *oldParentUUID = [oldParentURL to_fileSystemUUID];
-    NSString *newParentUUID = [newParentURL to_fileSystemUUID];
+    TOFileSystemUUID *oldParentUUID = [self.fileSystemPresenter existingUUIDForItemAtURL:oldParentURL];
+    TOFileSystemUUID *newParentUUID = [self.fileSystemPresenter existingUUIDForItemAtURL:newParentURL];
     
     // Get the item and refresh its internal state with the new location
     [self refreshItemAtURL:url uuid:uuid];
-    
-    // Refresh both of the parents to update the children counts in each
-    [self refreshParentItemWithUUID:oldParentUUID];
-    [self refreshParentItemWithUUID:newParentUUID];
 
-    // Broadcast this event to all of the observers.
-    TOFileSystemChanges *changes = [[TOFileSystemChanges alloc] initWithFileSystemObserver:self];
-    if (scanOperation.isFullScan) { [changes setIsFullScan]; }
-    [changes addMovedItemWithUUID:uuid oldFileURL:previousURL newFileURL:url];
-    [self postNotificationsWithChanges:changes];
-    
-    id mainBlock = ^{
-        // If the item used to be in a list item, remove it from that list
-        TOFileSystemItemList *oldList = self.itemListTable[oldParentUUID];
-        [oldList removeItemWithUUID:uuid fileURL:url];
-        
-        // If the destination also had a list, append it to that list
-        TOFileSystemItemList *newList = self.itemListTable[newParentUUID];
-        [newList addItemWithUUID:uuid itemURL:url];
-    };
-    [[NSOperationQueue mainQueue] addOperationWithBlock:mainBlock];
+    // Broadcast this event to all of the observers, and if the item used to be
+    // in a list, remove it from that list, and append it to the destination list.
+    [self addChangesToBatchForScanOperation:scanOperation usingBlock:^(TOFileSystemChangesBatch *batch) {
+        [batch addMovedItemWithUUID:uuid
+                         oldFileURL:previousURL
+                         newFileURL:url
+                      oldParentUUID:oldParentUUID
+                      newParentUUID:newParentUUID];
+    }];
 }
 
 - (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
    didDeleteItemAtURL:(NSURL *)itemURL
-             withUUID:(NSString *)uuid
+             withUUID:(TOFileSystemUUID *)uuid
 {
-    NSString *parentUUID = [self uuidForParentOfItemAtURL:itemURL];
+    TOFileSystemUUID *parentUUID = [self uuidValueForParentOfItemAtURL:itemURL];
     
-    // Broadcast this event to all of the observers.
-    TOFileSystemChanges *changes = [[TOFileSystemChanges alloc] initWithFileSystemObserver:self];
-    if (scanOperation.isFullScan) { [changes setIsFullScan]; }
-    [changes addDeletedItemWithUUID:uuid fileURL:itemURL];
-    [self postNotificationsWithChanges:changes];
-    
-    id mainBlock = ^{
-        // If we have this item in memory, remove it from everywhere
-        TOFileSystemItem *item = self.itemTable[uuid];
-        [item.list removeItemWithUUID:uuid fileURL:itemURL];
-        [self.itemTable removeItemForUUID:uuid];
-        [self.itemListTable removeItemForUUID:uuid];
-        
-        // If this item is a child of a list, update that list
-        TOFileSystemItem *listItem = self.itemTable[parentUUID];
-        [listItem refreshWithURL:nil];
-    };
-    [[NSOperationQueue mainQueue] addOperationWithBlock:mainBlock];
+    // Broadcast this event to all of the observers, and
+    // if we have this item in memory, remove it from everywhere
+    [self addChangesToBatchForScanOperation:scanOperation usingBlock:^(TOFileSystemChangesBatch *batch) {
+        [batch addDeletedItemWithUUID:uuid fileURL:itemURL parentUUID:parentUUID];
+    }];
 }
 
 - (void)scanOperationWillBeginFullScan:(TOFileSystemScanOperation *)scanOperation
@@ -617,10 +823,16 @@ static TOFileSystemObserver *_sharedObserver = nil;
 
 - (void)scanOperationDidCompleteFullScan:(TOFileSystemScanOperation *)scanOperation
 {
+    // Make sure every change has been broadcast before the scan is reported as complete
+    [self flushChangesBatch];
+
     // Loop through the list one more time to remove any headless entries
-    for (NSString *listUUID in self.itemListTable) {
+    for (TOFileSystemUUID *listUUID in self.itemListTable.allUUIDs) {
         [self.itemListTable[listUUID] synchronizeWithDisk];
     }
+
+    // Save the state of everything we found, so the next session can start from it
+    [self saveScanIndex];
     
     // Perform the Notification Center broadcast
     if (self.broadcastsNotifications) {
@@ -639,6 +851,154 @@ static TOFileSystemObserver *_sharedObserver = nil;
     }
 }
 
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
+    didCancelFullScanWithCheckpoint:(TOFileSystemScanCheckpoint *)checkpoint
+{
+    // Hold onto the checkpoint so the next full scan can resume from it
+    self.scanCheckpoint = checkpoint;
+    [self flushChangesBatch];
+}
+
+- (void)scanOperationDidScanPriorityDirectories:(TOFileSystemScanOperation *)scanOperation
+{
+    // Deliver what was found in the prioritized directories now, rather than waiting for the batch to fill
+    [self flushChangesBatch];
+}
+
+#pragma mark - Batching Changes -
+
+- (void)addChangesToBatchForScanOperation:(TOFileSystemScanOperation *)scanOperation
+                               usingBlock:(void (^)(TOFileSystemChangesBatch *batch))block
+{
+    TOFileSystemLockLock(&_changesBatchLock);
+
+    TOFileSystemChangesBatch *batch = self.changesBatch;
+    if (batch == nil) {
+        batch = [[TOFileSystemChangesBatch alloc] initWithFileSystemObserver:self isFullScan:scanOperation.isFullScan];
+        self.changesBatch = batch;
+        [self startTimerForChangesBatch:batch];
+    }
+    block(batch);
+
+    // Keep collecting changes until the batch is full. (If no more arrive, the timer will send it.)
+    BOOL isBatchFull = (batch.count >= self.maximumChangesBatchSize || self.maximumChangesBatchInterval <= 0.0f);
+
+    TOFileSystemLockUnlock(&_changesBatchLock);
+
+    if (isBatchFull) { [self flushChangesBatch:batch]; }
+}
+
+- (void)startTimerForChangesBatch:(TOFileSystemChangesBatch *)batch
+{
+    // Batches of one are sent straight away, so they never need a timer
+    NSTimeInterval interval = self.maximumChangesBatchInterval;
+    if (self.maximumChangesBatchSize <= 1 || interval <= 0.0f) { return; }
+
+    // Only send the batch the timer was started for, in case it fired just as that one was sent
+    __weak typeof(self) weakSelf = self;
+    __weak TOFileSystemChangesBatch *weakBatch = batch;
+    self.changesBatchTimer = dispatch_block_create(0, ^{
+        TOFileSystemChangesBatch *timedBatch = weakBatch;
+        if (timedBatch) { [weakSelf broadcastChangesBatch:timedBatch]; }
+    });
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)),
+                   self.changesDeliveryQueue, self.changesBatchTimer);
+}
+
+- (void)flushChangesBatch:(TOFileSystemChangesBatch *)batch
+{
+    if (batch == nil) { return; }
+    dispatch_sync(self.changesDeliveryQueue, ^{
+        [self broadcastChangesBatch:batch];
+    });
+}
+
+- (void)flushChangesBatch
+{
+    dispatch_sync(self.changesDeliveryQueue, ^{
+        [self broadcastChangesBatch:nil];
+    });
+}
+
+- (nullable TOFileSystemChangesBatch *)detachChangesBatch:(nullable TOFileSystemChangesBatch *)batch
+{
+    TOFileSystemLockLock(&_changesBatchLock);
+
+    // If a specific batch was requested, and it has already been sent, leave the next one collecting
+    TOFileSystemChangesBatch *currentBatch = self.changesBatch;
+    if (currentBatch == nil || (batch && currentBatch != batch)) {
+        TOFileSystemLockUnlock(&_changesBatchLock);
+        return nil;
+    }
+    self.changesBatch = nil;
+
+    // The batch is going out now, so it doesn't need to be sent when its timer fires
+    if (self.changesBatchTimer) {
+        dispatch_block_cancel(self.changesBatchTimer);
+        self.changesBatchTimer = nil;
+    }
+
+    TOFileSystemLockUnlock(&_changesBatchLock);
+    return currentBatch;
+}
+
+- (void)broadcastChangesBatch:(nullable TOFileSystemChangesBatch *)requestedBatch
+{
+    // Detaching on the delivery queue means batches are broadcast in the same order they were sent.
+    // (The lock is only held to take the batch, so scans can keep adding to the next one during the broadcast.)
+    TOFileSystemChangesBatch *batch = [self detachChangesBatch:requestedBatch];
+    if (batch == nil) { return; }
+
+    // Refresh each directory that had items change inside it once, updating its
+    // number of items from what was reported, rather than reading it again
+    [batch.parentItemChanges enumerateKeysAndObjectsUsingBlock:^(TOFileSystemUUID *uuid, id change, BOOL *stop) {
+        NSInteger numberOfSubItemsChange = (change == [NSNull null]) ? NSNotFound : [change integerValue];
+        [self refreshParentItemWithUUID:uuid numberOfSubItemsChange:numberOfSubItemsChange];
+    }];
+
+    // Broadcast every change in the batch to all of the observers at once
+    [self postNotificationsWithChanges:batch.changes];
+
+    // Apply the changes to any lists in memory as one update on the main thread
+    if (batch.insertedListItems.count == 0 && batch.removedListItems.count == 0 && batch.deletedItems.count == 0) {
+        return;
+    }
+    [[NSOperationQueue mainQueue] addOperationWithBlock:^{
+        [self applyListChangesInBatch:batch];
+    }];
+}
+
+- (void)applyListChangesInBatch:(TOFileSystemChangesBatch *)batch
+{
+    // Work out which list each deleted item is in, while it is still in memory
+    NSMutableDictionary<TOFileSystemUUID *, NSMutableSet<TOFileSystemUUID *> *> *removedListItems = [NSMutableDictionary dictionary];
+    [batch.removedListItems enumerateKeysAndObjectsUsingBlock:^(TOFileSystemUUID *listUUID, NSSet *uuids, BOOL *stop) {
+        removedListItems[listUUID] = [uuids mutableCopy];
+    }];
+    for (TOFileSystemUUID *uuid in batch.deletedItems) {
+        TOFileSystemItem *item = self.itemTable[uuid];
+        TOFileSystemUUID *listUUID = item.list.uuidValue;
+        if (listUUID == nil) { continue; }
+
+        if (removedListItems[listUUID] == nil) { removedListItems[listUUID] = [NSMutableSet set]; }
+        [removedListItems[listUUID] addObject:uuid];
+    }
+
+    // Update each list that had items added or removed in one go
+    NSMutableSet<TOFileSystemUUID *> *listUUIDs = [NSMutableSet setWithArray:removedListItems.allKeys];
+    [listUUIDs addObjectsFromArray:batch.insertedListItems.allKeys];
+    for (TOFileSystemUUID *listUUID in listUUIDs) {
+        TOFileSystemItemList *list = self.itemListTable[listUUID];
+        [list removeItemsWithUUIDs:removedListItems[listUUID] addItems:batch.insertedListItems[listUUID]];
+    }
+
+    // Remove every deleted item from memory. (The parent directories they were in were refreshed when the batch was sent.)
+    for (TOFileSystemUUID *uuid in batch.deletedItems) {
+        [self.itemTable removeItemForUUID:uuid];
+        [self.itemListTable removeItemForUUID:uuid];
+    }
+}
+
 #pragma mark - Notifications -
 
 - (NSDictionary *)userInfoDictionaryWithChanges:(TOFileSystemChanges *)changes
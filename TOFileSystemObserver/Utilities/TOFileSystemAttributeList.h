@@ -0,0 +1,129 @@
+//
+//  TOFileSystemAttributeList.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "NSURL+TOFileSystemAttributes.h"
+
+#include <sys/attr.h>
+#include <sys/vnode.h>
+
+/**
+ Configures an attribute list to request everything needed to fill out a
+ `TOFileSystemItemAttributes` (plus the name) from `getattrlist` or `getattrlistbulk`.
+ Per-entry error reporting is only supported (and only requested) for bulk reads.
+ */
+static inline void TOFileSystemAttributeListPrepare(struct attrlist *attributeList, BOOL isBulkRead) {
+    memset(attributeList, 0, sizeof(struct attrlist));
+    attributeList->bitmapcount = ATTR_BIT_MAP_COUNT;
+    attributeList->commonattr = ATTR_CMN_RETURNED_ATTRS | ATTR_CMN_NAME | ATTR_CMN_DEVID |
+                                ATTR_CMN_OBJTYPE | ATTR_CMN_CRTIME | ATTR_CMN_MODTIME | ATTR_CMN_CHGTIME |
+                                ATTR_CMN_FILEID;
+    if (isBulkRead) { attributeList->commonattr |= ATTR_CMN_ERROR; }
+    attributeList->dirattr = ATTR_DIR_ENTRYCOUNT;
+    attributeList->fileattr = ATTR_FILE_DATALENGTH;
+}
+
+/**
+ Unpacks a single record written by the kernel for the attribute list above.
+ The kernel packs each attribute in the order of its bit value (apart from the returned
+ attributes and error fields, which always lead), and only includes the attributes it could supply.
+ 
+ Returns NO if the kernel reported an error for this entry. The name, if requested,
+ points into the record and is NUL-terminated. If `objectType` isn't NULL, it is set to
+ the type of the item (eg, `VREG`, `VDIR` or `VLNK`), or `VNON` if it wasn't supplied.
+ */
+static inline BOOL TOFileSystemAttributeListParseRecord(const char *record,
+                                                        TOFileSystemItemAttributes *attributes,
+                                                        const char **name,
+                                                        fsobj_type_t *objectType) {
+    // Fields are packed without padding, so copy each one out rather than casting in place
+    const char *field = record + sizeof(uint32_t);
+
+    attribute_set_t returnedAttributes;
+    memcpy(&returnedAttributes, field, sizeof(attribute_set_t));
+    field += sizeof(attribute_set_t);
+
+    if (returnedAttributes.commonattr & ATTR_CMN_ERROR) {
+        uint32_t error;
+        memcpy(&error, field, sizeof(uint32_t));
+        field += sizeof(uint32_t);
+        if (error != 0) { return NO; }
+    }
+
+    // The name is stored at an offset relative to its reference field
+    *name = NULL;
+    if (returnedAttributes.commonattr & ATTR_CMN_NAME) {
+        attrreference_t nameReference;
+        memcpy(&nameReference, field, sizeof(attrreference_t));
+        *name = field + nameReference.attr_dataoffset;
+        field += sizeof(attrreference_t);
+    }
+
+    memset(attributes, 0, sizeof(TOFileSystemItemAttributes));
+    if (objectType) { *objectType = VNON; }
+    if (returnedAttributes.commonattr & ATTR_CMN_DEVID) {
+        memcpy(&attributes->device, field, sizeof(dev_t));
+        field += sizeof(dev_t);
+    }
+
+    if (returnedAttributes.commonattr & ATTR_CMN_OBJTYPE) {
+        fsobj_type_t type;
+        memcpy(&type, field, sizeof(fsobj_type_t));
+        field += sizeof(fsobj_type_t);
+        attributes->isDirectory = (type == VDIR);
+        if (objectType) { *objectType = type; }
+    }
+
+    if (returnedAttributes.commonattr & ATTR_CMN_CRTIME) {
+        memcpy(&attributes->creationTime, field, sizeof(struct timespec));
+        field += sizeof(struct timespec);
+    }
+
+    if (returnedAttributes.commonattr & ATTR_CMN_MODTIME) {
+        memcpy(&attributes->modificationTime, field, sizeof(struct timespec));
+        field += sizeof(struct timespec);
+    }
+
+    if (returnedAttributes.commonattr & ATTR_CMN_CHGTIME) {
+        memcpy(&attributes->changeTime, field, sizeof(struct timespec));
+        field += sizeof(struct timespec);
+    }
+
+    if (returnedAttributes.commonattr & ATTR_CMN_FILEID) {
+        memcpy(&attributes->inode, field, sizeof(uint64_t));
+        field += sizeof(uint64_t);
+    }
+
+    // Directory attributes are only returned for directories, and file attributes for files
+    if (returnedAttributes.dirattr & ATTR_DIR_ENTRYCOUNT) {
+        memcpy(&attributes->numberOfChildItems, field, sizeof(uint32_t));
+        field += sizeof(uint32_t);
+    }
+
+    if (returnedAttributes.fileattr & ATTR_FILE_DATALENGTH) {
+        off_t size;
+        memcpy(&size, field, sizeof(off_t));
+        attributes->size = (long long)size;
+    }
+
+    return YES;
+}
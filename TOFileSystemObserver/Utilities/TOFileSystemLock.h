@@ -0,0 +1,68 @@
+//
+//  TOFileSystemLock.h
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+#import <os/lock.h>
+#import <pthread/pthread.h>
+
+/**
+ A lightweight lock that uses `os_unfair_lock` where available,
+ and falls back to a pthread mutex on older versions of iOS.
+ */
+typedef struct {
+    os_unfair_lock unfairLock;
+    pthread_mutex_t pthreadMutexLock;
+} TOFileSystemLock;
+
+/** Prepares a lock for use. Must be called before the lock is used. */
+static inline void TOFileSystemLockInit(TOFileSystemLock *lock) {
+    if (@available(iOS 10.0, *)) {
+        lock->unfairLock = OS_UNFAIR_LOCK_INIT;
+    } else {
+        pthread_mutex_init(&lock->pthreadMutexLock, NULL);
+    }
+}
+
+/** Blocks the current thread until the lock is acquired. */
+static inline void TOFileSystemLockLock(TOFileSystemLock *lock) {
+    if (@available(iOS 10.0, *)) {
+        os_unfair_lock_lock(&lock->unfairLock);
+    } else {
+        pthread_mutex_lock(&lock->pthreadMutexLock);
+    }
+}
+
+/** Releases a lock previously acquired on the current thread. */
+static inline void TOFileSystemLockUnlock(TOFileSystemLock *lock) {
+    if (@available(iOS 10.0, *)) {
+        os_unfair_lock_unlock(&lock->unfairLock);
+    } else {
+        pthread_mutex_unlock(&lock->pthreadMutexLock);
+    }
+}
+
+/** Frees any resources the lock holds. */
+static inline void TOFileSystemLockDestroy(TOFileSystemLock *lock) {
+    if (@available(iOS 10.0, *)) { return; }
+    pthread_mutex_destroy(&lock->pthreadMutexLock);
+}
@@ -0,0 +1 @@
+../Utilities/TOFileSystemAttributeList.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Entities/Changes/TOFileSystemChangesBatch.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Scanning/TOFileSystemDirectoryReader.h
\ No newline at end of file
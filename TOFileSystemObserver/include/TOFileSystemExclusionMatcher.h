@@ -0,0 +1 @@
+../Entities/FilePaths/TOFileSystemExclusionMatcher.h
\ No newline at end of file
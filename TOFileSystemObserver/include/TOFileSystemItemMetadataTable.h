@@ -0,0 +1 @@
+../Entities/Collections/TOFileSystemItemMetadataTable.h
\ No newline at end of file
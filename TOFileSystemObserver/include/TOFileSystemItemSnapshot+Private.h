@@ -0,0 +1 @@
+../Entities/Items/TOFileSystemItemSnapshot+Private.h
\ No newline at end of file
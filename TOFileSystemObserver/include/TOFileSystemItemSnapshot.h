@@ -0,0 +1 @@
+../Entities/Items/TOFileSystemItemSnapshot.h
\ No newline at end of file
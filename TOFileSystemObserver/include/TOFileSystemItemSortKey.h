@@ -0,0 +1 @@
+../Entities/Items/TOFileSystemItemSortKey.h
\ No newline at end of file
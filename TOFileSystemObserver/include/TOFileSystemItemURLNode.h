@@ -0,0 +1 @@
+../Entities/Collections/TOFileSystemItemURLNode.h
\ No newline at end of file
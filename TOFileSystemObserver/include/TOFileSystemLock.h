@@ -0,0 +1 @@
+../Utilities/TOFileSystemLock.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Entities/Collections/TOFileSystemOrderStatisticTree.h
\ No newline at end of file
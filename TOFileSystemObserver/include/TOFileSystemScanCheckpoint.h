@@ -0,0 +1 @@
+../Scanning/TOFileSystemScanCheckpoint.h
\ No newline at end of file
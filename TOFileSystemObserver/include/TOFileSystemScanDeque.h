@@ -0,0 +1 @@
+../Scanning/TOFileSystemScanDeque.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Entities/Collections/TOFileSystemScanIndex.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Scanning/TOFileSystemScanScheduler.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Entities/Collections/TOFileSystemShardedDictionary.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Scanning/TOFileSystemStripedLock.h
\ No newline at end of file
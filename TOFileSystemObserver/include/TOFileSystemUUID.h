@@ -0,0 +1 @@
+../Entities/Items/TOFileSystemUUID.h
\ No newline at end of file
@@ -0,0 +1 @@
+../Entities/Collections/TOFileSystemUUIDCache.h
\ No newline at end of file
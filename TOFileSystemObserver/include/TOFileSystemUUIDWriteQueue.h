@@ -0,0 +1 @@
+../Scanning/TOFileSystemUUIDWriteQueue.h
\ No newline at end of file
@@ -128,7 +128,7 @@
         cell = [[UITableViewCell alloc] initWithStyle:UITableViewCellStyleSubtitle reuseIdentifier:cellIdentifier];
     }
     
-    TOFileSystemItem *fileItem = self.fileItemList[indexPath.row];
+    TOFileSystemItemSnapshot *fileItem = self.fileItemList[indexPath.row].snapshot;
     cell.textLabel.text = fileItem.name;
     
     if (fileItem.isCopying) {
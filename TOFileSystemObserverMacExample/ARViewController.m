@@ -70,7 +70,7 @@
 }
 
 - (NSView *)tableView:(NSTableView *)tableView viewForTableColumn:(NSTableColumn *)tableColumn row:(NSInteger)row {
-    TOFileSystemItem *fileItem = self.fileItemList[row];
+    TOFileSystemItemSnapshot *fileItem = self.fileItemList[row].snapshot;
     
     if ([tableColumn.identifier isEqualToString: @"NameColumn"]) {
         static NSString *cellIdentifier = @"NameCell";
@@ -0,0 +1,149 @@
+//
+//  TOFileSystemDirectoryReaderTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemDirectoryReader.h"
+#import "TOFileSystemUUID.h"
+#include <sys/stat.h>
+
+@interface TOFileSystemDirectoryReaderTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *folderURL;
+
+@end
+
+@implementation TOFileSystemDirectoryReaderTests
+
+- (void)setUp
+{
+    NSURL *url = [NSURL fileURLWithPath:NSTemporaryDirectory()];
+    self.folderURL = [url URLByAppendingPathComponent:@"ReaderFolder"];
+    [NSFileManager.defaultManager createDirectoryAtURL:self.folderURL withIntermediateDirectories:YES attributes:nil error:nil];
+
+    // A file, a sub-folder and a hidden file that should be skipped
+    NSData *data = [@"Hello" dataUsingEncoding:NSUTF8StringEncoding];
+    [data writeToURL:[self.folderURL URLByAppendingPathComponent:@"File.txt"] atomically:NO];
+    [data writeToURL:[self.folderURL URLByAppendingPathComponent:@".Hidden"] atomically:NO];
+    [NSFileManager.defaultManager createDirectoryAtURL:[self.folderURL URLByAppendingPathComponent:@"SubFolder"]
+                           withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown
+{
+    [NSFileManager.defaultManager removeItemAtURL:self.folderURL error:nil];
+}
+
+- (void)testReadingDirectory
+{
+    TOFileSystemDirectoryReader *reader = [[TOFileSystemDirectoryReader alloc] init];
+    XCTAssertTrue([reader readDirectoryAtURL:self.folderURL]);
+    XCTAssertTrue(reader.numberOfEntries == 2);
+
+    for (NSUInteger i = 0; i < reader.numberOfEntries; i++) {
+        NSString *name = [reader nameOfEntryAtIndex:i];
+        TOFileSystemItemAttributes attributes = reader.entries[i].attributes;
+        if ([name isEqualToString:@"File.txt"]) {
+            XCTAssertFalse(attributes.isDirectory);
+            XCTAssertTrue(attributes.size == 5);
+        }
+        else {
+            XCTAssertEqualObjects(name, @"SubFolder");
+            XCTAssertTrue(attributes.isDirectory);
+            XCTAssertTrue([reader URLOfEntryAtIndex:i].hasDirectoryPath);
+        }
+        XCTAssertTrue(attributes.inode != 0);
+    }
+}
+
+- (void)testReusingReader
+{
+    TOFileSystemDirectoryReader *reader = [[TOFileSystemDirectoryReader alloc] init];
+    [reader readDirectoryAtURL:self.folderURL];
+
+    // Reading a different directory should fully replace the previous entries
+    NSURL *subfolderURL = [self.folderURL URLByAppendingPathComponent:@"SubFolder"];
+    XCTAssertTrue([reader readDirectoryAtURL:subfolderURL]);
+    XCTAssertTrue(reader.numberOfEntries == 0);
+
+    // Missing directories fail, and leave the reader empty
+    NSURL *missingURL = [self.folderURL URLByAppendingPathComponent:@"Missing"];
+    XCTAssertFalse([reader readDirectoryAtURL:missingURL]);
+    XCTAssertTrue(reader.numberOfEntries == 0);
+}
+
+- (void)testReadingAndWritingUUIDs
+{
+    TOFileSystemDirectoryReader *reader = [[TOFileSystemDirectoryReader alloc] init];
+    XCTAssertTrue([reader readDirectoryAtURL:self.folderURL]);
+
+    // New items don't have a UUID yet, which isn't treated as an error
+    TOFileSystemUUID *uuid = nil;
+    XCTAssertTrue([reader readUUID:&uuid ofEntryAtIndex:0] == TOFileSystemUUIDReadResultMissing);
+    XCTAssertNil(uuid);
+
+    // Write one relative to the directory, and make sure it matches when read back through the URL
+    TOFileSystemUUID *newUUID = [TOFileSystemUUID UUID];
+    XCTAssertTrue([reader writeUUID:newUUID toEntryAtIndex:0]);
+    XCTAssertTrue([reader readUUID:&uuid ofEntryAtIndex:0] == TOFileSystemUUIDReadResultFound);
+    XCTAssertEqualObjects(uuid, newUUID);
+    XCTAssertEqualObjects([reader URLOfEntryAtIndex:0].to_fileSystemUUIDValue, newUUID);
+
+    // Items that disappeared since the directory was read are reported as errors
+    [NSFileManager.defaultManager removeItemAtURL:[reader URLOfEntryAtIndex:1] error:nil];
+    XCTAssertTrue([reader readUUID:&uuid ofEntryAtIndex:1] == TOFileSystemUUIDReadResultError);
+
+    // Once closed, entries can no longer be accessed
+    [reader closeDirectory];
+    XCTAssertTrue([reader readUUID:&uuid ofEntryAtIndex:0] == TOFileSystemUUIDReadResultError);
+}
+
+- (void)testSpecialItems
+{
+    // A named pipe blocks whoever opens it until the other end is opened too, and a link points somewhere else
+    NSURL *pipeURL = [self.folderURL URLByAppendingPathComponent:@"Pipe"];
+    NSURL *linkURL = [self.folderURL URLByAppendingPathComponent:@"Link"];
+    XCTAssertTrue(mkfifo(pipeURL.fileSystemRepresentation, 0644) == 0);
+    XCTAssertTrue([NSFileManager.defaultManager createSymbolicLinkAtURL:linkURL
+                                                     withDestinationURL:[self.folderURL URLByAppendingPathComponent:@"File.txt"]
+                                                                  error:nil]);
+
+    TOFileSystemDirectoryReader *reader = [[TOFileSystemDirectoryReader alloc] init];
+    XCTAssertTrue([reader readDirectoryAtURL:self.folderURL]);
+
+    for (NSUInteger i = 0; i < reader.numberOfEntries; i++) {
+        NSString *name = [reader nameOfEntryAtIndex:i];
+        BOOL isSpecial = [name isEqualToString:@"Pipe"] || [name isEqualToString:@"Link"];
+        XCTAssertEqual(reader.entries[i].isFileOrDirectory, !isSpecial);
+        if (!isSpecial) { continue; }
+
+        // Both should be accessed without waiting, and each gets its own UUID, separate from what the link points to
+        TOFileSystemUUID *uuid = nil;
+        TOFileSystemUUID *newUUID = [TOFileSystemUUID UUID];
+        XCTAssertTrue([reader readUUID:&uuid ofEntryAtIndex:i] == TOFileSystemUUIDReadResultMissing);
+        XCTAssertTrue([reader writeUUID:newUUID toEntryAtIndex:i]);
+        XCTAssertTrue([reader readUUID:&uuid ofEntryAtIndex:i] == TOFileSystemUUIDReadResultFound);
+        XCTAssertEqualObjects(uuid, newUUID);
+    }
+    XCTAssertNil([self.folderURL URLByAppendingPathComponent:@"File.txt"].to_fileSystemUUIDValue);
+}
+
+@end
@@ -103,4 +103,20 @@ const NSInteger kTOFileSystemTestFileSize = 3 * 1000000;
     XCTAssertNotNil(self.fileURL.to_modificationDate);
 }
 
+- (void)testGetAttributes
+{
+    TOFileSystemItemAttributes attributes = {0};
+    XCTAssertTrue([self.fileURL to_getAttributes:&attributes]);
+    XCTAssertFalse(attributes.isDirectory);
+    XCTAssertTrue(attributes.size == kTOFileSystemTestFileSize);
+    XCTAssertTrue(attributes.inode != 0);
+
+    XCTAssertTrue([self.directoryURL to_getAttributes:&attributes]);
+    XCTAssertTrue(attributes.isDirectory);
+    XCTAssertTrue(attributes.size == 0);
+
+    NSURL *missingURL = [self.directoryURL URLByAppendingPathComponent:@"Missing.dat"];
+    XCTAssertFalse([missingURL to_getAttributes:&attributes]);
+}
+
 @end
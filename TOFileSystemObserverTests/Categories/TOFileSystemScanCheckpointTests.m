@@ -0,0 +1,82 @@
+//
+//  TOFileSystemScanCheckpointTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemScanCheckpoint.h"
+
+@interface TOFileSystemScanCheckpointTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *folderURL;
+
+@end
+
+@implementation TOFileSystemScanCheckpointTests
+
+- (void)setUp
+{
+    NSURL *url = [NSURL fileURLWithPath:NSTemporaryDirectory()];
+    self.folderURL = [url URLByAppendingPathComponent:@"CheckpointFolder" isDirectory:YES];
+    [NSFileManager.defaultManager createDirectoryAtURL:self.folderURL withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown
+{
+    [NSFileManager.defaultManager removeItemAtURL:self.folderURL error:nil];
+}
+
+- (TOFileSystemScanCheckpoint *)checkpointOfFolder
+{
+    TOFileSystemItemAttributes attributes;
+    [self.folderURL to_getAttributes:&attributes];
+    NSValue *value = [NSValue valueWithBytes:&attributes objCType:@encode(TOFileSystemItemAttributes)];
+    return [[TOFileSystemScanCheckpoint alloc] initWithDirectoryURL:self.folderURL
+                                               pendingDirectoryURLs:@[]
+                                                 scannedDirectories:@{self.folderURL : value}
+                                                          scanIndex:nil
+                                                  reconciledRecords:nil];
+}
+
+- (void)testUnchangedDirectory
+{
+    TOFileSystemScanCheckpoint *checkpoint = [self checkpointOfFolder];
+    XCTAssertTrue([checkpoint containsUnchangedDirectoryAtURL:self.folderURL]);
+
+    // A directory that wasn't scanned is never unchanged
+    NSURL *otherURL = [self.folderURL URLByAppendingPathComponent:@"Other" isDirectory:YES];
+    XCTAssertFalse([checkpoint containsUnchangedDirectoryAtURL:otherURL]);
+}
+
+- (void)testChangedDirectory
+{
+    TOFileSystemScanCheckpoint *checkpoint = [self checkpointOfFolder];
+
+    // Adding an item changes the number of items in the directory
+    NSData *data = [@"Hello" dataUsingEncoding:NSUTF8StringEncoding];
+    [data writeToURL:[self.folderURL URLByAppendingPathComponent:@"File.txt"] atomically:NO];
+    XCTAssertFalse([checkpoint containsUnchangedDirectoryAtURL:self.folderURL]);
+
+    // As does deleting the directory entirely
+    [NSFileManager.defaultManager removeItemAtURL:self.folderURL error:nil];
+    XCTAssertFalse([checkpoint containsUnchangedDirectoryAtURL:self.folderURL]);
+}
+
+@end
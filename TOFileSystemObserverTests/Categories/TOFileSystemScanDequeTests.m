@@ -0,0 +1,95 @@
+//
+//  TOFileSystemScanDequeTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemScanDeque.h"
+
+@interface TOFileSystemScanDequeTests : XCTestCase
+
+@end
+
+@implementation TOFileSystemScanDequeTests
+
+- (void)testPushingAndPopping
+{
+    TOFileSystemScanDeque *deque = [[TOFileSystemScanDeque alloc] init];
+    XCTAssertNil([deque popObject]);
+
+    [deque pushObject:@"A"];
+    [deque pushObject:@"B"];
+    [deque pushObject:@"C"];
+    XCTAssertEqual(deque.count, 3);
+    XCTAssertEqualObjects(deque.allObjects, (@[@"A", @"B", @"C"]));
+
+    // The owning worker takes the most recently pushed object first
+    XCTAssertEqualObjects([deque popObject], @"C");
+    XCTAssertEqualObjects([deque popObject], @"B");
+    XCTAssertEqualObjects([deque popObject], @"A");
+    XCTAssertNil([deque popObject]);
+    XCTAssertEqual(deque.count, 0);
+}
+
+- (void)testStealing
+{
+    TOFileSystemScanDeque *deque = [[TOFileSystemScanDeque alloc] init];
+    XCTAssertNil([deque stealObject]);
+
+    [deque pushObject:@"A"];
+    [deque pushObject:@"B"];
+    [deque pushObject:@"C"];
+
+    // Other workers take the oldest object, leaving the newest for the owner
+    XCTAssertEqualObjects([deque stealObject], @"A");
+    XCTAssertEqualObjects([deque popObject], @"C");
+    XCTAssertEqualObjects([deque stealObject], @"B");
+    XCTAssertNil([deque stealObject]);
+    XCTAssertNil([deque popObject]);
+}
+
+- (void)testConcurrentPoppingAndStealing
+{
+    TOFileSystemScanDeque *deque = [[TOFileSystemScanDeque alloc] init];
+    NSInteger numberOfObjects = 10000;
+    for (NSInteger i = 0; i < numberOfObjects; i++) {
+        [deque pushObject:@(i)];
+    }
+
+    // With one thread popping and the rest stealing, every object is taken exactly once
+    NSMutableArray *takenObjects = [NSMutableArray array];
+    NSLock *lock = [[NSLock alloc] init];
+    dispatch_apply(8, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^(size_t index) {
+        NSMutableArray *objects = [NSMutableArray array];
+        id object = nil;
+        while ((object = (index == 0) ? [deque popObject] : [deque stealObject])) {
+            [objects addObject:object];
+        }
+        [lock lock];
+        [takenObjects addObjectsFromArray:objects];
+        [lock unlock];
+    });
+
+    XCTAssertEqual(deque.count, 0);
+    XCTAssertEqual(takenObjects.count, numberOfObjects);
+    XCTAssertEqual([NSSet setWithArray:takenObjects].count, numberOfObjects);
+}
+
+@end
@@ -0,0 +1,310 @@
+//
+//  TOFileSystemScanOperationTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemScanOperation.h"
+#import "TOFileSystemPresenter.h"
+#import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemScanIndex.h"
+#import "TOFileSystemScanCheckpoint.h"
+#import "TOFileSystemUUID.h"
+#import "NSURL+TOFileSystemUUID.h"
+
+/** Records every event a scan reports, keyed by the UUID of the item. */
+@interface TOFileSystemScanOperationTestsRecorder : NSObject <TOFileSystemScanOperationDelegate>
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, NSString *> *discoveredItems;
+@property (nonatomic, strong) NSMutableArray<NSString *> *discoveredPaths; // In the order they were reported
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, NSArray<NSString *> *> *movedItems;
+@property (nonatomic, strong) NSMutableDictionary<TOFileSystemUUID *, NSString *> *deletedItems;
+@property (nonatomic, assign) NSInteger numberOfCompletedScans;
+@property (nonatomic, assign) NSInteger numberOfPriorityCallbacks;
+@property (nonatomic, assign) NSUInteger numberOfItemsBeforePriorityCallback;
+@property (nonatomic, strong) TOFileSystemScanCheckpoint *checkpoint;
+@property (nonatomic, copy) void (^discoveryHandler)(TOFileSystemScanOperation *operation, NSURL *itemURL);
+@end
+
+@implementation TOFileSystemScanOperationTestsRecorder
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _discoveredItems = [NSMutableDictionary dictionary];
+        _discoveredPaths = [NSMutableArray array];
+        _movedItems = [NSMutableDictionary dictionary];
+        _deletedItems = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDiscoverItemAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid
+{
+    @synchronized (self) {
+        self.discoveredItems[uuid] = itemURL.path;
+        [self.discoveredPaths addObject:itemURL.path];
+    }
+    if (self.discoveryHandler) { self.discoveryHandler(scanOperation, itemURL); }
+}
+
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemDidChangeAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid { }
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemWithUUID:(TOFileSystemUUID *)uuid
+       didMoveFromURL:(NSURL *)previousURL toURL:(NSURL *)url
+{
+    @synchronized (self) { self.movedItems[uuid] = @[previousURL.path, url.path]; }
+}
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDeleteItemAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid
+{
+    @synchronized (self) { self.deletedItems[uuid] = itemURL.path; }
+}
+- (void)scanOperationWillBeginFullScan:(TOFileSystemScanOperation *)scanOperation { }
+- (void)scanOperationDidCompleteFullScan:(TOFileSystemScanOperation *)scanOperation
+{
+    @synchronized (self) { self.numberOfCompletedScans++; }
+}
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
+    didCancelFullScanWithCheckpoint:(TOFileSystemScanCheckpoint *)checkpoint
+{
+    @synchronized (self) { self.checkpoint = checkpoint; }
+}
+- (void)scanOperationDidScanPriorityDirectories:(TOFileSystemScanOperation *)scanOperation
+{
+    @synchronized (self) {
+        if (self.numberOfPriorityCallbacks++ == 0) { self.numberOfItemsBeforePriorityCallback = self.discoveredPaths.count; }
+    }
+}
+
+@end
+
+@interface TOFileSystemScanOperationTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *directoryURL;
+@property (nonatomic, strong) TOFileSystemPresenter *presenter;
+
+@end
+
+@implementation TOFileSystemScanOperationTests
+
+- (void)setUp
+{
+    NSURL *temporaryURL = [NSURL fileURLWithPath:NSTemporaryDirectory()].URLByStandardizingPath;
+    self.directoryURL = [temporaryURL URLByAppendingPathComponent:@"ScanOperationFolder" isDirectory:YES];
+    [NSFileManager.defaultManager removeItemAtURL:self.directoryURL error:nil];
+    self.presenter = [[TOFileSystemPresenter alloc] initWithDirectoryURL:self.directoryURL];
+
+    // A few levels of folders, each with a few files, so there's plenty for workers to steal
+    NSFileManager *fileManager = NSFileManager.defaultManager;
+    for (NSInteger i = 0; i < 4; i++) {
+        for (NSInteger j = 0; j < 3; j++) {
+            for (NSInteger k = 0; k < 3; k++) {
+                NSString *path = [NSString stringWithFormat:@"Folder%ld/SubFolder%ld/Leaf%ld", (long)i, (long)j, (long)k];
+                NSURL *folderURL = [self.directoryURL URLByAppendingPathComponent:path isDirectory:YES];
+                [fileManager createDirectoryAtURL:folderURL withIntermediateDirectories:YES attributes:nil error:nil];
+                for (NSInteger l = 0; l < 3; l++) {
+                    NSString *fileName = [NSString stringWithFormat:@"File%ld.txt", (long)l];
+                    [[NSData data] writeToURL:[folderURL URLByAppendingPathComponent:fileName] atomically:NO];
+                }
+            }
+        }
+    }
+}
+
+- (void)tearDown
+{
+    [NSFileManager.defaultManager removeItemAtURL:self.directoryURL error:nil];
+}
+
+- (TOFileSystemScanOperationTestsRecorder *)runFullScanWithNumberOfWorkers:(NSInteger)numberOfWorkers
+{
+    TOFileSystemItemURLDictionary *allItems = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.directoryURL];
+    return [self runFullScanWithNumberOfWorkers:numberOfWorkers allItems:allItems scanIndex:nil];
+}
+
+- (TOFileSystemScanOperationTestsRecorder *)runFullScanWithNumberOfWorkers:(NSInteger)numberOfWorkers
+                                                                   allItems:(TOFileSystemItemURLDictionary *)allItems
+                                                                  scanIndex:(TOFileSystemScanIndex *)scanIndex
+{
+    TOFileSystemScanOperationTestsRecorder *recorder = [[TOFileSystemScanOperationTestsRecorder alloc] init];
+    TOFileSystemScanOperation *operation = [self fullScanOperationWithNumberOfWorkers:numberOfWorkers
+                                                                              allItems:allItems
+                                                                              recorder:recorder];
+    operation.scanIndex = scanIndex;
+    operation.skipsUnchangedDirectories = (scanIndex != nil);
+    [self runOperation:operation];
+    return recorder;
+}
+
+- (TOFileSystemScanOperation *)fullScanOperationWithNumberOfWorkers:(NSInteger)numberOfWorkers
+                                                           allItems:(TOFileSystemItemURLDictionary *)allItems
+                                                           recorder:(TOFileSystemScanOperationTestsRecorder *)recorder
+{
+    TOFileSystemScanOperation *operation = [[TOFileSystemScanOperation alloc] initForFullScanWithDirectoryAtURL:self.directoryURL
+                                                                                                  skippingItems:nil
+                                                                                             allItemsDictionary:allItems
+                                                                                                  filePresenter:self.presenter];
+    operation.numberOfWorkers = numberOfWorkers;
+    operation.delegate = recorder;
+    return operation;
+}
+
+- (void)runOperation:(TOFileSystemScanOperation *)operation
+{
+    [operation start];
+
+    // Make sure any new UUIDs are on disk before the next scan reads them
+    [self.presenter flushPendingUUIDWrites];
+}
+
+- (NSUInteger)indexOfLastPathWithPrefix:(NSString *)prefix inPaths:(NSArray<NSString *> *)paths
+{
+    return [paths indexOfObjectWithOptions:NSEnumerationReverse passingTest:^BOOL(NSString *path, NSUInteger index, BOOL *stop) {
+        return [path hasPrefix:prefix];
+    }];
+}
+
+- (NSUInteger)indexOfFirstPathWithPrefix:(NSString *)prefix inPaths:(NSArray<NSString *> *)paths
+{
+    return [paths indexOfObjectPassingTest:^BOOL(NSString *path, NSUInteger index, BOOL *stop) {
+        return [path hasPrefix:prefix];
+    }];
+}
+
+- (void)testParallelScanMatchesSerialScan
+{
+    // 4 folders, 12 subfolders, 36 leaf folders and 108 files
+    TOFileSystemScanOperationTestsRecorder *serialRecorder = [self runFullScanWithNumberOfWorkers:1];
+    XCTAssertEqual(serialRecorder.numberOfCompletedScans, 1);
+    XCTAssertEqual(serialRecorder.discoveredItems.count, 160);
+
+    // Every item is discovered exactly once, at the same location and with the same UUID, however many workers there are
+    for (NSInteger i = 0; i < 3; i++) {
+        TOFileSystemScanOperationTestsRecorder *parallelRecorder = [self runFullScanWithNumberOfWorkers:4];
+        XCTAssertEqual(parallelRecorder.numberOfCompletedScans, 1);
+        XCTAssertEqualObjects(parallelRecorder.discoveredItems, serialRecorder.discoveredItems);
+    }
+}
+
+- (void)testMovingItemAfterReloadingFromIndex
+{
+    // Scan everything, and save it into an index as if the app was closing
+    TOFileSystemItemURLDictionary *allItems = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.directoryURL];
+    [self runFullScanWithNumberOfWorkers:1 allItems:allItems scanIndex:nil];
+    NSURL *indexURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:@"ScanOperation.index"];
+    XCTAssertTrue([TOFileSystemScanIndex writeItems:allItems toFileURL:indexURL]);
+
+    // On the next launch, every unchanged directory is filled in straight from the index
+    TOFileSystemScanIndex *scanIndex = [TOFileSystemScanIndex indexWithContentsOfFileURL:indexURL];
+    [NSFileManager.defaultManager removeItemAtURL:indexURL error:nil];
+    XCTAssertNotNil(scanIndex);
+    allItems = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.directoryURL];
+    TOFileSystemScanOperationTestsRecorder *recorder = [self runFullScanWithNumberOfWorkers:1 allItems:allItems scanIndex:scanIndex];
+    XCTAssertEqual(recorder.discoveredItems.count + recorder.movedItems.count + recorder.deletedItems.count, 0);
+
+    // Move a file, and give it a different UUID on disk, so it can only be recognized from its file system ID
+    NSURL *fileURL = [self.directoryURL URLByAppendingPathComponent:@"Folder0/SubFolder0/Leaf0/File0.txt"];
+    NSURL *movedURL = [self.directoryURL URLByAppendingPathComponent:@"Folder1/Moved.txt"];
+    TOFileSystemUUID *uuid = [allItems uuidForItemWithURL:fileURL];
+    XCTAssertNotNil(uuid);
+    XCTAssertTrue([NSFileManager.defaultManager moveItemAtURL:fileURL toURL:movedURL error:nil]);
+    [movedURL to_setFileSystemUUIDValue:[TOFileSystemUUID UUID]];
+
+    // It should be reported as moved, rather than as a new item replacing a deleted one
+    recorder = [self runFullScanWithNumberOfWorkers:1 allItems:allItems scanIndex:nil];
+    XCTAssertEqualObjects(recorder.movedItems[uuid], (@[fileURL.path, movedURL.path]));
+    XCTAssertEqual(recorder.discoveredItems.count, 0);
+    XCTAssertNil(recorder.deletedItems[uuid]);
+}
+
+- (void)testPrioritizingDirectory
+{
+    TOFileSystemItemURLDictionary *allItems = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.directoryURL];
+    TOFileSystemScanOperationTestsRecorder *recorder = [[TOFileSystemScanOperationTestsRecorder alloc] init];
+    TOFileSystemScanOperation *operation = [self fullScanOperationWithNumberOfWorkers:1 allItems:allItems recorder:recorder];
+
+    // Prioritize the folder that would otherwise be scanned last
+    NSURL *priorityURL = [self.directoryURL URLByAppendingPathComponent:@"Folder3" isDirectory:YES];
+    [operation prioritizeDirectoryAtURL:priorityURL];
+    [self runOperation:operation];
+    XCTAssertEqual(recorder.numberOfCompletedScans, 1);
+    XCTAssertEqual(recorder.discoveredPaths.count, 160);
+
+    // Everything inside it comes before anything below the other folders,
+    // and the callback is made as soon as the last of it has been found
+    NSArray<NSString *> *paths = recorder.discoveredPaths;
+    NSString *priorityPrefix = [priorityURL.path stringByAppendingString:@"/"];
+    NSString *otherPrefix = [[self.directoryURL URLByAppendingPathComponent:@"Folder0"].path stringByAppendingString:@"/"];
+    NSUInteger lastPriorityIndex = [self indexOfLastPathWithPrefix:priorityPrefix inPaths:paths];
+    NSUInteger firstOtherIndex = [self indexOfFirstPathWithPrefix:otherPrefix inPaths:paths];
+    XCTAssertNotEqual(lastPriorityIndex, NSNotFound);
+    XCTAssertLessThan(lastPriorityIndex, firstOtherIndex);
+    XCTAssertEqual(recorder.numberOfPriorityCallbacks, 1);
+    XCTAssertEqual(recorder.numberOfItemsBeforePriorityCallback, lastPriorityIndex + 1);
+}
+
+- (void)testPrioritizingDirectoryInParallel
+{
+    TOFileSystemItemURLDictionary *allItems = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.directoryURL];
+    TOFileSystemScanOperationTestsRecorder *recorder = [[TOFileSystemScanOperationTestsRecorder alloc] init];
+    TOFileSystemScanOperation *operation = [self fullScanOperationWithNumberOfWorkers:4 allItems:allItems recorder:recorder];
+
+    // The folder is already sitting in a worker's queue when the request is picked up, so a copy
+    // of it is scanned first, and the original is skipped once that worker reaches it
+    [operation prioritizeDirectoryAtURL:[self.directoryURL URLByAppendingPathComponent:@"Folder2" isDirectory:YES]];
+    [self runOperation:operation];
+
+    // Nothing is scanned twice, or missed
+    XCTAssertEqual(recorder.numberOfCompletedScans, 1);
+    XCTAssertEqual(recorder.discoveredPaths.count, 160);
+    XCTAssertEqual([NSSet setWithArray:recorder.discoveredPaths].count, 160);
+    XCTAssertEqual(recorder.numberOfPriorityCallbacks, 1);
+}
+
+- (void)testPrioritizedDirectoriesAreCheckpointed
+{
+    TOFileSystemItemURLDictionary *allItems = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.directoryURL];
+    TOFileSystemScanOperationTestsRecorder *recorder = [[TOFileSystemScanOperationTestsRecorder alloc] init];
+    TOFileSystemScanOperation *operation = [self fullScanOperationWithNumberOfWorkers:1 allItems:allItems recorder:recorder];
+
+    // Cancel while the prioritized folder is being scanned, before any of its subfolders are reached
+    NSURL *priorityURL = [self.directoryURL URLByAppendingPathComponent:@"Folder3" isDirectory:YES];
+    NSString *priorityPrefix = [priorityURL.path stringByAppendingString:@"/"];
+    recorder.discoveryHandler = ^(TOFileSystemScanOperation *scanOperation, NSURL *itemURL) {
+        if ([itemURL.path hasPrefix:priorityPrefix]) { [scanOperation cancel]; }
+    };
+    [operation prioritizeDirectoryAtURL:priorityURL];
+    [self runOperation:operation];
+    XCTAssertEqual(recorder.numberOfCompletedScans, 0);
+    XCTAssertEqual(recorder.numberOfPriorityCallbacks, 0);
+
+    // The prioritized subfolders that were still waiting are saved with the rest of the pending folders
+    XCTAssertNotNil(recorder.checkpoint);
+    NSMutableSet<NSString *> *pendingPaths = [NSMutableSet set];
+    for (NSURL *url in recorder.checkpoint.pendingDirectoryURLs) { [pendingPaths addObject:url.path]; }
+    NSMutableSet<NSString *> *expectedPaths = [NSMutableSet set];
+    for (NSInteger i = 0; i < 3; i++) {
+        NSString *name = [NSString stringWithFormat:@"Folder%ld", (long)i];
+        [expectedPaths addObject:[self.directoryURL URLByAppendingPathComponent:name].path];
+        name = [NSString stringWithFormat:@"SubFolder%ld", (long)i];
+        [expectedPaths addObject:[priorityURL URLByAppendingPathComponent:name].path];
+    }
+    XCTAssertEqualObjects(pendingPaths, expectedPaths);
+}
+
+@end
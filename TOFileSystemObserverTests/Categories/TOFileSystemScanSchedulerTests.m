@@ -0,0 +1,254 @@
+//
+//  TOFileSystemScanSchedulerTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemScanScheduler.h"
+#import "TOFileSystemScanOperation.h"
+#import "TOFileSystemPresenter.h"
+#import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemUUID.h"
+
+/** Records the order items were discovered in by the scans the scheduler runs. */
+@interface TOFileSystemScanSchedulerTestsRecorder : NSObject <TOFileSystemScanOperationDelegate>
+@property (nonatomic, strong) NSMutableArray<NSString *> *discoveredPaths;
+@property (nonatomic, strong) NSMutableArray<NSString *> *deletedPaths;
+@property (nonatomic, assign) NSInteger numberOfPriorityCallbacks;
+@end
+
+@implementation TOFileSystemScanSchedulerTestsRecorder
+
+- (instancetype)init
+{
+    if (self = [super init]) {
+        _discoveredPaths = [NSMutableArray array];
+        _deletedPaths = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDiscoverItemAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid
+{
+    @synchronized (self) { [self.discoveredPaths addObject:itemURL.path]; }
+}
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation didDeleteItemAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid
+{
+    @synchronized (self) { [self.deletedPaths addObject:itemURL.path]; }
+}
+- (void)scanOperationDidScanPriorityDirectories:(TOFileSystemScanOperation *)scanOperation
+{
+    @synchronized (self) { self.numberOfPriorityCallbacks++; }
+}
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemDidChangeAtURL:(NSURL *)itemURL withUUID:(TOFileSystemUUID *)uuid { }
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation itemWithUUID:(TOFileSystemUUID *)uuid
+       didMoveFromURL:(NSURL *)previousURL toURL:(NSURL *)url { }
+- (void)scanOperationWillBeginFullScan:(TOFileSystemScanOperation *)scanOperation { }
+- (void)scanOperationDidCompleteFullScan:(TOFileSystemScanOperation *)scanOperation { }
+- (void)scanOperation:(TOFileSystemScanOperation *)scanOperation
+    didCancelFullScanWithCheckpoint:(TOFileSystemScanCheckpoint *)checkpoint { }
+
+@end
+
+@interface TOFileSystemScanSchedulerTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *directoryURL;
+@property (nonatomic, strong) TOFileSystemPresenter *presenter;
+@property (nonatomic, strong) TOFileSystemItemURLDictionary *allItems;
+@property (nonatomic, strong) TOFileSystemScanSchedulerTestsRecorder *recorder;
+@property (nonatomic, strong) NSOperationQueue *operationQueue;
+@property (nonatomic, strong) TOFileSystemScanScheduler *scheduler;
+
+@end
+
+@implementation TOFileSystemScanSchedulerTests
+
+- (void)setUp
+{
+    NSURL *temporaryURL = [NSURL fileURLWithPath:NSTemporaryDirectory()].URLByStandardizingPath;
+    self.directoryURL = [temporaryURL URLByAppendingPathComponent:@"ScanSchedulerFolder" isDirectory:YES];
+    [NSFileManager.defaultManager removeItemAtURL:self.directoryURL error:nil];
+
+    // Two folders, each with a subfolder holding a few files
+    for (NSInteger i = 0; i < 2; i++) {
+        NSString *path = [NSString stringWithFormat:@"Folder%ld/SubFolder", (long)i];
+        NSURL *folderURL = [self.directoryURL URLByAppendingPathComponent:path isDirectory:YES];
+        [NSFileManager.defaultManager createDirectoryAtURL:folderURL withIntermediateDirectories:YES attributes:nil error:nil];
+        for (NSInteger j = 0; j < 3; j++) {
+            NSString *fileName = [NSString stringWithFormat:@"File%ld.txt", (long)j];
+            [[NSData data] writeToURL:[folderURL URLByAppendingPathComponent:fileName] atomically:NO];
+        }
+    }
+
+    self.presenter = [[TOFileSystemPresenter alloc] initWithDirectoryURL:self.directoryURL];
+    self.allItems = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.directoryURL];
+    self.recorder = [[TOFileSystemScanSchedulerTestsRecorder alloc] init];
+
+    // Hold every scan in the queue until the test is ready for them to run
+    self.operationQueue = [[NSOperationQueue alloc] init];
+    self.operationQueue.maxConcurrentOperationCount = 1;
+    self.operationQueue.suspended = YES;
+    self.scheduler = [[TOFileSystemScanScheduler alloc] initWithOperationQueue:self.operationQueue];
+}
+
+- (void)tearDown
+{
+    self.operationQueue.suspended = NO;
+    [self.operationQueue waitUntilAllOperationsAreFinished];
+    [self.presenter flushPendingUUIDWrites];
+    [NSFileManager.defaultManager removeItemAtURL:self.directoryURL error:nil];
+}
+
+- (TOFileSystemScanOperation *)fullScanOperation
+{
+    TOFileSystemScanOperation *operation = [[TOFileSystemScanOperation alloc] initForFullScanWithDirectoryAtURL:self.directoryURL
+                                                                                                  skippingItems:nil
+                                                                                             allItemsDictionary:self.allItems
+                                                                                                  filePresenter:self.presenter];
+    operation.delegate = self.recorder;
+    return operation;
+}
+
+- (TOFileSystemScanOperation *)itemScanOperationWithItemURLs:(NSArray<NSURL *> *)itemURLs
+{
+    TOFileSystemScanOperation *operation = [[TOFileSystemScanOperation alloc] initForItemScanWithItemURLs:itemURLs
+                                                                                                  baseURL:self.directoryURL
+                                                                                            skippingItems:nil
+                                                                                       allItemsDictionary:self.allItems
+                                                                                            filePresenter:self.presenter];
+    operation.delegate = self.recorder;
+    return operation;
+}
+
+- (NSArray<NSURL *> *)fileURLsInDirectoryAtURL:(NSURL *)directoryURL range:(NSRange)range
+{
+    NSMutableArray<NSURL *> *fileURLs = [NSMutableArray array];
+    for (NSUInteger i = range.location; i < NSMaxRange(range); i++) {
+        NSString *fileName = [NSString stringWithFormat:@"File%ld.txt", (long)i];
+        [fileURLs addObject:[directoryURL URLByAppendingPathComponent:fileName]];
+    }
+    return fileURLs;
+}
+
+- (void)runQueuedScans
+{
+    self.operationQueue.suspended = NO;
+    [self.operationQueue waitUntilAllOperationsAreFinished];
+    self.operationQueue.suspended = YES;
+    [self.presenter flushPendingUUIDWrites];
+}
+
+- (void)testHoldingPriorityUntilFullScanIsQueued
+{
+    // Prioritize the folder that would otherwise be scanned last, before there's any scan to apply it to
+    NSURL *priorityURL = [self.directoryURL URLByAppendingPathComponent:@"Folder1" isDirectory:YES];
+    [self.scheduler prioritizeDirectoryAtURL:priorityURL];
+    [self.scheduler addFullScanOperation:[self fullScanOperation]];
+    [self runQueuedScans];
+
+    // It was handed to the scan once it was queued, so its contents were found first
+    NSArray<NSString *> *paths = self.recorder.discoveredPaths;
+    NSUInteger priorityIndex = [paths indexOfObject:[priorityURL URLByAppendingPathComponent:@"SubFolder"].path];
+    NSUInteger otherIndex = [paths indexOfObject:[self.directoryURL URLByAppendingPathComponent:@"Folder0/SubFolder"].path];
+    XCTAssertNotEqual(priorityIndex, NSNotFound);
+    XCTAssertLessThan(priorityIndex, otherIndex);
+    XCTAssertEqual(self.recorder.numberOfPriorityCallbacks, 1);
+
+    // Once that scan has finished, new requests are held for the next one
+    [self.scheduler prioritizeDirectoryAtURL:priorityURL];
+    [self.scheduler addFullScanOperation:[self fullScanOperation]];
+    [self runQueuedScans];
+    XCTAssertEqual(self.recorder.numberOfPriorityCallbacks, 2);
+}
+
+- (void)testMergingIntoPendingItemScan
+{
+    NSURL *folderURL = [self.directoryURL URLByAppendingPathComponent:@"Folder0/SubFolder" isDirectory:YES];
+    NSArray<NSURL *> *fileURLs = [self fileURLsInDirectoryAtURL:folderURL range:NSMakeRange(0, 3)];
+
+    // While the first item scan is waiting, more items are merged into it instead of queueing another
+    XCTAssertFalse([self.scheduler addItemURLsToPendingScan:@[fileURLs[0]]]);
+    [self.scheduler addItemScanOperation:[self itemScanOperationWithItemURLs:@[fileURLs[0]]]];
+    XCTAssertTrue([self.scheduler addItemURLsToPendingScan:@[fileURLs[1], fileURLs[2]]]);
+    XCTAssertTrue([self.scheduler addItemURLsToPendingScan:@[fileURLs[1]]]);
+    XCTAssertEqual(self.operationQueue.operationCount, 1);
+
+    // That one scan reports all of them, once each
+    [self runQueuedScans];
+    for (NSURL *fileURL in fileURLs) {
+        NSIndexSet *indexes = [self.recorder.discoveredPaths indexesOfObjectsPassingTest:^BOOL(NSString *path, NSUInteger i, BOOL *stop) {
+            return [path isEqualToString:fileURL.path];
+        }];
+        XCTAssertEqual(indexes.count, 1);
+    }
+
+    // Once it has run, nothing more can be merged into it
+    XCTAssertFalse([self.scheduler addItemURLsToPendingScan:@[fileURLs[0]]]);
+}
+
+- (void)testDroppingItemsCoveredByFullScan
+{
+    NSURL *fileURL = [self.directoryURL URLByAppendingPathComponent:@"Folder0/SubFolder/File0.txt"];
+
+    // A fresh full scan that hasn't started yet will read every item anyway
+    [self.scheduler addFullScanOperation:[self fullScanOperation]];
+    XCTAssertTrue([self.scheduler addItemURLsToPendingScan:@[fileURL]]);
+    XCTAssertEqual(self.operationQueue.operationCount, 1);
+    [self runQueuedScans];
+
+    // Once it has run, the items need their own scan again
+    XCTAssertFalse([self.scheduler addItemURLsToPendingScan:@[fileURL]]);
+
+    // Full scans that skip unchanged directories may not notice items modified in place, so they don't cover them
+    TOFileSystemScanOperation *operation = [self fullScanOperation];
+    operation.skipsUnchangedDirectories = YES;
+    [self.scheduler addFullScanOperation:operation];
+    XCTAssertFalse([self.scheduler addItemURLsToPendingScan:@[fileURL]]);
+}
+
+- (void)testCollapsingSiblingsIntoDirectoryRescan
+{
+    // Fill a folder with more items than the collapsing threshold, and record them all with a full scan
+    NSURL *folderURL = [self.directoryURL URLByAppendingPathComponent:@"Crowded" isDirectory:YES];
+    [NSFileManager.defaultManager createDirectoryAtURL:folderURL withIntermediateDirectories:YES attributes:nil error:nil];
+    NSArray<NSURL *> *fileURLs = [self fileURLsInDirectoryAtURL:folderURL range:NSMakeRange(0, 60)];
+    for (NSURL *fileURL in fileURLs) {
+        [[NSData data] writeToURL:fileURL atomically:NO];
+    }
+    [self.scheduler addFullScanOperation:[self fullScanOperation]];
+    [self runQueuedScans];
+
+    // Delete an item that won't be reported to any of the item scans
+    NSURL *deletedURL = fileURLs.lastObject;
+    XCTAssertTrue([NSFileManager.defaultManager removeItemAtURL:deletedURL error:nil]);
+
+    // A handful of its siblings are checked one by one, which doesn't look at the rest of the folder
+    [self.scheduler addItemScanOperation:[self itemScanOperationWithItemURLs:[fileURLs subarrayWithRange:NSMakeRange(0, 10)]]];
+    [self runQueuedScans];
+    XCTAssertFalse([self.recorder.deletedPaths containsObject:deletedURL.path]);
+
+    // But once 50 or more siblings have changed (across merged batches), the whole folder is read again
+    [self.scheduler addItemScanOperation:[self itemScanOperationWithItemURLs:[fileURLs subarrayWithRange:NSMakeRange(0, 30)]]];
+    XCTAssertTrue([self.scheduler addItemURLsToPendingScan:[fileURLs subarrayWithRange:NSMakeRange(30, 25)]]);
+    [self runQueuedScans];
+    XCTAssertEqualObjects(self.recorder.deletedPaths, @[deletedURL.path]);
+}
+
+@end
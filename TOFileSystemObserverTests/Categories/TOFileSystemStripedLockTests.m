@@ -0,0 +1,104 @@
+//
+//  TOFileSystemStripedLockTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemStripedLock.h"
+
+@interface TOFileSystemStripedLockTests : XCTestCase
+
+@end
+
+@implementation TOFileSystemStripedLockTests
+
+- (void)testPathHashes
+{
+    // Extending a directory's hash should match hashing the full path (even for the root directory)
+    uint64_t directoryHash = TOFileSystemPathHash("/Documents/Folder/");
+    XCTAssertEqual(TOFileSystemPathHashAppendComponent(directoryHash, "File.txt"),
+                   TOFileSystemPathHash("/Documents/Folder/File.txt"));
+    XCTAssertEqual(TOFileSystemPathHashAppendComponent(TOFileSystemPathHash("/"), "Documents"),
+                   TOFileSystemPathHash("/Documents"));
+    XCTAssertNotEqual(TOFileSystemPathHash("/Documents/A.txt"), TOFileSystemPathHash("/Documents/B.txt"));
+}
+
+- (void)testResolvedPathHashes
+{
+    NSFileManager *fileManager = NSFileManager.defaultManager;
+    NSString *temporaryPath = NSTemporaryDirectory();
+    NSString *folderPath = [temporaryPath stringByAppendingPathComponent:@"StripedLockFolder"];
+    NSString *linkPath = [temporaryPath stringByAppendingPathComponent:@"StripedLockLink"];
+    [fileManager removeItemAtPath:linkPath error:nil];
+    [fileManager createDirectoryAtPath:folderPath withIntermediateDirectories:YES attributes:nil error:nil];
+    [fileManager createSymbolicLinkAtPath:linkPath withDestinationPath:folderPath error:nil];
+
+    // Reaching the same directory through a link gives the same hash, both for it, and the items inside
+    NSString *filePath = [folderPath stringByAppendingPathComponent:@"File.txt"];
+    NSString *linkedFilePath = [linkPath stringByAppendingPathComponent:@"File.txt"];
+    XCTAssertEqual(TOFileSystemPathHashForDirectoryPath(linkPath), TOFileSystemPathHashForDirectoryPath(folderPath));
+    XCTAssertEqual(TOFileSystemPathHashForItemPath(linkedFilePath), TOFileSystemPathHashForItemPath(filePath));
+    XCTAssertEqual(TOFileSystemPathHashAppendComponent(TOFileSystemPathHashForDirectoryPath(linkPath), "File.txt"),
+                   TOFileSystemPathHashForItemPath(filePath));
+
+    // The link itself is a separate item to the directory it points at
+    XCTAssertNotEqual(TOFileSystemPathHashForItemPath(linkPath), TOFileSystemPathHashForItemPath(folderPath));
+
+    [fileManager removeItemAtPath:linkPath error:nil];
+    [fileManager removeItemAtPath:folderPath error:nil];
+}
+
+- (void)testWritesToDifferentStripesDontWait
+{
+    TOFileSystemStripedLock *lock = [[TOFileSystemStripedLock alloc] initWithNumberOfStripes:2];
+
+    // While one stripe is held for writing, a read on the other stripe can still complete
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Read finished"];
+    [lock performWriteWithPathHash:0 usingBlock:^{
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+            [lock performReadWithPathHash:1 usingBlock:^{
+                [expectation fulfill];
+            }];
+        });
+        [self waitForExpectations:@[expectation] timeout:1.0f];
+    }];
+}
+
+- (void)testStatistics
+{
+    TOFileSystemStripedLock *lock = [[TOFileSystemStripedLock alloc] initWithNumberOfStripes:4];
+    [lock performReadWithPathHash:TOFileSystemPathHash("/A") usingBlock:^{}];
+    [lock performReadWithPathHash:TOFileSystemPathHash("/B") usingBlock:^{}];
+    [lock performWriteWithPathHash:TOFileSystemPathHash("/A") usingBlock:^{
+        [NSThread sleepForTimeInterval:0.01f];
+    }];
+
+    TOFileSystemStripedLockStatistics statistics = [lock statistics];
+    XCTAssertEqual(statistics.numberOfReads, 2);
+    XCTAssertEqual(statistics.numberOfWrites, 1);
+    XCTAssertTrue(statistics.totalHoldTime >= 0.01f);
+
+    [lock resetStatistics];
+    statistics = [lock statistics];
+    XCTAssertEqual(statistics.numberOfReads + statistics.numberOfWrites, 0);
+    XCTAssertTrue(statistics.totalHoldTime == 0.0f);
+}
+
+@end
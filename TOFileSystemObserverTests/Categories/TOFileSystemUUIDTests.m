@@ -22,6 +22,7 @@
 
 #import <XCTest/XCTest.h>
 #import "NSURL+TOFileSystemUUID.h"
+#import "TOFileSystemUUID.h"
 
 @interface TOFileSystemUUIDTests : XCTestCase
 @property (nonatomic, strong) NSURL *itemURL;
@@ -79,4 +80,43 @@
     XCTAssertNil(newUUID);
 }
 
+- (void)testBinaryUUID
+{
+    // Generate a UUID for the item, and read it back as a binary value
+    NSString *uuidString = [self.itemURL to_generateFileSystemUUID];
+    TOFileSystemUUID *uuid = [self.itemURL to_fileSystemUUIDValue];
+    XCTAssertEqualObjects(uuid.stringValue, uuidString);
+
+    // Save a new binary value, and make sure it's readable as a string
+    TOFileSystemUUID *newUUID = [TOFileSystemUUID UUID];
+    [self.childItemURL to_setFileSystemUUIDValue:newUUID];
+    XCTAssertEqualObjects([self.childItemURL to_fileSystemUUID], newUUID.stringValue);
+    XCTAssertEqualObjects([self.childItemURL to_fileSystemUUIDValue], newUUID);
+}
+
+- (void)testUUIDStringConversion
+{
+    // Lowercase strings are accepted, but always converted back to uppercase
+    TOFileSystemUUID *uuid = [TOFileSystemUUID UUIDWithString:@"f2a5bc6d-0eab-4970-8650-8629fdc3a866"];
+    XCTAssertEqualObjects(uuid.stringValue, @"F2A5BC6D-0EAB-4970-8650-8629FDC3A866");
+
+    // Equal values should be interchangeable as dictionary keys
+    TOFileSystemUUID *sameUUID = [TOFileSystemUUID UUIDWithString:@"F2A5BC6D-0EAB-4970-8650-8629FDC3A866"];
+    XCTAssertEqualObjects(uuid, sameUUID);
+    XCTAssertEqual(uuid.hash, sameUUID.hash);
+
+    // The bytes should match what NSUUID produces for the same string
+    NSUUID *systemUUID = [[NSUUID alloc] initWithUUIDString:uuid.stringValue];
+    uuid_t systemBytes, bytes;
+    [systemUUID getUUIDBytes:systemBytes];
+    [uuid getBytes:bytes];
+    XCTAssertTrue(memcmp(systemBytes, bytes, sizeof(uuid_t)) == 0);
+
+    // Invalid strings are rejected
+    XCTAssertNil([TOFileSystemUUID UUIDWithString:nil]);
+    XCTAssertNil([TOFileSystemUUID UUIDWithString:@"000000000000000000000000000000000000"]);
+    XCTAssertNil([TOFileSystemUUID UUIDWithString:@"F2A5BC6D-0EAB-4970-8650-8629FDC3A86G"]);
+    XCTAssertNil([TOFileSystemUUID UUIDWithString:@"F2A5BC6D-0EAB-4970-8650-8629FDC3A86"]);
+}
+
 @end
@@ -0,0 +1,158 @@
+//
+//  TOFileSystemUUIDWriteQueueTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemUUIDWriteQueue.h"
+#import "TOFileSystemStripedLock.h"
+#import "TOFileSystemUUID.h"
+#import "NSURL+TOFileSystemUUID.h"
+
+@interface TOFileSystemUUIDWriteQueueTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *folderURL;
+@property (nonatomic, strong) NSURL *itemURL;
+@property (nonatomic, strong) TOFileSystemUUIDWriteQueue *writeQueue;
+
+@end
+
+@implementation TOFileSystemUUIDWriteQueueTests
+
+- (void)setUp
+{
+    NSURL *url = [NSURL fileURLWithPath:NSTemporaryDirectory()];
+    self.folderURL = [url URLByAppendingPathComponent:@"WriteQueueFolder"];
+    [NSFileManager.defaultManager createDirectoryAtURL:self.folderURL withIntermediateDirectories:YES attributes:nil error:nil];
+
+    self.itemURL = [self.folderURL URLByAppendingPathComponent:@"File.txt"];
+    [[@"Hello" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:self.itemURL atomically:NO];
+
+    TOFileSystemStripedLock *lock = [[TOFileSystemStripedLock alloc] initWithNumberOfStripes:4];
+    self.writeQueue = [[TOFileSystemUUIDWriteQueue alloc] initWithCoordinationLock:lock];
+    self.writeQueue.writeInterval = 60.0f; // Only write when flushed
+}
+
+- (void)tearDown
+{
+    [NSFileManager.defaultManager removeItemAtURL:self.folderURL error:nil];
+}
+
+- (void)testPendingUUIDs
+{
+    XCTAssertNil([self.writeQueue pendingUUIDForItemAtURL:self.itemURL]);
+
+    // New UUIDs are available straight away, but aren't on disk yet
+    TOFileSystemUUID *uuid = [self.writeQueue uuidForNewItemAtURL:self.itemURL];
+    XCTAssertNotNil(uuid);
+    XCTAssertNil(self.itemURL.to_fileSystemUUIDValue);
+    XCTAssertTrue(self.writeQueue.numberOfPendingUUIDs == 1);
+
+    // Asking again returns the same pending one
+    XCTAssertEqualObjects([self.writeQueue uuidForNewItemAtURL:self.itemURL], uuid);
+    XCTAssertEqualObjects([self.writeQueue pendingUUIDForItemAtURL:self.itemURL], uuid);
+
+    // Flushing writes it to disk
+    [self.writeQueue flush];
+    XCTAssertEqualObjects(self.itemURL.to_fileSystemUUIDValue, uuid);
+    XCTAssertNil([self.writeQueue pendingUUIDForItemAtURL:self.itemURL]);
+    XCTAssertTrue(self.writeQueue.numberOfPendingUUIDs == 0);
+
+    // Once written, the saved one is reused
+    XCTAssertEqualObjects([self.writeQueue uuidForNewItemAtURL:self.itemURL], uuid);
+    XCTAssertTrue(self.writeQueue.numberOfPendingUUIDs == 0);
+}
+
+- (void)testDeletedItemIsSkipped
+{
+    [self.writeQueue uuidForNewItemAtURL:self.itemURL];
+    [NSFileManager.defaultManager removeItemAtURL:self.itemURL error:nil];
+
+    // Items deleted before being written are dropped without failing the rest of the write
+    NSURL *otherURL = [self.folderURL URLByAppendingPathComponent:@"Other.txt"];
+    [[@"Hello" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:otherURL atomically:NO];
+    TOFileSystemUUID *uuid = [self.writeQueue uuidForNewItemAtURL:otherURL];
+
+    [self.writeQueue flush];
+    XCTAssertTrue(self.writeQueue.numberOfPendingUUIDs == 0);
+    XCTAssertEqualObjects(otherURL.to_fileSystemUUIDValue, uuid);
+}
+
+- (void)testRenamedItemKeepsPendingUUID
+{
+    TOFileSystemUUID *uuid = [self.writeQueue uuidForNewItemAtURL:self.itemURL];
+
+    // Rename the item before its UUID is written
+    NSURL *renamedURL = [self.folderURL URLByAppendingPathComponent:@"Renamed.txt"];
+    XCTAssertTrue([NSFileManager.defaultManager moveItemAtURL:self.itemURL toURL:renamedURL error:nil]);
+
+    // Looking it up by its new name and attributes should find the same UUID
+    TOFileSystemItemAttributes attributes;
+    XCTAssertTrue([renamedURL to_getAttributes:&attributes]);
+    TOFileSystemUUID *renamedUUID = [self.writeQueue uuidForNewItemAtURL:renamedURL
+                                                              attributes:&attributes
+                                                 numberOfCompletedWrites:self.writeQueue.numberOfCompletedWrites];
+    XCTAssertEqualObjects(renamedUUID, uuid);
+    XCTAssertTrue(self.writeQueue.numberOfPendingUUIDs == 1);
+
+    // And it should be written to the item at its new location
+    [self.writeQueue flush];
+    XCTAssertEqualObjects(renamedURL.to_fileSystemUUIDValue, uuid);
+}
+
+- (void)testReplacedItemIsSkipped
+{
+    TOFileSystemUUID *uuid = [self.writeQueue uuidForNewItemAtURL:self.itemURL];
+    XCTAssertNotNil(uuid);
+
+    // Replace the item with a different one with the same name before the UUID is written
+    NSURL *otherURL = [self.folderURL URLByAppendingPathComponent:@"Other.txt"];
+    [[@"Other" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:otherURL atomically:NO];
+    [NSFileManager.defaultManager removeItemAtURL:self.itemURL error:nil];
+    XCTAssertTrue([NSFileManager.defaultManager moveItemAtURL:otherURL toURL:self.itemURL error:nil]);
+
+    // The new item shouldn't be handed the old one's UUID, and it shouldn't be written to it
+    TOFileSystemItemAttributes attributes;
+    XCTAssertTrue([self.itemURL to_getAttributes:&attributes]);
+    XCTAssertNotEqualObjects([self.writeQueue uuidForNewItemAtURL:self.itemURL
+                                                       attributes:&attributes
+                                          numberOfCompletedWrites:self.writeQueue.numberOfCompletedWrites], uuid);
+    [self.writeQueue flush];
+    XCTAssertNotEqualObjects(self.itemURL.to_fileSystemUUIDValue, uuid);
+}
+
+- (void)testCompletedWritesAreCheckedAgain
+{
+    // Simulate checking the disk just before a write completes
+    NSUInteger numberOfCompletedWrites = self.writeQueue.numberOfCompletedWrites;
+    TOFileSystemUUID *uuid = [self.writeQueue uuidForNewItemAtURL:self.itemURL];
+    [self.writeQueue flush];
+    XCTAssertTrue(self.writeQueue.numberOfCompletedWrites > numberOfCompletedWrites);
+
+    // The UUID is no longer pending, so the disk should be checked again rather than generating a new one
+    TOFileSystemItemAttributes attributes;
+    XCTAssertTrue([self.itemURL to_getAttributes:&attributes]);
+    XCTAssertEqualObjects([self.writeQueue uuidForNewItemAtURL:self.itemURL
+                                                    attributes:&attributes
+                                       numberOfCompletedWrites:numberOfCompletedWrites], uuid);
+    XCTAssertTrue(self.writeQueue.numberOfPendingUUIDs == 0);
+}
+
+@end
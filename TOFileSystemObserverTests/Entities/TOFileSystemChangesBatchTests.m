@@ -0,0 +1,128 @@
+//
+//  TOFileSystemChangesBatchTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemObserver.h"
+#import "TOFileSystemChangesBatch.h"
+#import "TOFileSystemUUID.h"
+
+@interface TOFileSystemChangesBatchTests : XCTestCase
+
+@property (nonatomic, strong) TOFileSystemObserver *observer;
+@property (nonatomic, strong) TOFileSystemChangesBatch *batch;
+@property (nonatomic, strong) TOFileSystemUUID *uuid;
+@property (nonatomic, strong) TOFileSystemUUID *listUUID;
+@property (nonatomic, strong) NSURL *url;
+
+@end
+
+@implementation TOFileSystemChangesBatchTests
+
+- (void)setUp
+{
+    self.url = [NSURL fileURLWithPath:@"/Documents/File.txt"];
+    self.uuid = [TOFileSystemUUID UUIDWithString:@"0256d425-f081-4bc3-8db5-bcb158568abb"];
+    self.listUUID = [TOFileSystemUUID UUIDWithString:@"0afec03c-ba74-4b87-9941-9c59bb97ccc4"];
+
+    self.observer = [[TOFileSystemObserver alloc] init];
+    self.batch = [[TOFileSystemChangesBatch alloc] initWithFileSystemObserver:self.observer isFullScan:YES];
+}
+
+- (void)testCollectingChanges
+{
+    NSURL *otherURL = [NSURL fileURLWithPath:@"/Documents/Other.txt"];
+    TOFileSystemUUID *otherUUID = [TOFileSystemUUID UUIDWithString:@"9e3a1b84-6c2f-4d0e-8b7a-5f1c2d3e4a5b"];
+    [self.batch addDiscoveredItemWithUUID:self.uuid fileURL:self.url parentUUID:self.listUUID];
+    [self.batch addModifiedItemWithUUID:otherUUID fileURL:otherURL parentUUID:self.listUUID];
+
+    // Every change should end up in the same changes object
+    XCTAssertTrue(self.batch.count == 2);
+    XCTAssertTrue(self.batch.changes.isFullScan);
+    XCTAssert(self.batch.changes.discoveredItems[self.uuid.stringValue] == self.url);
+    XCTAssert(self.batch.changes.modifiedItems[otherUUID.stringValue] == otherURL);
+    XCTAssert(self.batch.insertedListItems[self.listUUID][self.uuid] == self.url);
+}
+
+- (void)testDiscoveredThenDeleted
+{
+    [self.batch addDiscoveredItemWithUUID:self.uuid fileURL:self.url parentUUID:self.listUUID];
+    [self.batch addDeletedItemWithUUID:self.uuid fileURL:self.url parentUUID:self.listUUID];
+
+    // The insertion should be cancelled out by the deletion
+    XCTAssertTrue(self.batch.insertedListItems[self.listUUID].count == 0);
+    XCTAssertNotNil(self.batch.deletedItems[self.uuid]);
+}
+
+- (void)testMovedBetweenLists
+{
+    TOFileSystemUUID *newListUUID = [TOFileSystemUUID UUIDWithString:@"9e3a1b84-6c2f-4d0e-8b7a-5f1c2d3e4a5b"];
+    NSURL *newURL = [NSURL fileURLWithPath:@"/Documents/Folder/File.txt"];
+    [self.batch addMovedItemWithUUID:self.uuid
+                          oldFileURL:self.url
+                          newFileURL:newURL
+                       oldParentUUID:self.listUUID
+                       newParentUUID:newListUUID];
+
+    XCTAssertTrue([self.batch.removedListItems[self.listUUID] containsObject:self.uuid]);
+    XCTAssert(self.batch.insertedListItems[newListUUID][self.uuid] == newURL);
+
+    // Moving it straight back should cancel out the insertion into the new list
+    [self.batch addMovedItemWithUUID:self.uuid
+                          oldFileURL:newURL
+                          newFileURL:self.url
+                       oldParentUUID:newListUUID
+                       newParentUUID:self.listUUID];
+    XCTAssertTrue(self.batch.insertedListItems[newListUUID].count == 0);
+    XCTAssertTrue(self.batch.removedListItems[newListUUID].count == 0);
+}
+
+- (void)testParentItemChanges
+{
+    TOFileSystemChangesBatch *batch = [[TOFileSystemChangesBatch alloc] initWithFileSystemObserver:self.observer isFullScan:NO];
+    TOFileSystemUUID *otherUUID = [TOFileSystemUUID UUIDWithString:@"9e3a1b84-6c2f-4d0e-8b7a-5f1c2d3e4a5b"];
+    TOFileSystemUUID *newListUUID = [TOFileSystemUUID UUIDWithString:@"5d4c3b2a-1f0e-4d9c-8b7a-6f5e4d3c2b1a"];
+    NSURL *otherURL = [NSURL fileURLWithPath:@"/Documents/Other.txt"];
+    NSURL *newURL = [NSURL fileURLWithPath:@"/Documents/Folder/Other.txt"];
+
+    [batch addDiscoveredItemWithUUID:self.uuid fileURL:self.url parentUUID:self.listUUID];
+    [batch addDiscoveredItemWithUUID:otherUUID fileURL:otherURL parentUUID:self.listUUID];
+    [batch addModifiedItemWithUUID:self.uuid fileURL:self.url parentUUID:self.listUUID];
+    [batch addMovedItemWithUUID:otherUUID
+                     oldFileURL:otherURL
+                     newFileURL:newURL
+                  oldParentUUID:self.listUUID
+                  newParentUUID:newListUUID];
+
+    // Each parent should only appear once, with the total change to its number of items
+    XCTAssertTrue(batch.parentItemChanges.count == 2);
+    XCTAssertEqualObjects(batch.parentItemChanges[self.listUUID], @1);
+    XCTAssertEqualObjects(batch.parentItemChanges[newListUUID], @1);
+
+    [batch addDeletedItemWithUUID:self.uuid fileURL:self.url parentUUID:self.listUUID];
+    XCTAssertEqualObjects(batch.parentItemChanges[self.listUUID], @0);
+
+    // During a full scan, the parents are still collected, but nothing is counted
+    [self.batch addDiscoveredItemWithUUID:self.uuid fileURL:self.url parentUUID:self.listUUID];
+    XCTAssertEqualObjects(self.batch.parentItemChanges[self.listUUID], [NSNull null]);
+}
+
+@end
@@ -10,11 +10,12 @@
 
 #import "TOFileSystemObserver.h"
 #import "TOFileSystemChanges+Private.h"
+#import "TOFileSystemUUID.h"
 
 @interface TOFileSystemChangesTests : XCTestCase
 
 @property (nonatomic, strong) NSURL *url;
-@property (nonatomic, copy) NSString *uuid;
+@property (nonatomic, strong) TOFileSystemUUID *uuid;
 
 @property (nonatomic, strong) TOFileSystemObserver *observer;
 @property (nonatomic, strong) TOFileSystemChanges *changes;
@@ -27,7 +28,7 @@
 {
     // Create test data
     self.url = [NSURL fileURLWithPath:@"/Documents"];
-    self.uuid = @"0256d425-f081-4bc3-8db5-bcb158568abb";
+    self.uuid = [TOFileSystemUUID UUIDWithString:@"0256d425-f081-4bc3-8db5-bcb158568abb"];
     
     // Create test objects
     self.observer = [[TOFileSystemObserver alloc] init];
@@ -51,21 +52,21 @@
 {
     // Test we can properly retrieve discovered items that were added
     [self.changes addDiscoveredItemWithUUID:self.uuid fileURL:self.url];
-    XCTAssert(self.changes.discoveredItems[self.uuid] == self.url);
+    XCTAssert(self.changes.discoveredItems[self.uuid.stringValue] == self.url);
 }
 
 - (void)testModifications
 {
     // Test we can properly retrieve modified items that were added
     [self.changes addModifiedItemWithUUID:self.uuid fileURL:self.url];
-    XCTAssert(self.changes.modifiedItems[self.uuid] == self.url);
+    XCTAssert(self.changes.modifiedItems[self.uuid.stringValue] == self.url);
 }
 
 - (void)testDeletions
 {
     // Test we can properly retrieve deleted items that were added
     [self.changes addDeletedItemWithUUID:self.uuid fileURL:self.url];
-    XCTAssert(self.changes.deletedItems[self.uuid] == self.url);
+    XCTAssert(self.changes.deletedItems[self.uuid.stringValue] == self.url);
 }
 
 - (void)testMovedItems
@@ -73,8 +74,8 @@
     // Test we can properly retrieve moved items that were added
     NSURL *newURL = [NSURL fileURLWithPath:@"/Documents/Folder"];
     [self.changes addMovedItemWithUUID:self.uuid oldFileURL:self.url newFileURL:newURL];
-    XCTAssert(self.changes.movedItems[self.uuid].firstObject == self.url);
-    XCTAssert(self.changes.movedItems[self.uuid].lastObject == newURL);
+    XCTAssert(self.changes.movedItems[self.uuid.stringValue].firstObject == self.url);
+    XCTAssert(self.changes.movedItems[self.uuid.stringValue].lastObject == newURL);
 }
 
 @end
@@ -0,0 +1,93 @@
+//
+//  TOFileSystemExclusionMatcherTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemExclusionMatcher.h"
+
+@interface TOFileSystemExclusionMatcherTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *baseURL;
+
+@end
+
+@implementation TOFileSystemExclusionMatcherTests
+
+- (void)setUp
+{
+    self.baseURL = [NSURL fileURLWithPath:@"/Documents" isDirectory:YES];
+}
+
+- (void)testExactPaths
+{
+    NSArray *patterns = @[@"Inbox", @"Folder/Cache/"];
+    TOFileSystemExclusionMatcher *matcher = [[TOFileSystemExclusionMatcher alloc] initWithPatterns:patterns
+                                                                                          baseURL:self.baseURL];
+    XCTAssertTrue([matcher matchesRelativePath:@"Inbox"]);
+    XCTAssertTrue([matcher matchesRelativePath:@"Folder/Cache"]);
+
+    // Plain paths only match from the base directory
+    XCTAssertFalse([matcher matchesRelativePath:@"Folder/Inbox"]);
+    XCTAssertFalse([matcher matchesRelativePath:@"Cache"]);
+}
+
+- (void)testNamePatterns
+{
+    NSArray *patterns = @[@"*.tmp", @"**/node_modules"];
+    TOFileSystemExclusionMatcher *matcher = [[TOFileSystemExclusionMatcher alloc] initWithPatterns:patterns
+                                                                                          baseURL:self.baseURL];
+    XCTAssertTrue([matcher matchesRelativePath:@"File.tmp"]);
+    XCTAssertTrue([matcher matchesRelativePath:@"Folder/SubFolder/File.tmp"]);
+    XCTAssertTrue([matcher matchesRelativePath:@"node_modules"]);
+    XCTAssertTrue([matcher matchesRelativePath:@"Project/node_modules"]);
+    XCTAssertFalse([matcher matchesRelativePath:@"File.txt"]);
+    XCTAssertFalse([matcher matchesRelativePath:@"node_modules/File.txt"]);
+}
+
+- (void)testSegmentPatterns
+{
+    NSArray *patterns = @[@"Folder/*/Cache", @"Projects/**/build"];
+    TOFileSystemExclusionMatcher *matcher = [[TOFileSystemExclusionMatcher alloc] initWithPatterns:patterns
+                                                                                          baseURL:self.baseURL];
+    XCTAssertTrue([matcher matchesRelativePath:@"Folder/SubFolder/Cache"]);
+    XCTAssertFalse([matcher matchesRelativePath:@"Folder/Cache"]);
+    XCTAssertFalse([matcher matchesRelativePath:@"Folder/One/Two/Cache"]);
+
+    XCTAssertTrue([matcher matchesRelativePath:@"Projects/build"]);
+    XCTAssertTrue([matcher matchesRelativePath:@"Projects/App/Target/build"]);
+    XCTAssertFalse([matcher matchesRelativePath:@"Other/build"]);
+}
+
+- (void)testItemURLs
+{
+    TOFileSystemExclusionMatcher *matcher = [[TOFileSystemExclusionMatcher alloc] initWithPatterns:@[@"Inbox"]
+                                                                                          baseURL:self.baseURL];
+    NSURL *inboxURL = [self.baseURL URLByAppendingPathComponent:@"Inbox" isDirectory:YES];
+    NSURL *fileURL = [inboxURL URLByAppendingPathComponent:@"File.pdf"];
+    XCTAssertTrue([matcher matchesItemAtURL:inboxURL]);
+    XCTAssertFalse([matcher matchesItemAtURL:fileURL]);
+    XCTAssertTrue([matcher matchesItemOrParentOfItemAtURL:fileURL]);
+
+    // The base directory itself is never excluded
+    XCTAssertFalse([matcher matchesItemOrParentOfItemAtURL:self.baseURL]);
+}
+
+@end
@@ -49,33 +49,38 @@
 {
     TOFileSystemItemURLDictionary *dict = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.baseURL];
     
+    // Create the UUIDs to store them under
+    TOFileSystemUUID *firstUUID = [TOFileSystemUUID UUID];
+    TOFileSystemUUID *secondUUID = [TOFileSystemUUID UUID];
+
     // Test first insertion
     NSString *folder1URL = [NSString stringWithFormat:@"%@/Folder1", self.tempDirectory];
     NSURL *url = [NSURL fileURLWithPath:folder1URL].URLByStandardizingPath;
-    dict[@"folder1"] = url;
-    XCTAssert([url isEqual:dict[@"folder1"]]);
+    dict[firstUUID] = url;
+    XCTAssert([url isEqual:dict[firstUUID]]);
     
     // Test second insertion
     NSString *folder2URL = [NSString stringWithFormat:@"%@/Folder2", self.tempDirectory];
     url = [NSURL fileURLWithPath:folder2URL].URLByStandardizingPath;
-    dict[@"folder2"] = url;
-    XCTAssert([url isEqual:dict[@"folder2"]]);
+    dict[secondUUID] = url;
+    XCTAssert([url isEqual:dict[secondUUID]]);
     
     // Test deletion
-    dict[@"folder1"] = nil;
-    XCTAssertNil(dict[@"folder1"]);
+    dict[firstUUID] = nil;
+    XCTAssertNil(dict[firstUUID]);
 }
 
 - (void)testConcurrentReads
 {
     TOFileSystemItemURLDictionary *dict = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.baseURL];
     
+    TOFileSystemUUID *firstUUID = [TOFileSystemUUID UUID];
     NSString *folder1URL = [NSString stringWithFormat:@"%@/Folder1", self.tempDirectory];
     NSURL *url = [NSURL fileURLWithPath:folder1URL].URLByStandardizingPath;
-    dict[@"folder1"] = url;
+    dict[firstUUID] = url;
     
     // Check read is working on the main thread
-    XCTAssert([url isEqual:dict[@"folder1"]]);
+    XCTAssert([url isEqual:dict[firstUUID]]);
     
     // Create expectation to test concurrent execution
     XCTestExpectation *expectation = [[XCTestExpectation alloc]
@@ -87,13 +92,13 @@
     // Kickstart a read on the first thread
     dispatch_queue_t firstQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
     dispatch_group_async(dispatchGroup, firstQueue, ^ {
-        XCTAssert([url isEqual:dict[@"folder1"]]);
+        XCTAssert([url isEqual:dict[firstUUID]]);
     });
 
     // Kickstart a read on the second thread
     dispatch_queue_t secondQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
     dispatch_group_async(dispatchGroup, secondQueue, ^ {
-        XCTAssert([url isEqual:dict[@"folder1"]]);
+        XCTAssert([url isEqual:dict[firstUUID]]);
     });
     
     // Upon completion of both reads, ensure the dictionary contains both values
@@ -116,6 +121,10 @@
     
     NSString *folder2URL = [NSString stringWithFormat:@"%@/Folder2", self.tempDirectory];
     NSURL *secondUrl = [NSURL fileURLWithPath:folder2URL].URLByStandardizingPath;
+
+    // Create the UUIDs to store them under
+    TOFileSystemUUID *firstUUID = [TOFileSystemUUID UUID];
+    TOFileSystemUUID *secondUUID = [TOFileSystemUUID UUID];
     
     // Create expectation to test concurrent execution
     XCTestExpectation *expectation = [[XCTestExpectation alloc]
@@ -127,21 +136,21 @@
     // Kickstart a write on the first thread
     dispatch_queue_t firstQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
     dispatch_group_async(dispatchGroup, firstQueue, ^ {
-        [dict setItemURL:firstUrl forUUID:@"folder1"];
+        [dict setItemURL:firstUrl forUUID:firstUUID];
     });
 
     // Kickstart a write on the second thread
     dispatch_queue_t secondQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
     dispatch_group_async(dispatchGroup, secondQueue, ^ {
-        [dict setItemURL:secondUrl forUUID:@"folder2"];
+        [dict setItemURL:secondUrl forUUID:secondUUID];
     });
 
     // Upon completion of both writes, ensure the dictionary contains both values
     dispatch_queue_t mainQueue = dispatch_get_main_queue();
     dispatch_group_notify(dispatchGroup, mainQueue, ^ {
-        XCTAssert([firstUrl isEqual:dict[@"folder1"]]);
-        XCTAssert([secondUrl isEqual:dict[@"folder2"]]);
-        XCTAssertNil([dict itemURLForUUID:@"folder3"]);
+        XCTAssert([firstUrl isEqual:dict[firstUUID]]);
+        XCTAssert([secondUrl isEqual:dict[secondUUID]]);
+        XCTAssertNil([dict itemURLForUUID:[TOFileSystemUUID UUID]]);
         [expectation fulfill];
     });
     
@@ -9,11 +9,12 @@
 #import <XCTest/XCTest.h>
 
 #import "TOFileSystemItemMapTable.h"
+#import "TOFileSystemUUID.h"
 
 @interface TOFileSystemItemMapTableTests : XCTestCase
 
 @property (nonatomic, strong) TOFileSystemItemMapTable *mapTable;
-@property (nonatomic, copy) NSString *uuid;
+@property (nonatomic, strong) TOFileSystemUUID *uuid;
 @property (nonatomic, strong) NSString *object;
 
 @end
@@ -24,7 +25,7 @@
 {
     @autoreleasepool {
         self.mapTable = [[TOFileSystemItemMapTable alloc] init];
-        self.uuid = @"0afec03c-ba74-4b87-9941-9c59bb97ccc4";
+        self.uuid = [TOFileSystemUUID UUIDWithString:@"0afec03c-ba74-4b87-9941-9c59bb97ccc4"];
         self.object = @"XD";
     }
 
@@ -55,4 +56,44 @@
     XCTAssertEqual(self.mapTable.count, 0);
 }
 
+- (void)testSettingIfAbsent
+{
+    // An item that's already stored wins over a new one
+    NSString *object = [self.mapTable setItemIfAbsent:@"New" forUUID:self.uuid];
+    XCTAssertEqualObjects(object, self.object);
+
+    // Otherwise, the new item is stored
+    TOFileSystemUUID *uuid = [TOFileSystemUUID UUID];
+    XCTAssertEqualObjects([self.mapTable setItemIfAbsent:@"New" forUUID:uuid], @"New");
+    XCTAssertEqual(self.mapTable.allUUIDs.count, 2);
+}
+
+- (void)testConcurrentAccess
+{
+    // Store and look up items from many threads at once
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray array];
+    for (NSInteger i = 0; i < 1000; i++) { [uuids addObject:[TOFileSystemUUID UUID]]; }
+
+    dispatch_apply(uuids.count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        [self.mapTable setItemIfAbsent:self.object forUUID:uuids[index]];
+        XCTAssertEqualObjects([self.mapTable itemForUUID:uuids[index]], self.object);
+    });
+
+    XCTAssertEqual(self.mapTable.count, 1001);
+}
+
+- (void)testBatchAccess
+{
+    NSArray<TOFileSystemUUID *> *uuids = @[self.uuid, [TOFileSystemUUID UUID], [TOFileSystemUUID UUID]];
+
+    // Only the item already stored is found
+    NSArray *items = [self.mapTable itemsForUUIDs:uuids];
+    XCTAssertEqualObjects(items, (@[self.object, [NSNull null], [NSNull null]]));
+
+    // Storing a batch keeps the existing item, and adds the rest
+    items = [self.mapTable setItemsIfAbsent:@[@"A", @"B", @"C"] forUUIDs:uuids];
+    XCTAssertEqualObjects(items, (@[self.object, @"B", @"C"]));
+    XCTAssertEqualObjects([self.mapTable itemsForUUIDs:uuids], items);
+}
+
 @end
@@ -0,0 +1,136 @@
+//
+//  TOFileSystemItemMetadataTableTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemItemMetadataTable.h"
+#import "TOFileSystemUUID.h"
+
+@interface TOFileSystemItemMetadataTableTests : XCTestCase
+
+@end
+
+@implementation TOFileSystemItemMetadataTableTests
+
+- (TOFileSystemItemAttributes)attributesWithInode:(uint64_t)inode size:(long long)size
+{
+    TOFileSystemItemAttributes attributes = {0};
+    attributes.inode = inode;
+    attributes.device = 1;
+    attributes.size = size;
+    attributes.creationTime.tv_sec = 100;
+    attributes.creationTime.tv_nsec = 500;
+    attributes.modificationTime.tv_sec = 200;
+    attributes.changeTime.tv_sec = 300;
+    return attributes;
+}
+
+- (void)testStoringAttributes
+{
+    TOFileSystemItemMetadataTable *table = [[TOFileSystemItemMetadataTable alloc] init];
+    TOFileSystemUUID *uuid = [TOFileSystemUUID UUID];
+    TOFileSystemItemAttributes attributes = [self attributesWithInode:42 size:1024];
+
+    NSUInteger identifier = [table setAttributes:&attributes forUUID:uuid];
+    XCTAssertEqual(table.count, 1);
+    XCTAssertEqual([table identifierForUUID:uuid], identifier);
+    XCTAssertEqualObjects([table uuidForIdentifier:identifier], uuid);
+
+    // Every attribute comes back exactly as it went in
+    TOFileSystemItemAttributes savedAttributes = {0};
+    XCTAssertTrue([table getAttributes:&savedAttributes forUUID:uuid]);
+    XCTAssertTrue(TOFileSystemItemAttributesAreSameItem(&attributes, &savedAttributes));
+    XCTAssertEqual(savedAttributes.size, 1024);
+    XCTAssertEqual(savedAttributes.modificationTime.tv_sec, 200);
+    XCTAssertEqual(savedAttributes.changeTime.tv_sec, 300);
+    XCTAssertFalse(savedAttributes.isDirectory);
+
+    // Updating the child count only changes that column
+    [table setNumberOfChildItems:5 forUUID:uuid];
+    XCTAssertTrue([table getAttributes:&savedAttributes forIdentifier:identifier]);
+    XCTAssertEqual(savedAttributes.numberOfChildItems, 5);
+    XCTAssertEqual(savedAttributes.size, 1024);
+}
+
+- (void)testReusingIdentifiers
+{
+    TOFileSystemItemMetadataTable *table = [[TOFileSystemItemMetadataTable alloc] init];
+    TOFileSystemItemAttributes attributes = [self attributesWithInode:1 size:10];
+
+    TOFileSystemUUID *firstUUID = [TOFileSystemUUID UUID];
+    NSUInteger firstIdentifier = [table setAttributes:&attributes forUUID:firstUUID];
+    [table setAttributes:&attributes forUUID:[TOFileSystemUUID UUID]];
+
+    // Once removed, the row is empty until the next item takes it
+    [table removeAttributesForUUID:firstUUID];
+    XCTAssertEqual(table.count, 1);
+    XCTAssertEqual([table identifierForUUID:firstUUID], NSNotFound);
+    XCTAssertNil([table uuidForIdentifier:firstIdentifier]);
+    XCTAssertEqual(table.totalSizeOfFiles, 10);
+
+    XCTAssertEqual([table setAttributes:&attributes forUUID:[TOFileSystemUUID UUID]], firstIdentifier);
+    XCTAssertEqual(table.totalSizeOfFiles, 20);
+
+    [table removeAllAttributes];
+    XCTAssertEqual(table.count, 0);
+    XCTAssertEqual(table.memoryUsage, 0);
+}
+
+- (void)testReadingColumns
+{
+    TOFileSystemItemMetadataTable *table = [[TOFileSystemItemMetadataTable alloc] init];
+    for (NSInteger i = 0; i < 100; i++) {
+        TOFileSystemItemAttributes attributes = [self attributesWithInode:i + 1 size:i];
+        attributes.isDirectory = (i % 2 == 0);
+        [table setAttributes:&attributes forUUID:[TOFileSystemUUID UUID]];
+    }
+
+    [table performReadUsingBlock:^(const TOFileSystemItemMetadataColumns *columns) {
+        XCTAssertEqual(columns->numberOfRows, 100);
+        NSInteger numberOfDirectories = 0;
+        for (NSUInteger i = 0; i < columns->numberOfRows; i++) {
+            if (columns->types[i] == TOFileSystemItemMetadataTypeDirectory) { numberOfDirectories++; }
+        }
+        XCTAssertEqual(numberOfDirectories, 50);
+    }];
+}
+
+- (void)testFillingPerformance
+{
+    // Fill a table with a million items, and report how much memory the columns took
+    NSInteger numberOfItems = 1000000;
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray arrayWithCapacity:numberOfItems];
+    for (NSInteger i = 0; i < numberOfItems; i++) { [uuids addObject:[TOFileSystemUUID UUID]]; }
+
+    __block TOFileSystemItemMetadataTable *table = nil;
+    [self measureBlock:^{
+        table = [[TOFileSystemItemMetadataTable alloc] init];
+        for (NSInteger i = 0; i < numberOfItems; i++) {
+            TOFileSystemItemAttributes attributes = [self attributesWithInode:i + 1 size:i];
+            [table setAttributes:&attributes forUUID:uuids[i]];
+        }
+    }];
+
+    XCTAssertEqual(table.count, numberOfItems);
+    XCTAssertGreaterThanOrEqual(table.memoryUsage, numberOfItems * [TOFileSystemItemMetadataTable numberOfBytesPerRow]);
+}
+
+@end
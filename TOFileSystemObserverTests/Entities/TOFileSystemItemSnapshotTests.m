@@ -0,0 +1,154 @@
+//
+//  TOFileSystemItemSnapshotTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemObserver.h"
+#import "TOFileSystemItem+Private.h"
+#import "TOFileSystemItemSnapshot+Private.h"
+#import "TOFileSystemUUID.h"
+
+@interface TOFileSystemItemSnapshotTests : XCTestCase
+
+@property (nonatomic, strong) TOFileSystemObserver *observer;
+@property (nonatomic, strong) NSURL *folderURL;
+
+@end
+
+@implementation TOFileSystemItemSnapshotTests
+
+- (void)setUp
+{
+    self.observer = [[TOFileSystemObserver alloc] init];
+
+    NSURL *url = [NSURL fileURLWithPath:NSTemporaryDirectory()];
+    self.folderURL = [url URLByAppendingPathComponent:@"SnapshotFolder"];
+    [NSFileManager.defaultManager removeItemAtURL:self.folderURL error:nil];
+    [NSFileManager.defaultManager createDirectoryAtURL:self.folderURL withIntermediateDirectories:YES attributes:nil error:nil];
+
+    // Two files and a sub-folder
+    [self addFileNamed:@"File 1.txt"];
+    [self addFileNamed:@"File 2.txt"];
+    [NSFileManager.defaultManager createDirectoryAtURL:[self.folderURL URLByAppendingPathComponent:@"SubFolder"]
+                           withIntermediateDirectories:YES attributes:nil error:nil];
+}
+
+- (void)tearDown
+{
+    [NSFileManager.defaultManager removeItemAtURL:self.folderURL error:nil];
+}
+
+- (void)addFileNamed:(NSString *)name
+{
+    NSData *data = [@"Hello" dataUsingEncoding:NSUTF8StringEncoding];
+    [data writeToURL:[self.folderURL URLByAppendingPathComponent:name] atomically:NO];
+}
+
+- (void)removeFileNamed:(NSString *)name
+{
+    [NSFileManager.defaultManager removeItemAtURL:[self.folderURL URLByAppendingPathComponent:name] error:nil];
+}
+
+- (TOFileSystemItem *)folderItem
+{
+    TOFileSystemItemAttributes attributes = {0};
+    XCTAssertTrue([self.folderURL to_getAttributes:&attributes]);
+    return [[TOFileSystemItem alloc] initWithItemAtFileURL:self.folderURL
+                                                      uuid:[TOFileSystemUUID UUID]
+                                                attributes:&attributes
+                                        fileSystemObserver:self.observer];
+}
+
+- (NSInteger)cachedCountOfSnapshot:(TOFileSystemItemSnapshot *)snapshot
+{
+    NSDate *countedModificationDate = nil;
+    return [snapshot cachedNumberOfSubItemsWithModificationDate:&countedModificationDate];
+}
+
+- (void)testCountingLazily
+{
+    TOFileSystemItem *item = [self folderItem];
+    TOFileSystemItemSnapshot *snapshot = item.snapshot;
+
+    // Nothing should be counted until it's asked for
+    XCTAssertTrue([self cachedCountOfSnapshot:snapshot] < 0);
+    XCTAssertEqual(snapshot.numberOfSubItems, 3);
+    XCTAssertEqual([self cachedCountOfSnapshot:snapshot], 3);
+
+    // Once counted, the snapshot keeps its value, even if the directory changes
+    [self addFileNamed:@"File 3.txt"];
+    XCTAssertEqual(snapshot.numberOfSubItems, 3);
+    XCTAssertEqual(item.numberOfSubItems, 3);
+}
+
+- (void)testCarryingOverUnchangedCount
+{
+    TOFileSystemItem *item = [self folderItem];
+    XCTAssertEqual(item.numberOfSubItems, 3);
+
+    // Refreshing while the directory is unchanged should keep the count without reading it again
+    XCTAssertFalse([item refreshWithURL:nil]);
+    XCTAssertEqual([self cachedCountOfSnapshot:item.snapshot], 3);
+    XCTAssertEqual(item.numberOfSubItems, 3);
+}
+
+- (void)testInvalidatingCountAfterChanges
+{
+    TOFileSystemItem *item = [self folderItem];
+    XCTAssertEqual(item.numberOfSubItems, 3);
+
+    // Adding a file changes the directory, so it should be counted again
+    [self addFileNamed:@"File 3.txt"];
+    [item refreshWithURL:nil];
+    XCTAssertTrue([self cachedCountOfSnapshot:item.snapshot] < 0);
+    XCTAssertEqual(item.numberOfSubItems, 4);
+
+    // As should removing one
+    [self removeFileNamed:@"File 1.txt"];
+    [item refreshWithURL:nil];
+    XCTAssertTrue([self cachedCountOfSnapshot:item.snapshot] < 0);
+    XCTAssertEqual(item.numberOfSubItems, 3);
+}
+
+- (void)testAdjustingCountAcrossConsecutiveBatches
+{
+    TOFileSystemItem *item = [self folderItem];
+    XCTAssertEqual(item.numberOfSubItems, 3);
+
+    // Both files are added before the first batch is delivered, so the directory
+    // already includes the second file when the first batch refreshes it
+    [self addFileNamed:@"File 3.txt"];
+    [self addFileNamed:@"File 4.txt"];
+
+    // The first batch only reports one of them
+    [item refreshWithNumberOfSubItemsChange:1];
+    XCTAssertEqual(item.numberOfSubItems, 4);
+
+    // The second batch reports the other, and shouldn't be mistaken for an unchanged directory
+    [item refreshWithNumberOfSubItemsChange:1];
+    XCTAssertEqual(item.numberOfSubItems, 5);
+
+    // Refreshing again with nothing new should keep the count that was read from disk
+    [item refreshWithNumberOfSubItemsChange:0];
+    XCTAssertEqual([self cachedCountOfSnapshot:item.snapshot], 5);
+}
+
+@end
@@ -0,0 +1,105 @@
+//
+//  TOFileSystemItemSortKeyTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemItemSortKey.h"
+#import "TOFileSystemItemSnapshot+Private.h"
+#import "TOFileSystemUUID.h"
+
+@interface TOFileSystemItemSortKeyTests : XCTestCase
+
+@end
+
+@implementation TOFileSystemItemSortKeyTests
+
+- (TOFileSystemItemSortKey *)sortKeyWithName:(NSString *)name size:(long long)size
+{
+    NSURL *fileURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:name];
+    TOFileSystemItemSnapshot *snapshot = [[TOFileSystemItemSnapshot alloc] initWithFileURL:fileURL
+                                                                                      type:TOFileSystemItemTypeFile
+                                                                                      uuid:nil
+                                                                                      name:name
+                                                                                      size:size
+                                                                              creationDate:nil
+                                                                          modificationDate:[NSDate dateWithTimeIntervalSinceReferenceDate:size]
+                                                                          numberOfSubItems:0
+                                                                   countedModificationDate:nil
+                                                                                 isCopying:NO];
+    return [[TOFileSystemItemSortKey alloc] initWithUUID:[TOFileSystemUUID UUID] snapshot:snapshot];
+}
+
+- (void)testNameOrderMatchesStandardCompare
+{
+    NSArray<NSString *> *names = @[@"File 10.txt", @"File 2.txt", @"file 1.txt", @"File 02.txt", @"File.txt",
+                                   @"file_a", @"file-a", @"file.a", @"File A", @"filea", @"fileA",
+                                   @"Zebra", @"apple", @"Äpfel", @"123", @"99 Balloons", @"(Draft)", @"~tmp",
+                                   @"Photo 0001.jpg", @"Photo 1.jpg", @"Photo 100.jpg", @"Photo 20.jpg", @""];
+
+    // Every pair of names should compare the same way as comparing the names themselves
+    for (NSString *firstName in names) {
+        TOFileSystemItemSortKey *firstKey = [self sortKeyWithName:firstName size:0];
+        for (NSString *secondName in names) {
+            TOFileSystemItemSortKey *secondKey = [self sortKeyWithName:secondName size:0];
+            XCTAssertEqual([firstKey compareName:secondKey], [firstName localizedStandardCompare:secondName],
+                           @"'%@' and '%@' compared differently", firstName, secondName);
+        }
+    }
+}
+
+- (void)testComparators
+{
+    TOFileSystemItemSortKey *smallKey = [self sortKeyWithName:@"B" size:10];
+    TOFileSystemItemSortKey *largeKey = [self sortKeyWithName:@"A" size:20];
+    TOFileSystemItemSortKey *otherLargeKey = [self sortKeyWithName:@"C" size:20];
+
+    NSComparator comparator = [TOFileSystemItemSortKey comparatorForListOrder:TOFileSystemItemListOrderAlphanumeric isDescending:NO];
+    XCTAssertEqual(comparator(largeKey, smallKey), NSOrderedAscending);
+    XCTAssertEqual(comparator(smallKey, smallKey), NSOrderedSame);
+
+    comparator = [TOFileSystemItemSortKey comparatorForListOrder:TOFileSystemItemListOrderDate isDescending:NO];
+    XCTAssertEqual(comparator(smallKey, largeKey), NSOrderedAscending);
+
+    // Sizes go largest first, and then by name if they match
+    comparator = [TOFileSystemItemSortKey comparatorForListOrder:TOFileSystemItemListOrderSize isDescending:NO];
+    XCTAssertEqual(comparator(largeKey, smallKey), NSOrderedAscending);
+    XCTAssertEqual(comparator(largeKey, otherLargeKey), NSOrderedAscending);
+
+    comparator = [TOFileSystemItemSortKey comparatorForListOrder:TOFileSystemItemListOrderSize isDescending:YES];
+    XCTAssertEqual(comparator(largeKey, smallKey), NSOrderedDescending);
+}
+
+- (void)testSortingPerformance
+{
+    NSMutableArray<TOFileSystemItemSortKey *> *sortKeys = [NSMutableArray array];
+    for (NSInteger i = 0; i < 50000; i++) {
+        NSString *name = [NSString stringWithFormat:@"File %u.txt", arc4random()];
+        [sortKeys addObject:[self sortKeyWithName:name size:i]];
+    }
+
+    NSComparator comparator = [TOFileSystemItemSortKey comparatorForListOrder:TOFileSystemItemListOrderAlphanumeric isDescending:NO];
+    [self measureBlock:^{
+        NSMutableArray *array = [sortKeys mutableCopy];
+        [array sortWithOptions:NSSortConcurrent usingComparator:comparator];
+    }];
+}
+
+@end
@@ -10,6 +10,7 @@
 
 #import "TOFileSystemPath.h"
 #import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemUUID.h"
 
 
 @interface TOFileSystemItemURLDictionaryTests : XCTestCase
@@ -18,7 +19,7 @@
 @property (nonatomic, strong) TOFileSystemItemURLDictionary *dictionary;
 
 @property (nonatomic, strong) NSURL *url;
-@property (nonatomic, copy) NSString *uuid;
+@property (nonatomic, strong) TOFileSystemUUID *uuid;
 
 @end
 
@@ -32,7 +33,7 @@
     
     // Create some basic test data
     self.url = [self.baseURL URLByAppendingPathComponent:@"Folder"];
-    self.uuid = @"f2a5bc6d-0eab-4970-8650-8629fdc3a866";
+    self.uuid = [TOFileSystemUUID UUIDWithString:@"f2a5bc6d-0eab-4970-8650-8629fdc3a866"];
     
     // Insert the test data
     [self.dictionary setItemURL:self.url forUUID:self.uuid];
@@ -58,7 +59,7 @@
     XCTAssert([[self.dictionary itemURLForUUID:self.uuid] isEqual:self.url]);
     
     // Perform an inverse lookup
-    XCTAssert([[self.dictionary uuidForItemWithURL:self.url] isEqualToString:self.uuid]);
+    XCTAssert([[self.dictionary uuidForItemWithURL:self.url] isEqualToUUID:self.uuid]);
 }
 
 - (void)testSubscripting
@@ -79,6 +80,49 @@
     XCTAssertEqual(self.dictionary.count, 0);
 }
 
+- (void)testAttributes
+{
+    // Items stored without attributes don't report any
+    TOFileSystemItemAttributes attributes = {0};
+    XCTAssertFalse([self.dictionary getAttributes:&attributes forUUID:self.uuid]);
+
+    // Store some, and check they come back the same
+    attributes.inode = 1234;
+    attributes.size = 5678;
+    [self.dictionary setItemURL:self.url attributes:&attributes forUUID:self.uuid];
+
+    TOFileSystemItemAttributes savedAttributes = {0};
+    XCTAssertTrue([self.dictionary getAttributes:&savedAttributes forUUID:self.uuid]);
+    XCTAssertTrue(savedAttributes.inode == 1234);
+    XCTAssertTrue(savedAttributes.size == 5678);
+
+    // Removing the item removes its attributes too
+    [self.dictionary removeItemURLForUUID:self.uuid];
+    XCTAssertFalse([self.dictionary getAttributes:&savedAttributes forUUID:self.uuid]);
+}
+
+- (void)testFileSystemIDLookup
+{
+    // Store the item with attributes, as a scan would
+    TOFileSystemItemAttributes attributes = {0};
+    attributes.inode = 1234;
+    attributes.device = 1;
+    attributes.creationTime.tv_sec = 100;
+    [self.dictionary setItemURL:self.url attributes:&attributes forUUID:self.uuid];
+
+    // The same item can be found again after it's moved
+    XCTAssert([[self.dictionary uuidForItemWithAttributes:&attributes] isEqualToUUID:self.uuid]);
+
+    // A new item that was given the same ID after this one was deleted doesn't match
+    TOFileSystemItemAttributes reusedAttributes = attributes;
+    reusedAttributes.creationTime.tv_sec = 200;
+    XCTAssertNil([self.dictionary uuidForItemWithAttributes:&reusedAttributes]);
+
+    // Removing the item removes its ID too
+    [self.dictionary removeItemURLForUUID:self.uuid];
+    XCTAssertNil([self.dictionary uuidForItemWithAttributes:&attributes]);
+}
+
 - (void)testRemovingSpecificItem
 {
     // Test deleting a specific item works
@@ -93,6 +137,57 @@
     XCTAssertEqual(self.dictionary.count, 0);
 }
 
+- (void)testMovingDirectory
+{
+    // Store an item inside the folder, and another one level deeper
+    NSURL *subfolderURL = [self.url URLByAppendingPathComponent:@"Subfolder"];
+    NSURL *fileURL = [subfolderURL URLByAppendingPathComponent:@"File.txt"];
+    TOFileSystemUUID *subfolderUUID = [TOFileSystemUUID UUID];
+    TOFileSystemUUID *fileUUID = [TOFileSystemUUID UUID];
+    self.dictionary[subfolderUUID] = subfolderURL;
+    self.dictionary[fileUUID] = fileURL;
+
+    // Rename the top folder, and check everything inside it moved along with it
+    NSURL *renamedURL = [self.baseURL URLByAppendingPathComponent:@"Renamed"];
+    self.dictionary[self.uuid] = renamedURL;
+    XCTAssertEqual(self.dictionary.count, 3);
+    XCTAssertEqualObjects([self.dictionary itemURLForUUID:fileUUID].path,
+                          [[renamedURL URLByAppendingPathComponent:@"Subfolder"] URLByAppendingPathComponent:@"File.txt"].path);
+    XCTAssert([[self.dictionary uuidForItemWithURL:[renamedURL URLByAppendingPathComponent:@"Subfolder"]] isEqualToUUID:subfolderUUID]);
+
+    // Nothing is left at the old location
+    XCTAssertNil([self.dictionary uuidForItemWithURL:self.url]);
+    XCTAssertNil([self.dictionary uuidForItemWithURL:fileURL]);
+    XCTAssertEqual([self.dictionary itemURLsInDirectoryAtURL:self.url].count, 0);
+}
+
+- (void)testSubtreeEnumerationAndRemoval
+{
+    // Store an item inside the folder, and another one level deeper
+    NSURL *subfolderURL = [self.url URLByAppendingPathComponent:@"Subfolder"];
+    self.dictionary[[TOFileSystemUUID UUID]] = subfolderURL;
+    self.dictionary[[TOFileSystemUUID UUID]] = [subfolderURL URLByAppendingPathComponent:@"File.txt"];
+
+    // Only the direct child is in the folder's listing, but both are in its subtree
+    XCTAssertEqual([self.dictionary itemURLsInDirectoryAtURL:self.url].count, 1);
+    __block NSInteger numberOfItems = 0;
+    [self.dictionary enumerateItemsInDirectoryAtURL:self.url usingBlock:^(TOFileSystemUUID *uuid, NSURL *itemURL, BOOL *stop) {
+        XCTAssert([itemURL.path hasPrefix:self.url.path]);
+        numberOfItems++;
+    }];
+    XCTAssertEqual(numberOfItems, 2);
+
+    // Removing the folder's entry keeps the items inside it
+    [self.dictionary removeItemURLForUUID:self.uuid];
+    XCTAssertEqual(self.dictionary.count, 2);
+    XCTAssertNotNil([self.dictionary uuidForItemWithURL:subfolderURL]);
+
+    // Removing the subtree removes everything
+    [self.dictionary removeItemURLsInDirectoryAtURL:self.url];
+    XCTAssertEqual(self.dictionary.count, 0);
+    XCTAssertNil(self.dictionary.allURLs);
+}
+
 - (void)testConcurrency
 {
     dispatch_group_t group = dispatch_group_create();
@@ -111,7 +206,7 @@
     // Second queue execution
     dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
         NSURL *url = [self.baseURL URLByAppendingPathComponent:@"Folder2"];
-        NSString *uuid = @"3ccd0073-e57c-42c7-b3be-6410a051c900";
+        TOFileSystemUUID *uuid = [TOFileSystemUUID UUIDWithString:@"3ccd0073-e57c-42c7-b3be-6410a051c900"];
         self.dictionary[uuid] = url;
     });
     
@@ -124,4 +219,108 @@
     [self waitForExpectations:@[expectation] timeout:0.5f];
 }
 
+- (void)testReadingWhileMovingDirectory
+{
+    NSURL *fileURL = [self.url URLByAppendingPathComponent:@"File.txt"];
+    NSURL *renamedURL = [self.baseURL URLByAppendingPathComponent:@"Renamed"];
+    TOFileSystemUUID *fileUUID = [TOFileSystemUUID UUID];
+    self.dictionary[fileUUID] = fileURL;
+
+    // Keep moving the folder back and forth on another thread
+    __block BOOL isFinished = NO;
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        for (NSInteger i = 0; !isFinished; i++) {
+            self.dictionary[self.uuid] = (i % 2) ? self.url : renamedURL;
+        }
+        dispatch_semaphore_signal(semaphore);
+    });
+
+    // The item inside it should always be found at one of the two complete locations
+    NSString *renamedPath = [renamedURL URLByAppendingPathComponent:@"File.txt"].path;
+    for (NSInteger i = 0; i < 20000; i++) {
+        NSString *path = [self.dictionary itemURLForUUID:fileUUID].path;
+        XCTAssertTrue([path isEqualToString:fileURL.path] || [path isEqualToString:renamedPath], @"%@", path);
+    }
+
+    isFinished = YES;
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+}
+
+- (void)testLookingUpURLsWhileRenaming
+{
+    NSURL *fileURL = [self.url URLByAppendingPathComponent:@"File.txt"];
+    NSURL *renamedURL = [self.url URLByAppendingPathComponent:@"Renamed.txt"];
+    NSURL *siblingURL = [self.url URLByAppendingPathComponent:@"Sibling.txt"];
+    TOFileSystemUUID *fileUUID = [TOFileSystemUUID UUID];
+    TOFileSystemUUID *siblingUUID = [TOFileSystemUUID UUID];
+    self.dictionary[fileUUID] = fileURL;
+    self.dictionary[siblingUUID] = siblingURL;
+
+    // Keep renaming the file back and forth on another thread
+    __block BOOL isFinished = NO;
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        for (NSInteger i = 0; !isFinished; i++) {
+            self.dictionary[fileUUID] = (i % 2) ? fileURL : renamedURL;
+        }
+        dispatch_semaphore_signal(semaphore);
+    });
+
+    // The item next to it should always be found, and the renamed item should never be mistaken for another
+    for (NSInteger i = 0; i < 20000; i++) {
+        XCTAssertEqualObjects([self.dictionary uuidForItemWithURL:siblingURL], siblingUUID);
+        TOFileSystemUUID *uuid = [self.dictionary uuidForItemWithURL:(i % 2) ? fileURL : renamedURL];
+        XCTAssertTrue(uuid == nil || [uuid isEqualToUUID:fileUUID]);
+    }
+
+    isFinished = YES;
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+}
+
+#pragma mark - Read Performance -
+
+- (NSArray<NSURL *> *)populateDictionaryForPerformanceTests
+{
+    // Fill the store with enough items to spread over every shard
+    NSMutableArray<NSURL *> *urls = [NSMutableArray array];
+    for (NSInteger i = 0; i < 10000; i++) {
+        NSURL *url = [self.baseURL URLByAppendingPathComponent:[NSString stringWithFormat:@"Item %ld", (long)i]];
+        self.dictionary[[TOFileSystemUUID UUID]] = url;
+        [urls addObject:url];
+    }
+    return urls;
+}
+
+- (void)testSerialReadPerformance
+{
+    NSArray<NSURL *> *urls = [self populateDictionaryForPerformanceTests];
+    NSInteger numberOfThreads = NSProcessInfo.processInfo.activeProcessorCount;
+
+    // Perform every lookup on a single thread, as a baseline for the concurrent test below
+    [self measureBlock:^{
+        for (NSInteger i = 0; i < numberOfThreads; i++) {
+            for (NSURL *url in urls) {
+                [self.dictionary uuidForItemWithURL:url];
+            }
+        }
+    }];
+}
+
+- (void)testConcurrentReadPerformance
+{
+    NSArray<NSURL *> *urls = [self populateDictionaryForPerformanceTests];
+    NSInteger numberOfThreads = NSProcessInfo.processInfo.activeProcessorCount;
+
+    // Perform the same lookups spread over every core. Since readers don't wait on
+    // each other, this should finish in roughly the serial time divided by the number of cores.
+    [self measureBlock:^{
+        dispatch_apply(numberOfThreads, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+            for (NSURL *url in urls) {
+                [self.dictionary uuidForItemWithURL:url];
+            }
+        });
+    }];
+}
+
 @end
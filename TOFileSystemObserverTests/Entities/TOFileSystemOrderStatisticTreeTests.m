@@ -0,0 +1,194 @@
+//
+//  TOFileSystemOrderStatisticTreeTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemOrderStatisticTree.h"
+
+/** A value wrapper, since the tree tracks objects by identity and equal NSNumbers may be the same object. */
+@interface TOOrderStatisticTreeTestValue : NSObject
+@property (nonatomic, assign) NSUInteger value;
+@end
+
+@implementation TOOrderStatisticTreeTestValue
+@end
+
+@interface TOFileSystemOrderStatisticTreeTests : XCTestCase
+
+@end
+
+@implementation TOFileSystemOrderStatisticTreeTests
+
+- (NSComparator)comparator
+{
+    return ^NSComparisonResult(TOOrderStatisticTreeTestValue *first, TOOrderStatisticTreeTestValue *second) {
+        if (first.value == second.value) { return NSOrderedSame; }
+        return (first.value < second.value) ? NSOrderedAscending : NSOrderedDescending;
+    };
+}
+
+- (NSArray<TOOrderStatisticTreeTestValue *> *)valuesWithCount:(NSUInteger)count
+{
+    // Values are random, so there will be plenty of distinct objects that compare the same
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        TOOrderStatisticTreeTestValue *value = [[TOOrderStatisticTreeTestValue alloc] init];
+        value.value = arc4random_uniform((uint32_t)count);
+        [values addObject:value];
+    }
+    return values;
+}
+
+- (void)assertTree:(TOFileSystemOrderStatisticTree *)tree matchesArray:(NSArray *)array
+{
+    XCTAssertEqual(tree.count, array.count);
+    for (NSUInteger i = 0; i < array.count; i++) {
+        XCTAssertEqualObjects(tree[i], array[i]);
+        XCTAssertEqual([tree indexOfObject:array[i]], i);
+    }
+    XCTAssertTrue([tree.allObjects isEqualToArray:array]);
+}
+
+- (void)testBasicOperations
+{
+    TOFileSystemOrderStatisticTree *tree = [[TOFileSystemOrderStatisticTree alloc] initWithComparator:^NSComparisonResult(NSNumber *first, NSNumber *second) {
+        return [first compare:second];
+    }];
+    NSNumber *one = @1, *two = @2, *three = @3;
+
+    XCTAssertEqual([tree insertObject:two], 0);
+    XCTAssertEqual([tree insertObject:three], 1);
+    XCTAssertEqual([tree insertObject:one], 0);
+    [self assertTree:tree matchesArray:@[one, two, three]];
+
+    XCTAssertEqual([tree removeObject:two], 1);
+    XCTAssertEqual([tree removeObject:two], NSNotFound);
+    XCTAssertFalse([tree containsObject:two]);
+    [self assertTree:tree matchesArray:@[one, three]];
+
+    // Changing the comparator should re-sort everything
+    tree.comparator = ^NSComparisonResult(NSNumber *first, NSNumber *second) {
+        return [second compare:first];
+    };
+    [self assertTree:tree matchesArray:@[three, one]];
+
+    [tree removeAllObjects];
+    XCTAssertEqual(tree.count, 0);
+    XCTAssertThrows(tree[0]);
+}
+
+- (void)testEqualObjectsKeepInsertionOrder
+{
+    // Distinct objects that compare the same should be stored in the order they were added
+    NSMutableString *first = [@"a" mutableCopy];
+    NSMutableString *second = [@"a" mutableCopy];
+    TOFileSystemOrderStatisticTree *tree = [[TOFileSystemOrderStatisticTree alloc] initWithComparator:^NSComparisonResult(id a, id b) {
+        return [a compare:b];
+    }];
+    [tree insertObject:first];
+    [tree insertObject:second];
+    XCTAssertTrue(tree[0] == first);
+    XCTAssertTrue(tree[1] == second);
+    XCTAssertEqual([tree indexOfObject:second], 1);
+}
+
+- (void)testRandomizedChangesMatchSortedArray
+{
+    NSComparator comparator = self.comparator;
+    NSArray<TOOrderStatisticTreeTestValue *> *values = [self valuesWithCount:2000];
+
+    TOFileSystemOrderStatisticTree *tree = [[TOFileSystemOrderStatisticTree alloc] initWithComparator:comparator];
+    [tree setObjects:[values subarrayWithRange:NSMakeRange(0, 1000)]];
+
+    NSMutableArray *array = [[values subarrayWithRange:NSMakeRange(0, 1000)] mutableCopy];
+    [array sortWithOptions:NSSortStable usingComparator:comparator];
+    [self assertTree:tree matchesArray:array];
+
+    // Mix removals and insertions, checking the reported indexes against the array as we go
+    NSMutableArray *pendingValues = [[values subarrayWithRange:NSMakeRange(1000, 1000)] mutableCopy];
+    for (NSUInteger i = 0; i < 4000; i++) {
+        if (array.count > 0 && (pendingValues.count == 0 || arc4random_uniform(2) == 0)) {
+            NSUInteger index = arc4random_uniform((uint32_t)array.count);
+            TOOrderStatisticTreeTestValue *value = array[index];
+            XCTAssertEqual([tree removeObject:value], index);
+            [array removeObjectAtIndex:index];
+            [pendingValues addObject:value];
+        }
+        else {
+            NSUInteger pendingIndex = arc4random_uniform((uint32_t)pendingValues.count);
+            TOOrderStatisticTreeTestValue *value = pendingValues[pendingIndex];
+            [pendingValues removeObjectAtIndex:pendingIndex];
+
+            // Equal objects go after any that are already in the array
+            NSUInteger index = [array indexOfObject:value
+                                      inSortedRange:NSMakeRange(0, array.count)
+                                            options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+                                    usingComparator:comparator];
+            [array insertObject:value atIndex:index];
+            XCTAssertEqual([tree insertObject:value], index);
+        }
+    }
+
+    [self assertTree:tree matchesArray:array];
+}
+
+#pragma mark - Performance -
+
+- (void)measureRepositioningWithCount:(NSUInteger)count
+{
+    NSComparator comparator = self.comparator;
+    NSArray<TOOrderStatisticTreeTestValue *> *values = [self valuesWithCount:count];
+    TOFileSystemOrderStatisticTree *tree = [[TOFileSystemOrderStatisticTree alloc] initWithComparator:comparator];
+    [tree setObjects:values];
+
+    // Move 10,000 objects, reading by index and looking up ranks the same way an item list does
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < 10000; i++) {
+            TOOrderStatisticTreeTestValue *value = tree[arc4random_uniform((uint32_t)count)];
+            NSUInteger oldIndex = [tree removeObject:value];
+            value.value = arc4random_uniform((uint32_t)count);
+            NSUInteger newIndex = [tree insertObject:value];
+            XCTAssertTrue(oldIndex < count && newIndex < count);
+        }
+    }];
+}
+
+- (void)measureBuildingWithCount:(NSUInteger)count
+{
+    NSArray<TOOrderStatisticTreeTestValue *> *values = [self valuesWithCount:count];
+    TOFileSystemOrderStatisticTree *tree = [[TOFileSystemOrderStatisticTree alloc] initWithComparator:self.comparator];
+
+    [self measureBlock:^{
+        [tree setObjects:values];
+    }];
+}
+
+- (void)testRepositioningPerformance1K { [self measureRepositioningWithCount:1000]; }
+- (void)testRepositioningPerformance10K { [self measureRepositioningWithCount:10000]; }
+- (void)testRepositioningPerformance100K { [self measureRepositioningWithCount:100000]; }
+- (void)testRepositioningPerformance1M { [self measureRepositioningWithCount:1000000]; }
+
+- (void)testBuildingPerformance1K { [self measureBuildingWithCount:1000]; }
+- (void)testBuildingPerformance10K { [self measureBuildingWithCount:10000]; }
+- (void)testBuildingPerformance100K { [self measureBuildingWithCount:100000]; }
+- (void)testBuildingPerformance1M { [self measureBuildingWithCount:1000000]; }
+
+@end
@@ -0,0 +1,168 @@
+//
+//  TOFileSystemScanIndexTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemScanIndex.h"
+#import "TOFileSystemItemURLDictionary.h"
+#import "TOFileSystemPath.h"
+
+@interface TOFileSystemScanIndexTests : XCTestCase
+
+@property (nonatomic, strong) NSURL *baseURL;
+@property (nonatomic, strong) NSURL *indexURL;
+@property (nonatomic, strong) TOFileSystemItemURLDictionary *dictionary;
+
+@end
+
+@implementation TOFileSystemScanIndexTests
+
+- (void)setUp
+{
+    self.baseURL = [TOFileSystemPath documentsDirectoryURL];
+    self.indexURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:@"Test.index"];
+    self.dictionary = [[TOFileSystemItemURLDictionary alloc] initWithBaseURL:self.baseURL];
+
+    // One item with attributes, and one without
+    TOFileSystemItemAttributes attributes = {0};
+    attributes.inode = 42;
+    attributes.size = 100;
+    attributes.modificationTime.tv_sec = 1000;
+    attributes.creationTime.tv_sec = 500;
+    attributes.creationTime.tv_nsec = 250;
+    [self.dictionary setItemURL:[self.baseURL URLByAppendingPathComponent:@"File.txt"]
+                     attributes:&attributes
+                        forUUID:[TOFileSystemUUID UUIDWithString:@"f2a5bc6d-0eab-4970-8650-8629fdc3a866"]];
+    [self.dictionary setItemURL:[self.baseURL URLByAppendingPathComponent:@"Folder"]
+                        forUUID:[TOFileSystemUUID UUIDWithString:@"3ccd0073-e57c-42c7-b3be-6410a051c900"]];
+}
+
+- (void)tearDown
+{
+    [NSFileManager.defaultManager removeItemAtURL:self.indexURL error:nil];
+}
+
+- (void)testWritingAndReading
+{
+    XCTAssertTrue([TOFileSystemScanIndex writeItems:self.dictionary toFileURL:self.indexURL]);
+
+    TOFileSystemScanIndex *index = [TOFileSystemScanIndex indexWithContentsOfFileURL:self.indexURL];
+    XCTAssertNotNil(index);
+    XCTAssertTrue(index.count == 2);
+
+    // Look up the file by path, and check it's the same record when looked up by UUID
+    NSURL *fileURL = [self.baseURL URLByAppendingPathComponent:@"File.txt"];
+    NSString *relativePath = [self.dictionary relativePathForItemURL:fileURL];
+    NSUInteger recordIndex = [index indexOfRecordWithRelativePath:relativePath];
+    XCTAssertTrue(recordIndex != NSNotFound);
+    XCTAssertEqualObjects([index uuidOfRecordAtIndex:recordIndex], [TOFileSystemUUID UUIDWithString:@"f2a5bc6d-0eab-4970-8650-8629fdc3a866"]);
+    XCTAssertEqualObjects([index relativePathOfRecordAtIndex:recordIndex], relativePath);
+    XCTAssertTrue([index indexOfRecordWithUUID:[TOFileSystemUUID UUIDWithString:@"f2a5bc6d-0eab-4970-8650-8629fdc3a866"]] == recordIndex);
+
+    // Items that weren't saved aren't found
+    XCTAssertTrue([index indexOfRecordWithRelativePath:@"/Documents/Missing"] == NSNotFound);
+    XCTAssertTrue([index indexOfRecordWithUUID:[TOFileSystemUUID UUIDWithString:@"0afec03c-ba74-4b87-9941-9c59bb97ccc4"]] == NSNotFound);
+}
+
+- (void)testMatchingAttributes
+{
+    [TOFileSystemScanIndex writeItems:self.dictionary toFileURL:self.indexURL];
+    TOFileSystemScanIndex *index = [TOFileSystemScanIndex indexWithContentsOfFileURL:self.indexURL];
+
+    TOFileSystemItemAttributes attributes = {0};
+    attributes.inode = 42;
+    attributes.size = 100;
+    attributes.modificationTime.tv_sec = 1000;
+    attributes.creationTime.tv_sec = 500;
+    attributes.creationTime.tv_nsec = 250;
+
+    NSUInteger fileIndex = [index indexOfRecordWithUUID:[TOFileSystemUUID UUIDWithString:@"f2a5bc6d-0eab-4970-8650-8629fdc3a866"]];
+    XCTAssertTrue([index recordAtIndex:fileIndex matchesAttributes:&attributes]);
+
+    // The creation time is saved too, so items seeded from the index can still be matched after they're moved
+    TOFileSystemItemAttributes savedAttributes;
+    [index getAttributes:&savedAttributes ofRecordAtIndex:fileIndex];
+    XCTAssertTrue(TOFileSystemItemAttributesAreSameItem(&savedAttributes, &attributes));
+
+    // An item with a reused ID is a different item
+    attributes.creationTime.tv_nsec = 251;
+    XCTAssertFalse([index recordAtIndex:fileIndex matchesAttributes:&attributes]);
+    attributes.creationTime.tv_nsec = 250;
+
+    // A change in size means the item was modified
+    attributes.size = 101;
+    XCTAssertFalse([index recordAtIndex:fileIndex matchesAttributes:&attributes]);
+
+    // Items saved without attributes never match
+    NSUInteger folderIndex = [index indexOfRecordWithUUID:[TOFileSystemUUID UUIDWithString:@"3ccd0073-e57c-42c7-b3be-6410a051c900"]];
+    TOFileSystemItemAttributes emptyAttributes = {0};
+    XCTAssertFalse([index recordAtIndex:folderIndex matchesAttributes:&emptyAttributes]);
+}
+
+- (void)testChildRecords
+{
+    // Add a child, and a grandchild to the folder
+    NSURL *folderURL = [self.baseURL URLByAppendingPathComponent:@"Folder"];
+    TOFileSystemItemAttributes attributes = {0};
+    attributes.isDirectory = YES;
+    attributes.numberOfChildItems = 1;
+    [self.dictionary setItemURL:[folderURL URLByAppendingPathComponent:@"SubFolder"]
+                     attributes:&attributes
+                        forUUID:[TOFileSystemUUID UUIDWithString:@"0afec03c-ba74-4b87-9941-9c59bb97ccc4"]];
+    [self.dictionary setItemURL:[folderURL URLByAppendingPathComponent:@"SubFolder/Deep.txt"]
+                        forUUID:[TOFileSystemUUID UUIDWithString:@"9e3a1b84-6c2f-4d0e-8b7a-5f1c2d3e4a5b"]];
+
+    [TOFileSystemScanIndex writeItems:self.dictionary toFileURL:self.indexURL];
+    TOFileSystemScanIndex *index = [TOFileSystemScanIndex indexWithContentsOfFileURL:self.indexURL];
+
+    // Only the direct child of the folder should be returned
+    NSMutableArray *uuids = [NSMutableArray array];
+    NSString *relativePath = [self.dictionary relativePathForItemURL:folderURL];
+    [index enumerateChildRecordsOfDirectoryWithRelativePath:relativePath usingBlock:^(NSUInteger recordIndex) {
+        [uuids addObject:[index uuidOfRecordAtIndex:recordIndex]];
+    }];
+    XCTAssertEqualObjects(uuids, @[[TOFileSystemUUID UUIDWithString:@"0afec03c-ba74-4b87-9941-9c59bb97ccc4"]]);
+
+    // The directory's attributes should survive the round trip
+    NSUInteger recordIndex = [index indexOfRecordWithUUID:[TOFileSystemUUID UUIDWithString:@"0afec03c-ba74-4b87-9941-9c59bb97ccc4"]];
+    TOFileSystemItemAttributes savedAttributes;
+    [index getAttributes:&savedAttributes ofRecordAtIndex:recordIndex];
+    XCTAssertTrue(savedAttributes.isDirectory);
+    XCTAssertTrue(savedAttributes.numberOfChildItems == 1);
+}
+
+- (void)testInvalidFiles
+{
+    // Missing files
+    XCTAssertNil([TOFileSystemScanIndex indexWithContentsOfFileURL:self.indexURL]);
+
+    // Files that aren't indexes
+    [[@"Not an index file" dataUsingEncoding:NSUTF8StringEncoding] writeToURL:self.indexURL atomically:YES];
+    XCTAssertNil([TOFileSystemScanIndex indexWithContentsOfFileURL:self.indexURL]);
+
+    // Indexes that have been truncated
+    [TOFileSystemScanIndex writeItems:self.dictionary toFileURL:self.indexURL];
+    NSData *data = [NSData dataWithContentsOfURL:self.indexURL];
+    [[data subdataWithRange:NSMakeRange(0, data.length - 1)] writeToURL:self.indexURL atomically:YES];
+    XCTAssertNil([TOFileSystemScanIndex indexWithContentsOfFileURL:self.indexURL]);
+}
+
+@end
@@ -0,0 +1,86 @@
+//
+//  TOFileSystemShardedDictionaryTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemShardedDictionary.h"
+
+@interface TOFileSystemShardedDictionaryTests : XCTestCase
+
+@end
+
+@implementation TOFileSystemShardedDictionaryTests
+
+- (void)testStoringObjects
+{
+    TOFileSystemShardedDictionary<NSNumber *, NSString *> *dictionary = [[TOFileSystemShardedDictionary alloc] initWithNumberOfShards:10];
+    XCTAssertEqual(dictionary.numberOfShards, 16);
+
+    for (NSInteger i = 0; i < 100; i++) {
+        dictionary[@(i)] = [NSString stringWithFormat:@"%ld", (long)i];
+    }
+    XCTAssertEqual(dictionary.count, 100);
+    XCTAssertEqualObjects(dictionary[@(42)], @"42");
+    XCTAssertEqual(dictionary.allKeys.count, 100);
+
+    // Replacing an object doesn't change the count
+    dictionary[@(42)] = @"Forty Two";
+    XCTAssertEqual(dictionary.count, 100);
+    XCTAssertEqualObjects(dictionary[@(42)], @"Forty Two");
+
+    // Nilling an object removes it
+    dictionary[@(42)] = nil;
+    XCTAssertNil(dictionary[@(42)]);
+    XCTAssertEqual(dictionary.count, 99);
+
+    __block NSInteger numberOfObjects = 0;
+    [dictionary enumerateKeysAndObjectsUsingBlock:^(NSNumber *key, NSString *object, BOOL *stop) {
+        XCTAssertEqualObjects(object, key.stringValue);
+        numberOfObjects++;
+    }];
+    XCTAssertEqual(numberOfObjects, 99);
+
+    [dictionary removeAllObjects];
+    XCTAssertEqual(dictionary.count, 0);
+    XCTAssertNil(dictionary[@(1)]);
+}
+
+- (void)testReadingWhileWriting
+{
+    TOFileSystemShardedDictionary<NSNumber *, NSNumber *> *dictionary = [[TOFileSystemShardedDictionary alloc] init];
+    dictionary[@(-1)] = @(-1);
+
+    // Readers running alongside a writer should always find the entry that isn't being changed
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        for (NSInteger i = 0; i < 10000; i++) { dictionary[@(i)] = @(i); }
+    });
+    dispatch_apply(4, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t index) {
+        for (NSInteger i = 0; i < 10000; i++) {
+            XCTAssertEqualObjects(dictionary[@(-1)], @(-1));
+        }
+    });
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+
+    XCTAssertEqual(dictionary.count, 10001);
+}
+
+@end
@@ -0,0 +1,100 @@
+//
+//  TOFileSystemUUIDCacheTests.m
+//
+//  Copyright 2019-2022 Timothy Oliver. All rights reserved.
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a copy
+//  of this software and associated documentation files (the "Software"), to
+//  deal in the Software without restriction, including without limitation the
+//  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+//  sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR
+//  IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import "TOFileSystemUUIDCache.h"
+#import "TOFileSystemUUID.h"
+
+@interface TOFileSystemUUIDCacheTests : XCTestCase
+
+@end
+
+@implementation TOFileSystemUUIDCacheTests
+
+- (TOFileSystemItemAttributes)attributesWithInode:(uint64_t)inode changeTime:(time_t)changeTime
+{
+    TOFileSystemItemAttributes attributes = {0};
+    attributes.inode = inode;
+    attributes.device = 1;
+    attributes.changeTime.tv_sec = changeTime;
+    return attributes;
+}
+
+- (void)testCachingUUIDs
+{
+    TOFileSystemUUIDCache *cache = [[TOFileSystemUUIDCache alloc] initWithCapacity:100];
+    XCTAssertEqual(cache.capacity, 128);
+
+    TOFileSystemItemAttributes attributes = [self attributesWithInode:42 changeTime:1000];
+    XCTAssertNil([cache uuidForItemWithAttributes:&attributes]);
+    XCTAssertEqual(cache.numberOfMisses, 1);
+
+    TOFileSystemUUID *uuid = [TOFileSystemUUID UUID];
+    [cache setUUID:uuid forItemWithAttributes:&attributes];
+    XCTAssertEqualObjects([cache uuidForItemWithAttributes:&attributes], uuid);
+    XCTAssertEqual(cache.numberOfHits, 1);
+
+    // Once the item's metadata has changed, the cached UUID can't be trusted
+    TOFileSystemItemAttributes changedAttributes = [self attributesWithInode:42 changeTime:1001];
+    XCTAssertNil([cache uuidForItemWithAttributes:&changedAttributes]);
+    XCTAssertEqual(cache.numberOfMisses, 2);
+
+    [cache removeAllUUIDs];
+    XCTAssertNil([cache uuidForItemWithAttributes:&attributes]);
+    XCTAssertEqual(cache.numberOfHits, 0);
+}
+
+- (void)testUncacheableAttributes
+{
+    TOFileSystemUUIDCache *cache = [[TOFileSystemUUIDCache alloc] init];
+
+    // Without a status change time, there's no way to tell if the UUID changed, so nothing is cached
+    TOFileSystemItemAttributes attributes = [self attributesWithInode:42 changeTime:0];
+    [cache setUUID:[TOFileSystemUUID UUID] forItemWithAttributes:&attributes];
+    XCTAssertNil([cache uuidForItemWithAttributes:&attributes]);
+}
+
+- (void)testCapacityIsBounded
+{
+    TOFileSystemUUIDCache *cache = [[TOFileSystemUUIDCache alloc] initWithCapacity:4];
+
+    // Adding more items than the capacity replaces older ones, rather than growing
+    NSMutableArray<TOFileSystemUUID *> *uuids = [NSMutableArray array];
+    for (uint64_t i = 1; i <= 64; i++) {
+        TOFileSystemItemAttributes attributes = [self attributesWithInode:i changeTime:1000];
+        TOFileSystemUUID *uuid = [TOFileSystemUUID UUID];
+        [uuids addObject:uuid];
+        [cache setUUID:uuid forItemWithAttributes:&attributes];
+    }
+
+    NSInteger numberOfCachedUUIDs = 0;
+    for (uint64_t i = 1; i <= 64; i++) {
+        TOFileSystemItemAttributes attributes = [self attributesWithInode:i changeTime:1000];
+        TOFileSystemUUID *uuid = [cache uuidForItemWithAttributes:&attributes];
+        if (uuid == nil) { continue; }
+        XCTAssertEqualObjects(uuid, uuids[i - 1]);
+        numberOfCachedUUIDs++;
+    }
+    XCTAssertTrue(numberOfCachedUUIDs > 0 && numberOfCachedUUIDs <= 4);
+}
+
+@end